@@ -0,0 +1,1080 @@
+///////////////////////////////////////////////////////////////////////////////
+// benchmarks.cpp
+// ============
+// command line microbenchmarks of the scene rendering code paths
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Benchmarks.h"
+#include "Transform.h"
+#include "TransformBatch.h"
+#include "FrustumCuller.h"
+#include "BoundingVolumeHierarchy.h"
+#include "OcclusionCuller.h"
+#include "JobSystem.h"
+#include "RenderQueue.h"
+
+#include <glm/gtc/type_ptr.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtx/transform.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+// declaration of global variables
+namespace
+{
+	// number of timed repetitions - the fastest one is reported
+	const int BENCHMARK_REPEATS = 10;
+	// number of objects used by the transform benchmark
+	const int TRANSFORM_COUNT = 100000;
+	// largest relative difference allowed between matrices
+	const float MATRIX_EPSILON = 1.0e-5f;
+	// number of bounding boxes used by the culling benchmark
+	const int CULLING_COUNT = 100000;
+	// scene sizes the hierarchy benchmark is run at, and the
+	// average distance between neighbouring objects
+	const int HIERARCHY_COUNTS[] = { 1000, 100000, 1000000 };
+	const float HIERARCHY_SPACING = 10.0f;
+	// number of rays cast by the hierarchy benchmark
+	const int HIERARCHY_RAYS = 1000;
+	// number of boxes tested by the occlusion benchmark, and
+	// the columns and rows of the wall of occluders they are
+	// spread around
+	const int OCCLUSION_COUNT = 100000;
+	const int OCCLUSION_WALL_COLUMNS = 8;
+	const int OCCLUSION_WALL_ROWS = 4;
+	// number of empty jobs used to time the cost of a job,
+	// the number of matrices and boxes split into jobs, and
+	// the number of those per job
+	const int JOB_OVERHEAD_COUNT = 100000;
+	const int JOB_WORK_COUNT = 1000000;
+	const int JOB_GRAIN_SIZE = 4096;
+	// number of jobs in the dependency check - each squares
+	// its index and a continuation adds up the squares
+	const int JOB_DEPENDENCY_COUNT = 256;
+	// number of moving objects in the record benchmark, the
+	// number of meshes and textures they are spread over, and
+	// the number of objects per job and per record packet
+	const int RECORD_COUNT = 100000;
+	const int RECORD_MESHES = 8;
+	const int RECORD_TEXTURES = 16;
+	const int RECORD_JOB_SIZE = 4096;
+	// number of translucent objects in the transparency
+	// benchmark, the number of meshes they are spread over,
+	// and the number of camera positions it orbits through
+	const int TRANSPARENCY_COUNT = 10000;
+	const int TRANSPARENCY_MESHES = 4;
+	const int TRANSPARENCY_FRAMES = 60;
+
+	// per-instance data written by the record benchmark, the
+	// same size as the instance data of the scene
+	struct RECORD_INSTANCE
+	{
+		glm::mat4 model;
+		glm::vec4 color;
+		glm::vec2 UVscale;
+		int32_t materialIndex;
+		int32_t textureLayer;
+		int32_t objectIndex;
+	};
+
+	/***********************************************************
+	 *  GetThreadCounts()
+	 *
+	 *  This function is used for getting the thread counts the
+	 *  scaling benchmarks run at - 1, 2, 4 and so on, up to one
+	 *  thread per hardware thread.
+	 ***********************************************************/
+	std::vector<int> GetThreadCounts()
+	{
+		std::vector<int> threadCounts;
+		int hardwareThreads = (int)std::thread::hardware_concurrency();
+
+		for (int threads = 1; threads < hardwareThreads; threads *= 2)
+		{
+			threadCounts.push_back(threads);
+		}
+		threadCounts.push_back((hardwareThreads > 1) ? hardwareThreads : 1);
+
+		return(threadCounts);
+	}
+
+	/***********************************************************
+	 *  ElapsedMilliseconds()
+	 *
+	 *  This function is used for getting the milliseconds that
+	 *  passed since the passed in start time.
+	 ***********************************************************/
+	double ElapsedMilliseconds(std::chrono::high_resolution_clock::time_point start)
+	{
+		std::chrono::duration<double, std::milli> elapsed =
+			std::chrono::high_resolution_clock::now() - start;
+		return(elapsed.count());
+	}
+
+	/***********************************************************
+	 *  MaxMatrixError()
+	 *
+	 *  This function is used for getting the largest difference
+	 *  between two lists of matrices, relative to the size of
+	 *  the expected value.
+	 ***********************************************************/
+	float MaxMatrixError(const std::vector<glm::mat4>& expected, const std::vector<glm::mat4>& actual)
+	{
+		float maxError = 0.0f;
+
+		for (size_t i = 0; i < expected.size(); i++)
+		{
+			const float* pExpected = glm::value_ptr(expected[i]);
+			const float* pActual = glm::value_ptr(actual[i]);
+			for (int value = 0; value < 16; value++)
+			{
+				float magnitude = std::fabs(pExpected[value]);
+				float error = std::fabs(pExpected[value] - pActual[value]) / ((magnitude > 1.0f) ? magnitude : 1.0f);
+				if (error > maxError)
+				{
+					maxError = error;
+				}
+			}
+		}
+
+		return(maxError);
+	}
+}
+
+/***********************************************************
+ *  Run()
+ *
+ *  This method is used for running the benchmark with the
+ *  passed in name.
+ ***********************************************************/
+bool Benchmarks::Run(const char* name)
+{
+	bool bRunAll = (strcmp(name, "all") == 0);
+	bool bFound = false;
+
+	if (bRunAll || (strcmp(name, "transforms") == 0))
+	{
+		RunTransforms();
+		bFound = true;
+	}
+
+	if (bRunAll || (strcmp(name, "culling") == 0))
+	{
+		RunCulling();
+		bFound = true;
+	}
+
+	if (bRunAll || (strcmp(name, "hierarchy") == 0))
+	{
+		RunHierarchy();
+		bFound = true;
+	}
+
+	if (bRunAll || (strcmp(name, "occlusion") == 0))
+	{
+		RunOcclusion();
+		bFound = true;
+	}
+
+	if (bRunAll || (strcmp(name, "jobs") == 0))
+	{
+		RunJobs();
+		bFound = true;
+	}
+
+	if (bRunAll || (strcmp(name, "record") == 0))
+	{
+		RunRecord();
+		bFound = true;
+	}
+
+	if (bRunAll || (strcmp(name, "transparency") == 0))
+	{
+		RunTransparency();
+		bFound = true;
+	}
+
+	if (false == bFound)
+	{
+		std::cout << "ERROR: unknown benchmark \"" << name << "\"" << std::endl;
+		std::cout << "INFO: available benchmarks - all, transforms, culling, hierarchy, occlusion, jobs, record, transparency" << std::endl;
+	}
+
+	return(bFound);
+}
+
+/***********************************************************
+ *  RunTransforms()
+ *
+ *  This method is used for timing the model matrices of many
+ *  random transforms built with Transform::ComposeMatrix,
+ *  the scalar closed form and the SIMD kernel, and checking
+ *  that the kernels match the glm results.
+ ***********************************************************/
+void Benchmarks::RunTransforms()
+{
+	std::mt19937 random(330);
+	std::uniform_real_distribution<float> scaleRange(0.1f, 10.0f);
+	std::uniform_real_distribution<float> rotationRange(-360.0f, 360.0f);
+	std::uniform_real_distribution<float> positionRange(-100.0f, 100.0f);
+
+	TransformBatch batch;
+	std::vector<glm::vec3> scales(TRANSFORM_COUNT);
+	std::vector<glm::vec3> rotations(TRANSFORM_COUNT);
+	std::vector<glm::vec3> positions(TRANSFORM_COUNT);
+	for (int i = 0; i < TRANSFORM_COUNT; i++)
+	{
+		scales[i] = glm::vec3(scaleRange(random), scaleRange(random), scaleRange(random));
+		rotations[i] = glm::vec3(rotationRange(random), rotationRange(random), rotationRange(random));
+		positions[i] = glm::vec3(positionRange(random), positionRange(random), positionRange(random));
+		batch.Add(scales[i], rotations[i], positions[i]);
+	}
+
+	std::vector<glm::mat4> composed(TRANSFORM_COUNT);
+	std::vector<glm::mat4> scalar(TRANSFORM_COUNT);
+	std::vector<glm::mat4> batched(TRANSFORM_COUNT);
+	double composeTime = 0.0;
+	double batchTime = 0.0;
+
+	for (int repeat = 0; repeat < BENCHMARK_REPEATS; repeat++)
+	{
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < TRANSFORM_COUNT; i++)
+		{
+			composed[i] = Transform::ComposeMatrix(scales[i], rotations[i], positions[i]);
+		}
+		double elapsed = ElapsedMilliseconds(start);
+		composeTime = ((repeat == 0) || (elapsed < composeTime)) ? elapsed : composeTime;
+
+		start = std::chrono::high_resolution_clock::now();
+		batch.BuildModelMatrices(batched.data());
+		elapsed = ElapsedMilliseconds(start);
+		batchTime = ((repeat == 0) || (elapsed < batchTime)) ? elapsed : batchTime;
+	}
+
+	// the scalar closed form is only used to check the kernel
+	TransformBatch::TRANSFORM_SOA transforms;
+	std::vector<float> values[9];
+	for (int component = 0; component < 9; component++)
+	{
+		values[component].resize(TRANSFORM_COUNT);
+	}
+	for (int i = 0; i < TRANSFORM_COUNT; i++)
+	{
+		for (int axis = 0; axis < 3; axis++)
+		{
+			values[axis][i] = scales[i][axis];
+			values[3 + axis][i] = rotations[i][axis];
+			values[6 + axis][i] = positions[i][axis];
+		}
+	}
+	transforms.scaleX = values[0].data();
+	transforms.scaleY = values[1].data();
+	transforms.scaleZ = values[2].data();
+	transforms.rotationX = values[3].data();
+	transforms.rotationY = values[4].data();
+	transforms.rotationZ = values[5].data();
+	transforms.positionX = values[6].data();
+	transforms.positionY = values[7].data();
+	transforms.positionZ = values[8].data();
+	TransformBatch::BuildModelMatricesScalar(transforms, TRANSFORM_COUNT, scalar.data());
+
+	float batchError = MaxMatrixError(composed, batched);
+	float scalarError = MaxMatrixError(composed, scalar);
+
+	std::cout << "INFO: Benchmark transforms - " << TRANSFORM_COUNT << " matrices, best of "
+		<< BENCHMARK_REPEATS << " runs" << std::endl;
+	std::cout << "INFO:   Transform::ComposeMatrix: " << composeTime << " ms" << std::endl;
+	std::cout << "INFO:   TransformBatch (" << TransformBatch::GetKernelName() << "): " << batchTime
+		<< " ms, " << (composeTime / batchTime) << "x faster" << std::endl;
+	std::cout << "INFO:   max error - batch: " << batchError << ", scalar closed form: " << scalarError
+		<< ", epsilon: " << MATRIX_EPSILON << std::endl;
+
+	if ((batchError > MATRIX_EPSILON) || (scalarError > MATRIX_EPSILON))
+	{
+		std::cout << "ERROR: batched model matrices do not match Transform::ComposeMatrix" << std::endl;
+	}
+}
+
+/***********************************************************
+ *  RunCulling()
+ *
+ *  This method is used for timing the frustum test of many
+ *  random boxes spread around a camera, one box at a time
+ *  and with the SIMD kernel, and checking that both find the
+ *  same boxes visible.
+ ***********************************************************/
+void Benchmarks::RunCulling()
+{
+	std::mt19937 random(330);
+	std::uniform_real_distribution<float> positionRange(-100.0f, 100.0f);
+	std::uniform_real_distribution<float> extentRange(0.1f, 2.0f);
+
+	std::vector<float> values[6];
+	for (int component = 0; component < 6; component++)
+	{
+		values[component].resize(CULLING_COUNT);
+	}
+	for (int i = 0; i < CULLING_COUNT; i++)
+	{
+		for (int axis = 0; axis < 3; axis++)
+		{
+			values[axis][i] = positionRange(random);
+			values[3 + axis][i] = extentRange(random);
+		}
+	}
+
+	FrustumCuller::BOUNDS_SOA bounds;
+	bounds.centerX = values[0].data();
+	bounds.centerY = values[1].data();
+	bounds.centerZ = values[2].data();
+	bounds.extentX = values[3].data();
+	bounds.extentY = values[4].data();
+	bounds.extentZ = values[5].data();
+
+	// the starting camera of the scene, placed among the boxes
+	glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 5.0f, 12.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	glm::mat4 projection = glm::perspective(glm::radians(45.0f), 1000.0f / 800.0f, 0.1f, 100.0f);
+	glm::vec4 planes[6];
+	FrustumCuller::ExtractPlanes(projection * view, planes);
+
+	std::vector<uint8_t> scalar(CULLING_COUNT);
+	std::vector<uint8_t> simd(CULLING_COUNT);
+	double scalarTime = 0.0;
+	double simdTime = 0.0;
+	int scalarVisible = 0;
+	int simdVisible = 0;
+
+	for (int repeat = 0; repeat < BENCHMARK_REPEATS; repeat++)
+	{
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		scalarVisible = FrustumCuller::CullBoxesScalar(bounds, CULLING_COUNT, planes, scalar.data());
+		double elapsed = ElapsedMilliseconds(start);
+		scalarTime = ((repeat == 0) || (elapsed < scalarTime)) ? elapsed : scalarTime;
+
+		start = std::chrono::high_resolution_clock::now();
+		simdVisible = FrustumCuller::CullBoxes(bounds, CULLING_COUNT, planes, simd.data());
+		elapsed = ElapsedMilliseconds(start);
+		simdTime = ((repeat == 0) || (elapsed < simdTime)) ? elapsed : simdTime;
+	}
+
+	int mismatches = 0;
+	for (int i = 0; i < CULLING_COUNT; i++)
+	{
+		mismatches += (scalar[i] != simd[i]) ? 1 : 0;
+	}
+
+	std::cout << "INFO: Benchmark culling - " << CULLING_COUNT << " boxes, best of "
+		<< BENCHMARK_REPEATS << " runs" << std::endl;
+	std::cout << "INFO:   scalar: " << scalarTime << " ms, " << scalarVisible << " visible" << std::endl;
+	std::cout << "INFO:   FrustumCuller (" << FrustumCuller::GetKernelName() << "): " << simdTime
+		<< " ms, " << simdVisible << " visible, " << (scalarTime / simdTime) << "x faster" << std::endl;
+
+	if (mismatches > 0)
+	{
+		std::cout << "ERROR: " << mismatches << " boxes differ between the scalar and SIMD culling" << std::endl;
+	}
+}
+
+/***********************************************************
+ *  RunHierarchy()
+ *
+ *  This method is used for running the hierarchy benchmark
+ *  at each of the scene sizes.
+ ***********************************************************/
+void Benchmarks::RunHierarchy()
+{
+	for (size_t i = 0; i < sizeof(HIERARCHY_COUNTS) / sizeof(HIERARCHY_COUNTS[0]); i++)
+	{
+		RunHierarchyAt(HIERARCHY_COUNTS[i]);
+	}
+}
+
+/***********************************************************
+ *  RunHierarchyAt()
+ *
+ *  This method is used for timing the bounding volume
+ *  hierarchy over random boxes spread at the same density
+ *  at any scene size, so the camera sees about the same
+ *  number of objects while the total grows.  Building,
+ *  refitting every node, moving one object in a hundred,
+ *  frustum culling and ray casting are timed, and the query
+ *  results are checked against testing every box.
+ ***********************************************************/
+void Benchmarks::RunHierarchyAt(int objectCount)
+{
+	// fewer repeats for the largest scenes keep the run short
+	int repeats = (objectCount > 100000) ? 3 : BENCHMARK_REPEATS;
+	float sceneSize = HIERARCHY_SPACING * std::cbrt((float)objectCount);
+	std::mt19937 random(330);
+	std::uniform_real_distribution<float> positionRange(-0.5f * sceneSize, 0.5f * sceneSize);
+	std::uniform_real_distribution<float> extentRange(0.1f, 2.0f);
+	std::uniform_real_distribution<float> moveRange(-1.0f, 1.0f);
+
+	std::vector<glm::vec3> boundsMin(objectCount);
+	std::vector<glm::vec3> boundsMax(objectCount);
+	for (int i = 0; i < objectCount; i++)
+	{
+		glm::vec3 center(positionRange(random), positionRange(random), positionRange(random));
+		glm::vec3 extent(extentRange(random), extentRange(random), extentRange(random));
+		boundsMin[i] = center - extent;
+		boundsMax[i] = center + extent;
+	}
+
+	BoundingVolumeHierarchy bvh;
+	double buildTime = 0.0;
+	double refitTime = 0.0;
+	double updateTime = 0.0;
+	for (int repeat = 0; repeat < repeats; repeat++)
+	{
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		bvh.Build(boundsMin.data(), boundsMax.data(), objectCount);
+		double elapsed = ElapsedMilliseconds(start);
+		buildTime = ((repeat == 0) || (elapsed < buildTime)) ? elapsed : buildTime;
+
+		start = std::chrono::high_resolution_clock::now();
+		bvh.Refit();
+		elapsed = ElapsedMilliseconds(start);
+		refitTime = ((repeat == 0) || (elapsed < refitTime)) ? elapsed : refitTime;
+
+		// move every hundredth object a little, one at a time
+		start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < objectCount; i += 100)
+		{
+			glm::vec3 offset(moveRange(random), moveRange(random), moveRange(random));
+			bvh.UpdateObject(i, boundsMin[i] + offset, boundsMax[i] + offset);
+		}
+		elapsed = ElapsedMilliseconds(start);
+		updateTime = ((repeat == 0) || (elapsed < updateTime)) ? elapsed : updateTime;
+	}
+	float traversalCost = bvh.GetTraversalCost();
+	// the moved objects are put back for the query checks
+	bvh.Build(boundsMin.data(), boundsMax.data(), objectCount);
+
+	// flat copies of the boxes for the checks
+	std::vector<float> values[6];
+	for (int component = 0; component < 6; component++)
+	{
+		values[component].resize(objectCount);
+	}
+	for (int i = 0; i < objectCount; i++)
+	{
+		for (int axis = 0; axis < 3; axis++)
+		{
+			values[axis][i] = (boundsMin[i][axis] + boundsMax[i][axis]) * 0.5f;
+			values[3 + axis][i] = (boundsMax[i][axis] - boundsMin[i][axis]) * 0.5f;
+		}
+	}
+	FrustumCuller::BOUNDS_SOA bounds;
+	bounds.centerX = values[0].data();
+	bounds.centerY = values[1].data();
+	bounds.centerZ = values[2].data();
+	bounds.extentX = values[3].data();
+	bounds.extentY = values[4].data();
+	bounds.extentZ = values[5].data();
+
+	glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 5.0f, 12.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	glm::mat4 projection = glm::perspective(glm::radians(45.0f), 1000.0f / 800.0f, 0.1f, 100.0f);
+	glm::vec4 planes[6];
+	FrustumCuller::ExtractPlanes(projection * view, planes);
+
+	std::vector<uint8_t> flatVisible(objectCount);
+	std::vector<uint8_t> treeVisible(objectCount);
+	double flatTime = 0.0;
+	double treeTime = 0.0;
+	int flatCount = 0;
+	int treeCount = 0;
+	for (int repeat = 0; repeat < repeats; repeat++)
+	{
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		flatCount = FrustumCuller::CullBoxes(bounds, objectCount, planes, flatVisible.data());
+		double elapsed = ElapsedMilliseconds(start);
+		flatTime = ((repeat == 0) || (elapsed < flatTime)) ? elapsed : flatTime;
+
+		start = std::chrono::high_resolution_clock::now();
+		treeCount = bvh.QueryFrustum(planes, treeVisible.data());
+		elapsed = ElapsedMilliseconds(start);
+		treeTime = ((repeat == 0) || (elapsed < treeTime)) ? elapsed : treeTime;
+	}
+
+	int cullMismatches = 0;
+	for (int i = 0; i < objectCount; i++)
+	{
+		cullMismatches += (flatVisible[i] != treeVisible[i]) ? 1 : 0;
+	}
+
+	// rays from random points in the scene in random directions,
+	// checked against the nearest box found by testing them all
+	std::uniform_real_distribution<float> directionRange(-1.0f, 1.0f);
+	std::vector<glm::vec3> origins(HIERARCHY_RAYS);
+	std::vector<glm::vec3> directions(HIERARCHY_RAYS);
+	std::vector<int> hits(HIERARCHY_RAYS);
+	std::vector<float> hitDistances(HIERARCHY_RAYS);
+	for (int ray = 0; ray < HIERARCHY_RAYS; ray++)
+	{
+		origins[ray] = glm::vec3(positionRange(random), positionRange(random), positionRange(random));
+		directions[ray] = glm::normalize(glm::vec3(directionRange(random), directionRange(random), directionRange(random)) + glm::vec3(0.0f, 0.0f, 1.0e-3f));
+	}
+
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	for (int ray = 0; ray < HIERARCHY_RAYS; ray++)
+	{
+		hitDistances[ray] = sceneSize * 2.0f;
+		hits[ray] = bvh.Raycast(origins[ray], directions[ray], hitDistances[ray]);
+	}
+	double rayTime = ElapsedMilliseconds(start);
+
+	int rayMismatches = 0;
+	for (int ray = 0; ray < HIERARCHY_RAYS; ray++)
+	{
+		float closest = sceneSize * 2.0f;
+		glm::vec3 inverseDirection = 1.0f / directions[ray];
+
+		for (int i = 0; i < objectCount; i++)
+		{
+			float nearest = 0.0f;
+			float farthest = closest;
+			for (int axis = 0; axis < 3; axis++)
+			{
+				float first = (boundsMin[i][axis] - origins[ray][axis]) * inverseDirection[axis];
+				float second = (boundsMax[i][axis] - origins[ray][axis]) * inverseDirection[axis];
+				nearest = std::max(nearest, std::min(first, second));
+				farthest = std::min(farthest, std::max(first, second));
+			}
+			if (nearest <= farthest)
+			{
+				closest = nearest;
+			}
+		}
+
+		// two boxes can be entered at the same distance, so the
+		// distance is compared rather than the object
+		bool bTreeHit = (hits[ray] >= 0);
+		bool bFlatHit = (closest < sceneSize * 2.0f);
+		if ((bTreeHit != bFlatHit) || (bTreeHit && (hitDistances[ray] != closest)))
+		{
+			rayMismatches++;
+		}
+	}
+
+	std::cout << "INFO: Benchmark hierarchy - " << objectCount << " objects, " << bvh.GetNodeCount()
+		<< " nodes, traversal cost " << traversalCost << ", best of " << repeats << " runs" << std::endl;
+	std::cout << "INFO:   build: " << buildTime << " ms, refit: " << refitTime << " ms, move "
+		<< ((objectCount + 99) / 100) << " objects: " << updateTime << " ms" << std::endl;
+	std::cout << "INFO:   frustum - every box: " << flatTime << " ms, hierarchy: " << treeTime << " ms, "
+		<< treeCount << " visible" << std::endl;
+	std::cout << "INFO:   " << HIERARCHY_RAYS << " rays: " << rayTime << " ms" << std::endl;
+
+	if ((cullMismatches > 0) || (flatCount != treeCount))
+	{
+		std::cout << "ERROR: " << cullMismatches << " objects differ between hierarchy and flat culling" << std::endl;
+	}
+	if (rayMismatches > 0)
+	{
+		std::cout << "ERROR: " << rayMismatches << " rays hit a different box than testing every box" << std::endl;
+	}
+}
+
+/***********************************************************
+ *  RunOcclusion()
+ *
+ *  This method is used for timing the occlusion pass with a
+ *  wall of box occluders 20 units in front of the camera and
+ *  random boxes in front of, around and behind it.  The wall
+ *  is drawn into the depth buffer, the pyramid is built and
+ *  every box is tested.  A box in front of the wall or
+ *  reaching past its outline on screen by more than a pixel
+ *  of the depth buffer must stay visible, and any that is
+ *  hidden is reported as an error.
+ ***********************************************************/
+void Benchmarks::RunOcclusion()
+{
+	const float wallDepth = 20.0f;
+	const float wallThickness = 0.2f;
+	const float tileSize = 2.5f;
+	std::mt19937 random(330);
+	std::uniform_real_distribution<float> positionX(-40.0f, 40.0f);
+	std::uniform_real_distribution<float> positionY(-30.0f, 30.0f);
+	std::uniform_real_distribution<float> positionZ(-95.0f, -2.0f);
+	std::uniform_real_distribution<float> extentRange(0.1f, 1.0f);
+
+	std::vector<glm::vec3> centers(OCCLUSION_COUNT);
+	std::vector<glm::vec3> extents(OCCLUSION_COUNT);
+	for (int i = 0; i < OCCLUSION_COUNT; i++)
+	{
+		centers[i] = glm::vec3(positionX(random), positionY(random), positionZ(random));
+		extents[i] = glm::vec3(extentRange(random), extentRange(random), extentRange(random));
+	}
+
+	std::vector<glm::mat4> wall;
+	for (int row = 0; row < OCCLUSION_WALL_ROWS; row++)
+	{
+		for (int column = 0; column < OCCLUSION_WALL_COLUMNS; column++)
+		{
+			glm::vec3 position(
+				((float)column - 0.5f * (float)(OCCLUSION_WALL_COLUMNS - 1)) * tileSize,
+				((float)row - 0.5f * (float)(OCCLUSION_WALL_ROWS - 1)) * tileSize,
+				-wallDepth);
+			wall.push_back(glm::translate(position) * glm::scale(glm::vec3(tileSize, tileSize, wallThickness)));
+		}
+	}
+
+	glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	glm::mat4 projection = glm::perspective(glm::radians(45.0f), 1000.0f / 800.0f, 0.1f, 100.0f);
+	glm::mat4 viewProjection = projection * view;
+
+	OcclusionCuller culler;
+	std::vector<uint8_t> visible(OCCLUSION_COUNT);
+	double drawTime = 0.0;
+	double pyramidTime = 0.0;
+	double testTime = 0.0;
+	int occludedCount = 0;
+	for (int repeat = 0; repeat < BENCHMARK_REPEATS; repeat++)
+	{
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		culler.BeginFrame(viewProjection);
+		for (size_t i = 0; i < wall.size(); i++)
+		{
+			culler.DrawOccluder(wall[i], glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.5f, 0.5f, 0.5f));
+		}
+		double elapsed = ElapsedMilliseconds(start);
+		drawTime = ((repeat == 0) || (elapsed < drawTime)) ? elapsed : drawTime;
+
+		start = std::chrono::high_resolution_clock::now();
+		culler.BuildPyramid();
+		elapsed = ElapsedMilliseconds(start);
+		pyramidTime = ((repeat == 0) || (elapsed < pyramidTime)) ? elapsed : pyramidTime;
+
+		start = std::chrono::high_resolution_clock::now();
+		occludedCount = 0;
+		for (int i = 0; i < OCCLUSION_COUNT; i++)
+		{
+			visible[i] = culler.IsVisible(centers[i], extents[i]) ? 1 : 0;
+			occludedCount += (0 == visible[i]) ? 1 : 0;
+		}
+		elapsed = ElapsedMilliseconds(start);
+		testTime = ((repeat == 0) || (elapsed < testTime)) ? elapsed : testTime;
+	}
+
+	// outline of the wall on screen, from its front face and
+	// grown by one pixel of the depth buffer
+	float frontZ = -wallDepth + 0.5f * wallThickness;
+	glm::vec4 wallCorner = viewProjection * glm::vec4(
+		0.5f * tileSize * (float)OCCLUSION_WALL_COLUMNS,
+		0.5f * tileSize * (float)OCCLUSION_WALL_ROWS,
+		frontZ, 1.0f);
+	float outlineX = wallCorner.x / wallCorner.w + 2.0f / (float)OcclusionCuller::BUFFER_WIDTH;
+	float outlineY = wallCorner.y / wallCorner.w + 2.0f / (float)OcclusionCuller::BUFFER_HEIGHT;
+
+	int errorCount = 0;
+	for (int i = 0; i < OCCLUSION_COUNT; i++)
+	{
+		if (0 != visible[i])
+		{
+			continue;
+		}
+
+		bool bInside = (centers[i].z + extents[i].z) < frontZ;
+		for (int corner = 0; bInside && (corner < 8); corner++)
+		{
+			glm::vec3 offset(
+				(corner & 1) ? extents[i].x : -extents[i].x,
+				(corner & 2) ? extents[i].y : -extents[i].y,
+				(corner & 4) ? extents[i].z : -extents[i].z);
+			glm::vec4 clip = viewProjection * glm::vec4(centers[i] + offset, 1.0f);
+
+			bInside = (std::fabs(clip.x / clip.w) <= outlineX) && (std::fabs(clip.y / clip.w) <= outlineY);
+		}
+		errorCount += bInside ? 0 : 1;
+	}
+
+	std::cout << "INFO: Benchmark occlusion - " << wall.size() << " occluders, " << OCCLUSION_COUNT
+		<< " boxes, " << OcclusionCuller::BUFFER_WIDTH << "x" << OcclusionCuller::BUFFER_HEIGHT
+		<< " depth buffer, best of " << BENCHMARK_REPEATS << " runs" << std::endl;
+	std::cout << "INFO:   draw occluders: " << drawTime << " ms, build pyramid: " << pyramidTime
+		<< " ms, test boxes: " << testTime << " ms, " << occludedCount << " occluded" << std::endl;
+
+	if (errorCount > 0)
+	{
+		std::cout << "ERROR: " << errorCount << " boxes were hidden that are not behind the occluders" << std::endl;
+	}
+}
+
+/***********************************************************
+ *  RunJobs()
+ *
+ *  This method is used for timing the batched transform and
+ *  frustum culling kernels split into jobs on job systems
+ *  of 1, 2, 4 and so on up to one thread per hardware
+ *  thread, along with the cost of an empty job, and checking
+ *  that the split results and a chain of dependent jobs are
+ *  the same at every thread count.
+ ***********************************************************/
+void Benchmarks::RunJobs()
+{
+	std::mt19937 random(330);
+	std::uniform_real_distribution<float> scaleRange(0.1f, 10.0f);
+	std::uniform_real_distribution<float> rotationRange(-360.0f, 360.0f);
+	std::uniform_real_distribution<float> positionRange(-100.0f, 100.0f);
+	std::uniform_real_distribution<float> extentRange(0.1f, 2.0f);
+
+	TransformBatch batch;
+	FrustumCuller culler;
+	culler.Resize(JOB_WORK_COUNT);
+	for (int i = 0; i < JOB_WORK_COUNT; i++)
+	{
+		glm::vec3 position(positionRange(random), positionRange(random), positionRange(random));
+		batch.Add(glm::vec3(scaleRange(random), scaleRange(random), scaleRange(random)),
+			glm::vec3(rotationRange(random), rotationRange(random), rotationRange(random)), position);
+		culler.SetBounds(i, position, glm::vec3(extentRange(random), extentRange(random), extentRange(random)));
+	}
+
+	glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 5.0f, 12.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	glm::mat4 projection = glm::perspective(glm::radians(45.0f), 1000.0f / 800.0f, 0.1f, 100.0f);
+	glm::mat4 viewProjection = projection * view;
+
+	// the single threaded results every thread count must match
+	std::vector<glm::mat4> expectedMatrices(JOB_WORK_COUNT);
+	std::vector<uint8_t> expectedVisible(JOB_WORK_COUNT);
+	batch.BuildModelMatrices(expectedMatrices.data());
+	int expectedVisibleCount = culler.Cull(viewProjection, expectedVisible.data());
+	long long expectedSum = 0;
+	for (int i = 0; i < JOB_DEPENDENCY_COUNT; i++)
+	{
+		expectedSum += (long long)i * i;
+	}
+
+	std::vector<int> threadCounts = GetThreadCounts();
+
+	std::cout << "INFO: Benchmark jobs - " << JOB_WORK_COUNT << " matrices and boxes in jobs of "
+		<< JOB_GRAIN_SIZE << ", " << std::thread::hardware_concurrency() << " hardware threads, best of "
+		<< BENCHMARK_REPEATS << " runs" << std::endl;
+
+	double baseTransformTime = 0.0;
+	double baseCullingTime = 0.0;
+	int errorCount = 0;
+
+	for (size_t t = 0; t < threadCounts.size(); t++)
+	{
+		JobSystem jobs(threadCounts[t]);
+		std::vector<glm::mat4> matrices(JOB_WORK_COUNT);
+		std::vector<uint8_t> visible(JOB_WORK_COUNT);
+		double jobTime = 0.0;
+		double transformTime = 0.0;
+		double cullingTime = 0.0;
+		std::atomic<int> visibleCount(0);
+
+		for (int repeat = 0; repeat < BENCHMARK_REPEATS; repeat++)
+		{
+			std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+			JobSystem::JOB_COUNTER counter;
+			for (int i = 0; i < JOB_OVERHEAD_COUNT; i++)
+			{
+				jobs.Run([]() {}, &counter);
+			}
+			jobs.Wait(&counter);
+			double elapsed = ElapsedMilliseconds(start);
+			jobTime = ((repeat == 0) || (elapsed < jobTime)) ? elapsed : jobTime;
+
+			start = std::chrono::high_resolution_clock::now();
+			jobs.ParallelFor(JOB_WORK_COUNT, JOB_GRAIN_SIZE, [&batch, &matrices](int first, int count)
+			{
+				batch.BuildModelMatrices(first, count, matrices.data());
+			});
+			elapsed = ElapsedMilliseconds(start);
+			transformTime = ((repeat == 0) || (elapsed < transformTime)) ? elapsed : transformTime;
+
+			visibleCount = 0;
+			start = std::chrono::high_resolution_clock::now();
+			jobs.ParallelFor(JOB_WORK_COUNT, JOB_GRAIN_SIZE, [&culler, &viewProjection, &visible, &visibleCount](int first, int count)
+			{
+				visibleCount += culler.Cull(viewProjection, first, count, visible.data());
+			});
+			elapsed = ElapsedMilliseconds(start);
+			cullingTime = ((repeat == 0) || (elapsed < cullingTime)) ? elapsed : cullingTime;
+		}
+
+		// square every index in its own job, then add them up
+		// in a continuation that has to wait for all of them
+		std::vector<long long> squares(JOB_DEPENDENCY_COUNT, 0);
+		long long sum = 0;
+		JobSystem::JOB_COUNTER squaresDone;
+		JobSystem::JOB_COUNTER sumDone;
+		for (int i = 0; i < JOB_DEPENDENCY_COUNT; i++)
+		{
+			jobs.Run([&squares, i]() { squares[i] = (long long)i * i; }, &squaresDone);
+		}
+		jobs.RunAfter(&squaresDone, [&squares, &sum]()
+		{
+			for (size_t i = 0; i < squares.size(); i++)
+			{
+				sum += squares[i];
+			}
+		}, &sumDone);
+		jobs.Wait(&sumDone);
+
+		int mismatches = (sum != expectedSum) ? 1 : 0;
+		mismatches += (visibleCount != expectedVisibleCount) ? 1 : 0;
+		for (int i = 0; i < JOB_WORK_COUNT; i++)
+		{
+			mismatches += (visible[i] != expectedVisible[i]) ? 1 : 0;
+			mismatches += (memcmp(&matrices[i], &expectedMatrices[i], sizeof(glm::mat4)) != 0) ? 1 : 0;
+		}
+		errorCount += mismatches;
+
+		if (0 == t)
+		{
+			baseTransformTime = transformTime;
+			baseCullingTime = cullingTime;
+		}
+
+		std::cout << "INFO:   " << jobs.GetThreadCount() << " threads - empty job: "
+			<< (jobTime * 1000000.0 / JOB_OVERHEAD_COUNT) << " ns, transforms: " << transformTime
+			<< " ms (" << (baseTransformTime / transformTime) << "x), culling: " << cullingTime
+			<< " ms (" << (baseCullingTime / cullingTime) << "x)" << std::endl;
+	}
+
+	if (errorCount > 0)
+	{
+		std::cout << "ERROR: " << errorCount << " results differ between the job system and a single thread" << std::endl;
+	}
+}
+
+/***********************************************************
+ *  RunRecord()
+ *
+ *  This method is used for timing the record phase of a
+ *  frame in which every object of a large scene moved, the
+ *  way SceneManager::RecordScene() splits it into jobs -
+ *  rebuilding the matrices and bounds, frustum culling,
+ *  keying the visible objects into per-job packets, joining
+ *  and sorting them, and writing the instance data of the
+ *  sorted queue.  The sorted order is checked to be the same
+ *  at every thread count.
+ ***********************************************************/
+void Benchmarks::RunRecord()
+{
+	std::mt19937 random(330);
+	std::uniform_real_distribution<float> scaleRange(0.1f, 2.0f);
+	std::uniform_real_distribution<float> rotationRange(-360.0f, 360.0f);
+	std::uniform_real_distribution<float> positionRange(-100.0f, 100.0f);
+	std::uniform_int_distribution<int> meshRange(0, RECORD_MESHES - 1);
+	std::uniform_int_distribution<int> textureRange(0, RECORD_TEXTURES - 1);
+
+	TransformBatch batch;
+	std::vector<int> meshes(RECORD_COUNT);
+	std::vector<int> textures(RECORD_COUNT);
+	for (int i = 0; i < RECORD_COUNT; i++)
+	{
+		batch.Add(glm::vec3(scaleRange(random), scaleRange(random), scaleRange(random)),
+			glm::vec3(rotationRange(random), rotationRange(random), rotationRange(random)),
+			glm::vec3(positionRange(random), positionRange(random), positionRange(random)));
+		meshes[i] = meshRange(random);
+		textures[i] = textureRange(random);
+	}
+
+	glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 5.0f, 12.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	glm::mat4 projection = glm::perspective(glm::radians(45.0f), 1000.0f / 800.0f, 0.1f, 100.0f);
+	glm::mat4 viewProjection = projection * view;
+
+	std::vector<int> threadCounts = GetThreadCounts();
+	std::vector<uint32_t> expectedOrder;
+	double baseTime = 0.0;
+	int errorCount = 0;
+
+	std::cout << "INFO: Benchmark record - " << RECORD_COUNT << " moving objects in jobs of "
+		<< RECORD_JOB_SIZE << ", best of " << BENCHMARK_REPEATS << " runs" << std::endl;
+
+	for (size_t t = 0; t < threadCounts.size(); t++)
+	{
+		JobSystem jobs(threadCounts[t]);
+		FrustumCuller culler;
+		RenderQueue queue;
+		std::vector<glm::mat4> matrices(RECORD_COUNT);
+		std::vector<uint8_t> visible(RECORD_COUNT);
+		std::vector<std::vector<RenderQueue::RENDER_ENTRY> > packets((RECORD_COUNT + RECORD_JOB_SIZE - 1) / RECORD_JOB_SIZE);
+		std::vector<RECORD_INSTANCE> instances(RECORD_COUNT);
+		double recordTime = 0.0;
+
+		culler.Resize(RECORD_COUNT);
+		for (int repeat = 0; repeat < BENCHMARK_REPEATS; repeat++)
+		{
+			std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+			jobs.ParallelFor(RECORD_COUNT, RECORD_JOB_SIZE, [&](int first, int count)
+			{
+				batch.BuildModelMatrices(first, count, matrices.data());
+				for (int i = first; i < (first + count); i++)
+				{
+					culler.SetBounds(i, matrices[i], glm::vec3(0.0f), glm::vec3(0.5f));
+				}
+			});
+
+			jobs.ParallelFor(RECORD_COUNT, RECORD_JOB_SIZE, [&](int first, int count)
+			{
+				culler.Cull(viewProjection, first, count, visible.data());
+			});
+
+			jobs.ParallelFor(RECORD_COUNT, RECORD_JOB_SIZE, [&](int first, int count)
+			{
+				std::vector<RenderQueue::RENDER_ENTRY>& packet = packets[first / RECORD_JOB_SIZE];
+				packet.clear();
+				for (int i = first; i < (first + count); i++)
+				{
+					if (0 == visible[i])
+					{
+						continue;
+					}
+
+					RenderQueue::RENDER_ENTRY entry;
+					entry.key = RenderQueue::MakeSortKey(false, 1, meshes[i], textures[i] + 1, 0,
+						-(view * matrices[i][3]).z);
+					entry.itemIndex = (uint32_t)i;
+					packet.push_back(entry);
+				}
+			});
+
+			queue.Clear();
+			for (size_t p = 0; p < packets.size(); p++)
+			{
+				queue.Append(packets[p].data(), (int)packets[p].size());
+				packets[p].clear();
+			}
+			queue.Sort();
+
+			jobs.ParallelFor(queue.GetCount(), RECORD_JOB_SIZE, [&](int first, int count)
+			{
+				for (int i = first; i < (first + count); i++)
+				{
+					uint32_t itemIndex = queue.GetItemIndex(i);
+					RECORD_INSTANCE& instance = instances[i];
+					instance.model = matrices[itemIndex];
+					instance.color = glm::vec4(1.0f);
+					instance.UVscale = glm::vec2(1.0f);
+					instance.materialIndex = meshes[itemIndex];
+					instance.textureLayer = textures[itemIndex];
+					instance.objectIndex = (int32_t)itemIndex;
+				}
+			});
+
+			double elapsed = ElapsedMilliseconds(start);
+			recordTime = ((repeat == 0) || (elapsed < recordTime)) ? elapsed : recordTime;
+		}
+
+		std::vector<uint32_t> order(queue.GetCount());
+		for (int i = 0; i < queue.GetCount(); i++)
+		{
+			order[i] = queue.GetItemIndex(i);
+		}
+		if (0 == t)
+		{
+			expectedOrder = order;
+			baseTime = recordTime;
+		}
+		errorCount += (order != expectedOrder) ? 1 : 0;
+
+		std::cout << "INFO:   " << jobs.GetThreadCount() << " threads - record: " << recordTime << " ms ("
+			<< (baseTime / recordTime) << "x), " << queue.GetCount() << " draws queued" << std::endl;
+	}
+
+	if (errorCount > 0)
+	{
+		std::cout << "ERROR: the recorded draw order differs between thread counts " << errorCount << " times" << std::endl;
+	}
+}
+
+/***********************************************************
+ *  RunTransparency()
+ *
+ *  This method is used for timing the CPU side of drawing a
+ *  cube of translucent objects while the camera orbits it.
+ *  Sorted, every frame keys the objects by their distance
+ *  and sorts them back to front, and each one is its own
+ *  draw call.  With the order-independent transparency pass
+ *  the keys hold no distance, so the order stays the same
+ *  from frame to frame and neighbouring objects of the same
+ *  mesh are drawn as one instance batch, plus the composite.
+ ***********************************************************/
+void Benchmarks::RunTransparency()
+{
+	int side = (int)std::ceil(std::cbrt((double)TRANSPARENCY_COUNT));
+	std::vector<glm::vec3> positions(TRANSPARENCY_COUNT);
+	std::vector<int> meshes(TRANSPARENCY_COUNT);
+	for (int i = 0; i < TRANSPARENCY_COUNT; i++)
+	{
+		positions[i] = glm::vec3((float)(i % side), (float)((i / side) % side), (float)(i / (side * side))) -
+			glm::vec3((float)(side - 1) * 0.5f);
+		meshes[i] = (i * 7) % TRANSPARENCY_MESHES;
+	}
+
+	std::vector<glm::mat4> views(TRANSPARENCY_FRAMES);
+	for (int frame = 0; frame < TRANSPARENCY_FRAMES; frame++)
+	{
+		float angle = glm::radians(360.0f * (float)frame / (float)TRANSPARENCY_FRAMES);
+		glm::vec3 eye = glm::vec3(std::sin(angle), 0.5f, std::cos(angle)) * ((float)side * 1.5f);
+		views[frame] = glm::lookAt(eye, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	}
+
+	RenderQueue queue;
+	double sortedTime = 0.0;
+	double blendedTime = 0.0;
+	int sortedDrawCalls = 0;
+	int blendedDrawCalls = 0;
+
+	for (int repeat = 0; repeat < BENCHMARK_REPEATS; repeat++)
+	{
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		for (int frame = 0; frame < TRANSPARENCY_FRAMES; frame++)
+		{
+			queue.Clear();
+			for (int i = 0; i < TRANSPARENCY_COUNT; i++)
+			{
+				float depth = -(views[frame] * glm::vec4(positions[i], 1.0f)).z;
+				queue.Add(RenderQueue::MakeSortKey(true, 1, meshes[i], 0, 0, depth), (uint32_t)i);
+			}
+			queue.Sort();
+			sortedDrawCalls = queue.GetCount();
+		}
+		double elapsed = ElapsedMilliseconds(start) / TRANSPARENCY_FRAMES;
+		sortedTime = ((repeat == 0) || (elapsed < sortedTime)) ? elapsed : sortedTime;
+
+		start = std::chrono::high_resolution_clock::now();
+		for (int frame = 0; frame < TRANSPARENCY_FRAMES; frame++)
+		{
+			queue.Clear();
+			for (int i = 0; i < TRANSPARENCY_COUNT; i++)
+			{
+				queue.Add(RenderQueue::MakeSortKey(true, 1, meshes[i], 0, 0, 0.0f), (uint32_t)i);
+			}
+			queue.Sort();
+
+			// one instance batch per run of the same mesh, and
+			// the composite of the transparency targets
+			blendedDrawCalls = 1;
+			for (int i = 0; i < queue.GetCount(); i++)
+			{
+				if ((0 == i) || (meshes[queue.GetItemIndex(i)] != meshes[queue.GetItemIndex(i - 1)]))
+				{
+					blendedDrawCalls++;
+				}
+			}
+		}
+		elapsed = ElapsedMilliseconds(start) / TRANSPARENCY_FRAMES;
+		blendedTime = ((repeat == 0) || (elapsed < blendedTime)) ? elapsed : blendedTime;
+	}
+
+	std::cout << "INFO: Benchmark transparency - " << TRANSPARENCY_COUNT << " translucent objects, "
+		<< TRANSPARENCY_FRAMES << " camera positions, best of " << BENCHMARK_REPEATS << " runs" << std::endl;
+	std::cout << "INFO:   sorted back to front: " << sortedTime << " ms per frame, "
+		<< sortedDrawCalls << " draw calls" << std::endl;
+	std::cout << "INFO:   order independent:    " << blendedTime << " ms per frame ("
+		<< (sortedTime / blendedTime) << "x), " << blendedDrawCalls << " draw calls" << std::endl;
+}
@@ -0,0 +1,47 @@
+///////////////////////////////////////////////////////////////////////////////
+// benchmarks.h
+// ============
+// command line microbenchmarks of the scene rendering code paths
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+/***********************************************************
+ *  Benchmarks
+ *
+ *  This class runs the microbenchmarks selected on the
+ *  command line with "--benchmark <name>" and prints their
+ *  results to the console.  The benchmarks run before any
+ *  window or OpenGL context is created, so only CPU code
+ *  paths are measured.
+ ***********************************************************/
+class Benchmarks
+{
+public:
+	// run the named benchmark, or all of them for "all" -
+	// returns false when the name is not known
+	static bool Run(const char* name);
+
+private:
+	// compare building model matrices one at a time
+	// with the batched SIMD kernel
+	static void RunTransforms();
+	// compare testing bounding boxes against the view
+	// frustum one at a time with the SIMD kernel
+	static void RunCulling();
+	// time building, refitting and querying the bounding
+	// volume hierarchy at several scene sizes
+	static void RunHierarchy();
+	static void RunHierarchyAt(int objectCount);
+	// time the occlusion pass against a wall of occluders
+	static void RunOcclusion();
+	// time spreading the transform and culling work across
+	// job systems of 1 to N threads
+	static void RunJobs();
+	// time recording the draws of a large moving scene on
+	// job systems of 1 to N threads
+	static void RunRecord();
+	// compare sorting translucent draws back to front every
+	// frame with batching them for the transparency pass
+	static void RunTransparency();
+};
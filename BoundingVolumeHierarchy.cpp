@@ -0,0 +1,712 @@
+///////////////////////////////////////////////////////////////////////////////
+// boundingvolumehierarchy.cpp
+// ============
+// tree of bounding boxes over the scene objects for culling and spatial queries
+///////////////////////////////////////////////////////////////////////////////
+
+#include "BoundingVolumeHierarchy.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+// declaration of global variables
+namespace
+{
+	const int PLANE_COUNT = 6;
+	// number of bins the split candidates are evaluated in
+	const int BIN_COUNT = 16;
+	// nodes with this many objects or fewer are not split
+	const int MAX_LEAF_SIZE = 4;
+	// relative cost of visiting a node and testing an object
+	const float TRAVERSAL_COST = 1.0f;
+	const float INTERSECTION_COST = 1.0f;
+	// fraction of the objects that may be moved one at a time
+	// before the tree is considered too loose
+	const int REBUILD_DIVISOR = 4;
+	// deepest tree a query can walk - nodes at this depth are
+	// not split, which a balanced tree of a few million objects
+	// never comes close to
+	const int MAX_STACK_DEPTH = 128;
+	const int MAX_TREE_DEPTH = MAX_STACK_DEPTH - 2;
+
+	// box being grown while the split candidates are counted
+	struct BIN
+	{
+		glm::vec3 boundsMin;
+		glm::vec3 boundsMax;
+		int count;
+	};
+
+	/***********************************************************
+	 *  SurfaceArea()
+	 *
+	 *  This function is used for getting the surface area of a
+	 *  box, which the split heuristic uses as the chance of a
+	 *  ray passing through it.
+	 ***********************************************************/
+	inline float SurfaceArea(const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+	{
+		glm::vec3 size = boundsMax - boundsMin;
+		if ((size.x < 0.0f) || (size.y < 0.0f) || (size.z < 0.0f))
+		{
+			return(0.0f);
+		}
+		return(2.0f * (size.x * size.y + size.y * size.z + size.z * size.x));
+	}
+
+	/***********************************************************
+	 *  GrowBounds()
+	 *
+	 *  This function is used for growing a box to include
+	 *  another box.
+	 ***********************************************************/
+	inline void GrowBounds(glm::vec3& boundsMin, glm::vec3& boundsMax, const glm::vec3& otherMin, const glm::vec3& otherMax)
+	{
+		boundsMin = glm::min(boundsMin, otherMin);
+		boundsMax = glm::max(boundsMax, otherMax);
+	}
+
+	/***********************************************************
+	 *  ClassifyBox()
+	 *
+	 *  This function is used for testing a box against the
+	 *  frustum planes whose bits are set in the plane mask.
+	 *  Returns false when the box is outside a plane, and
+	 *  clears the bits of the planes the box is fully inside,
+	 *  so the children of a node skip those planes.  The plane
+	 *  test is the same one FrustumCuller uses.
+	 ***********************************************************/
+	inline bool ClassifyBox(const glm::vec3& boundsMin, const glm::vec3& boundsMax,
+		const glm::vec4 planes[PLANE_COUNT], int& planeMask)
+	{
+		glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+		glm::vec3 extent = (boundsMax - boundsMin) * 0.5f;
+
+		for (int p = 0; p < PLANE_COUNT; p++)
+		{
+			if (0 == (planeMask & (1 << p)))
+			{
+				continue;
+			}
+
+			const glm::vec4& plane = planes[p];
+			// summed in the same order as the flat culling
+			float distance = (plane.x * center.x + plane.y * center.y) + (plane.z * center.z + plane.w);
+			float radius = (std::fabs(plane.x) * extent.x + std::fabs(plane.y) * extent.y) + std::fabs(plane.z) * extent.z;
+
+			if ((distance + radius) < 0.0f)
+			{
+				return(false);
+			}
+			if ((distance - radius) >= 0.0f)
+			{
+				planeMask &= ~(1 << p);
+			}
+		}
+
+		return(true);
+	}
+
+	/***********************************************************
+	 *  RayBoxDistance()
+	 *
+	 *  This function is used for getting the distance along a
+	 *  ray at which it enters a box, with the slab method.
+	 *  Returns false when the ray misses the box or enters it
+	 *  after the passed in limit.  A ray that starts inside a
+	 *  box enters it at distance 0.
+	 ***********************************************************/
+	inline bool RayBoxDistance(const glm::vec3& origin, const glm::vec3& inverseDirection,
+		const glm::vec3& boundsMin, const glm::vec3& boundsMax, float limit, float& distance)
+	{
+		float nearest = 0.0f;
+		float farthest = limit;
+
+		for (int axis = 0; axis < 3; axis++)
+		{
+			float first = (boundsMin[axis] - origin[axis]) * inverseDirection[axis];
+			float second = (boundsMax[axis] - origin[axis]) * inverseDirection[axis];
+
+			// a ray parallel to a slab gives NaN from 0 * inf,
+			// which the comparisons below leave unchanged
+			nearest = std::max(nearest, std::min(first, second));
+			farthest = std::min(farthest, std::max(first, second));
+		}
+
+		distance = nearest;
+		return(nearest <= farthest);
+	}
+
+	/***********************************************************
+	 *  BoxTouchesSphere()
+	 *
+	 *  This function is used for checking whether the closest
+	 *  point of a box to a sphere center is inside the sphere.
+	 ***********************************************************/
+	inline bool BoxTouchesSphere(const glm::vec3& boundsMin, const glm::vec3& boundsMax,
+		const glm::vec3& center, float radius)
+	{
+		glm::vec3 closest = glm::min(glm::max(center, boundsMin), boundsMax);
+		glm::vec3 offset = closest - center;
+
+		return(glm::dot(offset, offset) <= (radius * radius));
+	}
+}
+
+/***********************************************************
+ *  BoundingVolumeHierarchy()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+BoundingVolumeHierarchy::BoundingVolumeHierarchy()
+{
+	m_updatesSinceBuild = 0;
+}
+
+/***********************************************************
+ *  Build()
+ *
+ *  This method is used for building the tree from scratch
+ *  over the passed in object boxes.  Nodes are split from a
+ *  work list, and the children of a node are always stored
+ *  after it, so walking the nodes backwards visits every
+ *  child before its parent.
+ ***********************************************************/
+void BoundingVolumeHierarchy::Build(const glm::vec3* pBoundsMin, const glm::vec3* pBoundsMax, int count)
+{
+	std::vector<glm::vec3> centroids(count);
+	// nodes still to be split and their depth in the tree
+	std::vector<std::pair<int, int> > pending;
+
+	m_objectMin.assign(pBoundsMin, pBoundsMin + count);
+	m_objectMax.assign(pBoundsMax, pBoundsMax + count);
+	m_objectLeaf.assign(count, 0);
+	m_objectOrder.resize(count);
+	for (int i = 0; i < count; i++)
+	{
+		m_objectOrder[i] = i;
+		centroids[i] = (pBoundsMin[i] + pBoundsMax[i]) * 0.5f;
+	}
+
+	m_nodes.clear();
+	m_updatesSinceBuild = 0;
+	if (0 == count)
+	{
+		return;
+	}
+
+	// a binary tree with at least one object per leaf has
+	// fewer than twice as many nodes as objects
+	m_nodes.reserve(2 * count);
+
+	NODE root;
+	root.leftChild = -1;
+	root.firstObject = 0;
+	root.objectCount = count;
+	root.parent = -1;
+	m_nodes.push_back(root);
+	FitNode(0);
+
+	pending.push_back(std::make_pair(0, 0));
+	while (false == pending.empty())
+	{
+		int nodeIndex = pending.back().first;
+		int depth = pending.back().second;
+		pending.pop_back();
+
+		if ((depth < MAX_TREE_DEPTH) && SplitNode(nodeIndex, centroids))
+		{
+			pending.push_back(std::make_pair(m_nodes[nodeIndex].leftChild, depth + 1));
+			pending.push_back(std::make_pair(m_nodes[nodeIndex].leftChild + 1, depth + 1));
+		}
+		else
+		{
+			const NODE& leaf = m_nodes[nodeIndex];
+			for (int i = 0; i < leaf.objectCount; i++)
+			{
+				m_objectLeaf[m_objectOrder[leaf.firstObject + i]] = nodeIndex;
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  SplitNode()
+ *
+ *  This method is used for splitting a node along the axis
+ *  and position with the lowest surface area heuristic cost.
+ *  The object centroids are sorted into bins along each axis,
+ *  the cost of a split between every pair of neighbouring
+ *  bins is found with one sweep from each side, and the node
+ *  is only split when the best cost is lower than the cost
+ *  of testing all of its objects.
+ ***********************************************************/
+bool BoundingVolumeHierarchy::SplitNode(int nodeIndex, const std::vector<glm::vec3>& centroids)
+{
+	NODE node = m_nodes[nodeIndex];
+	if (node.objectCount <= MAX_LEAF_SIZE)
+	{
+		return(false);
+	}
+
+	// the bins divide the range of the centroids, which can
+	// be much smaller than the node box
+	glm::vec3 centroidMin(FLT_MAX);
+	glm::vec3 centroidMax(-FLT_MAX);
+	for (int i = 0; i < node.objectCount; i++)
+	{
+		const glm::vec3& centroid = centroids[m_objectOrder[node.firstObject + i]];
+		centroidMin = glm::min(centroidMin, centroid);
+		centroidMax = glm::max(centroidMax, centroid);
+	}
+
+	float bestCost = FLT_MAX;
+	int bestAxis = -1;
+	int bestSplit = 0;
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+		float range = centroidMax[axis] - centroidMin[axis];
+		if (range <= 0.0f)
+		{
+			continue;
+		}
+
+		BIN bins[BIN_COUNT];
+		for (int b = 0; b < BIN_COUNT; b++)
+		{
+			bins[b].boundsMin = glm::vec3(FLT_MAX);
+			bins[b].boundsMax = glm::vec3(-FLT_MAX);
+			bins[b].count = 0;
+		}
+
+		float binScale = (float)BIN_COUNT / range;
+		for (int i = 0; i < node.objectCount; i++)
+		{
+			int object = m_objectOrder[node.firstObject + i];
+			int b = std::min(BIN_COUNT - 1, (int)((centroids[object][axis] - centroidMin[axis]) * binScale));
+			bins[b].count++;
+			GrowBounds(bins[b].boundsMin, bins[b].boundsMax, m_objectMin[object], m_objectMax[object]);
+		}
+
+		// sweep from the left to get the area and count of
+		// everything left of each split, then from the right
+		float leftArea[BIN_COUNT - 1];
+		int leftCount[BIN_COUNT - 1];
+		glm::vec3 sweepMin(FLT_MAX);
+		glm::vec3 sweepMax(-FLT_MAX);
+		int sweepCount = 0;
+		for (int b = 0; b < (BIN_COUNT - 1); b++)
+		{
+			GrowBounds(sweepMin, sweepMax, bins[b].boundsMin, bins[b].boundsMax);
+			sweepCount += bins[b].count;
+			leftArea[b] = SurfaceArea(sweepMin, sweepMax);
+			leftCount[b] = sweepCount;
+		}
+
+		sweepMin = glm::vec3(FLT_MAX);
+		sweepMax = glm::vec3(-FLT_MAX);
+		sweepCount = 0;
+		for (int b = BIN_COUNT - 1; b > 0; b--)
+		{
+			GrowBounds(sweepMin, sweepMax, bins[b].boundsMin, bins[b].boundsMax);
+			sweepCount += bins[b].count;
+
+			int split = b - 1;
+			if ((0 == leftCount[split]) || (0 == sweepCount))
+			{
+				continue;
+			}
+
+			float cost = leftArea[split] * leftCount[split] + SurfaceArea(sweepMin, sweepMax) * sweepCount;
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestAxis = axis;
+				bestSplit = split;
+			}
+		}
+	}
+
+	// compare with the cost of keeping all objects in a leaf,
+	// both relative to the area of this node
+	float nodeArea = SurfaceArea(node.boundsMin, node.boundsMax);
+	float leafCost = INTERSECTION_COST * node.objectCount;
+	if ((bestAxis < 0) ||
+		((nodeArea > 0.0f) && ((TRAVERSAL_COST + INTERSECTION_COST * bestCost / nodeArea) >= leafCost)))
+	{
+		return(false);
+	}
+
+	// move the objects left of the split to the front
+	float binScale = (float)BIN_COUNT / (centroidMax[bestAxis] - centroidMin[bestAxis]);
+	int* pFirst = &m_objectOrder[node.firstObject];
+	int* pMiddle = std::partition(pFirst, pFirst + node.objectCount,
+		[&](int object)
+		{
+			int b = std::min(BIN_COUNT - 1, (int)((centroids[object][bestAxis] - centroidMin[bestAxis]) * binScale));
+			return(b <= bestSplit);
+		});
+	int leftCount = (int)(pMiddle - pFirst);
+
+	NODE child;
+	child.leftChild = -1;
+	child.parent = nodeIndex;
+	child.firstObject = node.firstObject;
+	child.objectCount = leftCount;
+	m_nodes.push_back(child);
+	child.firstObject = node.firstObject + leftCount;
+	child.objectCount = node.objectCount - leftCount;
+	m_nodes.push_back(child);
+
+	int leftChild = (int)m_nodes.size() - 2;
+	m_nodes[nodeIndex].leftChild = leftChild;
+	FitNode(leftChild);
+	FitNode(leftChild + 1);
+
+	return(true);
+}
+
+/***********************************************************
+ *  FitNode()
+ *
+ *  This method is used for setting the box of a node to the
+ *  boxes of its two children, or of its objects for a leaf.
+ ***********************************************************/
+void BoundingVolumeHierarchy::FitNode(int nodeIndex)
+{
+	NODE& node = m_nodes[nodeIndex];
+
+	if (node.leftChild >= 0)
+	{
+		const NODE& left = m_nodes[node.leftChild];
+		const NODE& right = m_nodes[node.leftChild + 1];
+		node.boundsMin = glm::min(left.boundsMin, right.boundsMin);
+		node.boundsMax = glm::max(left.boundsMax, right.boundsMax);
+		return;
+	}
+
+	node.boundsMin = glm::vec3(FLT_MAX);
+	node.boundsMax = glm::vec3(-FLT_MAX);
+	for (int i = 0; i < node.objectCount; i++)
+	{
+		int object = m_objectOrder[node.firstObject + i];
+		GrowBounds(node.boundsMin, node.boundsMax, m_objectMin[object], m_objectMax[object]);
+	}
+}
+
+/***********************************************************
+ *  SetObjectBounds()
+ *
+ *  This method is used for storing the new box of an object
+ *  when many objects move at once and the whole tree is
+ *  refit afterwards.
+ ***********************************************************/
+void BoundingVolumeHierarchy::SetObjectBounds(int object, const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+{
+	m_objectMin[object] = boundsMin;
+	m_objectMax[object] = boundsMax;
+}
+
+/***********************************************************
+ *  Refit()
+ *
+ *  This method is used for updating the boxes of all nodes
+ *  in one backwards pass, which visits the children of every
+ *  node before the node itself.  The tree keeps its shape.
+ ***********************************************************/
+void BoundingVolumeHierarchy::Refit()
+{
+	for (int i = (int)m_nodes.size() - 1; i >= 0; i--)
+	{
+		FitNode(i);
+	}
+}
+
+/***********************************************************
+ *  UpdateObject()
+ *
+ *  This method is used for moving a single object, refitting
+ *  its leaf and then each parent in turn until a node box
+ *  does not change, so a few moving objects cost a few
+ *  nodes each instead of a pass over the whole tree.
+ ***********************************************************/
+void BoundingVolumeHierarchy::UpdateObject(int object, const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+{
+	m_objectMin[object] = boundsMin;
+	m_objectMax[object] = boundsMax;
+	m_updatesSinceBuild++;
+
+	int nodeIndex = m_nodes.empty() ? -1 : m_objectLeaf[object];
+	while (nodeIndex >= 0)
+	{
+		NODE& node = m_nodes[nodeIndex];
+		glm::vec3 oldMin = node.boundsMin;
+		glm::vec3 oldMax = node.boundsMax;
+
+		FitNode(nodeIndex);
+		if ((node.boundsMin == oldMin) && (node.boundsMax == oldMax))
+		{
+			break;
+		}
+		nodeIndex = node.parent;
+	}
+}
+
+/***********************************************************
+ *  NeedsRebuild()
+ *
+ *  This method is used for checking whether so many objects
+ *  were moved one at a time since the last build that the
+ *  node boxes may overlap enough to slow the queries down.
+ ***********************************************************/
+bool BoundingVolumeHierarchy::NeedsRebuild() const
+{
+	return(m_updatesSinceBuild > ((int)m_objectMin.size() / REBUILD_DIVISOR));
+}
+
+/***********************************************************
+ *  QueryFrustum()
+ *
+ *  This method is used for marking the visible objects.  A
+ *  node outside any plane is skipped with all its objects,
+ *  and the planes a node is fully inside are not tested
+ *  again below it, so a node inside all planes marks its
+ *  whole range of objects without any more tests.
+ ***********************************************************/
+int BoundingVolumeHierarchy::QueryFrustum(const glm::vec4 planes[6], uint8_t* pVisible) const
+{
+	const int ALL_PLANES = (1 << PLANE_COUNT) - 1;
+	int nodeStack[MAX_STACK_DEPTH];
+	int maskStack[MAX_STACK_DEPTH];
+	int stackSize = 0;
+	int visibleCount = 0;
+
+	memset(pVisible, 0, m_objectMin.size());
+	if (m_nodes.empty())
+	{
+		return(0);
+	}
+
+	nodeStack[stackSize] = 0;
+	maskStack[stackSize] = ALL_PLANES;
+	stackSize++;
+
+	while (stackSize > 0)
+	{
+		stackSize--;
+		const NODE& node = m_nodes[nodeStack[stackSize]];
+		int planeMask = maskStack[stackSize];
+
+		if (false == ClassifyBox(node.boundsMin, node.boundsMax, planes, planeMask))
+		{
+			continue;
+		}
+
+		if ((0 == planeMask) || (node.leftChild < 0))
+		{
+			for (int i = 0; i < node.objectCount; i++)
+			{
+				int object = m_objectOrder[node.firstObject + i];
+				int objectMask = planeMask;
+
+				if ((0 == planeMask) || ClassifyBox(m_objectMin[object], m_objectMax[object], planes, objectMask))
+				{
+					pVisible[object] = 1;
+					visibleCount++;
+				}
+			}
+			continue;
+		}
+
+		nodeStack[stackSize] = node.leftChild;
+		maskStack[stackSize] = planeMask;
+		stackSize++;
+		nodeStack[stackSize] = node.leftChild + 1;
+		maskStack[stackSize] = planeMask;
+		stackSize++;
+	}
+
+	return(visibleCount);
+}
+
+/***********************************************************
+ *  Raycast()
+ *
+ *  This method is used for finding the first object box a
+ *  ray enters.  The nearer child of each node is visited
+ *  first and nodes that start beyond the closest hit so far
+ *  are skipped.
+ ***********************************************************/
+int BoundingVolumeHierarchy::Raycast(const glm::vec3& origin, const glm::vec3& direction, float& distance) const
+{
+	int nodeStack[MAX_STACK_DEPTH];
+	int stackSize = 0;
+	int hitObject = -1;
+	float closest = distance;
+	float entry = 0.0f;
+	glm::vec3 inverseDirection = 1.0f / direction;
+
+	if (m_nodes.empty() ||
+		(false == RayBoxDistance(origin, inverseDirection, m_nodes[0].boundsMin, m_nodes[0].boundsMax, closest, entry)))
+	{
+		return(-1);
+	}
+
+	nodeStack[stackSize++] = 0;
+
+	while (stackSize > 0)
+	{
+		const NODE& node = m_nodes[nodeStack[--stackSize]];
+
+		if (node.leftChild < 0)
+		{
+			for (int i = 0; i < node.objectCount; i++)
+			{
+				int object = m_objectOrder[node.firstObject + i];
+				float objectDistance = 0.0f;
+
+				if (RayBoxDistance(origin, inverseDirection, m_objectMin[object], m_objectMax[object], closest, objectDistance) &&
+					((hitObject < 0) || (objectDistance < closest)))
+				{
+					closest = objectDistance;
+					hitObject = object;
+				}
+			}
+			continue;
+		}
+
+		float leftDistance = 0.0f;
+		float rightDistance = 0.0f;
+		const NODE& left = m_nodes[node.leftChild];
+		const NODE& right = m_nodes[node.leftChild + 1];
+		bool bHitLeft = RayBoxDistance(origin, inverseDirection, left.boundsMin, left.boundsMax, closest, leftDistance);
+		bool bHitRight = RayBoxDistance(origin, inverseDirection, right.boundsMin, right.boundsMax, closest, rightDistance);
+
+		// push the farther child first so the nearer one is
+		// popped and searched first
+		if (bHitLeft && bHitRight)
+		{
+			bool bLeftFirst = (leftDistance <= rightDistance);
+			nodeStack[stackSize++] = bLeftFirst ? (node.leftChild + 1) : node.leftChild;
+			nodeStack[stackSize++] = bLeftFirst ? node.leftChild : (node.leftChild + 1);
+		}
+		else if (bHitLeft)
+		{
+			nodeStack[stackSize++] = node.leftChild;
+		}
+		else if (bHitRight)
+		{
+			nodeStack[stackSize++] = node.leftChild + 1;
+		}
+	}
+
+	if (hitObject >= 0)
+	{
+		distance = closest;
+	}
+
+	return(hitObject);
+}
+
+/***********************************************************
+ *  QuerySphere()
+ *
+ *  This method is used for collecting the objects whose
+ *  boxes are within the range of a point light or any
+ *  other sphere.
+ ***********************************************************/
+void BoundingVolumeHierarchy::QuerySphere(const glm::vec3& center, float radius, std::vector<int>& objects) const
+{
+	int nodeStack[MAX_STACK_DEPTH];
+	int stackSize = 0;
+
+	if (m_nodes.empty())
+	{
+		return;
+	}
+
+	nodeStack[stackSize++] = 0;
+	while (stackSize > 0)
+	{
+		const NODE& node = m_nodes[nodeStack[--stackSize]];
+
+		if (false == BoxTouchesSphere(node.boundsMin, node.boundsMax, center, radius))
+		{
+			continue;
+		}
+
+		if (node.leftChild < 0)
+		{
+			for (int i = 0; i < node.objectCount; i++)
+			{
+				int object = m_objectOrder[node.firstObject + i];
+				if (BoxTouchesSphere(m_objectMin[object], m_objectMax[object], center, radius))
+				{
+					objects.push_back(object);
+				}
+			}
+			continue;
+		}
+
+		nodeStack[stackSize++] = node.leftChild;
+		nodeStack[stackSize++] = node.leftChild + 1;
+	}
+}
+
+/***********************************************************
+ *  GetObjectCount()
+ *
+ *  This method is used for getting the number of objects.
+ ***********************************************************/
+int BoundingVolumeHierarchy::GetObjectCount() const
+{
+	return((int)m_objectMin.size());
+}
+
+/***********************************************************
+ *  GetNodeCount()
+ *
+ *  This method is used for getting the number of nodes.
+ ***********************************************************/
+int BoundingVolumeHierarchy::GetNodeCount() const
+{
+	return((int)m_nodes.size());
+}
+
+/***********************************************************
+ *  GetTraversalCost()
+ *
+ *  This method is used for getting the surface area
+ *  heuristic cost of the whole tree - the expected number
+ *  of node visits and object tests for a random ray that
+ *  hits the root box.
+ ***********************************************************/
+float BoundingVolumeHierarchy::GetTraversalCost() const
+{
+	if (m_nodes.empty())
+	{
+		return(0.0f);
+	}
+
+	float rootArea = SurfaceArea(m_nodes[0].boundsMin, m_nodes[0].boundsMax);
+	float cost = 0.0f;
+
+	if (rootArea <= 0.0f)
+	{
+		return(0.0f);
+	}
+
+	for (size_t i = 0; i < m_nodes.size(); i++)
+	{
+		const NODE& node = m_nodes[i];
+		float chance = SurfaceArea(node.boundsMin, node.boundsMax) / rootArea;
+
+		cost += chance * ((node.leftChild < 0) ? (INTERSECTION_COST * node.objectCount) : TRAVERSAL_COST);
+	}
+
+	return(cost);
+}
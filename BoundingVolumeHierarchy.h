@@ -0,0 +1,101 @@
+///////////////////////////////////////////////////////////////////////////////
+// boundingvolumehierarchy.h
+// ============
+// tree of bounding boxes over the scene objects for culling and spatial queries
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <stdint.h>
+#include <vector>
+
+/***********************************************************
+ *  BoundingVolumeHierarchy
+ *
+ *  This class builds a binary tree of axis aligned boxes
+ *  over the world-space boxes of the scene objects, so that
+ *  frustum culling, ray picking and light range queries can
+ *  skip whole groups of objects with one box test.
+ *
+ *  The tree is built top down, splitting every node where
+ *  the surface area heuristic estimates the cheapest
+ *  traversal, with the candidate splits evaluated in bins
+ *  along each axis.  When objects move the tree keeps its
+ *  shape and only the boxes are updated - either all nodes
+ *  in one bottom up pass when many objects moved, or only
+ *  the nodes above each moved object when few did.  Once
+ *  enough objects were moved that the tree may have become
+ *  loose, NeedsRebuild() asks for a new build.
+ ***********************************************************/
+class BoundingVolumeHierarchy
+{
+public:
+	// constructor
+	BoundingVolumeHierarchy();
+
+	// one node of the tree - leaves have no children and own
+	// a range of the object order, inner nodes own the range
+	// of all of their leaves, and the right child always
+	// directly follows the left one
+	struct NODE
+	{
+		glm::vec3 boundsMin;
+		glm::vec3 boundsMax;
+		int32_t leftChild;
+		int32_t firstObject;
+		int32_t objectCount;
+		int32_t parent;
+	};
+
+	// build the tree over the passed in object boxes
+	void Build(const glm::vec3* pBoundsMin, const glm::vec3* pBoundsMax, int count);
+	// change the box of an object without updating the tree,
+	// which must be followed by a Refit()
+	void SetObjectBounds(int object, const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+	// update the boxes of all nodes from the object boxes
+	void Refit();
+	// change the box of an object and update only the nodes
+	// above it
+	void UpdateObject(int object, const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+	// check whether enough objects moved since the last build
+	// that the tree should be built again
+	bool NeedsRebuild() const;
+
+	// write 1 for every object whose box is inside the frustum
+	// planes and 0 for the others - returns the number of
+	// visible objects
+	int QueryFrustum(const glm::vec4 planes[6], uint8_t* pVisible) const;
+	// find the object whose box a ray enters first - returns
+	// -1 when no box is hit before the passed in distance,
+	// which is replaced with the distance to the hit
+	int Raycast(const glm::vec3& origin, const glm::vec3& direction, float& distance) const;
+	// add every object whose box touches a sphere to the list
+	void QuerySphere(const glm::vec3& center, float radius, std::vector<int>& objects) const;
+
+	// get the number of objects and nodes in the tree
+	int GetObjectCount() const;
+	int GetNodeCount() const;
+	// get the estimated cost of tracing a ray through the
+	// tree, in box tests - lower is a tighter tree
+	float GetTraversalCost() const;
+
+private:
+	std::vector<NODE> m_nodes;
+	// object indices ordered so every node owns a range
+	std::vector<int> m_objectOrder;
+	// boxes of the objects and the leaf each object is in
+	std::vector<glm::vec3> m_objectMin;
+	std::vector<glm::vec3> m_objectMax;
+	std::vector<int> m_objectLeaf;
+	// number of incremental updates since the last build
+	int m_updatesSinceBuild;
+
+	// split a node in two when that is estimated to be
+	// cheaper than testing its objects - returns false when
+	// the node stays a leaf
+	bool SplitNode(int nodeIndex, const std::vector<glm::vec3>& centroids);
+	// set the box of a node to enclose its children or objects
+	void FitNode(int nodeIndex);
+};
@@ -0,0 +1,166 @@
+///////////////////////////////////////////////////////////////////////////////
+// framedatabuffer.cpp
+// ============
+// per-frame camera and timing data shared by all shader programs
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FrameDataBuffer.h"
+#include "ShaderBindings.h"
+#include "FrameStats.h"
+#include "PersistentRingBuffer.h"
+
+#include <cstring>
+
+// the C++ structure must match the std140 layout of the block
+static_assert(sizeof(FrameDataBuffer::FRAME_DATA) == 160, "FRAME_DATA does not match the std140 FrameData block");
+
+// declaration of global variables
+namespace
+{
+	const char* g_FrameDataBlockName = "FrameData";
+}
+
+/***********************************************************
+ *  FrameDataBuffer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+FrameDataBuffer::FrameDataBuffer()
+{
+	m_bufferID = 0;
+	m_frameData = FRAME_DATA();
+	m_pRingBuffer = NULL;
+	m_bBoundToRing = false;
+}
+
+/***********************************************************
+ *  ~FrameDataBuffer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+FrameDataBuffer::~FrameDataBuffer()
+{
+	DestroyBuffer();
+}
+
+/***********************************************************
+ *  CreateBuffer()
+ *
+ *  This method is used for creating the uniform buffer and
+ *  binding it to the fixed FrameData binding point, where
+ *  it stays bound for the lifetime of the application.
+ ***********************************************************/
+void FrameDataBuffer::CreateBuffer()
+{
+	if (m_bufferID != 0)
+	{
+		return;
+	}
+
+	glGenBuffers(1, &m_bufferID);
+	glBindBuffer(GL_UNIFORM_BUFFER, m_bufferID);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(FRAME_DATA), NULL, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	glBindBufferBase(GL_UNIFORM_BUFFER, UniformBinding::FRAME_DATA, m_bufferID);
+}
+
+/***********************************************************
+ *  DestroyBuffer()
+ *
+ *  This method is used for freeing the uniform buffer.
+ ***********************************************************/
+void FrameDataBuffer::DestroyBuffer()
+{
+	if (m_bufferID != 0)
+	{
+		glDeleteBuffers(1, &m_bufferID);
+		m_bufferID = 0;
+	}
+}
+
+/***********************************************************
+ *  AttachProgram()
+ *
+ *  This method is used for pointing the FrameData block of
+ *  the passed in shader program at the fixed binding point.
+ *  Shaders that do not declare the block are left alone and
+ *  false is returned so the caller can fall back to plain
+ *  uniforms.
+ ***********************************************************/
+bool FrameDataBuffer::AttachProgram(GLuint programID)
+{
+	GLuint blockIndex = GL_INVALID_INDEX;
+
+	blockIndex = glGetUniformBlockIndex(programID, g_FrameDataBlockName);
+	if (blockIndex == GL_INVALID_INDEX)
+	{
+		return(false);
+	}
+
+	glUniformBlockBinding(programID, blockIndex, UniformBinding::FRAME_DATA);
+	return(true);
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used for writing the values of the
+ *  current frame into the buffer with one buffer update.
+ ***********************************************************/
+void FrameDataBuffer::Update(const FRAME_DATA& frameData)
+{
+	m_frameData = frameData;
+
+	if (NULL != m_pRingBuffer)
+	{
+		GLintptr offset = 0;
+		void* pData = m_pRingBuffer->Allocate(sizeof(FRAME_DATA), PersistentRingBuffer::GetUniformAlignment(), offset);
+		if (NULL != pData)
+		{
+			memcpy(pData, &m_frameData, sizeof(FRAME_DATA));
+			glBindBufferRange(GL_UNIFORM_BUFFER, UniformBinding::FRAME_DATA, m_pRingBuffer->GetBufferID(),
+				offset, sizeof(FRAME_DATA));
+			m_bBoundToRing = true;
+			return;
+		}
+	}
+
+	// the ring buffer is full or missing, so go back to
+	// the own buffer
+	if (m_bBoundToRing && (m_bufferID != 0))
+	{
+		glBindBufferBase(GL_UNIFORM_BUFFER, UniformBinding::FRAME_DATA, m_bufferID);
+		m_bBoundToRing = false;
+	}
+
+	if (m_bufferID != 0)
+	{
+		glBindBuffer(GL_UNIFORM_BUFFER, m_bufferID);
+		glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FRAME_DATA), &m_frameData);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+		FrameStats::Current().bufferUploads++;
+	}
+}
+
+/***********************************************************
+ *  SetRingBuffer()
+ *
+ *  This method is used for writing the values of each frame
+ *  into a range of the passed in ring buffer.
+ ***********************************************************/
+void FrameDataBuffer::SetRingBuffer(PersistentRingBuffer* pRingBuffer)
+{
+	m_pRingBuffer = pRingBuffer;
+}
+
+/***********************************************************
+ *  GetFrameData()
+ *
+ *  This method is used for getting the values written for
+ *  the current frame, such as the view and projection.
+ ***********************************************************/
+const FrameDataBuffer::FRAME_DATA& FrameDataBuffer::GetFrameData() const
+{
+	return(m_frameData);
+}
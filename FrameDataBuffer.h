@@ -0,0 +1,84 @@
+///////////////////////////////////////////////////////////////////////////////
+// framedatabuffer.h
+// ============
+// per-frame camera and timing data shared by all shader programs
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+class PersistentRingBuffer;
+
+/***********************************************************
+ *  FrameDataBuffer
+ *
+ *  This class owns a uniform buffer object that holds the
+ *  camera and timing values for the current frame.  It is
+ *  written with a single buffer update per frame and stays
+ *  bound to a fixed binding point, so every shader program
+ *  that declares the block reads it with no extra uploads.
+ *  With a ring buffer attached the values are written into
+ *  the mapped ring instead and the range is bound, so the
+ *  update never waits on the GPU reading the last frame.
+ *
+ *  The matching GLSL declaration is:
+ *
+ *    layout(std140, binding = 0) uniform FrameData
+ *    {
+ *        mat4 view;
+ *        mat4 projection;
+ *        vec4 viewPosition;
+ *        vec2 viewportSize;
+ *        float time;
+ *        float deltaTime;
+ *    };
+ ***********************************************************/
+class FrameDataBuffer
+{
+public:
+	// constructor
+	FrameDataBuffer();
+	// destructor
+	~FrameDataBuffer();
+
+	// std140 image of the FrameData uniform block
+	struct FRAME_DATA
+	{
+		glm::mat4 view;
+		glm::mat4 projection;
+		glm::vec4 viewPosition;
+		glm::vec2 viewportSize;
+		float time;
+		float deltaTime;
+	};
+
+	// create the buffer and bind it to its binding point
+	void CreateBuffer();
+	// free the buffer
+	void DestroyBuffer();
+
+	// connect the FrameData block of a shader program to the
+	// buffer - returns false when the program does not use it
+	bool AttachProgram(GLuint programID);
+
+	// write the values for the current frame into the buffer
+	void Update(const FRAME_DATA& frameData);
+	// write the values into ranges of a ring buffer instead
+	// of the own buffer - NULL goes back to the own buffer
+	void SetRingBuffer(PersistentRingBuffer* pRingBuffer);
+
+	// get the values that were written for the current frame
+	const FRAME_DATA& GetFrameData() const;
+
+private:
+	// OpenGL buffer object name
+	GLuint m_bufferID;
+	// copy of the values written for the current frame
+	FRAME_DATA m_frameData;
+	// optional ring buffer the values are written into
+	PersistentRingBuffer* m_pRingBuffer;
+	// true while the binding point holds a ring buffer range
+	bool m_bBoundToRing;
+};
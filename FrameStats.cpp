@@ -0,0 +1,159 @@
+///////////////////////////////////////////////////////////////////////////////
+// framestats.cpp
+// ============
+// collect per-frame rendering counters and report them periodically
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FrameStats.h"
+
+#include <iostream>
+#include <sstream>
+
+// declaration of global variables
+namespace
+{
+	FrameStats::FRAME_STATS g_CurrentFrame = {};
+	FrameStats::FRAME_STATS g_PreviousFrame = {};
+
+	// time of the last console report, in seconds
+	double g_LastReportTime = 0.0;
+	// number of seconds between console reports
+	const double REPORT_INTERVAL = 1.0;
+
+	// time the last frame was completed, in seconds
+	double g_LastFrameTime = 0.0;
+	// running average milliseconds per frame without and with
+	// the occlusion pass, so turning the pass off and on shows
+	// its net effect on the frame time
+	double g_AverageFrameTime[2] = { 0.0, 0.0 };
+	// weight of the latest frame in the running averages
+	const double FRAME_TIME_WEIGHT = 0.05;
+
+	// short form of the last report shown in the window
+	std::string g_Summary;
+}
+
+/***********************************************************
+ *  Current()
+ *
+ *  This method is used for getting the counters of the
+ *  frame that is currently being rendered.
+ ***********************************************************/
+FrameStats::FRAME_STATS& FrameStats::Current()
+{
+	return(g_CurrentFrame);
+}
+
+/***********************************************************
+ *  Previous()
+ *
+ *  This method is used for getting the counters of the
+ *  last frame that was completely rendered.
+ ***********************************************************/
+const FrameStats::FRAME_STATS& FrameStats::Previous()
+{
+	return(g_PreviousFrame);
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for resetting the counters at the
+ *  start of every rendered frame.
+ ***********************************************************/
+void FrameStats::BeginFrame()
+{
+	g_CurrentFrame = FRAME_STATS();
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used for saving the counters of the
+ *  completed frame and writing them to the console once
+ *  the report interval has passed.  The frame time, the
+ *  culled and occluded objects and the occlusion win are
+ *  also kept as a summary the caller can put on screen.
+ ***********************************************************/
+bool FrameStats::EndFrame(double currentTime)
+{
+	g_PreviousFrame = g_CurrentFrame;
+
+	if (g_LastFrameTime > 0.0)
+	{
+		double frameTime = (currentTime - g_LastFrameTime) * 1000.0;
+		double& average = g_AverageFrameTime[(g_PreviousFrame.occlusionPasses > 0) ? 1 : 0];
+
+		average = (0.0 == average) ? frameTime : (average + (frameTime - average) * FRAME_TIME_WEIGHT);
+	}
+	g_LastFrameTime = currentTime;
+
+	if ((currentTime - g_LastReportTime) >= REPORT_INTERVAL)
+	{
+		std::ostringstream summary;
+
+		g_LastReportTime = currentTime;
+
+		std::cout << "INFO: Frame stats - uniform name lookups:" << g_PreviousFrame.uniformNameLookups
+			<< ", uniforms issued:" << g_PreviousFrame.uniformUploads
+			<< ", uniforms suppressed:" << g_PreviousFrame.uniformsSuppressed
+			<< ", state issued:" << g_PreviousFrame.stateChangesIssued
+			<< ", state suppressed:" << g_PreviousFrame.stateChangesSuppressed
+			<< ", buffer uploads:" << g_PreviousFrame.bufferUploads
+			<< ", matrices rebuilt:" << g_PreviousFrame.matricesRebuilt
+			<< ", draw state changes unsorted:" << g_PreviousFrame.drawStateChangesUnsorted
+			<< ", submitted:" << g_PreviousFrame.drawStateChangesSubmitted
+			<< ", draw calls:" << g_PreviousFrame.drawCalls
+			<< ", ring stalls:" << g_PreviousFrame.ringBufferStalls
+			<< ", ring overflows:" << g_PreviousFrame.ringBufferOverflows
+			<< ", objects culled:" << g_PreviousFrame.objectsCulled
+			<< ", submitted:" << g_PreviousFrame.objectsSubmitted
+			<< ", occluders:" << g_PreviousFrame.occludersDrawn
+			<< ", occluded:" << g_PreviousFrame.objectsOccluded
+			<< ", occlusion ms:" << g_PreviousFrame.occlusionMilliseconds
+			<< ", triangles:" << g_PreviousFrame.trianglesDrawn
+			<< ", at full detail:" << g_PreviousFrame.trianglesFullDetail
+			<< ", threads:" << g_PreviousFrame.recordThreads
+			<< ", record ms:" << g_PreviousFrame.recordMilliseconds
+			<< ", submit ms:" << g_PreviousFrame.submitMilliseconds;
+
+		// the net win can only be shown once frames were
+		// measured both with and without the occlusion pass
+		if ((g_AverageFrameTime[0] > 0.0) && (g_AverageFrameTime[1] > 0.0))
+		{
+			std::cout << ", frame ms occlusion on:" << g_AverageFrameTime[1]
+				<< ", off:" << g_AverageFrameTime[0]
+				<< ", win:" << (g_AverageFrameTime[0] - g_AverageFrameTime[1]);
+		}
+		std::cout << std::endl;
+
+		summary.setf(std::ios::fixed);
+		summary.precision(2);
+		summary << g_AverageFrameTime[(g_PreviousFrame.occlusionPasses > 0) ? 1 : 0] << " ms"
+			<< " | draws " << g_PreviousFrame.drawCalls
+			<< " | culled " << g_PreviousFrame.objectsCulled
+			<< " | occluded " << g_PreviousFrame.objectsOccluded;
+		if ((g_AverageFrameTime[0] > 0.0) && (g_AverageFrameTime[1] > 0.0))
+		{
+			summary << " | occlusion win " << (g_AverageFrameTime[0] - g_AverageFrameTime[1]) << " ms";
+		}
+		g_Summary = summary.str();
+
+		return(true);
+	}
+
+	return(false);
+}
+
+/***********************************************************
+ *  GetSummary()
+ *
+ *  This method is used for getting the one line summary of
+ *  the last report - the frame time, draw calls, culled and
+ *  occluded objects, and the frame time the occlusion pass
+ *  wins once frames were measured with it on and off.
+ ***********************************************************/
+const std::string& FrameStats::GetSummary()
+{
+	return(g_Summary);
+}
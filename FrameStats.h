@@ -0,0 +1,86 @@
+///////////////////////////////////////////////////////////////////////////////
+// framestats.h
+// ============
+// collect per-frame rendering counters and report them periodically
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+
+/***********************************************************
+ *  FrameStats
+ *
+ *  This class holds the counters that are gathered while a
+ *  single frame is rendered.  The counters are reset at the
+ *  start of every frame and the values of the last completed
+ *  frame are written to the console about once per second,
+ *  along with a short summary for display in the window.
+ ***********************************************************/
+class FrameStats
+{
+public:
+	struct FRAME_STATS
+	{
+		// number of uniform locations looked up by name
+		unsigned int uniformNameLookups;
+		// number of uniform values sent to the shader
+		unsigned int uniformUploads;
+		// number of repeated uniform values that were dropped
+		unsigned int uniformsSuppressed;
+		// number of GL state changes sent to the driver
+		unsigned int stateChangesIssued;
+		// number of repeated GL state changes that were dropped
+		unsigned int stateChangesSuppressed;
+		// number of buffer object updates
+		unsigned int bufferUploads;
+		// number of object world matrices that were rebuilt
+		unsigned int matricesRebuilt;
+		// number of program, mesh, texture and material changes
+		// between draws in authoring order and as submitted
+		unsigned int drawStateChangesUnsorted;
+		unsigned int drawStateChangesSubmitted;
+		// number of draw calls, counting an instanced draw once
+		unsigned int drawCalls;
+		// number of times the CPU waited for the GPU to finish
+		// reading a ring buffer region
+		unsigned int ringBufferStalls;
+		// number of frames whose ring buffer region was too small
+		unsigned int ringBufferOverflows;
+		// number of objects outside the view frustum and the
+		// number that were passed on to be drawn
+		unsigned int objectsCulled;
+		unsigned int objectsSubmitted;
+		// number of occluders drawn into the depth pyramid, the
+		// number of objects hidden behind them and the number
+		// of occlusion passes, which is 0 when it is disabled
+		unsigned int occludersDrawn;
+		unsigned int objectsOccluded;
+		unsigned int occlusionPasses;
+		// milliseconds spent in the occlusion pass
+		double occlusionMilliseconds;
+		// number of triangles drawn, and the number that would
+		// have been drawn with every shape at full detail
+		unsigned int trianglesDrawn;
+		unsigned int trianglesFullDetail;
+		// number of threads the frame was recorded on, and the
+		// milliseconds spent recording the draw commands and
+		// submitting them to GL
+		unsigned int recordThreads;
+		double recordMilliseconds;
+		double submitMilliseconds;
+	};
+
+	// get the counters for the frame being rendered
+	static FRAME_STATS& Current();
+	// get the counters of the last completed frame
+	static const FRAME_STATS& Previous();
+
+	// reset the counters at the start of a frame
+	static void BeginFrame();
+	// close out the counters at the end of a frame - returns
+	// true when a new report was written
+	static bool EndFrame(double currentTime);
+	// get the one line summary of the last report
+	static const std::string& GetSummary();
+};
@@ -0,0 +1,386 @@
+///////////////////////////////////////////////////////////////////////////////
+// frustumculler.cpp
+// ============
+// test many world-space bounding boxes against the view frustum at once
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FrustumCuller.h"
+
+#include <cmath>
+
+// select the widest instruction set the code is compiled for
+#if defined(__AVX2__)
+#define FRUSTUM_CULLER_AVX2
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define FRUSTUM_CULLER_SSE2
+#endif
+
+#if defined(FRUSTUM_CULLER_AVX2) || defined(FRUSTUM_CULLER_SSE2)
+#include <immintrin.h>
+#endif
+
+// declaration of global variables
+namespace
+{
+	const int PLANE_COUNT = 6;
+
+	/***********************************************************
+	 *  IsBoxVisible()
+	 *
+	 *  This function is used for testing one box against the
+	 *  frustum planes.  The box is outside a plane when its
+	 *  center is further behind the plane than the projection
+	 *  of the half size onto the plane normal.
+	 ***********************************************************/
+	inline bool IsBoxVisible(
+		float centerX, float centerY, float centerZ,
+		float extentX, float extentY, float extentZ,
+		const glm::vec4 planes[PLANE_COUNT])
+	{
+		for (int p = 0; p < PLANE_COUNT; p++)
+		{
+			const glm::vec4& plane = planes[p];
+			// summed in the same order as the SIMD kernels
+			float distance = (plane.x * centerX + plane.y * centerY) + (plane.z * centerZ + plane.w);
+			float radius = (std::fabs(plane.x) * extentX + std::fabs(plane.y) * extentY) + std::fabs(plane.z) * extentZ;
+
+			if ((distance + radius) < 0.0f)
+			{
+				return(false);
+			}
+		}
+
+		return(true);
+	}
+
+#if defined(FRUSTUM_CULLER_AVX2)
+	// AVX2 operations on 8 floats at a time
+	struct SIMD_AVX2
+	{
+		typedef __m256 Float;
+		static const int WIDTH = 8;
+
+		static inline Float Zero() { return _mm256_setzero_ps(); }
+		static inline Float Set1(float value) { return _mm256_set1_ps(value); }
+		static inline Float Load(const float* pValues) { return _mm256_loadu_ps(pValues); }
+		static inline Float Add(Float a, Float b) { return _mm256_add_ps(a, b); }
+		static inline Float Mul(Float a, Float b) { return _mm256_mul_ps(a, b); }
+		static inline Float Or(Float a, Float b) { return _mm256_or_ps(a, b); }
+		static inline Float CmpLt(Float a, Float b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+		static inline int MoveMask(Float value) { return _mm256_movemask_ps(value); }
+	};
+#endif
+
+#if defined(FRUSTUM_CULLER_SSE2)
+	// SSE2 operations on 4 floats at a time
+	struct SIMD_SSE2
+	{
+		typedef __m128 Float;
+		static const int WIDTH = 4;
+
+		static inline Float Zero() { return _mm_setzero_ps(); }
+		static inline Float Set1(float value) { return _mm_set1_ps(value); }
+		static inline Float Load(const float* pValues) { return _mm_loadu_ps(pValues); }
+		static inline Float Add(Float a, Float b) { return _mm_add_ps(a, b); }
+		static inline Float Mul(Float a, Float b) { return _mm_mul_ps(a, b); }
+		static inline Float Or(Float a, Float b) { return _mm_or_ps(a, b); }
+		static inline Float CmpLt(Float a, Float b) { return _mm_cmplt_ps(a, b); }
+		static inline int MoveMask(Float value) { return _mm_movemask_ps(value); }
+	};
+#endif
+
+#if defined(FRUSTUM_CULLER_AVX2) || defined(FRUSTUM_CULLER_SSE2)
+	/***********************************************************
+	 *  CullBoxesSimd()
+	 *
+	 *  This function is used for testing a full SIMD width of
+	 *  boxes against each plane at once.  The plane values and
+	 *  their absolute values are broadcast one time, and the
+	 *  boxes left over at the end are tested one at a time.
+	 ***********************************************************/
+	template <typename SIMD>
+	int CullBoxesSimd(const FrustumCuller::BOUNDS_SOA& bounds, int count, const glm::vec4 planes[PLANE_COUNT], uint8_t* pVisible)
+	{
+		typename SIMD::Float planeX[PLANE_COUNT];
+		typename SIMD::Float planeY[PLANE_COUNT];
+		typename SIMD::Float planeZ[PLANE_COUNT];
+		typename SIMD::Float planeW[PLANE_COUNT];
+		typename SIMD::Float absX[PLANE_COUNT];
+		typename SIMD::Float absY[PLANE_COUNT];
+		typename SIMD::Float absZ[PLANE_COUNT];
+		typename SIMD::Float zero = SIMD::Zero();
+		int visibleCount = 0;
+		int i = 0;
+
+		for (int p = 0; p < PLANE_COUNT; p++)
+		{
+			planeX[p] = SIMD::Set1(planes[p].x);
+			planeY[p] = SIMD::Set1(planes[p].y);
+			planeZ[p] = SIMD::Set1(planes[p].z);
+			planeW[p] = SIMD::Set1(planes[p].w);
+			absX[p] = SIMD::Set1(std::fabs(planes[p].x));
+			absY[p] = SIMD::Set1(std::fabs(planes[p].y));
+			absZ[p] = SIMD::Set1(std::fabs(planes[p].z));
+		}
+
+		for (; (i + SIMD::WIDTH) <= count; i += SIMD::WIDTH)
+		{
+			typename SIMD::Float centerX = SIMD::Load(bounds.centerX + i);
+			typename SIMD::Float centerY = SIMD::Load(bounds.centerY + i);
+			typename SIMD::Float centerZ = SIMD::Load(bounds.centerZ + i);
+			typename SIMD::Float extentX = SIMD::Load(bounds.extentX + i);
+			typename SIMD::Float extentY = SIMD::Load(bounds.extentY + i);
+			typename SIMD::Float extentZ = SIMD::Load(bounds.extentZ + i);
+			typename SIMD::Float outside = zero;
+
+			for (int p = 0; p < PLANE_COUNT; p++)
+			{
+				typename SIMD::Float distance = SIMD::Add(
+					SIMD::Add(SIMD::Mul(planeX[p], centerX), SIMD::Mul(planeY[p], centerY)),
+					SIMD::Add(SIMD::Mul(planeZ[p], centerZ), planeW[p]));
+				typename SIMD::Float radius = SIMD::Add(
+					SIMD::Add(SIMD::Mul(absX[p], extentX), SIMD::Mul(absY[p], extentY)),
+					SIMD::Mul(absZ[p], extentZ));
+
+				outside = SIMD::Or(outside, SIMD::CmpLt(SIMD::Add(distance, radius), zero));
+			}
+
+			int outsideMask = SIMD::MoveMask(outside);
+			for (int lane = 0; lane < SIMD::WIDTH; lane++)
+			{
+				uint8_t bVisible = (uint8_t)(((outsideMask >> lane) & 1) ^ 1);
+				pVisible[i + lane] = bVisible;
+				visibleCount += bVisible;
+			}
+		}
+
+		for (; i < count; i++)
+		{
+			pVisible[i] = IsBoxVisible(
+				bounds.centerX[i], bounds.centerY[i], bounds.centerZ[i],
+				bounds.extentX[i], bounds.extentY[i], bounds.extentZ[i], planes) ? 1 : 0;
+			visibleCount += pVisible[i];
+		}
+
+		return(visibleCount);
+	}
+#endif
+}
+
+/***********************************************************
+ *  FrustumCuller()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+FrustumCuller::FrustumCuller()
+{
+}
+
+/***********************************************************
+ *  Resize()
+ *
+ *  This method is used for setting the number of boxes.
+ ***********************************************************/
+void FrustumCuller::Resize(int count)
+{
+	m_centerX.resize(count, 0.0f);
+	m_centerY.resize(count, 0.0f);
+	m_centerZ.resize(count, 0.0f);
+	m_extentX.resize(count, 0.0f);
+	m_extentY.resize(count, 0.0f);
+	m_extentZ.resize(count, 0.0f);
+}
+
+/***********************************************************
+ *  GetCount()
+ *
+ *  This method is used for getting the number of boxes.
+ ***********************************************************/
+int FrustumCuller::GetCount() const
+{
+	return((int)m_centerX.size());
+}
+
+/***********************************************************
+ *  SetBounds()
+ *
+ *  This method is used for setting the box of one object
+ *  from its world-space center and half size.
+ ***********************************************************/
+void FrustumCuller::SetBounds(int index, const glm::vec3& center, const glm::vec3& extent)
+{
+	m_centerX[index] = center.x;
+	m_centerY[index] = center.y;
+	m_centerZ[index] = center.z;
+	m_extentX[index] = extent.x;
+	m_extentY[index] = extent.y;
+	m_extentZ[index] = extent.z;
+}
+
+/***********************************************************
+ *  SetBounds()
+ *
+ *  This method is used for setting the box of one object to
+ *  the smallest world-space box around its local box.  The
+ *  center is moved by the model matrix and each world half
+ *  size is the sum of the local half sizes scaled by the
+ *  absolute values of the matching matrix row, which covers
+ *  any rotation and scale.
+ ***********************************************************/
+void FrustumCuller::SetBounds(int index, const glm::mat4& world, const glm::vec3& localCenter, const glm::vec3& localExtent)
+{
+	glm::vec3 center = glm::vec3(world * glm::vec4(localCenter, 1.0f));
+	glm::vec3 extent;
+
+	for (int row = 0; row < 3; row++)
+	{
+		extent[row] =
+			std::fabs(world[0][row]) * localExtent.x +
+			std::fabs(world[1][row]) * localExtent.y +
+			std::fabs(world[2][row]) * localExtent.z;
+	}
+
+	SetBounds(index, center, extent);
+}
+
+/***********************************************************
+ *  GetBounds()
+ *
+ *  This method is used for getting the world-space center
+ *  and half size of the box of one object.
+ ***********************************************************/
+void FrustumCuller::GetBounds(int index, glm::vec3& center, glm::vec3& extent) const
+{
+	center = glm::vec3(m_centerX[index], m_centerY[index], m_centerZ[index]);
+	extent = glm::vec3(m_extentX[index], m_extentY[index], m_extentZ[index]);
+}
+
+/***********************************************************
+ *  Cull()
+ *
+ *  This method is used for testing every box against the
+ *  frustum of a view projection matrix.
+ ***********************************************************/
+int FrustumCuller::Cull(const glm::mat4& viewProjection, uint8_t* pVisible) const
+{
+	return(Cull(viewProjection, 0, GetCount(), pVisible));
+}
+
+/***********************************************************
+ *  Cull()
+ *
+ *  This method is used for testing part of the boxes, so
+ *  the test can be split between threads.
+ ***********************************************************/
+int FrustumCuller::Cull(const glm::mat4& viewProjection, int first, int count, uint8_t* pVisible) const
+{
+	glm::vec4 planes[PLANE_COUNT];
+	BOUNDS_SOA bounds;
+
+	if (count <= 0)
+	{
+		return(0);
+	}
+
+	ExtractPlanes(viewProjection, planes);
+	bounds.centerX = m_centerX.data() + first;
+	bounds.centerY = m_centerY.data() + first;
+	bounds.centerZ = m_centerZ.data() + first;
+	bounds.extentX = m_extentX.data() + first;
+	bounds.extentY = m_extentY.data() + first;
+	bounds.extentZ = m_extentZ.data() + first;
+
+	return(CullBoxes(bounds, count, planes, pVisible + first));
+}
+
+/***********************************************************
+ *  ExtractPlanes()
+ *
+ *  This method is used for getting the left, right, bottom,
+ *  top, near and far planes of the frustum from the rows of
+ *  the view projection matrix.  A point is inside a plane
+ *  when dot(plane.xyz, point) + plane.w is not negative.
+ ***********************************************************/
+void FrustumCuller::ExtractPlanes(const glm::mat4& viewProjection, glm::vec4 planes[6])
+{
+	// glm stores columns, so a row is gathered across them
+	glm::vec4 rows[4];
+	for (int row = 0; row < 4; row++)
+	{
+		rows[row] = glm::vec4(viewProjection[0][row], viewProjection[1][row],
+			viewProjection[2][row], viewProjection[3][row]);
+	}
+
+	// clip space is inside where -w <= x, y, z <= w
+	planes[0] = rows[3] + rows[0];
+	planes[1] = rows[3] - rows[0];
+	planes[2] = rows[3] + rows[1];
+	planes[3] = rows[3] - rows[1];
+	planes[4] = rows[3] + rows[2];
+	planes[5] = rows[3] - rows[2];
+
+	for (int p = 0; p < PLANE_COUNT; p++)
+	{
+		float length = glm::length(glm::vec3(planes[p]));
+		if (length > 0.0f)
+		{
+			planes[p] /= length;
+		}
+	}
+}
+
+/***********************************************************
+ *  CullBoxes()
+ *
+ *  This method is used for testing boxes from structure-of-
+ *  arrays input with the widest SIMD kernel the code was
+ *  compiled for.
+ ***********************************************************/
+int FrustumCuller::CullBoxes(const BOUNDS_SOA& bounds, int count, const glm::vec4 planes[6], uint8_t* pVisible)
+{
+#if defined(FRUSTUM_CULLER_AVX2)
+	return(CullBoxesSimd<SIMD_AVX2>(bounds, count, planes, pVisible));
+#elif defined(FRUSTUM_CULLER_SSE2)
+	return(CullBoxesSimd<SIMD_SSE2>(bounds, count, planes, pVisible));
+#else
+	return(CullBoxesScalar(bounds, count, planes, pVisible));
+#endif
+}
+
+/***********************************************************
+ *  CullBoxesScalar()
+ *
+ *  This method is used for testing boxes one at a time.
+ ***********************************************************/
+int FrustumCuller::CullBoxesScalar(const BOUNDS_SOA& bounds, int count, const glm::vec4 planes[6], uint8_t* pVisible)
+{
+	int visibleCount = 0;
+
+	for (int i = 0; i < count; i++)
+	{
+		pVisible[i] = IsBoxVisible(
+			bounds.centerX[i], bounds.centerY[i], bounds.centerZ[i],
+			bounds.extentX[i], bounds.extentY[i], bounds.extentZ[i], planes) ? 1 : 0;
+		visibleCount += pVisible[i];
+	}
+
+	return(visibleCount);
+}
+
+/***********************************************************
+ *  GetKernelName()
+ *
+ *  This method is used for getting the name of the kernel
+ *  that CullBoxes uses, for benchmark reports.
+ ***********************************************************/
+const char* FrustumCuller::GetKernelName()
+{
+#if defined(FRUSTUM_CULLER_AVX2)
+	return("AVX2 x8");
+#elif defined(FRUSTUM_CULLER_SSE2)
+	return("SSE2 x4");
+#else
+	return("scalar");
+#endif
+}
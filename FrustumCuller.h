@@ -0,0 +1,82 @@
+///////////////////////////////////////////////////////////////////////////////
+// frustumculler.h
+// ============
+// test many world-space bounding boxes against the view frustum at once
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <stdint.h>
+#include <vector>
+
+/***********************************************************
+ *  FrustumCuller
+ *
+ *  This class keeps the world-space axis aligned bounding
+ *  box of every scene object as a center and a half size,
+ *  with one array per component, and tests all of them
+ *  against the six planes of the view frustum.  A box is
+ *  culled when it lies completely behind any one plane.
+ *  The test runs on 4 or 8 boxes per instruction with SSE2
+ *  or AVX2, depending on the instruction set the code is
+ *  compiled for, and can report a box as visible that is
+ *  outside near a frustum corner, but never the reverse.
+ ***********************************************************/
+class FrustumCuller
+{
+public:
+	// constructor
+	FrustumCuller();
+
+	// pointers to the bounding boxes, one array per component
+	struct BOUNDS_SOA
+	{
+		const float* centerX;
+		const float* centerY;
+		const float* centerZ;
+		const float* extentX;
+		const float* extentY;
+		const float* extentZ;
+	};
+
+	// set the number of boxes - new boxes are empty and at
+	// the origin until they are set
+	void Resize(int count);
+	// get the number of boxes
+	int GetCount() const;
+	// set the box of one object from its center and half size
+	void SetBounds(int index, const glm::vec3& center, const glm::vec3& extent);
+	// set the box of one object that encloses a local box
+	// moved into the world by a model matrix
+	void SetBounds(int index, const glm::mat4& world, const glm::vec3& localCenter, const glm::vec3& localExtent);
+	// get the box of one object as its center and half size
+	void GetBounds(int index, glm::vec3& center, glm::vec3& extent) const;
+	// write 1 for every box inside the frustum of a view
+	// projection matrix and 0 for the others - returns the
+	// number of visible boxes
+	int Cull(const glm::mat4& viewProjection, uint8_t* pVisible) const;
+	// test the boxes [first, first + count) only, writing to
+	// the same places of the full visibility array
+	int Cull(const glm::mat4& viewProjection, int first, int count, uint8_t* pVisible) const;
+
+	// get the normalized planes of the frustum of a view
+	// projection matrix, with the normals pointing inside
+	static void ExtractPlanes(const glm::mat4& viewProjection, glm::vec4 planes[6]);
+	// test boxes from structure-of-arrays input with the
+	// fastest kernel available
+	static int CullBoxes(const BOUNDS_SOA& bounds, int count, const glm::vec4 planes[6], uint8_t* pVisible);
+	// test boxes one at a time without SIMD
+	static int CullBoxesScalar(const BOUNDS_SOA& bounds, int count, const glm::vec4 planes[6], uint8_t* pVisible);
+	// get the name of the kernel used by CullBoxes
+	static const char* GetKernelName();
+
+private:
+	std::vector<float> m_centerX;
+	std::vector<float> m_centerY;
+	std::vector<float> m_centerZ;
+	std::vector<float> m_extentX;
+	std::vector<float> m_extentY;
+	std::vector<float> m_extentZ;
+};
@@ -0,0 +1,593 @@
+///////////////////////////////////////////////////////////////////////////////
+// instancedmeshes.cpp
+// ============
+// draw many copies of the basic shape meshes from one shared vertex buffer
+///////////////////////////////////////////////////////////////////////////////
+
+#include "InstancedMeshes.h"
+#include "ShaderBindings.h"
+#include "FrameStats.h"
+
+#include <cstring>
+
+// the attribute offsets below rely on this exact layout
+static_assert(sizeof(InstancedMeshes::INSTANCE_DATA) == 100, "INSTANCE_DATA must match the instance attribute layout");
+// glMultiDrawElementsIndirect reads tightly packed commands
+static_assert(sizeof(InstancedMeshes::DRAW_COMMAND) == 20, "DRAW_COMMAND must match the indirect command layout");
+
+// declaration of global variables
+namespace
+{
+	// segments around and along the curved shapes at each
+	// level of detail, level 0 being the ShapeGeometry default
+	const int g_LodSlices[InstancedMeshes::LOD_COUNT] = { ShapeGeometry::DEFAULT_SLICES, 24, 14, 8 };
+	const int g_LodStacks[InstancedMeshes::LOD_COUNT] = { ShapeGeometry::DEFAULT_STACKS, 12, 8, 5 };
+}
+
+/***********************************************************
+ *  InstancedMeshes()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+InstancedMeshes::InstancedMeshes()
+{
+	memset(m_ranges, 0, sizeof(m_ranges));
+	m_bGeometryChanged = false;
+	m_vao = 0;
+	m_vbo = 0;
+	m_ibo = 0;
+	m_instanceBuffer = 0;
+	m_firstInstance = 0;
+}
+
+/***********************************************************
+ *  ~InstancedMeshes()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+InstancedMeshes::~InstancedMeshes()
+{
+	if (0 != m_vao)
+	{
+		glDeleteVertexArrays(1, &m_vao);
+		glDeleteBuffers(1, &m_vbo);
+		glDeleteBuffers(1, &m_ibo);
+	}
+	m_vao = 0;
+	m_vbo = 0;
+	m_ibo = 0;
+}
+
+/***********************************************************
+ *  LoadMesh()
+ *
+ *  This method is used for appending the generated vertex
+ *  and index data of a level of detail of a shape to the
+ *  shared geometry.  The indices stay relative to the first
+ *  vertex of the shape and the OpenGL buffers are refreshed
+ *  before the next draw.  The levels above the loaded one
+ *  draw the same mesh until they are loaded themselves.
+ ***********************************************************/
+void InstancedMeshes::LoadMesh(SHAPE shape, int lod, const ShapeGeometry::MESH_DATA& mesh)
+{
+	MESH_RANGE range;
+
+	range.firstIndex = (GLuint)m_indices.size();
+	range.indexCount = (GLsizei)mesh.indices.size();
+	range.baseVertex = (GLint)m_vertices.size();
+	for (int level = lod; level < LOD_COUNT; level++)
+	{
+		m_ranges[shape][level] = range;
+	}
+
+	m_vertices.insert(m_vertices.end(), mesh.vertices.begin(), mesh.vertices.end());
+	m_indices.insert(m_indices.end(), mesh.indices.begin(), mesh.indices.end());
+	m_bGeometryChanged = true;
+}
+
+/***********************************************************
+ *  UploadGeometry()
+ *
+ *  This method is used for copying the shared geometry into
+ *  the OpenGL buffers and recording the per-vertex attribute
+ *  layout in the vertex array object.
+ ***********************************************************/
+void InstancedMeshes::UploadGeometry()
+{
+	GLsizei stride = sizeof(ShapeGeometry::VERTEX);
+
+	if (0 == m_vao)
+	{
+		glGenVertexArrays(1, &m_vao);
+		glGenBuffers(1, &m_vbo);
+		glGenBuffers(1, &m_ibo);
+	}
+
+	glBindVertexArray(m_vao);
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+	glBufferData(GL_ARRAY_BUFFER, m_vertices.size() * sizeof(ShapeGeometry::VERTEX), m_vertices.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ibo);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_indices.size() * sizeof(uint32_t), m_indices.data(), GL_STATIC_DRAW);
+
+	glEnableVertexAttribArray(VertexAttribute::POSITION);
+	glVertexAttribPointer(VertexAttribute::POSITION, 3, GL_FLOAT, GL_FALSE, stride,
+		(const void*)offsetof(ShapeGeometry::VERTEX, position));
+	glEnableVertexAttribArray(VertexAttribute::NORMAL);
+	glVertexAttribPointer(VertexAttribute::NORMAL, 3, GL_FLOAT, GL_FALSE, stride,
+		(const void*)offsetof(ShapeGeometry::VERTEX, normal));
+	glEnableVertexAttribArray(VertexAttribute::TEXTURE_COORDINATE);
+	glVertexAttribPointer(VertexAttribute::TEXTURE_COORDINATE, 2, GL_FLOAT, GL_FALSE, stride,
+		(const void*)offsetof(ShapeGeometry::VERTEX, textureCoordinate));
+
+	glBindVertexArray(0);
+
+	FrameStats::Current().bufferUploads += 2;
+	m_bGeometryChanged = false;
+	// the instance attributes have to be pointed again
+	m_instanceBuffer = 0;
+}
+
+/***********************************************************
+ *  BindVertexArray()
+ *
+ *  This method is used for binding the shared vertex array
+ *  object with its per-instance attributes pointing at an
+ *  instance buffer, starting at the passed in instance.  The
+ *  attributes are only pointed again when they would read
+ *  from a different place.
+ ***********************************************************/
+bool InstancedMeshes::BindVertexArray(GLuint instanceBuffer, int firstInstance)
+{
+	if (m_bGeometryChanged)
+	{
+		UploadGeometry();
+	}
+	if (0 == m_vao)
+	{
+		return(false);
+	}
+
+	glBindVertexArray(m_vao);
+	if ((m_instanceBuffer == instanceBuffer) && (m_firstInstance == firstInstance))
+	{
+		return(true);
+	}
+
+	GLsizei stride = sizeof(INSTANCE_DATA);
+	size_t baseOffset = (size_t)firstInstance * sizeof(INSTANCE_DATA);
+
+	glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+
+	// a mat4 attribute is read as four vec4 columns
+	for (unsigned int column = 0; column < 4; column++)
+	{
+		GLuint location = VertexAttribute::INSTANCE_MODEL + column;
+		glEnableVertexAttribArray(location);
+		glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, stride,
+			(const void*)(baseOffset + offsetof(INSTANCE_DATA, model) + column * sizeof(glm::vec4)));
+		glVertexAttribDivisor(location, 1);
+	}
+
+	glEnableVertexAttribArray(VertexAttribute::INSTANCE_COLOR);
+	glVertexAttribPointer(VertexAttribute::INSTANCE_COLOR, 4, GL_FLOAT, GL_FALSE, stride,
+		(const void*)(baseOffset + offsetof(INSTANCE_DATA, color)));
+	glVertexAttribDivisor(VertexAttribute::INSTANCE_COLOR, 1);
+
+	glEnableVertexAttribArray(VertexAttribute::INSTANCE_UV_SCALE);
+	glVertexAttribPointer(VertexAttribute::INSTANCE_UV_SCALE, 2, GL_FLOAT, GL_FALSE, stride,
+		(const void*)(baseOffset + offsetof(INSTANCE_DATA, UVscale)));
+	glVertexAttribDivisor(VertexAttribute::INSTANCE_UV_SCALE, 1);
+
+	// integer attributes need the I variant to skip the
+	// conversion to float
+	glEnableVertexAttribArray(VertexAttribute::INSTANCE_MATERIAL_INDEX);
+	glVertexAttribIPointer(VertexAttribute::INSTANCE_MATERIAL_INDEX, 1, GL_INT, stride,
+		(const void*)(baseOffset + offsetof(INSTANCE_DATA, materialIndex)));
+	glVertexAttribDivisor(VertexAttribute::INSTANCE_MATERIAL_INDEX, 1);
+
+	glEnableVertexAttribArray(VertexAttribute::INSTANCE_TEXTURE_LAYER);
+	glVertexAttribIPointer(VertexAttribute::INSTANCE_TEXTURE_LAYER, 1, GL_INT, stride,
+		(const void*)(baseOffset + offsetof(INSTANCE_DATA, textureLayer)));
+	glVertexAttribDivisor(VertexAttribute::INSTANCE_TEXTURE_LAYER, 1);
+
+	glEnableVertexAttribArray(VertexAttribute::INSTANCE_OBJECT_INDEX);
+	glVertexAttribIPointer(VertexAttribute::INSTANCE_OBJECT_INDEX, 1, GL_INT, stride,
+		(const void*)(baseOffset + offsetof(INSTANCE_DATA, objectIndex)));
+	glVertexAttribDivisor(VertexAttribute::INSTANCE_OBJECT_INDEX, 1);
+
+	m_instanceBuffer = instanceBuffer;
+	m_firstInstance = firstInstance;
+
+	return(true);
+}
+
+/***********************************************************
+ *  DrawMeshInstanced()
+ *
+ *  This method is used for drawing a range of instances of a
+ *  loaded shape at a level of detail.  With OpenGL 4.2 the
+ *  range start is passed as the base instance, otherwise the
+ *  attribute offsets are moved to it.
+ ***********************************************************/
+void InstancedMeshes::DrawMeshInstanced(SHAPE shape, int lod, GLuint instanceBuffer, int instanceCount, int firstInstance)
+{
+	const MESH_RANGE& range = m_ranges[shape][lod];
+	bool bBaseInstance = (GLEW_VERSION_4_2 != 0);
+
+	if ((0 == range.indexCount) || (instanceCount <= 0))
+	{
+		return;
+	}
+	if (false == BindVertexArray(instanceBuffer, bBaseInstance ? 0 : firstInstance))
+	{
+		return;
+	}
+
+	const void* pFirstIndex = (const void*)((size_t)range.firstIndex * sizeof(uint32_t));
+	if (bBaseInstance)
+	{
+		glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, range.indexCount, GL_UNSIGNED_INT, pFirstIndex,
+			instanceCount, range.baseVertex, (GLuint)firstInstance);
+	}
+	else
+	{
+		glDrawElementsInstancedBaseVertex(GL_TRIANGLES, range.indexCount, GL_UNSIGNED_INT, pFirstIndex,
+			instanceCount, range.baseVertex);
+	}
+	glBindVertexArray(0);
+
+	FrameStats::Current().drawCalls++;
+}
+
+/***********************************************************
+ *  MakeDrawCommand()
+ *
+ *  This method is used for filling in the indirect draw
+ *  command of a range of instances of a loaded shape at a
+ *  level of detail.
+ ***********************************************************/
+bool InstancedMeshes::MakeDrawCommand(SHAPE shape, int lod, int instanceCount, int firstInstance, DRAW_COMMAND& command) const
+{
+	const MESH_RANGE& range = m_ranges[shape][lod];
+
+	if (0 == range.indexCount)
+	{
+		return(false);
+	}
+
+	command.count = (GLuint)range.indexCount;
+	command.instanceCount = (GLuint)instanceCount;
+	command.firstIndex = range.firstIndex;
+	command.baseVertex = range.baseVertex;
+	command.baseInstance = (GLuint)firstInstance;
+
+	return(true);
+}
+
+/***********************************************************
+ *  GetTriangleCount()
+ *
+ *  This method is used for getting the number of triangles
+ *  drawn for one instance of a shape at a level of detail.
+ ***********************************************************/
+int InstancedMeshes::GetTriangleCount(SHAPE shape, int lod) const
+{
+	return((int)m_ranges[shape][lod].indexCount / 3);
+}
+
+/***********************************************************
+ *  DrawIndirect()
+ *
+ *  This method is used for drawing a range of commands from
+ *  an indirect draw buffer with a single call.  The commands
+ *  can draw any mix of shapes since they all live in the
+ *  shared buffers, and each picks its instance data with its
+ *  base instance.
+ ***********************************************************/
+void InstancedMeshes::DrawIndirect(GLuint instanceBuffer, GLuint commandBuffer, int firstCommand, int commandCount)
+{
+	if ((commandCount <= 0) || (false == IsIndirectSupported()))
+	{
+		return;
+	}
+	if (false == BindVertexArray(instanceBuffer, 0))
+	{
+		return;
+	}
+
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+	glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+		(const void*)((size_t)firstCommand * sizeof(DRAW_COMMAND)), commandCount, 0);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	glBindVertexArray(0);
+
+	FrameStats::Current().drawCalls++;
+}
+
+/***********************************************************
+ *  IsIndirectSupported()
+ *
+ *  This method is used for checking whether the context can
+ *  draw from indirect command buffers with base instances.
+ ***********************************************************/
+bool InstancedMeshes::IsIndirectSupported()
+{
+	return((GLEW_VERSION_4_3 != 0) || (GLEW_ARB_multi_draw_indirect != 0));
+}
+
+/***********************************************************
+ *  CreateBuffer()
+ *
+ *  This method is used for creating an empty buffer that
+ *  instance data or draw commands are uploaded into.
+ ***********************************************************/
+GLuint InstancedMeshes::CreateBuffer()
+{
+	GLuint bufferID = 0;
+
+	glGenBuffers(1, &bufferID);
+
+	return(bufferID);
+}
+
+/***********************************************************
+ *  UploadBuffer()
+ *
+ *  This method is used for replacing the contents of a
+ *  buffer.  The buffer storage is only reallocated when the
+ *  data no longer fits, with room to grow.
+ ***********************************************************/
+void InstancedMeshes::UploadBuffer(GLenum target, GLuint buffer, int& capacity, const void* pData, int count, size_t elementSize)
+{
+	if ((0 == buffer) || (count <= 0))
+	{
+		return;
+	}
+
+	glBindBuffer(target, buffer);
+	if (count > capacity)
+	{
+		capacity = (capacity > 0) ? capacity : 64;
+		while (capacity < count)
+		{
+			capacity *= 2;
+		}
+		glBufferData(target, (GLsizeiptr)capacity * elementSize, NULL, GL_DYNAMIC_DRAW);
+	}
+	glBufferSubData(target, 0, (GLsizeiptr)count * elementSize, pData);
+	glBindBuffer(target, 0);
+
+	FrameStats::Current().bufferUploads++;
+}
+
+/***********************************************************
+ *  UploadInstances()
+ *
+ *  This method is used for replacing the contents of an
+ *  instance buffer.
+ ***********************************************************/
+void InstancedMeshes::UploadInstances(GLuint instanceBuffer, int& capacity, const INSTANCE_DATA* pInstances, int instanceCount)
+{
+	UploadBuffer(GL_ARRAY_BUFFER, instanceBuffer, capacity, pInstances, instanceCount, sizeof(INSTANCE_DATA));
+}
+
+/***********************************************************
+ *  UploadDrawCommands()
+ *
+ *  This method is used for replacing the contents of an
+ *  indirect draw command buffer.
+ ***********************************************************/
+void InstancedMeshes::UploadDrawCommands(GLuint commandBuffer, int& capacity, const DRAW_COMMAND* pCommands, int commandCount)
+{
+	UploadBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer, capacity, pCommands, commandCount, sizeof(DRAW_COMMAND));
+}
+
+/***********************************************************
+ *  BuildShapeGeometry()
+ *
+ *  This method is used for generating the geometry of a
+ *  shape at a level of detail.  Returns false when the shape
+ *  has no mesh of its own at that level, in which case the
+ *  mesh of the level before is drawn instead.
+ ***********************************************************/
+bool InstancedMeshes::BuildShapeGeometry(SHAPE shape, int lod, ShapeGeometry::MESH_DATA& mesh)
+{
+	if ((lod < 0) || (lod >= LOD_COUNT))
+	{
+		return(false);
+	}
+
+	switch (shape)
+	{
+	case SHAPE_BOX:
+		ShapeGeometry::BuildBox(mesh);
+		return(0 == lod);
+	case SHAPE_PLANE:
+		ShapeGeometry::BuildPlane(mesh);
+		return(0 == lod);
+	case SHAPE_CYLINDER:
+		ShapeGeometry::BuildCylinder(mesh, g_LodSlices[lod]);
+		return(true);
+	case SHAPE_CONE:
+		ShapeGeometry::BuildCone(mesh, g_LodSlices[lod]);
+		return(true);
+	case SHAPE_TAPERED_CYLINDER:
+		ShapeGeometry::BuildTaperedCylinder(mesh, g_LodSlices[lod]);
+		return(true);
+	case SHAPE_SPHERE:
+		ShapeGeometry::BuildSphere(mesh, g_LodSlices[lod], g_LodStacks[lod]);
+		return(true);
+	case SHAPE_TORUS:
+		ShapeGeometry::BuildTorus(mesh, g_LodSlices[lod], g_LodStacks[lod]);
+		return(true);
+	default:
+		return(false);
+	}
+}
+
+/***********************************************************
+ *  LoadShape()
+ *
+ *  This method is used for loading every level of detail a
+ *  shape has a mesh for.
+ ***********************************************************/
+void InstancedMeshes::LoadShape(SHAPE shape)
+{
+	ShapeGeometry::MESH_DATA mesh;
+
+	for (int lod = 0; lod < LOD_COUNT; lod++)
+	{
+		if (BuildShapeGeometry(shape, lod, mesh))
+		{
+			LoadMesh(shape, lod, mesh);
+		}
+	}
+}
+
+/***********************************************************
+ *  LoadBoxMesh()
+ *
+ *  This method is used for loading the box mesh.
+ ***********************************************************/
+void InstancedMeshes::LoadBoxMesh()
+{
+	LoadShape(SHAPE_BOX);
+}
+
+/***********************************************************
+ *  LoadPlaneMesh()
+ *
+ *  This method is used for loading the plane mesh.
+ ***********************************************************/
+void InstancedMeshes::LoadPlaneMesh()
+{
+	LoadShape(SHAPE_PLANE);
+}
+
+/***********************************************************
+ *  LoadCylinderMesh()
+ *
+ *  This method is used for loading the cylinder mesh at
+ *  every level of detail.
+ ***********************************************************/
+void InstancedMeshes::LoadCylinderMesh()
+{
+	LoadShape(SHAPE_CYLINDER);
+}
+
+/***********************************************************
+ *  LoadConeMesh()
+ *
+ *  This method is used for loading the cone mesh at every
+ *  level of detail.
+ ***********************************************************/
+void InstancedMeshes::LoadConeMesh()
+{
+	LoadShape(SHAPE_CONE);
+}
+
+/***********************************************************
+ *  LoadTaperedCylinderMesh()
+ *
+ *  This method is used for loading the tapered cylinder
+ *  mesh at every level of detail.
+ ***********************************************************/
+void InstancedMeshes::LoadTaperedCylinderMesh()
+{
+	LoadShape(SHAPE_TAPERED_CYLINDER);
+}
+
+/***********************************************************
+ *  LoadSphereMesh()
+ *
+ *  This method is used for loading the sphere mesh at every
+ *  level of detail.
+ ***********************************************************/
+void InstancedMeshes::LoadSphereMesh()
+{
+	LoadShape(SHAPE_SPHERE);
+}
+
+/***********************************************************
+ *  LoadTorusMesh()
+ *
+ *  This method is used for loading the torus mesh at every
+ *  level of detail.
+ ***********************************************************/
+void InstancedMeshes::LoadTorusMesh()
+{
+	LoadShape(SHAPE_TORUS);
+}
+
+/***********************************************************
+ *  DrawBoxMeshInstanced()
+ *
+ *  This method is used for drawing instances of the box.
+ ***********************************************************/
+void InstancedMeshes::DrawBoxMeshInstanced(GLuint instanceBuffer, int instanceCount, int firstInstance)
+{
+	DrawMeshInstanced(SHAPE_BOX, 0, instanceBuffer, instanceCount, firstInstance);
+}
+
+/***********************************************************
+ *  DrawPlaneMeshInstanced()
+ *
+ *  This method is used for drawing instances of the plane.
+ ***********************************************************/
+void InstancedMeshes::DrawPlaneMeshInstanced(GLuint instanceBuffer, int instanceCount, int firstInstance)
+{
+	DrawMeshInstanced(SHAPE_PLANE, 0, instanceBuffer, instanceCount, firstInstance);
+}
+
+/***********************************************************
+ *  DrawCylinderMeshInstanced()
+ *
+ *  This method is used for drawing instances of the
+ *  cylinder.
+ ***********************************************************/
+void InstancedMeshes::DrawCylinderMeshInstanced(GLuint instanceBuffer, int instanceCount, int firstInstance)
+{
+	DrawMeshInstanced(SHAPE_CYLINDER, 0, instanceBuffer, instanceCount, firstInstance);
+}
+
+/***********************************************************
+ *  DrawConeMeshInstanced()
+ *
+ *  This method is used for drawing instances of the cone.
+ ***********************************************************/
+void InstancedMeshes::DrawConeMeshInstanced(GLuint instanceBuffer, int instanceCount, int firstInstance)
+{
+	DrawMeshInstanced(SHAPE_CONE, 0, instanceBuffer, instanceCount, firstInstance);
+}
+
+/***********************************************************
+ *  DrawTaperedCylinderMeshInstanced()
+ *
+ *  This method is used for drawing instances of the tapered
+ *  cylinder.
+ ***********************************************************/
+void InstancedMeshes::DrawTaperedCylinderMeshInstanced(GLuint instanceBuffer, int instanceCount, int firstInstance)
+{
+	DrawMeshInstanced(SHAPE_TAPERED_CYLINDER, 0, instanceBuffer, instanceCount, firstInstance);
+}
+
+/***********************************************************
+ *  DrawSphereMeshInstanced()
+ *
+ *  This method is used for drawing instances of the sphere.
+ ***********************************************************/
+void InstancedMeshes::DrawSphereMeshInstanced(GLuint instanceBuffer, int instanceCount, int firstInstance)
+{
+	DrawMeshInstanced(SHAPE_SPHERE, 0, instanceBuffer, instanceCount, firstInstance);
+}
+
+/***********************************************************
+ *  DrawTorusMeshInstanced()
+ *
+ *  This method is used for drawing instances of the torus.
+ ***********************************************************/
+void InstancedMeshes::DrawTorusMeshInstanced(GLuint instanceBuffer, int instanceCount, int firstInstance)
+{
+	DrawMeshInstanced(SHAPE_TORUS, 0, instanceBuffer, instanceCount, firstInstance);
+}
@@ -0,0 +1,176 @@
+///////////////////////////////////////////////////////////////////////////////
+// instancedmeshes.h
+// ============
+// draw many copies of the basic shape meshes from one shared vertex buffer
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShapeGeometry.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  InstancedMeshes
+ *
+ *  This class packs all basic shape meshes into one shared
+ *  vertex buffer and one shared index buffer behind a single
+ *  vertex array object.  The same vertex array object also
+ *  reads per-instance data from a second vertex buffer with
+ *  an attribute divisor of 1, so any number of copies of any
+ *  shape can be drawn without rebinding anything - either
+ *  one shape per call, or every shape in the scene with one
+ *  glMultiDrawElementsIndirect call whose commands select
+ *  their instance data through the base instance.  The
+ *  vertex shader reads
+ *
+ *    layout(location = 3) in mat4 instanceModel;
+ *    layout(location = 7) in vec4 instanceColor;
+ *    layout(location = 8) in vec2 instanceUVscale;
+ *    layout(location = 9) in int instanceMaterialIndex;
+ *    layout(location = 10) in int instanceTextureLayer;
+ *    layout(location = 11) in int instanceObjectIndex;
+ *
+ *  in place of the model, objectColor, UVscale, materialIndex,
+ *  textureLayer and objectIndex uniforms while
+ *  bUseInstanceData is true.  A negative texture layer draws
+ *  the instance untextured, and the object index selects the
+ *  light list of the object - see LightManager.
+ *
+ *  The curved shapes are loaded at LOD_COUNT levels of
+ *  detail, level 0 being the full tessellation and every
+ *  further level using fewer segments around the shape, so
+ *  objects that are small on screen can be drawn with fewer
+ *  triangles.  Flat shapes use the same mesh at every level.
+ ***********************************************************/
+class InstancedMeshes
+{
+public:
+	// constructor
+	InstancedMeshes();
+	// destructor
+	~InstancedMeshes();
+
+	enum SHAPE
+	{
+		SHAPE_BOX,
+		SHAPE_PLANE,
+		SHAPE_CYLINDER,
+		SHAPE_CONE,
+		SHAPE_TAPERED_CYLINDER,
+		SHAPE_SPHERE,
+		SHAPE_TORUS,
+		SHAPE_COUNT
+	};
+
+	// per-instance vertex data, one entry per drawn object
+	struct INSTANCE_DATA
+	{
+		glm::mat4 model;
+		glm::vec4 color;
+		glm::vec2 UVscale;
+		int32_t materialIndex;
+		// layer in the bound texture array, -1 for none
+		int32_t textureLayer;
+		// index of the scene object, for its light list
+		int32_t objectIndex;
+	};
+
+	// layout of one command in an indirect draw buffer
+	struct DRAW_COMMAND
+	{
+		GLuint count;
+		GLuint instanceCount;
+		GLuint firstIndex;
+		GLint baseVertex;
+		GLuint baseInstance;
+	};
+
+	// number of levels of detail loaded for every shape
+	static const int LOD_COUNT = 4;
+
+	// load the shape meshes into the shared buffers
+	void LoadBoxMesh();
+	void LoadPlaneMesh();
+	void LoadCylinderMesh();
+	void LoadConeMesh();
+	void LoadTaperedCylinderMesh();
+	void LoadSphereMesh();
+	void LoadTorusMesh();
+
+	// draw instanceCount copies of a shape mesh with the
+	// instance data starting at firstInstance in the buffer
+	void DrawBoxMeshInstanced(GLuint instanceBuffer, int instanceCount, int firstInstance = 0);
+	void DrawPlaneMeshInstanced(GLuint instanceBuffer, int instanceCount, int firstInstance = 0);
+	void DrawCylinderMeshInstanced(GLuint instanceBuffer, int instanceCount, int firstInstance = 0);
+	void DrawConeMeshInstanced(GLuint instanceBuffer, int instanceCount, int firstInstance = 0);
+	void DrawTaperedCylinderMeshInstanced(GLuint instanceBuffer, int instanceCount, int firstInstance = 0);
+	void DrawSphereMeshInstanced(GLuint instanceBuffer, int instanceCount, int firstInstance = 0);
+	void DrawTorusMeshInstanced(GLuint instanceBuffer, int instanceCount, int firstInstance = 0);
+	void DrawMeshInstanced(SHAPE shape, int lod, GLuint instanceBuffer, int instanceCount, int firstInstance = 0);
+
+	// fill in the indirect command that draws a range of
+	// instances of a shape at a level of detail - returns
+	// false for shapes that were not loaded
+	bool MakeDrawCommand(SHAPE shape, int lod, int instanceCount, int firstInstance, DRAW_COMMAND& command) const;
+	// get the number of triangles of a shape at a level of
+	// detail, 0 when the shape was not loaded
+	int GetTriangleCount(SHAPE shape, int lod) const;
+	// generate the geometry of a shape at a level of detail -
+	// returns false when the level draws the mesh of the
+	// level before
+	static bool BuildShapeGeometry(SHAPE shape, int lod, ShapeGeometry::MESH_DATA& mesh);
+	// draw a range of the commands in an indirect draw buffer
+	// with one call - requires OpenGL 4.3
+	void DrawIndirect(GLuint instanceBuffer, GLuint commandBuffer, int firstCommand, int commandCount);
+	// check whether multi-draw-indirect is available
+	static bool IsIndirectSupported();
+
+	// create a buffer for instance data or draw commands
+	static GLuint CreateBuffer();
+	// replace the contents of an instance buffer, growing it
+	// when needed - the capacity is in instances
+	static void UploadInstances(GLuint instanceBuffer, int& capacity, const INSTANCE_DATA* pInstances, int instanceCount);
+	// replace the contents of a draw command buffer, growing
+	// it when needed - the capacity is in commands
+	static void UploadDrawCommands(GLuint commandBuffer, int& capacity, const DRAW_COMMAND* pCommands, int commandCount);
+
+private:
+	// place of a shape in the shared buffers
+	struct MESH_RANGE
+	{
+		GLuint firstIndex;
+		GLsizei indexCount;
+		GLint baseVertex;
+	};
+
+	MESH_RANGE m_ranges[SHAPE_COUNT][LOD_COUNT];
+	// shared geometry of all loaded shapes
+	std::vector<ShapeGeometry::VERTEX> m_vertices;
+	std::vector<uint32_t> m_indices;
+	bool m_bGeometryChanged;
+
+	GLuint m_vao;
+	GLuint m_vbo;
+	GLuint m_ibo;
+	// instance buffer range the per-instance attributes
+	// point at
+	GLuint m_instanceBuffer;
+	int m_firstInstance;
+
+	// append generated shape data to the shared geometry as
+	// a level of detail of a shape
+	void LoadMesh(SHAPE shape, int lod, const ShapeGeometry::MESH_DATA& mesh);
+	// load every level of detail of a shape
+	void LoadShape(SHAPE shape);
+	// copy the shared geometry into the OpenGL buffers
+	void UploadGeometry();
+	// bind the vertex array object with the per-instance
+	// attributes pointing at a buffer range
+	bool BindVertexArray(GLuint instanceBuffer, int firstInstance);
+	// replace the contents of a buffer, growing it when needed
+	static void UploadBuffer(GLenum target, GLuint buffer, int& capacity, const void* pData, int count, size_t elementSize);
+};
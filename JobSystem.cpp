@@ -0,0 +1,505 @@
+///////////////////////////////////////////////////////////////////////////////
+// jobsystem.cpp
+// ============
+// spread engine work across worker threads that steal jobs from each other
+///////////////////////////////////////////////////////////////////////////////
+
+#include "JobSystem.h"
+
+// declaration of global variables
+namespace
+{
+	// number of jobs ParallelFor() gives every thread when no
+	// grain size is passed in, so threads that finish early
+	// have work left to steal
+	const int JOBS_PER_THREAD = 4;
+
+	// job system and worker index of the calling thread
+	thread_local const JobSystem* g_pWorkerOwner = NULL;
+	thread_local int g_WorkerIndex = -1;
+}
+
+/***********************************************************
+ *  JOB_COUNTER()
+ *
+ *  The constructor for the counter
+ ***********************************************************/
+JobSystem::JOB_COUNTER::JOB_COUNTER()
+	: pending(0)
+{
+}
+
+/***********************************************************
+ *  JobSystem()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+JobSystem::JobSystem(int threadCount)
+	: m_mainThreadId(std::this_thread::get_id()),
+	m_queuedJobs(0),
+	m_queuedBackgroundJobs(0),
+	m_sleepingWorkers(0),
+	m_bStopping(false)
+{
+	if (threadCount <= 0)
+	{
+		threadCount = (int)std::thread::hardware_concurrency();
+	}
+	if (threadCount <= 0)
+	{
+		threadCount = 1;
+	}
+
+	for (int i = 0; i < threadCount; i++)
+	{
+		m_queues.push_back(std::unique_ptr<WORKER_QUEUE>(new WORKER_QUEUE()));
+	}
+
+	g_pWorkerOwner = this;
+	g_WorkerIndex = 0;
+	for (int i = 1; i < threadCount; i++)
+	{
+		m_threads.push_back(std::thread(&JobSystem::WorkerLoop, this, i));
+	}
+}
+
+/***********************************************************
+ *  ~JobSystem()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_bStopping = true;
+	}
+	m_wakeCondition.notify_all();
+
+	for (size_t i = 0; i < m_threads.size(); i++)
+	{
+		m_threads[i].join();
+	}
+
+	if (g_pWorkerOwner == this)
+	{
+		g_pWorkerOwner = NULL;
+		g_WorkerIndex = -1;
+	}
+}
+
+/***********************************************************
+ *  Run()
+ *
+ *  This method is used for adding a job to the queue of the
+ *  calling worker, or of the main thread when it is called
+ *  from a thread that is not a worker.
+ ***********************************************************/
+void JobSystem::Run(const JOB& job, JOB_COUNTER* pCounter)
+{
+	JOB_ENTRY entry;
+	entry.job = job;
+	entry.pCounter = pCounter;
+
+	if (NULL != pCounter)
+	{
+		pCounter->pending++;
+	}
+	Push(entry);
+}
+
+/***********************************************************
+ *  RunAfter()
+ *
+ *  This method is used for adding a job that starts once
+ *  the dependency counter reaches zero.  The job counts
+ *  toward its own counter right away, so waiting on that
+ *  counter also waits for the dependency.
+ ***********************************************************/
+void JobSystem::RunAfter(JOB_COUNTER* pDependency, const JOB& job, JOB_COUNTER* pCounter)
+{
+	if (NULL != pCounter)
+	{
+		pCounter->pending++;
+	}
+
+	if (NULL != pDependency)
+	{
+		std::lock_guard<std::mutex> lock(pDependency->mutex);
+		if (pDependency->pending > 0)
+		{
+			pDependency->continuations.push_back(std::make_pair(job, pCounter));
+			return;
+		}
+	}
+
+	JOB_ENTRY entry;
+	entry.job = job;
+	entry.pCounter = pCounter;
+	Push(entry);
+}
+
+/***********************************************************
+ *  ParallelFor()
+ *
+ *  This method is used for splitting a range of items into
+ *  jobs and waiting for them.  The calling thread runs the
+ *  first part itself and then helps with the rest.
+ ***********************************************************/
+void JobSystem::ParallelFor(int count, int grainSize, const RANGE_JOB& job)
+{
+	if (count <= 0)
+	{
+		return;
+	}
+	if (grainSize <= 0)
+	{
+		int jobCount = GetThreadCount() * JOBS_PER_THREAD;
+		grainSize = (count + jobCount - 1) / jobCount;
+	}
+	if ((count <= grainSize) || (GetThreadCount() == 1))
+	{
+		job(0, count);
+		return;
+	}
+
+	JOB_COUNTER counter;
+	for (int first = grainSize; first < count; first += grainSize)
+	{
+		int rangeCount = ((count - first) < grainSize) ? (count - first) : grainSize;
+		Run([&job, first, rangeCount]() { job(first, rangeCount); }, &counter);
+	}
+
+	job(0, grainSize);
+	Wait(&counter);
+}
+
+/***********************************************************
+ *  Wait()
+ *
+ *  This method is used for running queued jobs, and main
+ *  thread jobs when called on the main thread, until the
+ *  counter reaches zero.
+ ***********************************************************/
+void JobSystem::Wait(JOB_COUNTER* pCounter)
+{
+	int workerIndex = GetWorkerIndex();
+	bool bMainThread = IsMainThread();
+
+	while (pCounter->pending > 0)
+	{
+		JOB_ENTRY entry;
+		if (FindJob(workerIndex, entry))
+		{
+			Execute(entry);
+		}
+		else if ((false == bMainThread) || (0 == ExecuteMainThreadJobs()))
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	// the last job may still hold the counter lock while it
+	// takes the continuations, so wait for it to let go
+	// before the caller is free to destroy the counter
+	std::lock_guard<std::mutex> lock(pCounter->mutex);
+}
+
+/***********************************************************
+ *  RunInBackground()
+ *
+ *  This method is used for queuing a long job for the worker
+ *  threads to run when they have nothing else to do.
+ ***********************************************************/
+void JobSystem::RunInBackground(const JOB& job, JOB_COUNTER* pCounter)
+{
+	if (GetThreadCount() == 1)
+	{
+		RunOnMainThread(job, pCounter);
+		return;
+	}
+
+	JOB_ENTRY entry;
+	entry.job = job;
+	entry.pCounter = pCounter;
+
+	if (NULL != pCounter)
+	{
+		pCounter->pending++;
+	}
+
+	// counted first, like the jobs added by Push()
+	m_queuedBackgroundJobs++;
+	{
+		std::lock_guard<std::mutex> lock(m_backgroundMutex);
+		m_backgroundJobs.push_back(entry);
+	}
+
+	if (m_sleepingWorkers > 0)
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_wakeCondition.notify_one();
+	}
+}
+
+/***********************************************************
+ *  RunOnMainThread()
+ *
+ *  This method is used for queuing a job that makes OpenGL
+ *  calls, or otherwise has to run on the main thread.
+ ***********************************************************/
+void JobSystem::RunOnMainThread(const JOB& job, JOB_COUNTER* pCounter)
+{
+	JOB_ENTRY entry;
+	entry.job = job;
+	entry.pCounter = pCounter;
+
+	if (NULL != pCounter)
+	{
+		pCounter->pending++;
+	}
+
+	std::lock_guard<std::mutex> lock(m_mainThreadMutex);
+	m_mainThreadJobs.push_back(entry);
+}
+
+/***********************************************************
+ *  ExecuteMainThreadJobs()
+ *
+ *  This method is used for running the main thread jobs
+ *  queued so far.  Jobs queued by these jobs wait for the
+ *  next call, so a job that queues itself again cannot hold
+ *  up the frame.
+ ***********************************************************/
+int JobSystem::ExecuteMainThreadJobs()
+{
+	std::vector<JOB_ENTRY> jobs;
+	{
+		std::lock_guard<std::mutex> lock(m_mainThreadMutex);
+		jobs.swap(m_mainThreadJobs);
+	}
+
+	for (size_t i = 0; i < jobs.size(); i++)
+	{
+		Execute(jobs[i]);
+	}
+
+	return((int)jobs.size());
+}
+
+/***********************************************************
+ *  GetThreadCount()
+ *
+ *  This method is used for getting the number of threads
+ *  that run jobs, including the main thread.
+ ***********************************************************/
+int JobSystem::GetThreadCount() const
+{
+	return((int)m_queues.size());
+}
+
+/***********************************************************
+ *  IsMainThread()
+ *
+ *  This method is used for checking whether the calling
+ *  thread is the one that created the job system.
+ ***********************************************************/
+bool JobSystem::IsMainThread() const
+{
+	return(std::this_thread::get_id() == m_mainThreadId);
+}
+
+/***********************************************************
+ *  WorkerLoop()
+ *
+ *  This method is used for running jobs on a worker thread
+ *  until the job system is destroyed.  A worker only goes
+ *  to sleep after it has counted itself as sleeping and then
+ *  still found no queued job, and Push() counts the job
+ *  before it checks for sleeping workers, so a job is never
+ *  left queued with every worker asleep.
+ ***********************************************************/
+void JobSystem::WorkerLoop(int workerIndex)
+{
+	g_pWorkerOwner = this;
+	g_WorkerIndex = workerIndex;
+
+	while (false == m_bStopping)
+	{
+		JOB_ENTRY entry;
+		if (FindJob(workerIndex, entry) || FindBackgroundJob(entry))
+		{
+			Execute(entry);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(m_sleepMutex);
+		m_sleepingWorkers++;
+		m_wakeCondition.wait(lock, [this]()
+		{
+			return(m_bStopping || (m_queuedJobs > 0) || (m_queuedBackgroundJobs > 0));
+		});
+		m_sleepingWorkers--;
+	}
+}
+
+/***********************************************************
+ *  GetWorkerIndex()
+ *
+ *  This method is used for getting the worker index of the
+ *  calling thread in this job system.
+ ***********************************************************/
+int JobSystem::GetWorkerIndex() const
+{
+	return((g_pWorkerOwner == this) ? g_WorkerIndex : -1);
+}
+
+/***********************************************************
+ *  Push()
+ *
+ *  This method is used for adding a job to the back of the
+ *  calling worker's queue and waking a sleeping worker to
+ *  steal it.
+ ***********************************************************/
+void JobSystem::Push(const JOB_ENTRY& entry)
+{
+	int workerIndex = GetWorkerIndex();
+	WORKER_QUEUE& queue = *m_queues[(workerIndex >= 0) ? workerIndex : 0];
+
+	// counted first, so the count is never below the number
+	// of jobs a thief can find
+	m_queuedJobs++;
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.jobs.push_back(entry);
+	}
+
+	if (m_sleepingWorkers > 0)
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_wakeCondition.notify_one();
+	}
+}
+
+/***********************************************************
+ *  FindJob()
+ *
+ *  This method is used for taking the newest job from the
+ *  worker's own queue, or else the oldest job of the first
+ *  other worker that has one, starting after its own.
+ ***********************************************************/
+bool JobSystem::FindJob(int workerIndex, JOB_ENTRY& entry)
+{
+	int queueCount = (int)m_queues.size();
+
+	if (m_queuedJobs <= 0)
+	{
+		return(false);
+	}
+
+	if (workerIndex >= 0)
+	{
+		WORKER_QUEUE& queue = *m_queues[workerIndex];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (false == queue.jobs.empty())
+		{
+			entry = queue.jobs.back();
+			queue.jobs.pop_back();
+			m_queuedJobs--;
+			return(true);
+		}
+	}
+
+	for (int i = 1; i <= queueCount; i++)
+	{
+		int victimIndex = (((workerIndex >= 0) ? workerIndex : 0) + i) % queueCount;
+		if (victimIndex == workerIndex)
+		{
+			continue;
+		}
+
+		WORKER_QUEUE& queue = *m_queues[victimIndex];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (false == queue.jobs.empty())
+		{
+			entry = queue.jobs.front();
+			queue.jobs.pop_front();
+			m_queuedJobs--;
+			return(true);
+		}
+	}
+
+	return(false);
+}
+
+/***********************************************************
+ *  FindBackgroundJob()
+ *
+ *  This method is used for taking the oldest background job,
+ *  so background jobs run in the order they were added.
+ ***********************************************************/
+bool JobSystem::FindBackgroundJob(JOB_ENTRY& entry)
+{
+	if (m_queuedBackgroundJobs <= 0)
+	{
+		return(false);
+	}
+
+	std::lock_guard<std::mutex> lock(m_backgroundMutex);
+	if (m_backgroundJobs.empty())
+	{
+		return(false);
+	}
+
+	entry = m_backgroundJobs.front();
+	m_backgroundJobs.pop_front();
+	m_queuedBackgroundJobs--;
+	return(true);
+}
+
+/***********************************************************
+ *  Execute()
+ *
+ *  This method is used for running a job and counting it
+ *  as finished.
+ ***********************************************************/
+void JobSystem::Execute(JOB_ENTRY& entry)
+{
+	entry.job();
+	entry.job = JOB();
+	Finish(entry.pCounter);
+}
+
+/***********************************************************
+ *  Finish()
+ *
+ *  This method is used for counting a finished job and
+ *  adding the continuations of its counter once the last
+ *  job of the counter is done.  The counter is only touched
+ *  while its lock is held, so a waiter that sees it reach
+ *  zero can destroy it as soon as it gets the lock.
+ ***********************************************************/
+void JobSystem::Finish(JOB_COUNTER* pCounter)
+{
+	if (NULL == pCounter)
+	{
+		return;
+	}
+
+	std::vector<std::pair<JOB, JOB_COUNTER*> > continuations;
+	{
+		std::lock_guard<std::mutex> lock(pCounter->mutex);
+		if (--pCounter->pending == 0)
+		{
+			continuations.swap(pCounter->continuations);
+		}
+	}
+
+	for (size_t i = 0; i < continuations.size(); i++)
+	{
+		JOB_ENTRY entry;
+		entry.job = continuations[i].first;
+		entry.pCounter = continuations[i].second;
+		Push(entry);
+	}
+}
@@ -0,0 +1,147 @@
+///////////////////////////////////////////////////////////////////////////////
+// jobsystem.h
+// ============
+// spread engine work across worker threads that steal jobs from each other
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/***********************************************************
+ *  JobSystem
+ *
+ *  This class runs small jobs on a fixed set of threads.
+ *  The thread that creates the job system is worker 0 and
+ *  the others are started by it.  Every worker has its own
+ *  queue - it adds and takes jobs at the back, so the work
+ *  it just split off stays in its cache, and when its queue
+ *  is empty it steals the oldest job from the front of
+ *  another worker's queue.  Workers with nothing to steal
+ *  sleep until a job is added.
+ *
+ *  Jobs report to an optional JOB_COUNTER, which counts the
+ *  jobs still to finish.  Wait() runs other jobs until a
+ *  counter reaches zero, and RunAfter() holds a job back as
+ *  a continuation until then, so jobs that depend on each
+ *  other are chained without blocking a thread.
+ *
+ *  OpenGL calls may only be made on the thread that owns the
+ *  context, so jobs that need GL are handed to the main
+ *  thread queue with RunOnMainThread() and run there by
+ *  ExecuteMainThreadJobs() once per frame, or while the main
+ *  thread waits on a counter.
+ *
+ *  Long jobs that no frame waits for, like decoding files,
+ *  are added with RunInBackground().  Only the worker threads
+ *  take them, once their own and stolen work runs out, so a
+ *  thread waiting on a counter never picks one up and holds
+ *  up the frame.
+ ***********************************************************/
+class JobSystem
+{
+public:
+	typedef std::function<void()> JOB;
+	// job over the items [first, first + count) of a range
+	typedef std::function<void(int first, int count)> RANGE_JOB;
+
+	// number of jobs of a group still to finish, and the jobs
+	// to start once it reaches zero
+	struct JOB_COUNTER
+	{
+		JOB_COUNTER();
+
+		std::atomic<int> pending;
+		std::mutex mutex;
+		std::vector<std::pair<JOB, JOB_COUNTER*> > continuations;
+	};
+
+	// constructor - the thread count includes the calling
+	// thread, and 0 uses one thread per hardware thread
+	explicit JobSystem(int threadCount);
+	// destructor - stops the workers, dropping queued jobs
+	~JobSystem();
+
+	// add a job to the queue of the calling worker
+	void Run(const JOB& job, JOB_COUNTER* pCounter);
+	// add a job once the dependency counter reaches zero
+	void RunAfter(JOB_COUNTER* pDependency, const JOB& job, JOB_COUNTER* pCounter);
+	// split a range into jobs of about grainSize items, run
+	// them and wait for all of them - a grain size of 0
+	// gives every thread a few jobs
+	void ParallelFor(int count, int grainSize, const RANGE_JOB& job);
+	// run queued jobs until the counter reaches zero
+	void Wait(JOB_COUNTER* pCounter);
+
+	// add a long job that only the worker threads run - with
+	// no worker threads it is run with the main thread jobs
+	void RunInBackground(const JOB& job, JOB_COUNTER* pCounter);
+	// add a job that has to run on the main thread
+	void RunOnMainThread(const JOB& job, JOB_COUNTER* pCounter);
+	// run the main thread jobs queued so far - returns the
+	// number of jobs that were run
+	int ExecuteMainThreadJobs();
+
+	// get the number of threads, including the main thread
+	int GetThreadCount() const;
+	// check whether the calling thread created the job system
+	bool IsMainThread() const;
+
+private:
+	// a queued job and the counter it reports to
+	struct JOB_ENTRY
+	{
+		JOB job;
+		JOB_COUNTER* pCounter;
+	};
+
+	// jobs queued by one worker
+	struct WORKER_QUEUE
+	{
+		std::mutex mutex;
+		std::deque<JOB_ENTRY> jobs;
+	};
+
+	std::vector<std::unique_ptr<WORKER_QUEUE> > m_queues;
+	std::vector<std::thread> m_threads;
+	std::thread::id m_mainThreadId;
+
+	// number of jobs in all worker queues and the number of
+	// workers asleep waiting for one
+	std::atomic<int> m_queuedJobs;
+	std::atomic<int> m_queuedBackgroundJobs;
+	std::atomic<int> m_sleepingWorkers;
+	std::atomic<bool> m_bStopping;
+	std::mutex m_sleepMutex;
+	std::condition_variable m_wakeCondition;
+
+	std::mutex m_mainThreadMutex;
+	std::vector<JOB_ENTRY> m_mainThreadJobs;
+
+	std::mutex m_backgroundMutex;
+	std::deque<JOB_ENTRY> m_backgroundJobs;
+
+	// loop run by every worker thread but the main thread
+	void WorkerLoop(int workerIndex);
+	// get the worker index of the calling thread, -1 when it
+	// is not a worker of this job system
+	int GetWorkerIndex() const;
+	// add a job whose counter was already raised
+	void Push(const JOB_ENTRY& entry);
+	// take a job from the worker's own queue or steal one
+	bool FindJob(int workerIndex, JOB_ENTRY& entry);
+	// take the oldest background job
+	bool FindBackgroundJob(JOB_ENTRY& entry);
+	// run a job and report it to its counter
+	void Execute(JOB_ENTRY& entry);
+	// count a finished job and start the continuations once
+	// its counter reaches zero
+	void Finish(JOB_COUNTER* pCounter);
+};
@@ -0,0 +1,496 @@
+///////////////////////////////////////////////////////////////////////////////
+// lightmanager.cpp
+// ============
+// manage the point lights of the 3D scene in a shader storage buffer
+///////////////////////////////////////////////////////////////////////////////
+
+#include "LightManager.h"
+#include "ShaderBindings.h"
+#include "FrameStats.h"
+
+#include <string>
+
+// declaration of global variables
+namespace
+{
+	const char* g_LightDataBlockName = "LightData";
+	const char* g_LightListDataBlockName = "LightListData";
+
+	// size of the block header holding the light count - the
+	// light array after it is aligned to 16 bytes under std430
+	const GLsizeiptr LIGHT_HEADER_SIZE = 16;
+	// number of point lights in the fixed uniform array
+	const int LEGACY_POINT_LIGHTS = 5;
+	// smallest number of lights the buffer is created for
+	const int MIN_BUFFER_CAPACITY = 16;
+	// smallest number of objects the light list buffer is
+	// created for
+	const int MIN_LIST_CAPACITY = 1024;
+}
+
+/***********************************************************
+ *  LightManager()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+LightManager::LightManager(ShaderManager* pShaderManager)
+{
+	m_pShaderManager = pShaderManager;
+	m_bufferID = 0;
+	m_bufferCapacity = 0;
+	m_bUseStorageBuffer = false;
+	m_bCountDirty = true;
+	m_listBufferID = 0;
+	m_listBufferCapacity = 0;
+	m_bUseLightLists = false;
+	m_bListsDirty = true;
+	m_firstDirtyObject = -1;
+	m_lastDirtyObject = -1;
+	m_pJobSystem = NULL;
+}
+
+/***********************************************************
+ *  ~LightManager()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+LightManager::~LightManager()
+{
+	m_pShaderManager = NULL;
+	DestroyBuffer();
+}
+
+/***********************************************************
+ *  CreateBuffer()
+ *
+ *  This method is used for creating the storage buffers and
+ *  binding the lights to the fixed LightData binding point.
+ *  The light list buffer is sized on its first upload.
+ ***********************************************************/
+void LightManager::CreateBuffer()
+{
+	if (m_bufferID != 0)
+	{
+		return;
+	}
+
+	glGenBuffers(1, &m_bufferID);
+	glGenBuffers(1, &m_listBufferID);
+	ReserveBuffer(MIN_BUFFER_CAPACITY);
+}
+
+/***********************************************************
+ *  DestroyBuffer()
+ *
+ *  This method is used for freeing the storage buffers.
+ ***********************************************************/
+void LightManager::DestroyBuffer()
+{
+	if (m_bufferID != 0)
+	{
+		glDeleteBuffers(1, &m_bufferID);
+		m_bufferID = 0;
+		m_bufferCapacity = 0;
+	}
+	if (m_listBufferID != 0)
+	{
+		glDeleteBuffers(1, &m_listBufferID);
+		m_listBufferID = 0;
+		m_listBufferCapacity = 0;
+	}
+}
+
+/***********************************************************
+ *  ReserveBuffer()
+ *
+ *  This method is used for growing the storage buffer so it
+ *  has room for the passed in number of lights.  A grown
+ *  buffer has undefined contents, so every light is marked
+ *  dirty to be uploaded again.
+ ***********************************************************/
+void LightManager::ReserveBuffer(int lightCount)
+{
+	if ((m_bufferID == 0) || (lightCount <= m_bufferCapacity))
+	{
+		return;
+	}
+
+	int newCapacity = (m_bufferCapacity > 0) ? m_bufferCapacity : MIN_BUFFER_CAPACITY;
+	while (newCapacity < lightCount)
+	{
+		newCapacity *= 2;
+	}
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_bufferID);
+	glBufferData(GL_SHADER_STORAGE_BUFFER,
+		LIGHT_HEADER_SIZE + (GLsizeiptr)newCapacity * sizeof(GPU_POINT_LIGHT),
+		NULL, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, StorageBinding::LIGHT_DATA, m_bufferID);
+
+	m_bufferCapacity = newCapacity;
+	m_bCountDirty = true;
+	m_dirtyLights.assign(m_pointLights.size(), true);
+}
+
+/***********************************************************
+ *  AttachProgram()
+ *
+ *  This method is used for pointing the LightData and
+ *  LightListData blocks of the passed in shader program at
+ *  their fixed binding points.  Shaders that do not declare
+ *  the LightData block keep using the fixed pointLights
+ *  uniform array, and the light lists are only built for
+ *  shaders that declare the LightListData block.
+ ***********************************************************/
+bool LightManager::AttachProgram(GLuint programID)
+{
+	GLuint blockIndex = GL_INVALID_INDEX;
+
+	m_bUseStorageBuffer = false;
+	m_bUseLightLists = false;
+	if (!GLEW_VERSION_4_3)
+	{
+		return(false);
+	}
+
+	blockIndex = glGetProgramResourceIndex(programID, GL_SHADER_STORAGE_BLOCK, g_LightListDataBlockName);
+	if (blockIndex != GL_INVALID_INDEX)
+	{
+		glShaderStorageBlockBinding(programID, blockIndex, StorageBinding::LIGHT_LIST_DATA);
+		m_bUseLightLists = true;
+		m_bListsDirty = true;
+	}
+
+	blockIndex = glGetProgramResourceIndex(programID, GL_SHADER_STORAGE_BLOCK, g_LightDataBlockName);
+	if (blockIndex == GL_INVALID_INDEX)
+	{
+		return(false);
+	}
+
+	glShaderStorageBlockBinding(programID, blockIndex, StorageBinding::LIGHT_DATA);
+	m_bUseStorageBuffer = true;
+
+	return(true);
+}
+
+/***********************************************************
+ *  AddPointLight()
+ *
+ *  This method is used for adding a point light to the
+ *  scene.  The index of the new light is returned.
+ ***********************************************************/
+int LightManager::AddPointLight(const POINT_LIGHT& light)
+{
+	m_pointLights.push_back(GPU_POINT_LIGHT());
+	m_dirtyLights.push_back(true);
+	m_bCountDirty = true;
+
+	int index = (int)m_pointLights.size() - 1;
+	SetPointLight(index, light);
+
+	return(index);
+}
+
+/***********************************************************
+ *  SetPointLight()
+ *
+ *  This method is used for changing the values of a point
+ *  light.  The light is uploaded on the next UploadLights,
+ *  and every light list is gathered again on the next
+ *  BuildLightLists.
+ ***********************************************************/
+void LightManager::SetPointLight(int index, const POINT_LIGHT& light)
+{
+	if ((index < 0) || (index >= (int)m_pointLights.size()))
+	{
+		return;
+	}
+
+	GPU_POINT_LIGHT& gpuLight = m_pointLights[index];
+	gpuLight.position = glm::vec4(light.position, light.bActive ? 1.0f : 0.0f);
+	gpuLight.ambient = glm::vec4(light.ambient, (light.range > 0.0f) ? light.range : 0.0f);
+	gpuLight.diffuse = glm::vec4(light.diffuse, 0.0f);
+	gpuLight.specular = glm::vec4(light.specular, 0.0f);
+	m_dirtyLights[index] = true;
+	m_bListsDirty = true;
+}
+
+/***********************************************************
+ *  GetPointLightCount()
+ *
+ *  This method is used for getting the number of lights.
+ ***********************************************************/
+int LightManager::GetPointLightCount() const
+{
+	return((int)m_pointLights.size());
+}
+
+/***********************************************************
+ *  UploadLights()
+ *
+ *  This method is used for sending the lights that changed
+ *  since the last call to the shader.  The dirty lights are
+ *  covered by a single contiguous buffer update, and nothing
+ *  is sent when no light has changed.
+ ***********************************************************/
+void LightManager::UploadLights()
+{
+	if (false == m_bUseStorageBuffer)
+	{
+		UploadLegacyUniforms();
+		return;
+	}
+
+	ReserveBuffer((int)m_pointLights.size());
+
+	// find the range of lights that need to be uploaded
+	int firstDirty = -1;
+	int lastDirty = -1;
+	for (int i = 0; i < (int)m_dirtyLights.size(); i++)
+	{
+		if (m_dirtyLights[i])
+		{
+			if (firstDirty < 0)
+			{
+				firstDirty = i;
+			}
+			lastDirty = i;
+			m_dirtyLights[i] = false;
+		}
+	}
+
+	if ((firstDirty < 0) && (false == m_bCountDirty))
+	{
+		return;
+	}
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_bufferID);
+	if (m_bCountDirty)
+	{
+		GLint lightCount = (GLint)m_pointLights.size();
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(GLint), &lightCount);
+		m_bCountDirty = false;
+		FrameStats::Current().bufferUploads++;
+	}
+	if (firstDirty >= 0)
+	{
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER,
+			LIGHT_HEADER_SIZE + (GLintptr)firstDirty * sizeof(GPU_POINT_LIGHT),
+			(GLsizeiptr)(lastDirty - firstDirty + 1) * sizeof(GPU_POINT_LIGHT),
+			&m_pointLights[firstDirty]);
+		FrameStats::Current().bufferUploads++;
+	}
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+/***********************************************************
+ *  UploadLegacyUniforms()
+ *
+ *  This method is used for sending the first five lights
+ *  through the fixed pointLights uniform array for shaders
+ *  that do not declare the LightData block.
+ ***********************************************************/
+void LightManager::UploadLegacyUniforms()
+{
+	if (NULL == m_pShaderManager)
+	{
+		return;
+	}
+
+	for (int i = 0; i < LEGACY_POINT_LIGHTS; i++)
+	{
+		bool bDirty = (i < (int)m_dirtyLights.size()) ? m_dirtyLights[i] : m_bCountDirty;
+		if (false == bDirty)
+		{
+			continue;
+		}
+
+		std::string lightName = "pointLights[" + std::to_string(i) + "].";
+		if (i < (int)m_pointLights.size())
+		{
+			const GPU_POINT_LIGHT& light = m_pointLights[i];
+			m_pShaderManager->setVec3Value(lightName + "position", glm::vec3(light.position));
+			m_pShaderManager->setVec3Value(lightName + "ambient", glm::vec3(light.ambient));
+			m_pShaderManager->setVec3Value(lightName + "diffuse", glm::vec3(light.diffuse));
+			m_pShaderManager->setVec3Value(lightName + "specular", glm::vec3(light.specular));
+			m_pShaderManager->setBoolValue(lightName + "bActive", light.position.w > 0.0f);
+		}
+		else
+		{
+			m_pShaderManager->setBoolValue(lightName + "bActive", false);
+		}
+	}
+
+	m_dirtyLights.assign(m_pointLights.size(), false);
+	m_bCountDirty = false;
+}
+
+/***********************************************************
+ *  BuildLightLists()
+ *
+ *  This method is used for gathering the ranged lights that
+ *  reach each object of the passed in hierarchy.  The objects
+ *  in the range of each light are found with a sphere query,
+ *  split across the job system when there is one.  Every list
+ *  is gathered again when a light changed or the number of
+ *  objects changed, otherwise only the lists of the passed
+ *  in moved objects are, and nothing is done when no object
+ *  moved.  An object reached by more ranged lights than its
+ *  list has room for keeps the first of them.
+ ***********************************************************/
+void LightManager::BuildLightLists(const BoundingVolumeHierarchy& hierarchy, const std::vector<int>& movedObjects)
+{
+	int objectCount = hierarchy.GetObjectCount();
+	bool bRebuild = m_bListsDirty || ((size_t)objectCount * LIGHT_LIST_STRIDE != m_lightLists.size());
+
+	if (false == m_bUseLightLists)
+	{
+		return;
+	}
+	if ((false == bRebuild) && (movedObjects.empty() || m_rangedLights.empty()))
+	{
+		return;
+	}
+
+	if (bRebuild)
+	{
+		m_rangedLights.clear();
+		for (int i = 0; i < (int)m_pointLights.size(); i++)
+		{
+			if ((m_pointLights[i].position.w > 0.0f) && (m_pointLights[i].ambient.w > 0.0f))
+			{
+				m_rangedLights.push_back(i);
+			}
+		}
+
+		m_lightLists.assign((size_t)objectCount * LIGHT_LIST_STRIDE, 0);
+		m_movedObjects.assign(objectCount, 0);
+		m_firstDirtyObject = 0;
+		m_lastDirtyObject = objectCount - 1;
+		m_bListsDirty = false;
+	}
+	else
+	{
+		// empty the lists of the moved objects and mark them so
+		// only their entries are gathered again
+		for (size_t i = 0; i < movedObjects.size(); i++)
+		{
+			int objectIndex = movedObjects[i];
+			m_lightLists[(size_t)objectIndex * LIGHT_LIST_STRIDE] = 0;
+			m_movedObjects[objectIndex] = 1;
+			m_firstDirtyObject = ((m_firstDirtyObject < 0) || (objectIndex < m_firstDirtyObject)) ? objectIndex : m_firstDirtyObject;
+			m_lastDirtyObject = (objectIndex > m_lastDirtyObject) ? objectIndex : m_lastDirtyObject;
+		}
+	}
+
+	// every query writes the objects of its own light only, so
+	// the queries need no locking
+	m_lightObjects.resize(m_rangedLights.size());
+	JobSystem::RANGE_JOB queryLights = [this, &hierarchy](int first, int count)
+	{
+		for (int i = first; i < (first + count); i++)
+		{
+			const GPU_POINT_LIGHT& light = m_pointLights[m_rangedLights[i]];
+			m_lightObjects[i].clear();
+			hierarchy.QuerySphere(glm::vec3(light.position), light.ambient.w, m_lightObjects[i]);
+		}
+	};
+	if (NULL != m_pJobSystem)
+	{
+		m_pJobSystem->ParallelFor((int)m_rangedLights.size(), 1, queryLights);
+	}
+	else
+	{
+		queryLights(0, (int)m_rangedLights.size());
+	}
+
+	for (size_t i = 0; i < m_rangedLights.size(); i++)
+	{
+		const std::vector<int>& objects = m_lightObjects[i];
+		for (size_t j = 0; j < objects.size(); j++)
+		{
+			if ((false == bRebuild) && (0 == m_movedObjects[objects[j]]))
+			{
+				continue;
+			}
+
+			int32_t* pList = &m_lightLists[(size_t)objects[j] * LIGHT_LIST_STRIDE];
+			if (pList[0] < (LIGHT_LIST_STRIDE - 1))
+			{
+				pList[0]++;
+				pList[pList[0]] = m_rangedLights[i];
+			}
+		}
+	}
+
+	if (false == bRebuild)
+	{
+		for (size_t i = 0; i < movedObjects.size(); i++)
+		{
+			m_movedObjects[movedObjects[i]] = 0;
+		}
+	}
+}
+
+/***********************************************************
+ *  UploadLightLists()
+ *
+ *  This method is used for sending the light lists gathered
+ *  since the last call to the shader, covering the changed
+ *  objects with a single contiguous buffer update.  The
+ *  buffer is grown by doubling so a few more objects do not
+ *  reallocate it.
+ ***********************************************************/
+void LightManager::UploadLightLists()
+{
+	if ((m_firstDirtyObject < 0) || (m_listBufferID == 0))
+	{
+		return;
+	}
+
+	int objectCount = (int)(m_lightLists.size() / LIGHT_LIST_STRIDE);
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_listBufferID);
+	if (objectCount > m_listBufferCapacity)
+	{
+		int newCapacity = (m_listBufferCapacity > 0) ? m_listBufferCapacity : MIN_LIST_CAPACITY;
+		while (newCapacity < objectCount)
+		{
+			newCapacity *= 2;
+		}
+
+		glBufferData(GL_SHADER_STORAGE_BUFFER,
+			(GLsizeiptr)newCapacity * LIGHT_LIST_STRIDE * sizeof(int32_t), NULL, GL_DYNAMIC_DRAW);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, StorageBinding::LIGHT_LIST_DATA, m_listBufferID);
+		m_listBufferCapacity = newCapacity;
+
+		// a grown buffer has undefined contents
+		m_firstDirtyObject = 0;
+		m_lastDirtyObject = objectCount - 1;
+	}
+	if (m_lastDirtyObject >= m_firstDirtyObject)
+	{
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER,
+			(GLintptr)m_firstDirtyObject * LIGHT_LIST_STRIDE * sizeof(int32_t),
+			(GLsizeiptr)(m_lastDirtyObject - m_firstDirtyObject + 1) * LIGHT_LIST_STRIDE * sizeof(int32_t),
+			&m_lightLists[(size_t)m_firstDirtyObject * LIGHT_LIST_STRIDE]);
+		FrameStats::Current().bufferUploads++;
+	}
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	m_firstDirtyObject = -1;
+	m_lastDirtyObject = -1;
+}
+
+/***********************************************************
+ *  SetJobSystem()
+ *
+ *  This method is used for setting the job system the light
+ *  queries are split across, or NULL to run them on the
+ *  calling thread.
+ ***********************************************************/
+void LightManager::SetJobSystem(JobSystem* pJobSystem)
+{
+	m_pJobSystem = pJobSystem;
+}
@@ -0,0 +1,170 @@
+///////////////////////////////////////////////////////////////////////////////
+// lightmanager.h
+// ============
+// manage the point lights of the 3D scene in a shader storage buffer
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderManager.h"
+#include "BoundingVolumeHierarchy.h"
+#include "JobSystem.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <stdint.h>
+#include <vector>
+
+/***********************************************************
+ *  LightManager
+ *
+ *  This class keeps a runtime sized list of point lights in
+ *  a shader storage buffer.  The whole list is uploaded in
+ *  one call the first time, and after that only the range
+ *  covering the lights that were marked dirty is updated.
+ *
+ *  The matching GLSL declaration is:
+ *
+ *    struct PointLight
+ *    {
+ *        vec4 position;    // w is 1.0 when the light is active
+ *        vec4 ambient;
+ *        vec4 diffuse;
+ *        vec4 specular;
+ *    };
+ *    layout(std430, binding = 0) buffer LightData
+ *    {
+ *        int pointLightCount;
+ *        PointLight pointLights[];
+ *    };
+ *
+ *  Shaders without the LightData block fall back to the
+ *  fixed pointLights[0..4] uniform array.
+ *
+ *  A light with a range only reaches the objects whose boxes
+ *  are within it.  The ranged lights reaching each object
+ *  are gathered from the bounding volume hierarchy into a
+ *  list of LIGHT_LIST_STRIDE entries per object, and only
+ *  the lists of objects that moved are gathered again unless
+ *  a light changed.  The lists are read through:
+ *
+ *    layout(std430, binding = 2) buffer LightListData
+ *    {
+ *        int lightLists[];   // count, then light indices
+ *    };
+ *
+ *  starting at lightLists[objectIndex * 8], where the index
+ *  of the object comes from the instanceObjectIndex attribute
+ *  or the objectIndex uniform.  A light whose ambient.w range
+ *  is 0 reaches every object and is not in any list, so the
+ *  shader loops over those lights for every object and over
+ *  the list of the object for the rest.  Shaders without the
+ *  block loop over every light.
+ ***********************************************************/
+class LightManager
+{
+public:
+	// constructor
+	LightManager(ShaderManager* pShaderManager);
+	// destructor
+	~LightManager();
+
+	struct POINT_LIGHT
+	{
+		glm::vec3 position;
+		glm::vec3 ambient;
+		glm::vec3 diffuse;
+		glm::vec3 specular;
+		bool bActive;
+		// distance the light reaches, 0 to reach every object
+		float range;
+	};
+
+	// entries of the light list of one object, the count and
+	// up to LIGHT_LIST_STRIDE - 1 ranged lights
+	static const int LIGHT_LIST_STRIDE = 8;
+
+	// std430 image of one PointLight entry, with the range of
+	// the light in ambient.w
+	struct GPU_POINT_LIGHT
+	{
+		glm::vec4 position;
+		glm::vec4 ambient;
+		glm::vec4 diffuse;
+		glm::vec4 specular;
+	};
+
+	// create the storage buffer
+	void CreateBuffer();
+	// free the storage buffer
+	void DestroyBuffer();
+
+	// connect the LightData block of a shader program to the
+	// buffer - returns false when the program does not use it
+	bool AttachProgram(GLuint programID);
+
+	// add a point light and get its index
+	int AddPointLight(const POINT_LIGHT& light);
+	// change a point light and mark it dirty
+	void SetPointLight(int index, const POINT_LIGHT& light);
+	// get the number of point lights
+	int GetPointLightCount() const;
+
+	// send the dirty lights to the shader
+	void UploadLights();
+
+	// gather the ranged lights reaching each object of the
+	// hierarchy, or only the passed in moved objects when no
+	// light changed
+	void BuildLightLists(const BoundingVolumeHierarchy& hierarchy, const std::vector<int>& movedObjects);
+	// send the light lists gathered since the last upload
+	void UploadLightLists();
+
+	// split the light queries across the threads of a job
+	// system
+	void SetJobSystem(JobSystem* pJobSystem);
+
+private:
+	// pointer to shader manager object
+	ShaderManager* m_pShaderManager;
+	// OpenGL buffer object name
+	GLuint m_bufferID;
+	// number of lights the buffer has room for
+	int m_bufferCapacity;
+	// true when the shader reads the LightData block
+	bool m_bUseStorageBuffer;
+	// true when the light count needs to be uploaded
+	bool m_bCountDirty;
+	// the point lights of the scene
+	std::vector<GPU_POINT_LIGHT> m_pointLights;
+	// flags for lights changed since the last upload
+	std::vector<bool> m_dirtyLights;
+
+	// OpenGL buffer object name of the light lists and the
+	// number of objects it has room for
+	GLuint m_listBufferID;
+	int m_listBufferCapacity;
+	// true when the shader reads the LightListData block
+	bool m_bUseLightLists;
+	// true when every list needs to be gathered again
+	bool m_bListsDirty;
+	// light list of every object, LIGHT_LIST_STRIDE entries each
+	std::vector<int32_t> m_lightLists;
+	// range of objects whose lists changed since the last
+	// upload, -1 when none did
+	int m_firstDirtyObject;
+	int m_lastDirtyObject;
+	// the active lights with a range, the objects each of them
+	// reaches and flags for the objects gathered again
+	std::vector<int> m_rangedLights;
+	std::vector<std::vector<int> > m_lightObjects;
+	std::vector<uint8_t> m_movedObjects;
+	// optional job system the light queries are split across
+	JobSystem* m_pJobSystem;
+
+	// grow the buffer to hold at least the passed in count
+	void ReserveBuffer(int lightCount);
+	// upload the lights through the fixed uniform array
+	void UploadLegacyUniforms();
+};
@@ -8,7 +8,9 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #include <iostream>         // error handling and output
-#include <cstdlib>          // EXIT_FAILURE
+#include <cstdlib>          // EXIT_FAILURE, atoi
+#include <cstring>          // strcmp
+#include <chrono>           // time to the first frame
 
 #include <GL/glew.h>        // GLEW library
 #include "GLFW/glfw3.h"     // GLFW library
@@ -22,6 +24,14 @@
 #include "ViewManager.h"
 #include "ShapeMeshes.h"
 #include "ShaderManager.h"
+#include "ShaderUniforms.h"
+#include "FrameStats.h"
+#include "RenderState.h"
+#include "Benchmarks.h"
+#include "TextureCooker.h"
+#include "RenderSettings.h"
+#include "PersistentRingBuffer.h"
+#include "JobSystem.h"
 
 // Namespace for declaring global variables
 namespace
@@ -36,8 +46,19 @@ namespace
 	SceneManager* g_SceneManager = nullptr;
 	// shader manager object for dynamic interaction with the shader code
 	ShaderManager* g_ShaderManager = nullptr;
+	// shader uniforms object for setting values through cached handles
+	ShaderUniforms* g_ShaderUniforms = nullptr;
 	// view manager object for managing the 3D view setup and projection to 2D
 	ViewManager* g_ViewManager = nullptr;
+	// mapped ring buffer for the data written every frame
+	PersistentRingBuffer* g_RingBuffer = nullptr;
+	// bytes of the ring buffer used by each frame
+	const size_t RING_REGION_SIZE = 4 * 1024 * 1024;
+	// worker threads the per-object work is spread across
+	JobSystem* g_JobSystem = nullptr;
+	// farthest distance an object can be picked at, which is
+	// the far plane of the camera
+	const float PICK_DISTANCE = 100.0f;
 }
 
 // Function declarations - all functions that are called manually
@@ -54,6 +75,58 @@ bool InitializeGLEW();
  ***********************************************************/
 int main(int argc, char* argv[])
 {
+	std::chrono::high_resolution_clock::time_point startTime = std::chrono::high_resolution_clock::now();
+	bool bFirstFrame = true;
+
+	// run a microbenchmark instead of the scene when requested
+	if ((argc >= 3) && (strcmp(argv[1], "--benchmark") == 0))
+	{
+		return(Benchmarks::Run(argv[2]) ? EXIT_SUCCESS : EXIT_FAILURE);
+	}
+
+	// cook the passed images into compressed textures instead
+	if ((argc >= 2) && (strcmp(argv[1], "--cook") == 0))
+	{
+		return(TextureCooker::Run(argc - 2, argv + 2) ? EXIT_SUCCESS : EXIT_FAILURE);
+	}
+
+	// "--desks N" fills the scene with N copies of the desk setup,
+	// "--translucent N" adds N translucent spheres above the first
+	// desk and "--threads N" sets the number of job threads, which
+	// defaults to one per hardware thread.  "--decode-textures"
+	// decompresses cooked textures on the CPU before their upload,
+	// and "--no-texture-cache" decodes every image without reading
+	// or writing the texture cache
+	int deskCount = 1;
+	int translucentCount = 0;
+	int threadCount = 0;
+	for (int i = 1; (i + 1) < argc; i++)
+	{
+		if (strcmp(argv[i], "--desks") == 0)
+		{
+			deskCount = atoi(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--translucent") == 0)
+		{
+			translucentCount = atoi(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--threads") == 0)
+		{
+			threadCount = atoi(argv[i + 1]);
+		}
+	}
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--decode-textures") == 0)
+		{
+			RenderSettings::Get().bCompressedTextures = false;
+		}
+		else if (strcmp(argv[i], "--no-texture-cache") == 0)
+		{
+			RenderSettings::Get().bTextureCache = false;
+		}
+	}
+
 	// if GLFW fails initialization, then terminate the application
 	if (InitializeGLFW() == false)
 	{
@@ -81,16 +154,44 @@ int main(int argc, char* argv[])
 		"shaders/fragmentShader.glsl");
 	g_ShaderManager->use();
 
+	// resolve the uniform locations of the loaded shaders one time
+	g_ShaderUniforms = new ShaderUniforms();
+	g_ShaderUniforms->AttachProgram();
+	g_ViewManager->ResolveUniformHandles(g_ShaderUniforms);
+
 	// try to create a new scene manager object and prepare the 3D scene
-	g_SceneManager = new SceneManager(g_ShaderManager);
+	g_SceneManager = new SceneManager(g_ShaderManager, g_ShaderUniforms);
+	g_SceneManager->SetDeskCount(deskCount);
+	g_SceneManager->SetTranslucentCount(translucentCount);
+
+	// start the job threads on this thread, which makes it the
+	// main thread the GL jobs are run on
+	g_JobSystem = new JobSystem(threadCount);
+	g_SceneManager->SetJobSystem(g_JobSystem);
+	std::cout << "INFO: job system running on " << g_JobSystem->GetThreadCount() << " threads" << std::endl;
+
 	g_SceneManager->PrepareScene();
 
+	// write the per-frame and per-draw data into a persistently
+	// mapped ring buffer when the context supports it
+	g_RingBuffer = new PersistentRingBuffer();
+	if (g_RingBuffer->Create(RING_REGION_SIZE))
+	{
+		g_ViewManager->SetRingBuffer(g_RingBuffer);
+		g_SceneManager->SetRingBuffer(g_RingBuffer);
+	}
+
 	// loop will keep running until the application is closed 
 	// or until an error has occurred
 	while (!glfwWindowShouldClose(g_Window))
 	{
+		// reset the per-frame rendering counters
+		FrameStats::BeginFrame();
+		// move to a ring buffer region the GPU is done reading
+		g_RingBuffer->BeginFrame();
+
 		// Enable z-depth
-		glEnable(GL_DEPTH_TEST);
+		RenderState::Enable(GL_DEPTH_TEST);
 
 		// Clear the frame and z buffers
 		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
@@ -98,16 +199,55 @@ int main(int argc, char* argv[])
 
 		// convert from 3D object space to 2D view
 		g_ViewManager->PrepareSceneView();
+		g_SceneManager->SetViewMatrix(g_ViewManager->GetViewMatrix());
+		g_SceneManager->SetProjectionMatrix(g_ViewManager->GetProjectionMatrix());
+
+		// report the object in the middle of the view on a click
+		glm::vec3 pickOrigin;
+		glm::vec3 pickDirection;
+		if (g_ViewManager->GetPickRay(pickOrigin, pickDirection))
+		{
+			float pickDistance = PICK_DISTANCE;
+			int objectIndex = g_SceneManager->PickObject(pickOrigin, pickDirection, pickDistance);
+			if (objectIndex >= 0)
+			{
+				std::cout << "INFO: picked object " << objectIndex << " at distance " << pickDistance << std::endl;
+			}
+			else
+			{
+				std::cout << "INFO: nothing picked" << std::endl;
+			}
+		}
 
 		// refresh the 3D scene
 		g_SceneManager->RenderScene();
-
+		// fence the ring buffer region written this frame
+		g_RingBuffer->EndFrame();
 
 		// Flips the the back buffer with the front buffer every frame.
 		glfwSwapBuffers(g_Window);
 
+		// report how long the window stayed empty after launch
+		if (bFirstFrame)
+		{
+			std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - startTime;
+			std::cout << "INFO: first frame shown " << elapsed.count() << " ms after launch" << std::endl;
+			bFirstFrame = false;
+		}
+
+		// report the rendering counters of the completed frame,
+		// and show the summary of each new report in the title
+		if (FrameStats::EndFrame(glfwGetTime()))
+		{
+			std::string title = std::string(WINDOW_TITLE) + " - " + FrameStats::GetSummary();
+			glfwSetWindowTitle(g_Window, title.c_str());
+		}
+
 		// query the latest GLFW events
 		glfwPollEvents();
+
+		// run the GL work handed to the main thread by jobs
+		g_JobSystem->ExecuteMainThreadJobs();
 	}
 
 	// clear the allocated manager objects from memory
@@ -116,11 +256,26 @@ int main(int argc, char* argv[])
 		delete g_SceneManager;
 		g_SceneManager = NULL;
 	}
+	if (NULL != g_JobSystem)
+	{
+		delete g_JobSystem;
+		g_JobSystem = NULL;
+	}
 	if (NULL != g_ViewManager)
 	{
 		delete g_ViewManager;
 		g_ViewManager = NULL;
 	}
+	if (NULL != g_RingBuffer)
+	{
+		delete g_RingBuffer;
+		g_RingBuffer = NULL;
+	}
+	if (NULL != g_ShaderUniforms)
+	{
+		delete g_ShaderUniforms;
+		g_ShaderUniforms = NULL;
+	}
 	if (NULL != g_ShaderManager)
 	{
 		delete g_ShaderManager;
@@ -183,4 +338,4 @@ bool InitializeGLEW()
 	std::cout << "INFO: OpenGL Version: " << glGetString(GL_VERSION) << "\n" << std::endl;
 
 	return(true);
-}
\ No newline at end of file
+}
\ No newline at end of file
@@ -0,0 +1,388 @@
+///////////////////////////////////////////////////////////////////////////////
+// occlusionculler.cpp
+// ============
+// hide objects behind large occluders with a hierarchical depth buffer
+///////////////////////////////////////////////////////////////////////////////
+
+#include "OcclusionCuller.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+// declaration of global variables
+namespace
+{
+	// depth the buffer is cleared to, the far plane
+	const float FAR_DEPTH = 1.0f;
+	// most corners a quad can have after near plane clipping
+	const int MAX_POLYGON_CORNERS = 5;
+
+	// corners of the six faces of a box, where bit 0 of a
+	// corner index selects +x, bit 1 +y and bit 2 +z
+	const int g_BoxFaces[6][4] =
+	{
+		{ 0, 2, 6, 4 },
+		{ 1, 3, 7, 5 },
+		{ 0, 1, 5, 4 },
+		{ 2, 3, 7, 6 },
+		{ 0, 1, 3, 2 },
+		{ 4, 5, 7, 6 },
+	};
+
+	/***********************************************************
+	 *  NearPlaneDistance()
+	 *
+	 *  This function is used for getting the signed distance of
+	 *  a clip-space point in front of the near plane.
+	 ***********************************************************/
+	inline float NearPlaneDistance(const glm::vec4& corner)
+	{
+		return(corner.z + corner.w);
+	}
+}
+
+/***********************************************************
+ *  OcclusionCuller()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+OcclusionCuller::OcclusionCuller()
+{
+	int width = BUFFER_WIDTH;
+	int height = BUFFER_HEIGHT;
+
+	// every level is half the size of the one below it,
+	// rounded up, down to a single texel
+	while (true)
+	{
+		DEPTH_LEVEL level;
+		level.width = width;
+		level.height = height;
+		level.depth.assign((size_t)width * height, FAR_DEPTH);
+		m_levels.push_back(level);
+
+		if ((1 == width) && (1 == height))
+		{
+			break;
+		}
+		width = (width + 1) / 2;
+		height = (height + 1) / 2;
+	}
+
+	m_viewProjection = glm::mat4(1.0f);
+	m_occluderCount = 0;
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for clearing the depth buffer to the
+ *  far plane before the occluders of a frame are drawn.
+ ***********************************************************/
+void OcclusionCuller::BeginFrame(const glm::mat4& viewProjection)
+{
+	m_viewProjection = viewProjection;
+	m_occluderCount = 0;
+	std::fill(m_levels[0].depth.begin(), m_levels[0].depth.end(), FAR_DEPTH);
+}
+
+/***********************************************************
+ *  DrawOccluder()
+ *
+ *  This method is used for drawing the faces of a box into
+ *  the depth buffer.  Back faces are drawn as well, which is
+ *  harmless because the nearer front faces win the depth
+ *  test, and keeps quads visible from both sides.
+ ***********************************************************/
+void OcclusionCuller::DrawOccluder(const glm::mat4& world, const glm::vec3& localCenter, const glm::vec3& localExtent)
+{
+	glm::mat4 worldViewProjection = m_viewProjection * world;
+	glm::vec4 corners[8];
+
+	for (int i = 0; i < 8; i++)
+	{
+		glm::vec3 corner(
+			(i & 1) ? localExtent.x : -localExtent.x,
+			(i & 2) ? localExtent.y : -localExtent.y,
+			(i & 4) ? localExtent.z : -localExtent.z);
+		corners[i] = worldViewProjection * glm::vec4(localCenter + corner, 1.0f);
+	}
+
+	for (int face = 0; face < 6; face++)
+	{
+		glm::vec4 polygon[4];
+		for (int i = 0; i < 4; i++)
+		{
+			polygon[i] = corners[g_BoxFaces[face][i]];
+		}
+		DrawPolygon(polygon, 4);
+	}
+
+	m_occluderCount++;
+}
+
+/***********************************************************
+ *  DrawPolygon()
+ *
+ *  This method is used for clipping a convex clip-space
+ *  polygon to the near plane, moving the remaining corners
+ *  to pixels and drawing it as a fan of triangles.  Only the
+ *  near plane is clipped against, the other sides are left
+ *  to the pixel bounds of the triangles.
+ ***********************************************************/
+void OcclusionCuller::DrawPolygon(const glm::vec4* pCorners, int count)
+{
+	glm::vec4 clipped[MAX_POLYGON_CORNERS];
+	int clippedCount = 0;
+
+	for (int i = 0; i < count; i++)
+	{
+		const glm::vec4& current = pCorners[i];
+		const glm::vec4& next = pCorners[(i + 1) % count];
+		float currentDistance = NearPlaneDistance(current);
+		float nextDistance = NearPlaneDistance(next);
+
+		if (currentDistance >= 0.0f)
+		{
+			clipped[clippedCount++] = current;
+		}
+		// add the point where the edge crosses the plane
+		if ((currentDistance >= 0.0f) != (nextDistance >= 0.0f))
+		{
+			float t = currentDistance / (currentDistance - nextDistance);
+			clipped[clippedCount++] = current + (next - current) * t;
+		}
+	}
+
+	if (clippedCount < 3)
+	{
+		return;
+	}
+
+	glm::vec3 pixels[MAX_POLYGON_CORNERS];
+	for (int i = 0; i < clippedCount; i++)
+	{
+		// a corner on the near plane can still have w of 0
+		// when the near plane is at the eye
+		float w = std::max(clipped[i].w, FLT_MIN);
+		pixels[i] = glm::vec3(
+			(clipped[i].x / w * 0.5f + 0.5f) * (float)BUFFER_WIDTH,
+			(clipped[i].y / w * 0.5f + 0.5f) * (float)BUFFER_HEIGHT,
+			clipped[i].z / w * 0.5f + 0.5f);
+	}
+
+	for (int i = 2; i < clippedCount; i++)
+	{
+		DrawTriangle(pixels[0], pixels[i - 1], pixels[i]);
+	}
+}
+
+/***********************************************************
+ *  DrawTriangle()
+ *
+ *  This method is used for writing the depth of a triangle
+ *  into every pixel whose center it covers, keeping the
+ *  nearer depth.  Depth after the perspective divide changes
+ *  linearly across the screen, so it is interpolated with
+ *  the screen-space weights of the corners.  The edge
+ *  functions are evaluated in double precision because
+ *  corners close to the near plane can land far outside of
+ *  the buffer.
+ ***********************************************************/
+void OcclusionCuller::DrawTriangle(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
+{
+	double area = ((double)b.x - a.x) * ((double)c.y - a.y) - ((double)b.y - a.y) * ((double)c.x - a.x);
+	if (0.0 == area)
+	{
+		return;
+	}
+
+	int minX = (int)std::max(std::floor(std::min(a.x, std::min(b.x, c.x))), 0.0f);
+	int maxX = (int)std::min(std::ceil(std::max(a.x, std::max(b.x, c.x))), (float)(BUFFER_WIDTH - 1));
+	int minY = (int)std::max(std::floor(std::min(a.y, std::min(b.y, c.y))), 0.0f);
+	int maxY = (int)std::min(std::ceil(std::max(a.y, std::max(b.y, c.y))), (float)(BUFFER_HEIGHT - 1));
+	if ((minX > maxX) || (minY > maxY))
+	{
+		return;
+	}
+
+	// each weight is the edge function of the opposite edge
+	// divided by the area, so it does not matter which way
+	// the triangle winds
+	const glm::vec3* pFrom[3] = { &b, &c, &a };
+	const glm::vec3* pTo[3] = { &c, &a, &b };
+	double stepX[3];
+	double stepY[3];
+	double origin[3];
+	for (int edge = 0; edge < 3; edge++)
+	{
+		stepX[edge] = -((double)pTo[edge]->y - pFrom[edge]->y) / area;
+		stepY[edge] = ((double)pTo[edge]->x - pFrom[edge]->x) / area;
+		origin[edge] = -(stepX[edge] * pFrom[edge]->x + stepY[edge] * pFrom[edge]->y);
+	}
+
+	std::vector<float>& buffer = m_levels[0].depth;
+	for (int y = minY; y <= maxY; y++)
+	{
+		double centerY = (double)y + 0.5;
+		float* pRow = &buffer[(size_t)y * BUFFER_WIDTH];
+
+		for (int x = minX; x <= maxX; x++)
+		{
+			double centerX = (double)x + 0.5;
+			double weightA = origin[0] + stepX[0] * centerX + stepY[0] * centerY;
+			double weightB = origin[1] + stepX[1] * centerX + stepY[1] * centerY;
+			double weightC = origin[2] + stepX[2] * centerX + stepY[2] * centerY;
+
+			if ((weightA < 0.0) || (weightB < 0.0) || (weightC < 0.0))
+			{
+				continue;
+			}
+
+			float depth = (float)(weightA * a.z + weightB * b.z + weightC * c.z);
+			pRow[x] = std::min(pRow[x], depth);
+		}
+	}
+}
+
+/***********************************************************
+ *  BuildPyramid()
+ *
+ *  This method is used for filling every level above the
+ *  depth buffer with the farthest depth of the up to four
+ *  texels below each texel.
+ ***********************************************************/
+void OcclusionCuller::BuildPyramid()
+{
+	for (size_t level = 1; level < m_levels.size(); level++)
+	{
+		const DEPTH_LEVEL& source = m_levels[level - 1];
+		DEPTH_LEVEL& target = m_levels[level];
+
+		for (int y = 0; y < target.height; y++)
+		{
+			// odd sizes repeat the last row or column
+			const float* pRow0 = &source.depth[(size_t)(2 * y) * source.width];
+			const float* pRow1 = &source.depth[(size_t)std::min(2 * y + 1, source.height - 1) * source.width];
+
+			for (int x = 0; x < target.width; x++)
+			{
+				int x0 = 2 * x;
+				int x1 = std::min(2 * x + 1, source.width - 1);
+
+				target.depth[(size_t)y * target.width + x] = std::max(
+					std::max(pRow0[x0], pRow0[x1]),
+					std::max(pRow1[x0], pRow1[x1]));
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  IsVisible()
+ *
+ *  This method is used for testing a world-space box against
+ *  the depth pyramid.  The corners of the box give its pixel
+ *  rectangle and its nearest depth, and the level is picked
+ *  where the rectangle covers at most two texels each way.
+ *  Boxes that reach the near plane or lie completely outside
+ *  of the buffer are always visible, which leaves them to
+ *  the frustum test.
+ ***********************************************************/
+bool OcclusionCuller::IsVisible(const glm::vec3& center, const glm::vec3& extent) const
+{
+	if (0 == m_occluderCount)
+	{
+		return(true);
+	}
+
+	glm::vec2 rectMin(FLT_MAX, FLT_MAX);
+	glm::vec2 rectMax(-FLT_MAX, -FLT_MAX);
+	float nearest = FLT_MAX;
+
+	// the corners are the projected center plus or minus the
+	// projected half size along each axis
+	glm::vec4 clipCenter = m_viewProjection * glm::vec4(center, 1.0f);
+	glm::vec4 clipX = m_viewProjection[0] * extent.x;
+	glm::vec4 clipY = m_viewProjection[1] * extent.y;
+	glm::vec4 clipZ = m_viewProjection[2] * extent.z;
+
+	for (int i = 0; i < 8; i++)
+	{
+		glm::vec4 clip = clipCenter +
+			((i & 1) ? clipX : -clipX) +
+			((i & 2) ? clipY : -clipY) +
+			((i & 4) ? clipZ : -clipZ);
+
+		if (NearPlaneDistance(clip) < 0.0f)
+		{
+			return(true);
+		}
+
+		glm::vec3 ndc = glm::vec3(clip) / clip.w;
+		rectMin = glm::min(rectMin, glm::vec2(ndc));
+		rectMax = glm::max(rectMax, glm::vec2(ndc));
+		nearest = std::min(nearest, ndc.z);
+	}
+
+	// pixels whose centers can be covered by the rectangle
+	float left = (rectMin.x * 0.5f + 0.5f) * (float)BUFFER_WIDTH - 0.5f;
+	float right = (rectMax.x * 0.5f + 0.5f) * (float)BUFFER_WIDTH - 0.5f;
+	float bottom = (rectMin.y * 0.5f + 0.5f) * (float)BUFFER_HEIGHT - 0.5f;
+	float top = (rectMax.y * 0.5f + 0.5f) * (float)BUFFER_HEIGHT - 0.5f;
+	if ((right < 0.0f) || (top < 0.0f) ||
+		(left > (float)(BUFFER_WIDTH - 1)) || (bottom > (float)(BUFFER_HEIGHT - 1)))
+	{
+		return(true);
+	}
+
+	// the parts outside of the buffer are outside of the view
+	int x0 = (int)std::max(std::floor(left), 0.0f);
+	int x1 = (int)std::min(std::ceil(right), (float)(BUFFER_WIDTH - 1));
+	int y0 = (int)std::max(std::floor(bottom), 0.0f);
+	int y1 = (int)std::min(std::ceil(top), (float)(BUFFER_HEIGHT - 1));
+	int size = std::max(x1 - x0, y1 - y0) + 1;
+	int level = 0;
+	while (((1 << level) < size) && (level < (int)m_levels.size() - 1))
+	{
+		level++;
+	}
+
+	const DEPTH_LEVEL& depthLevel = m_levels[level];
+	float depth = nearest * 0.5f + 0.5f;
+	for (int y = (y0 >> level); y <= (y1 >> level); y++)
+	{
+		for (int x = (x0 >> level); x <= (x1 >> level); x++)
+		{
+			if (depth <= depthLevel.depth[(size_t)y * depthLevel.width + x])
+			{
+				return(true);
+			}
+		}
+	}
+
+	return(false);
+}
+
+/***********************************************************
+ *  GetOccluderCount()
+ *
+ *  This method is used for getting the number of occluders
+ *  drawn into the depth buffer this frame.
+ ***********************************************************/
+int OcclusionCuller::GetOccluderCount() const
+{
+	return(m_occluderCount);
+}
+
+/***********************************************************
+ *  GetLevelCount()
+ *
+ *  This method is used for getting the number of levels of
+ *  the depth pyramid, including the depth buffer.
+ ***********************************************************/
+int OcclusionCuller::GetLevelCount() const
+{
+	return((int)m_levels.size());
+}
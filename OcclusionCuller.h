@@ -0,0 +1,80 @@
+///////////////////////////////////////////////////////////////////////////////
+// occlusionculler.h
+// ============
+// hide objects behind large occluders with a hierarchical depth buffer
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  OcclusionCuller
+ *
+ *  This class draws the depth of a few chosen occluders into
+ *  a small depth buffer on the CPU, builds a mip pyramid of
+ *  it where every texel keeps the farthest depth of the four
+ *  below it, and tests the bounding boxes of the other
+ *  objects against the pyramid.  A box is occluded when its
+ *  nearest point is behind the farthest occluder depth over
+ *  every texel its screen rectangle covers, which the level
+ *  whose texels are about the size of the rectangle answers
+ *  with at most four reads.
+ *
+ *  Occluders are boxes, and boxes without height for quads,
+ *  given by the same local bounds and world matrix as their
+ *  mesh, so only meshes that fill their bounds should be
+ *  drawn as occluders.  Depth is sampled at pixel centers,
+ *  so an object seen only through a gap thinner than a pixel
+ *  of the buffer can be hidden.
+ ***********************************************************/
+class OcclusionCuller
+{
+public:
+	// constructor
+	OcclusionCuller();
+
+	// clear the depth buffer for a frame seen through a view
+	// projection matrix
+	void BeginFrame(const glm::mat4& viewProjection);
+	// draw the depth of a local box moved into the world by a
+	// model matrix
+	void DrawOccluder(const glm::mat4& world, const glm::vec3& localCenter, const glm::vec3& localExtent);
+	// build the farthest depth pyramid from the drawn occluders
+	void BuildPyramid();
+	// check whether any part of a world-space box, given by its
+	// center and half size, can be in front of the occluders
+	bool IsVisible(const glm::vec3& center, const glm::vec3& extent) const;
+
+	// get the number of occluders drawn since BeginFrame()
+	int GetOccluderCount() const;
+	// get the number of levels in the depth pyramid
+	int GetLevelCount() const;
+
+	// size of the depth buffer the occluders are drawn into
+	static const int BUFFER_WIDTH = 256;
+	static const int BUFFER_HEIGHT = 128;
+
+private:
+	// one level of the depth pyramid, level 0 being the
+	// buffer the occluders are drawn into
+	struct DEPTH_LEVEL
+	{
+		int width;
+		int height;
+		std::vector<float> depth;
+	};
+
+	glm::mat4 m_viewProjection;
+	std::vector<DEPTH_LEVEL> m_levels;
+	int m_occluderCount;
+
+	// draw a polygon of clip-space corners, clipped to the
+	// near plane
+	void DrawPolygon(const glm::vec4* pCorners, int count);
+	// draw a triangle whose corners are in pixels, with the
+	// depth in z
+	void DrawTriangle(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c);
+};
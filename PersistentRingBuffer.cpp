@@ -0,0 +1,275 @@
+///////////////////////////////////////////////////////////////////////////////
+// persistentringbuffer.cpp
+// ============
+// persistently mapped, fenced ring buffer for data written every frame
+///////////////////////////////////////////////////////////////////////////////
+
+#include "PersistentRingBuffer.h"
+#include "FrameStats.h"
+
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// nanoseconds to wait for a fence before checking again
+	const GLuint64 FENCE_WAIT_TIMEOUT = 1000000;
+}
+
+/***********************************************************
+ *  PersistentRingBuffer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+PersistentRingBuffer::PersistentRingBuffer()
+{
+	m_bufferID = 0;
+	m_pMappedData = NULL;
+	m_regionSize = 0;
+	m_regionCount = 0;
+	m_region = 0;
+	m_regionUsed = 0;
+	m_bGrowRequested = false;
+	for (int i = 0; i < MAX_REGIONS; i++)
+	{
+		m_fences[i] = NULL;
+	}
+}
+
+/***********************************************************
+ *  ~PersistentRingBuffer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+PersistentRingBuffer::~PersistentRingBuffer()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for creating the buffer with
+ *  immutable storage and mapping all of its regions one time
+ *  for writing.
+ ***********************************************************/
+bool PersistentRingBuffer::Create(size_t regionSize, int regionCount)
+{
+	Destroy();
+
+	if ((0 == GLEW_VERSION_4_4) && (0 == GLEW_ARB_buffer_storage))
+	{
+		std::cout << "INFO: persistent buffer mapping is not supported, using buffer updates" << std::endl;
+		return(false);
+	}
+
+	regionCount = (regionCount < 1) ? 1 : ((regionCount > MAX_REGIONS) ? MAX_REGIONS : regionCount);
+
+	GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	GLsizeiptr bufferSize = (GLsizeiptr)(regionSize * regionCount);
+
+	glGenBuffers(1, &m_bufferID);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, m_bufferID);
+	glBufferStorage(GL_COPY_WRITE_BUFFER, bufferSize, NULL, flags);
+	m_pMappedData = (unsigned char*)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, bufferSize, flags);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	if (NULL == m_pMappedData)
+	{
+		std::cout << "ERROR: could not map the ring buffer" << std::endl;
+		Destroy();
+		return(false);
+	}
+
+	m_regionSize = regionSize;
+	m_regionCount = regionCount;
+	m_region = 0;
+	m_regionUsed = 0;
+	m_bGrowRequested = false;
+
+	return(true);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for waiting until the GPU no longer
+ *  reads the buffer and then unmapping and freeing it.
+ ***********************************************************/
+void PersistentRingBuffer::Destroy()
+{
+	for (int i = 0; i < MAX_REGIONS; i++)
+	{
+		if (NULL != m_fences[i])
+		{
+			WaitForRegion(i);
+		}
+	}
+
+	if (0 != m_bufferID)
+	{
+		if (NULL != m_pMappedData)
+		{
+			glBindBuffer(GL_COPY_WRITE_BUFFER, m_bufferID);
+			glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		}
+		glDeleteBuffers(1, &m_bufferID);
+	}
+
+	m_bufferID = 0;
+	m_pMappedData = NULL;
+	m_regionSize = 0;
+	m_regionCount = 0;
+}
+
+/***********************************************************
+ *  WaitForRegion()
+ *
+ *  This method is used for blocking until the fence of a
+ *  region has been passed by the GPU.  A fence that is not
+ *  signaled at the first check counts as a stall.
+ ***********************************************************/
+void PersistentRingBuffer::WaitForRegion(int region)
+{
+	GLsync fence = m_fences[region];
+
+	if (NULL == fence)
+	{
+		return;
+	}
+
+	GLenum result = glClientWaitSync(fence, 0, 0);
+	if ((GL_ALREADY_SIGNALED != result) && (GL_CONDITION_SATISFIED != result))
+	{
+		FrameStats::Current().ringBufferStalls++;
+		do
+		{
+			result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_WAIT_TIMEOUT);
+		} while (GL_TIMEOUT_EXPIRED == result);
+	}
+
+	glDeleteSync(fence);
+	m_fences[region] = NULL;
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for moving to the region of the new
+ *  frame.  When a region ran out of space in an earlier
+ *  frame the buffer is first recreated with twice the size.
+ ***********************************************************/
+void PersistentRingBuffer::BeginFrame()
+{
+	if (0 == m_bufferID)
+	{
+		return;
+	}
+
+	if (m_bGrowRequested)
+	{
+		size_t newRegionSize = m_regionSize * 2;
+		int regionCount = m_regionCount;
+
+		std::cout << "INFO: growing ring buffer regions to " << newRegionSize << " bytes" << std::endl;
+		if (false == Create(newRegionSize, regionCount))
+		{
+			return;
+		}
+	}
+	else
+	{
+		m_region = (m_region + 1) % m_regionCount;
+		WaitForRegion(m_region);
+	}
+
+	m_regionUsed = 0;
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used for placing a fence after the last
+ *  commands that read the region of the current frame.
+ ***********************************************************/
+void PersistentRingBuffer::EndFrame()
+{
+	if (0 == m_bufferID)
+	{
+		return;
+	}
+
+	if (NULL != m_fences[m_region])
+	{
+		glDeleteSync(m_fences[m_region]);
+	}
+	m_fences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+/***********************************************************
+ *  Allocate()
+ *
+ *  This method is used for reserving space in the region of
+ *  the current frame.  The returned memory is write-only
+ *  and visible to the GPU without any flush.
+ ***********************************************************/
+void* PersistentRingBuffer::Allocate(size_t size, size_t alignment, GLintptr& offset)
+{
+	if ((NULL == m_pMappedData) || (0 == size))
+	{
+		return(NULL);
+	}
+
+	alignment = (alignment > 0) ? alignment : 1;
+
+	size_t regionStart = (size_t)m_region * m_regionSize;
+	size_t start = regionStart + m_regionUsed;
+	start = ((start + alignment - 1) / alignment) * alignment;
+
+	if ((start + size) > (regionStart + m_regionSize))
+	{
+		if (false == m_bGrowRequested)
+		{
+			FrameStats::Current().ringBufferOverflows++;
+		}
+		m_bGrowRequested = true;
+		return(NULL);
+	}
+
+	m_regionUsed = (start + size) - regionStart;
+	offset = (GLintptr)start;
+
+	return(m_pMappedData + start);
+}
+
+/***********************************************************
+ *  GetBufferID()
+ *
+ *  This method is used for getting the buffer object name,
+ *  so ranges of it can be bound.
+ ***********************************************************/
+GLuint PersistentRingBuffer::GetBufferID() const
+{
+	return(m_bufferID);
+}
+
+/***********************************************************
+ *  GetUniformAlignment()
+ *
+ *  This method is used for getting the offset alignment
+ *  that uniform buffer ranges must have.
+ ***********************************************************/
+size_t PersistentRingBuffer::GetUniformAlignment()
+{
+	// the limit never changes, so it is only queried once
+	static GLint alignment = 0;
+
+	if (alignment <= 0)
+	{
+		glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+		alignment = (alignment > 0) ? alignment : 256;
+	}
+
+	return((size_t)alignment);
+}
@@ -0,0 +1,79 @@
+///////////////////////////////////////////////////////////////////////////////
+// persistentringbuffer.h
+// ============
+// persistently mapped, fenced ring buffer for data written every frame
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <stddef.h>
+
+/***********************************************************
+ *  PersistentRingBuffer
+ *
+ *  This class owns one buffer object that stays mapped for
+ *  its whole lifetime with GL_MAP_PERSISTENT_BIT and
+ *  GL_MAP_COHERENT_BIT.  The buffer is split into regions,
+ *  three by default, and each frame writes into the next
+ *  region.  A fence placed at the end of the frame tells
+ *  when the GPU has finished reading a region, so the CPU
+ *  only waits when it gets a full ring ahead of the GPU.
+ *  Those waits are counted in the frame stats, and a region
+ *  that runs out of space is doubled at the start of the
+ *  next frame.  Requires OpenGL 4.4 or ARB_buffer_storage.
+ ***********************************************************/
+class PersistentRingBuffer
+{
+public:
+	// constructor
+	PersistentRingBuffer();
+	// destructor
+	~PersistentRingBuffer();
+
+	// create and map the buffer - returns false when the
+	// context cannot map buffers persistently
+	bool Create(size_t regionSize, int regionCount = DEFAULT_REGION_COUNT);
+	// unmap and free the buffer
+	void Destroy();
+
+	// move to the next region, waiting for the GPU to finish
+	// reading it when needed
+	void BeginFrame();
+	// mark the end of the commands that read this region
+	void EndFrame();
+
+	// reserve space in the region of the current frame - the
+	// offset from the start of the buffer is a multiple of the
+	// alignment, which does not have to be a power of two -
+	// returns NULL when the region is full
+	void* Allocate(size_t size, size_t alignment, GLintptr& offset);
+
+	// get the buffer object name
+	GLuint GetBufferID() const;
+	// get the alignment needed for uniform buffer ranges
+	static size_t GetUniformAlignment();
+
+	// number of regions that frames rotate through
+	static const int DEFAULT_REGION_COUNT = 3;
+
+private:
+	static const int MAX_REGIONS = 4;
+
+	GLuint m_bufferID;
+	// start of the mapped buffer memory
+	unsigned char* m_pMappedData;
+	size_t m_regionSize;
+	int m_regionCount;
+	// region of the current frame and the next free byte in it
+	int m_region;
+	size_t m_regionUsed;
+	// fence placed after the last commands that read a region
+	GLsync m_fences[MAX_REGIONS];
+	// true when an allocation did not fit in a region
+	bool m_bGrowRequested;
+
+	// wait until the GPU has finished reading a region
+	void WaitForRegion(int region);
+};
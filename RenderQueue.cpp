@@ -0,0 +1,254 @@
+///////////////////////////////////////////////////////////////////////////////
+// renderqueue.cpp
+// ============
+// order draw commands by 64-bit state sort keys before submission
+///////////////////////////////////////////////////////////////////////////////
+
+#include "RenderQueue.h"
+
+#include <cstring>
+
+// declaration of global variables
+namespace
+{
+	// sizes of the key fields in bits
+	const int PROGRAM_BITS = 7;
+	const int MESH_BITS = 6;
+	const int TEXTURE_BITS = 10;
+	const int MATERIAL_BITS = 12;
+	const int DEPTH_BITS = 28;
+	const int STATE_BITS = PROGRAM_BITS + MESH_BITS + TEXTURE_BITS + MATERIAL_BITS;
+
+	const uint64_t STATE_MASK = ((uint64_t)1 << STATE_BITS) - 1;
+	const uint64_t DEPTH_MASK = ((uint64_t)1 << DEPTH_BITS) - 1;
+	const uint64_t TRANSLUCENT_BIT = (uint64_t)1 << 63;
+
+	// number of key bits sorted in each radix pass
+	const int RADIX_BITS = 8;
+	const int RADIX_SIZE = 1 << RADIX_BITS;
+
+	/***********************************************************
+	 *  QuantizeDepth()
+	 *
+	 *  This function is used for converting a view depth into
+	 *  an unsigned value that sorts in the same order.  The
+	 *  bits of a positive float already compare like integers,
+	 *  so the DEPTH_BITS below the clear sign bit are kept.
+	 ***********************************************************/
+	uint64_t QuantizeDepth(float depth)
+	{
+		uint32_t bits = 0;
+
+		// objects behind the camera sort with the nearest ones
+		if (!(depth > 0.0f))
+		{
+			depth = 0.0f;
+		}
+		memcpy(&bits, &depth, sizeof(bits));
+
+		return((uint64_t)(bits >> (32 - DEPTH_BITS - 1)) & DEPTH_MASK);
+	}
+
+	/***********************************************************
+	 *  GetStateBits()
+	 *
+	 *  This function is used for getting the program, mesh,
+	 *  texture and material fields out of a sort key.
+	 ***********************************************************/
+	uint64_t GetStateBits(uint64_t key)
+	{
+		if (0 != (key & TRANSLUCENT_BIT))
+		{
+			return(key & STATE_MASK);
+		}
+
+		return((key >> DEPTH_BITS) & STATE_MASK);
+	}
+}
+
+/***********************************************************
+ *  RenderQueue()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+RenderQueue::RenderQueue()
+{
+}
+
+/***********************************************************
+ *  MakeSortKey()
+ *
+ *  This method is used for packing the state and depth of a
+ *  draw command into a sort key.
+ ***********************************************************/
+uint64_t RenderQueue::MakeSortKey(
+	bool bTranslucent,
+	uint32_t program,
+	uint32_t mesh,
+	uint32_t texture,
+	uint32_t material,
+	float depth)
+{
+	uint64_t state = 0;
+	uint64_t depthBits = QuantizeDepth(depth);
+
+	state = (uint64_t)(program & ((1u << PROGRAM_BITS) - 1));
+	state = (state << MESH_BITS) | (mesh & ((1u << MESH_BITS) - 1));
+	state = (state << TEXTURE_BITS) | (texture & ((1u << TEXTURE_BITS) - 1));
+	state = (state << MATERIAL_BITS) | (material & ((1u << MATERIAL_BITS) - 1));
+
+	if (bTranslucent)
+	{
+		// farthest first, so blending sees the objects behind
+		return(TRANSLUCENT_BIT | ((DEPTH_MASK - depthBits) << STATE_BITS) | state);
+	}
+
+	return((state << DEPTH_BITS) | depthBits);
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for removing all draw commands.  The
+ *  memory is kept for the next frame.
+ ***********************************************************/
+void RenderQueue::Clear()
+{
+	m_entries.clear();
+}
+
+/***********************************************************
+ *  Add()
+ *
+ *  This method is used for adding a draw command and its
+ *  sort key to the end of the queue.
+ ***********************************************************/
+void RenderQueue::Add(uint64_t key, uint32_t itemIndex)
+{
+	RENDER_ENTRY entry;
+	entry.key = key;
+	entry.itemIndex = itemIndex;
+	m_entries.push_back(entry);
+}
+
+/***********************************************************
+ *  Append()
+ *
+ *  This method is used for adding a list of draw commands
+ *  with their sort keys, such as the ones recorded by a job,
+ *  to the end of the queue.
+ ***********************************************************/
+void RenderQueue::Append(const RENDER_ENTRY* pEntries, int count)
+{
+	if (count > 0)
+	{
+		m_entries.insert(m_entries.end(), pEntries, pEntries + count);
+	}
+}
+
+/***********************************************************
+ *  Sort()
+ *
+ *  This method is used for ordering the draw commands by
+ *  their keys with a stable LSD radix sort, 8 bits per pass.
+ *  Passes over bytes that are equal in every key are skipped,
+ *  which removes most of them for the small number of
+ *  distinct states in a scene.
+ ***********************************************************/
+void RenderQueue::Sort()
+{
+	size_t count = m_entries.size();
+	if (count < 2)
+	{
+		return;
+	}
+
+	m_sortBuffer.resize(count);
+
+	for (int shift = 0; shift < 64; shift += RADIX_BITS)
+	{
+		size_t histogram[RADIX_SIZE] = {};
+
+		for (size_t i = 0; i < count; i++)
+		{
+			histogram[(m_entries[i].key >> shift) & (RADIX_SIZE - 1)]++;
+		}
+
+		// every key has the same byte so the order is unchanged
+		if (histogram[(m_entries[0].key >> shift) & (RADIX_SIZE - 1)] == count)
+		{
+			continue;
+		}
+
+		size_t offset = 0;
+		for (int bucket = 0; bucket < RADIX_SIZE; bucket++)
+		{
+			size_t bucketCount = histogram[bucket];
+			histogram[bucket] = offset;
+			offset += bucketCount;
+		}
+
+		for (size_t i = 0; i < count; i++)
+		{
+			m_sortBuffer[histogram[(m_entries[i].key >> shift) & (RADIX_SIZE - 1)]++] = m_entries[i];
+		}
+
+		m_entries.swap(m_sortBuffer);
+	}
+}
+
+/***********************************************************
+ *  GetCount()
+ *
+ *  This method is used for getting the number of draw
+ *  commands in the queue.
+ ***********************************************************/
+int RenderQueue::GetCount() const
+{
+	return((int)m_entries.size());
+}
+
+/***********************************************************
+ *  GetItemIndex()
+ *
+ *  This method is used for getting the index of the draw
+ *  command at a position in the queue.
+ ***********************************************************/
+uint32_t RenderQueue::GetItemIndex(int position) const
+{
+	return(m_entries[position].itemIndex);
+}
+
+/***********************************************************
+ *  CountStateChanges()
+ *
+ *  This method is used for counting how many of the program,
+ *  mesh, texture and material fields change from one draw
+ *  command to the next in the current order.  The first
+ *  draw counts as changing all of them.
+ ***********************************************************/
+int RenderQueue::CountStateChanges() const
+{
+	const uint64_t fieldMasks[4] =
+	{
+		(((uint64_t)1 << PROGRAM_BITS) - 1) << (MESH_BITS + TEXTURE_BITS + MATERIAL_BITS),
+		(((uint64_t)1 << MESH_BITS) - 1) << (TEXTURE_BITS + MATERIAL_BITS),
+		(((uint64_t)1 << TEXTURE_BITS) - 1) << MATERIAL_BITS,
+		((uint64_t)1 << MATERIAL_BITS) - 1
+	};
+	int changes = 0;
+
+	for (size_t i = 0; i < m_entries.size(); i++)
+	{
+		uint64_t state = GetStateBits(m_entries[i].key);
+		for (int field = 0; field < 4; field++)
+		{
+			if ((0 == i) || ((state & fieldMasks[field]) != (GetStateBits(m_entries[i - 1].key) & fieldMasks[field])))
+			{
+				changes++;
+			}
+		}
+	}
+
+	return(changes);
+}
@@ -0,0 +1,73 @@
+///////////////////////////////////////////////////////////////////////////////
+// renderqueue.h
+// ============
+// order draw commands by 64-bit state sort keys before submission
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+/***********************************************************
+ *  RenderQueue
+ *
+ *  This class holds one 64-bit sort key per draw command
+ *  and orders the commands with an LSD radix sort, so draws
+ *  that share a shader program, mesh, texture and material
+ *  are submitted next to each other.  The key layout is
+ *
+ *    opaque:       0 | program:7 | mesh:6 | texture:10 |
+ *                  material:12 | depth:28
+ *    translucent:  1 | ~depth:28 | program:7 | mesh:6 |
+ *                  texture:10 | material:12
+ *
+ *  so opaque draws come first, grouped by state and then
+ *  front to back, and translucent draws follow back to front.
+ ***********************************************************/
+class RenderQueue
+{
+public:
+	struct RENDER_ENTRY
+	{
+		uint64_t key;
+		// index of the draw command in the caller's list
+		uint32_t itemIndex;
+	};
+
+	// constructor
+	RenderQueue();
+
+	// build the sort key of a draw command - the state values
+	// are truncated to the size of their key field and the
+	// depth is the view space distance in front of the camera
+	static uint64_t MakeSortKey(
+		bool bTranslucent,
+		uint32_t program,
+		uint32_t mesh,
+		uint32_t texture,
+		uint32_t material,
+		float depth);
+
+	// remove all draw commands from the queue
+	void Clear();
+	// add a draw command with its sort key
+	void Add(uint64_t key, uint32_t itemIndex);
+	// add a list of draw commands with their sort keys
+	void Append(const RENDER_ENTRY* pEntries, int count);
+	// order the draw commands by their sort keys
+	void Sort();
+
+	// get the number of draw commands in the queue
+	int GetCount() const;
+	// get the draw command at a position in the queue
+	uint32_t GetItemIndex(int position) const;
+	// count the program, mesh, texture and material changes
+	// between neighbouring draw commands in the current order
+	int CountStateChanges() const;
+
+private:
+	std::vector<RENDER_ENTRY> m_entries;
+	// second buffer the radix sort scatters into
+	std::vector<RENDER_ENTRY> m_sortBuffer;
+};
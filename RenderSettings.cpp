@@ -0,0 +1,39 @@
+///////////////////////////////////////////////////////////////////////////////
+// rendersettings.cpp
+// ============
+// rendering options that can be switched while the application is running
+///////////////////////////////////////////////////////////////////////////////
+
+#include "RenderSettings.h"
+
+// declaration of global variables
+namespace
+{
+	RenderSettings::RENDER_SETTINGS g_RenderSettings =
+	{
+		true,	// bFilterRedundantState
+		true,	// bSortDraws
+		true,	// bInstancedDraws
+		true,	// bMultiDrawIndirect
+		true,	// bTextureArrays
+		true,	// bFrustumCulling
+		true,	// bHierarchicalCulling
+		true,	// bOcclusionCulling
+		true,	// bLevelOfDetail
+		true,	// bStaticBatching
+		true,	// bOrderIndependentTransparency
+		true,	// bCompressedTextures
+		true,	// bTextureCache
+	};
+}
+
+/***********************************************************
+ *  Get()
+ *
+ *  This method is used for getting the active rendering
+ *  options so they can be read or changed.
+ ***********************************************************/
+RenderSettings::RENDER_SETTINGS& RenderSettings::Get()
+{
+	return(g_RenderSettings);
+}
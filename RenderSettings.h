@@ -0,0 +1,70 @@
+///////////////////////////////////////////////////////////////////////////////
+// rendersettings.h
+// ============
+// rendering options that can be switched while the application is running
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+/***********************************************************
+ *  RenderSettings
+ *
+ *  This class holds the rendering options that are read by
+ *  the scene and state managers and changed from keyboard
+ *  input, so the cost of each optimization can be measured
+ *  by turning it off and on at runtime.
+ ***********************************************************/
+class RenderSettings
+{
+public:
+	struct RENDER_SETTINGS
+	{
+		// drop uniform and GL state writes that repeat the
+		// last value sent to the driver
+		bool bFilterRedundantState;
+		// submit draws ordered by their state sort keys
+		// instead of the order they were authored in
+		bool bSortDraws;
+		// draw opaque objects that share a mesh, texture and
+		// material with one instanced draw call
+		bool bInstancedDraws;
+		// submit the instance batches with multi-draw-indirect
+		// calls instead of one draw call per batch
+		bool bMultiDrawIndirect;
+		// pack the textures into texture arrays by size and
+		// select them by layer - read when the scene is loaded
+		bool bTextureArrays;
+		// skip objects whose bounds are outside the view
+		// frustum before they are queued for drawing
+		bool bFrustumCulling;
+		// cull through the bounding volume hierarchy instead
+		// of testing every object box
+		bool bHierarchicalCulling;
+		// skip objects hidden behind the largest boxes and
+		// quads in view, tested against a depth pyramid
+		bool bOcclusionCulling;
+		// draw curved shapes with fewer triangles the smaller
+		// they are on screen
+		bool bLevelOfDetail;
+		// draw the objects that have not moved from merged
+		// world-space batches
+		bool bStaticBatching;
+		// draw translucent objects into weighted blended
+		// order-independent transparency targets, unsorted
+		// and instanced, instead of one at a time back to front
+		bool bOrderIndependentTransparency;
+		// upload cooked textures still block compressed when
+		// the context supports the format, instead of
+		// decompressing them on the CPU - read when the scene
+		// is loaded
+		bool bCompressedTextures;
+		// map decoded and mipmapped textures from the texture
+		// cache next to their images instead of decoding them,
+		// and write the cache when it is missing or stale -
+		// read when the scene is loaded
+		bool bTextureCache;
+	};
+
+	// get the active rendering options
+	static RENDER_SETTINGS& Get();
+};
@@ -0,0 +1,186 @@
+///////////////////////////////////////////////////////////////////////////////
+// renderstate.cpp
+// ============
+// shadow copy of OpenGL pipeline state used to drop redundant state changes
+///////////////////////////////////////////////////////////////////////////////
+
+#include "RenderState.h"
+#include "RenderSettings.h"
+#include "FrameStats.h"
+
+#include <vector>
+
+// declaration of global variables
+namespace
+{
+	struct CAPABILITY_STATE
+	{
+		GLenum capability;
+		bool bEnabled;
+	};
+
+	// last known state of each capability that has been set
+	std::vector<CAPABILITY_STATE> g_Capabilities;
+
+	// last blending factors, valid once they have been set
+	bool g_bBlendFuncValid = false;
+	GLenum g_BlendSource = GL_ONE;
+	GLenum g_BlendDestination = GL_ZERO;
+
+	// last depth write mask, valid once it has been set
+	bool g_bDepthMaskValid = false;
+	GLboolean g_bDepthMask = GL_TRUE;
+
+	/***********************************************************
+	 *  IsFilterEnabled()
+	 *
+	 *  This function is used for checking whether redundant
+	 *  state writes should be dropped.
+	 ***********************************************************/
+	bool IsFilterEnabled()
+	{
+		return(RenderSettings::Get().bFilterRedundantState);
+	}
+}
+
+/***********************************************************
+ *  Enable()
+ *
+ *  This method is used for enabling an OpenGL capability.
+ ***********************************************************/
+void RenderState::Enable(GLenum capability)
+{
+	SetCapability(capability, true);
+}
+
+/***********************************************************
+ *  Disable()
+ *
+ *  This method is used for disabling an OpenGL capability.
+ ***********************************************************/
+void RenderState::Disable(GLenum capability)
+{
+	SetCapability(capability, false);
+}
+
+/***********************************************************
+ *  SetCapability()
+ *
+ *  This method is used for changing a capability and only
+ *  calling OpenGL when the capability is not already in the
+ *  requested state.
+ ***********************************************************/
+void RenderState::SetCapability(GLenum capability, bool bEnabled)
+{
+	CAPABILITY_STATE* pState = NULL;
+
+	for (size_t i = 0; i < g_Capabilities.size(); i++)
+	{
+		if (g_Capabilities[i].capability == capability)
+		{
+			pState = &g_Capabilities[i];
+			break;
+		}
+	}
+
+	if ((NULL != pState) && (pState->bEnabled == bEnabled) && IsFilterEnabled())
+	{
+		FrameStats::Current().stateChangesSuppressed++;
+		return;
+	}
+
+	if (bEnabled)
+	{
+		glEnable(capability);
+	}
+	else
+	{
+		glDisable(capability);
+	}
+	FrameStats::Current().stateChangesIssued++;
+
+	if (NULL == pState)
+	{
+		CAPABILITY_STATE state;
+		state.capability = capability;
+		state.bEnabled = bEnabled;
+		g_Capabilities.push_back(state);
+	}
+	else
+	{
+		pState->bEnabled = bEnabled;
+	}
+}
+
+/***********************************************************
+ *  BlendFunc()
+ *
+ *  This method is used for setting the blending factors.
+ ***********************************************************/
+void RenderState::BlendFunc(GLenum sourceFactor, GLenum destinationFactor)
+{
+	if (g_bBlendFuncValid && IsFilterEnabled() &&
+		(g_BlendSource == sourceFactor) && (g_BlendDestination == destinationFactor))
+	{
+		FrameStats::Current().stateChangesSuppressed++;
+		return;
+	}
+
+	glBlendFunc(sourceFactor, destinationFactor);
+	FrameStats::Current().stateChangesIssued++;
+
+	g_bBlendFuncValid = true;
+	g_BlendSource = sourceFactor;
+	g_BlendDestination = destinationFactor;
+}
+
+/***********************************************************
+ *  BlendFunci()
+ *
+ *  This method is used for setting the blending factors of
+ *  one draw buffer.  The factors of the draw buffers are
+ *  not remembered, and after one of them differs the shared
+ *  factors are no longer known, so the next BlendFunc() is
+ *  always sent.
+ ***********************************************************/
+void RenderState::BlendFunci(GLuint drawBuffer, GLenum sourceFactor, GLenum destinationFactor)
+{
+	glBlendFunci(drawBuffer, sourceFactor, destinationFactor);
+	FrameStats::Current().stateChangesIssued++;
+
+	g_bBlendFuncValid = false;
+}
+
+/***********************************************************
+ *  DepthMask()
+ *
+ *  This method is used for setting whether depth values
+ *  are written by draw commands.
+ ***********************************************************/
+void RenderState::DepthMask(GLboolean bWriteDepth)
+{
+	if (g_bDepthMaskValid && IsFilterEnabled() && (g_bDepthMask == bWriteDepth))
+	{
+		FrameStats::Current().stateChangesSuppressed++;
+		return;
+	}
+
+	glDepthMask(bWriteDepth);
+	FrameStats::Current().stateChangesIssued++;
+
+	g_bDepthMaskValid = true;
+	g_bDepthMask = bWriteDepth;
+}
+
+/***********************************************************
+ *  Invalidate()
+ *
+ *  This method is used for forgetting all the remembered
+ *  state, so the next write of each piece of state is sent.
+ ***********************************************************/
+void RenderState::Invalidate()
+{
+	g_Capabilities.clear();
+	g_bBlendFuncValid = false;
+	g_bDepthMaskValid = false;
+}
@@ -0,0 +1,41 @@
+///////////////////////////////////////////////////////////////////////////////
+// renderstate.h
+// ============
+// shadow copy of OpenGL pipeline state used to drop redundant state changes
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+/***********************************************************
+ *  RenderState
+ *
+ *  This class sits between the application and OpenGL for
+ *  pipeline state such as enabled capabilities and blending.
+ *  It remembers the last value sent for each piece of state
+ *  and drops writes that would not change anything, when
+ *  redundant state filtering is switched on.
+ ***********************************************************/
+class RenderState
+{
+public:
+	// enable or disable an OpenGL capability
+	static void Enable(GLenum capability);
+	static void Disable(GLenum capability);
+
+	// set the blending factors
+	static void BlendFunc(GLenum sourceFactor, GLenum destinationFactor);
+	// set the blending factors of one draw buffer
+	static void BlendFunci(GLuint drawBuffer, GLenum sourceFactor, GLenum destinationFactor);
+	// set whether depth values are written
+	static void DepthMask(GLboolean bWriteDepth);
+
+	// forget the remembered state, for example after code
+	// outside this class has changed OpenGL state directly
+	static void Invalidate();
+
+private:
+	// set a capability through the shadow state
+	static void SetCapability(GLenum capability, bool bEnabled);
+};
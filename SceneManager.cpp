@@ -8,6 +8,10 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "SceneManager.h"
+#include "ShaderBindings.h"
+#include "FrameStats.h"
+#include "RenderSettings.h"
+#include "RenderState.h"
 
 #ifndef STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_IMPLEMENTATION
@@ -16,6 +20,13 @@
 
 #include <glm/gtx/transform.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <functional>
+
 // declaration of global variables
 namespace
 {
@@ -24,6 +35,177 @@ namespace
 	const char* g_TextureValueName = "objectTexture";
 	const char* g_UseTextureName = "bUseTexture";
 	const char* g_UseLightingName = "bUseLighting";
+	const char* g_UVScaleName = "UVscale";
+	const char* g_MaterialIndexName = "materialIndex";
+	const char* g_MaterialDataBlockName = "MaterialData";
+	const char* g_UseInstanceDataName = "bUseInstanceData";
+	const char* g_InstanceModelName = "instanceModel";
+	const char* g_TextureArrayName = "objectTextureArray";
+	const char* g_TextureLayerName = "textureLayer";
+	const char* g_TransparencyPassName = "bTransparencyPass";
+	const char* g_ObjectIndexName = "objectIndex";
+
+	// fewest moved objects for which the matrices are rebuilt
+	// in a batch rather than one at a time
+	const int MIN_TRANSFORM_BATCH = 8;
+	// objects per job when the matrices and bounds of moved
+	// objects are rebuilt, and when boxes are frustum tested,
+	// on the job system
+	const int TRANSFORM_JOB_SIZE = 2048;
+	const int CULLING_JOB_SIZE = 8192;
+	// draws per job and per record packet in the other record
+	// phase passes
+	const int RECORD_JOB_SIZE = 4096;
+	// when more than one in this many objects moved, the
+	// whole hierarchy is refit in one pass instead of walking
+	// up from every moved object
+	const int HIERARCHY_REFIT_DIVISOR = 8;
+	// most occluders drawn into the depth pyramid per frame,
+	// and the smallest ratio of bounding radius to distance
+	// for an object to be considered as an occluder
+	const int MAX_OCCLUDERS = 32;
+	const float MIN_OCCLUDER_SIZE = 0.1f;
+	// screen size, as a fraction of half the viewport height,
+	// below which each level of detail switches to the next
+	// one, and how far past a switch the size has to move
+	// before switching back, so objects near a switch do not
+	// flicker between two levels
+	const float LOD_SCREEN_SIZES[InstancedMeshes::LOD_COUNT - 1] = { 0.25f, 0.1f, 0.04f };
+	const float LOD_HYSTERESIS = 0.2f;
+
+	// distance between copies of the desk setup, larger than
+	// the 15 x 10 desk top so neighbouring desks do not touch
+	const float DESK_SPACING_X = 18.0f;
+	const float DESK_SPACING_Z = 14.0f;
+
+	// distance between the extra translucent spheres, their
+	// size and alpha, and the height of the lowest layer
+	const float TRANSLUCENT_SPACING = 1.0f;
+	const float TRANSLUCENT_SCALE = 0.35f;
+	const float TRANSLUCENT_ALPHA = 0.4f;
+	const float TRANSLUCENT_BASE_HEIGHT = 2.0f;
+
+	// center and half size of the local bounding box of each
+	// basic shape mesh, in MESH_TYPE order
+	const glm::vec3 g_MeshBounds[SceneManager::MESH_COUNT][2] =
+	{
+		// box - unit cube around the origin
+		{ glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.5f, 0.5f, 0.5f) },
+		// plane - 2 x 2 square in the XZ plane
+		{ glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(1.0f, 0.0f, 1.0f) },
+		// cylinder, cone and tapered cylinder - radius 1 from
+		// a base at the origin up to a height of 1
+		{ glm::vec3(0.0f, 0.5f, 0.0f), glm::vec3(1.0f, 0.5f, 1.0f) },
+		{ glm::vec3(0.0f, 0.5f, 0.0f), glm::vec3(1.0f, 0.5f, 1.0f) },
+		{ glm::vec3(0.0f, 0.5f, 0.0f), glm::vec3(1.0f, 0.5f, 1.0f) },
+		// sphere - radius 1
+		{ glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(1.0f, 1.0f, 1.0f) },
+		// torus - ring of radius 1 around Z with a 0.2 tube
+		{ glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(1.2f, 1.2f, 0.2f) },
+	};
+
+	/***********************************************************
+	 *  GetInstancedShape()
+	 *
+	 *  This function is used for getting the instanced shape
+	 *  that matches a scene mesh type.
+	 ***********************************************************/
+	InstancedMeshes::SHAPE GetInstancedShape(SceneManager::MESH_TYPE mesh)
+	{
+		switch (mesh)
+		{
+		case SceneManager::MESH_BOX:
+			return(InstancedMeshes::SHAPE_BOX);
+		case SceneManager::MESH_PLANE:
+			return(InstancedMeshes::SHAPE_PLANE);
+		case SceneManager::MESH_CYLINDER:
+			return(InstancedMeshes::SHAPE_CYLINDER);
+		case SceneManager::MESH_CONE:
+			return(InstancedMeshes::SHAPE_CONE);
+		case SceneManager::MESH_TAPERED_CYLINDER:
+			return(InstancedMeshes::SHAPE_TAPERED_CYLINDER);
+		case SceneManager::MESH_SPHERE:
+			return(InstancedMeshes::SHAPE_SPHERE);
+		case SceneManager::MESH_TORUS:
+		default:
+			return(InstancedMeshes::SHAPE_TORUS);
+		}
+	}
+
+	/***********************************************************
+	 *  CanJoinBatch()
+	 *
+	 *  This function is used for checking whether a batch can
+	 *  be drawn as part of the batch before it, which needs the
+	 *  same draw state and the instances right after its own.
+	 ***********************************************************/
+	bool CanJoinBatch(const SceneManager::INSTANCE_BATCH& previous, const SceneManager::INSTANCE_BATCH& batch)
+	{
+		return((previous.mesh == batch.mesh) &&
+			(previous.lod == batch.lod) &&
+			(previous.textureUnit == batch.textureUnit) &&
+			(previous.materialIndex == batch.materialIndex) &&
+			(previous.bTranslucent == batch.bTranslucent) &&
+			(previous.firstInstance + previous.instanceCount == batch.firstInstance));
+	}
+
+	// interned tags of the scene textures
+	constexpr TagId g_DeskTexture("desk");
+	constexpr TagId g_MonitorTexture("monitor");
+	constexpr TagId g_ScreenTexture("screen");
+	constexpr TagId g_MetalTexture("metal");
+
+	// interned tags of the object materials
+	constexpr TagId g_GlossyMaterial("glossy");
+	constexpr TagId g_MetalMaterial("metal");
+	constexpr TagId g_WoodMaterial("wood");
+	constexpr TagId g_MatteMaterial("matte");
+	constexpr TagId g_CeramicMaterial("ceramic");
+	constexpr TagId g_DefaultMaterial("default");
+
+	// the objects making up the 3D scene - only one instance of
+	// a particular mesh is loaded in memory no matter how many
+	// times it is drawn in the rendered 3D scene
+	const SceneManager::SCENE_OBJECT g_SceneObjects[] =
+	{
+		// DESK - Draw as a box instead of a plane, WIDER desk,
+		// raised slightly so top is at y=0, wood with medium shine
+		{ SceneManager::MESH_BOX, glm::vec3(15.0f, 0.5f, 10.0f), 0.0f, 0.0f, 0.0f, glm::vec3(0.0f, -0.25f, 0.0f),
+			glm::vec4(0.91f, 0.85f, 0.85f, 1.0f), g_DeskTexture, g_WoodMaterial, glm::vec2(1.5f, 1.0f) },
+		// monitor box - centered on desk, matte plastic casing
+		{ SceneManager::MESH_BOX, glm::vec3(10.0f, 0.15f, 4.5f), 90.0f, 0.0f, 0.0f, glm::vec3(0.0f, 5.0f, 0.0f),
+			glm::vec4(0.2f, 0.2f, 0.2f, 1.0f), g_MonitorTexture, g_MatteMaterial, glm::vec2(1.0f, 1.0f) },
+		// cylinder plate under monitor box - centered on desk, shiny metal
+		{ SceneManager::MESH_CYLINDER, glm::vec3(0.5f, 0.5f, 2.5f), 0.0f, 90.0f, 0.0f, glm::vec3(0.0f, 0.0f, 0.0f),
+			glm::vec4(0.1f, 0.1f, 0.1f, 1.0f), TagId(), g_MetalMaterial, glm::vec2(1.0f, 1.0f) },
+		// tapered cylinder for monitor stand - centered on desk, shiny metal
+		{ SceneManager::MESH_TAPERED_CYLINDER, glm::vec3(0.2f, 5.0f, 1.0f), 0.0f, 90.0f, 0.0f, glm::vec3(0.0f, 0.0f, 0.0f),
+			glm::vec4(0.1f, 0.1f, 0.1f, 1.0f), g_MetalTexture, g_MetalMaterial, glm::vec2(1.0f, 2.0f) },
+		// plane for the monitor screen - centered with monitor body, glossy
+		{ SceneManager::MESH_PLANE, glm::vec3(4.0f, 1.0f, 2.0f), 90.0f, 0.0f, 0.0f, glm::vec3(-0.25f, 5.0f, 0.5f),
+			glm::vec4(1.0f, 1.0f, 1.0f, 1.0f), g_ScreenTexture, g_GlossyMaterial, glm::vec2(1.0f, 1.0f) },
+		// KEYBOARD - in front of monitor on desk, dark matte plastic
+		{ SceneManager::MESH_BOX, glm::vec3(5.0f, 0.15f, 1.0f), 0.0f, 0.0f, 0.0f, glm::vec3(0.0f, 0.075f, 3.0f),
+			glm::vec4(0.1f, 0.1f, 0.1f, 1.0f), TagId(), g_MatteMaterial, glm::vec2(1.0f, 1.0f) },
+		// DESK LAMP base - to the left of monitor, dark metal
+		{ SceneManager::MESH_CYLINDER, glm::vec3(0.5f, 0.3f, 0.3f), 0.0f, 0.0f, 0.0f, glm::vec3(-5.5f, 0.10f, 2.0f),
+			glm::vec4(0.2f, 0.2f, 0.2f, 1.0f), TagId(), g_MetalMaterial, glm::vec2(1.0f, 1.0f) },
+		// lamp pole - rising from base, dark metal
+		{ SceneManager::MESH_CYLINDER, glm::vec3(0.12f, 0.12f, 2.8f), 90.0f, 0.0f, 0.0f, glm::vec3(-5.5f, 0.3f, 2.0f),
+			glm::vec4(0.15f, 0.15f, 0.15f, 1.0f), TagId(), g_MetalMaterial, glm::vec2(1.0f, 1.0f) },
+		// lamp shade - cone flipped upside down at top of pole, warm cream matte
+		{ SceneManager::MESH_CONE, glm::vec3(0.7f, 0.9f, 0.7f), 180.0f, 0.0f, 0.0f, glm::vec3(-5.5f, 3.1f, 2.0f),
+			glm::vec4(0.9f, 0.85f, 0.7f, 1.0f), TagId(), g_MatteMaterial, glm::vec2(1.0f, 1.0f) },
+		// lamp bulb - inside shade, warm yellow-white glossy
+		{ SceneManager::MESH_SPHERE, glm::vec3(0.3f, 0.3f, 0.3f), 0.0f, 0.0f, 0.0f, glm::vec3(-5.5f, 2.7f, 2.0f),
+			glm::vec4(1.0f, 0.95f, 0.8f, 1.0f), TagId(), g_GlossyMaterial, glm::vec2(1.0f, 1.0f) },
+		// COFFEE MUG body - right side of desk near keyboard, red ceramic
+		{ SceneManager::MESH_CYLINDER, glm::vec3(0.45f, 0.45f, 0.65f), 0.0f, 0.0f, 0.0f, glm::vec3(5.0f, 0.325f, 2.5f),
+			glm::vec4(0.85f, 0.25f, 0.15f, 1.0f), TagId(), g_CeramicMaterial, glm::vec2(1.0f, 1.0f) },
+		// mug handle - rotated to face outward on the side of the mug
+		{ SceneManager::MESH_TORUS, glm::vec3(0.28f, 0.38f, 0.1f), 0.0f, 90.0f, 0.0f, glm::vec3(5.5f, 0.325f, 2.5f),
+			glm::vec4(0.85f, 0.25f, 0.15f, 1.0f), TagId(), g_CeramicMaterial, glm::vec2(1.0f, 1.0f) },
+	};
 }
 
 /***********************************************************
@@ -31,10 +213,36 @@ namespace
  *
  *  The constructor for the class
  ***********************************************************/
-SceneManager::SceneManager(ShaderManager* pShaderManager)
+SceneManager::SceneManager(ShaderManager* pShaderManager, ShaderUniforms* pShaderUniforms)
 {
 	m_pShaderManager = pShaderManager;
+	m_pShaderUniforms = pShaderUniforms;
+	m_pLightManager = new LightManager(pShaderManager);
 	m_basicMeshes = new ShapeMeshes();
+	for (int i = 0; i < MESH_COUNT; i++)
+	{
+		m_basicMeshTriangles[i] = 0;
+		m_basicMeshQueries[i] = 0;
+	}
+	m_pInstancedMeshes = new InstancedMeshes();
+	m_instanceBufferID = 0;
+	m_instanceCapacity = 0;
+	m_instanceCount = 0;
+	m_drawCommandBufferID = 0;
+	m_drawCommandCapacity = 0;
+	m_frameInstanceBuffer = 0;
+	m_pRingBuffer = NULL;
+	m_pJobSystem = NULL;
+	m_bUseInstancing = false;
+	m_deskCount = 1;
+	m_translucentCount = 0;
+	m_bUseTransparencyBuffer = false;
+	m_bUseTextureArrays = false;
+	m_materialBufferID = 0;
+	m_bUseMaterialTable = false;
+	m_viewMatrix = glm::mat4(1.0f);
+	m_cameraPosition = glm::vec3(0.0f, 0.0f, 0.0f);
+	m_projectionMatrix = glm::mat4(1.0f);
 }
 
 /***********************************************************
@@ -44,97 +252,143 @@ SceneManager::SceneManager(ShaderManager* pShaderManager)
  ***********************************************************/
 SceneManager::~SceneManager()
 {
+	DestroyMaterialTable();
+	DestroyGLTextures();
+	m_textureLoader.Destroy();
 	m_pShaderManager = NULL;
+	m_pShaderUniforms = NULL;
+	delete m_pLightManager;
+	m_pLightManager = NULL;
+	for (int i = 0; i < MESH_COUNT; i++)
+	{
+		if (0 != m_basicMeshQueries[i])
+		{
+			glDeleteQueries(1, &m_basicMeshQueries[i]);
+			m_basicMeshQueries[i] = 0;
+		}
+	}
 	delete m_basicMeshes;
 	m_basicMeshes = NULL;
+	delete m_pInstancedMeshes;
+	m_pInstancedMeshes = NULL;
+	m_staticBatches.Destroy();
+	m_transparencyBuffer.Destroy();
+	if (0 != m_instanceBufferID)
+	{
+		glDeleteBuffers(1, &m_instanceBufferID);
+		m_instanceBufferID = 0;
+	}
+	if (0 != m_drawCommandBufferID)
+	{
+		glDeleteBuffers(1, &m_drawCommandBufferID);
+		m_drawCommandBufferID = 0;
+	}
 }
 
 /***********************************************************
  *  CreateGLTexture()
  *
- *  This method is used for loading textures from image files,
- *  configuring the texture mapping parameters in OpenGL,
- *  generating the mipmaps, and loading the read texture into
- *  the next available texture slot in memory.
+ *  This method is used for registering a texture in the next
+ *  available texture slot and starting to load its image in
+ *  the background.  The slot holds the placeholder texture
+ *  until the loaded texture replaces it.  With texture arrays
+ *  a layer of the size bucket is reserved from the image size
+ *  alone, so draws know their layer before the image is
+ *  decoded, and the image is uploaded into it once
+ *  BindGLTextures() has built the arrays.  When the image was
+ *  cooked with "--cook", its compressed file is loaded instead.
  ***********************************************************/
-bool SceneManager::CreateGLTexture(const char* filename, std::string tag)
+bool SceneManager::CreateGLTexture(const char* filename, TagId tag)
 {
 	int width = 0;
 	int height = 0;
 	int colorChannels = 0;
-	GLuint textureID = 0;
-
-	// indicate to always flip images vertically when loaded
-	stbi_set_flip_vertically_on_load(true);
-
-	// try to parse the image data from the specified image file
-	unsigned char* image = stbi_load(
-		filename,
-		&width,
-		&height,
-		&colorChannels,
-		0);
-
-	// if the image was successfully read from the image file
-	if (image)
-	{
-		std::cout << "Successfully loaded image:" << filename << ", width:" << width << ", height:" << height << ", channels:" << colorChannels << std::endl;
-
-		glGenTextures(1, &textureID);
-		glBindTexture(GL_TEXTURE_2D, textureID);
-
-		// set the texture wrapping parameters
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		// set texture filtering parameters
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-		// if the loaded image is in RGB format
-		if (colorChannels == 3)
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, image);
-		// if the loaded image is in RGBA format - it supports transparency
-		else if (colorChannels == 4)
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
-		else
+	GLint maxTextureUnits = 0;
+	TEXTURE_INFO texture;
+
+	// every separate texture needs its own texture unit, below
+	// the units the application keeps for its own textures
+	glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &maxTextureUnits);
+	maxTextureUnits = (maxTextureUnits < TextureUnit::FIRST_RESERVED) ? maxTextureUnits : TextureUnit::FIRST_RESERVED;
+	if ((false == m_bUseTextureArrays) && ((int)m_textureIDs.size() >= maxTextureUnits))
+	{
+		std::cout << "ERROR: all " << maxTextureUnits << " texture units are used, cannot load " << filename << std::endl;
+		return false;
+	}
+
+	// read only the size from the image file header
+	if (0 == stbi_info(filename, &width, &height, &colorChannels))
+	{
+		std::cout << "Could not load image:" << filename << std::endl;
+		return false;
+	}
+
+	texture.tag = tag;
+	texture.ID = 0;
+	texture.unit = (int)m_textureIDs.size();
+	texture.layer = -1;
+
+	if (m_bUseTextureArrays)
+	{
+		TextureArrays::TEXTURE_LOCATION location;
+		if (false == m_textureArrays.ReserveLayer(width, height, location))
 		{
-			std::cout << "Not implemented to handle image with " << colorChannels << " channels" << std::endl;
 			return false;
 		}
 
-		// generate the texture mipmaps for mapping textures to lower resolutions
-		glGenerateMipmap(GL_TEXTURE_2D);
-
-		// free the image data from local memory
-		stbi_image_free(image);
-		glBindTexture(GL_TEXTURE_2D, 0); // Unbind the texture
-
-		// register the loaded texture and associate it with the special tag string
-		m_textureIDs[m_loadedTextures].ID = textureID;
-		m_textureIDs[m_loadedTextures].tag = tag;
-		m_loadedTextures++;
+		// each size bucket is sampled from its own unit
+		texture.unit = location.bucket;
+		texture.layer = location.layer;
+		m_textureLoader.LoadTextureLayer(filename, &m_textureArrays, location);
+	}
+	else
+	{
+		// the loaded texture replaces the placeholder on the unit
+		// of its slot, so nothing that refers to the slot changes
+		int textureSlot = (int)m_textureIDs.size();
+		int textureUnit = texture.unit;
 
-		return true;
+		texture.ID = m_textureLoader.GetPlaceholderID();
+		m_textureLoader.LoadTexture(filename, [this, textureSlot, textureUnit](GLuint textureID)
+		{
+			m_textureIDs[textureSlot].ID = textureID;
+			glActiveTexture(GL_TEXTURE0 + textureUnit);
+			glBindTexture(GL_TEXTURE_2D, textureID);
+		});
 	}
 
-	std::cout << "Could not load image:" << filename << std::endl;
+	// register the texture and associate it with the special tag string
+	m_textureSlots.Add(tag, (int)m_textureIDs.size());
+	m_textureIDs.push_back(texture);
 
-	// Error loading the image
-	return false;
+	return true;
 }
 
 /***********************************************************
  *  BindGLTextures()
  *
  *  This method is used for binding the loaded textures to
- *  OpenGL texture memory slots.  There are up to 16 slots.
+ *  OpenGL texture memory slots.  Separate textures take one
+ *  slot each, while texture arrays are uploaded first and
+ *  take one slot per size bucket.
  ***********************************************************/
 void SceneManager::BindGLTextures()
 {
-	for (int i = 0; i < m_loadedTextures; i++)
+	if (m_bUseTextureArrays)
+	{
+		m_textureArrays.Build();
+		for (size_t i = 0; i < m_textureIDs.size(); i++)
+		{
+			m_textureIDs[i].ID = m_textureArrays.GetTextureID(m_textureIDs[i].unit);
+		}
+		m_textureArrays.Bind();
+		return;
+	}
+
+	for (size_t i = 0; i < m_textureIDs.size(); i++)
 	{
 		// bind textures on corresponding texture units
-		glActiveTexture(GL_TEXTURE0 + i);
+		glActiveTexture(GL_TEXTURE0 + m_textureIDs[i].unit);
 		glBindTexture(GL_TEXTURE_2D, m_textureIDs[i].ID);
 	}
 }
@@ -147,10 +401,24 @@ void SceneManager::BindGLTextures()
  ***********************************************************/
 void SceneManager::DestroyGLTextures()
 {
-	for (int i = 0; i < m_loadedTextures; i++)
+	if (m_bUseTextureArrays)
 	{
-		glGenTextures(1, &m_textureIDs[i].ID);
+		m_textureArrays.Destroy();
 	}
+	else
+	{
+		// the placeholder belongs to the texture loader
+		for (size_t i = 0; i < m_textureIDs.size(); i++)
+		{
+			if (m_textureIDs[i].ID != m_textureLoader.GetPlaceholderID())
+			{
+				glDeleteTextures(1, &m_textureIDs[i].ID);
+			}
+		}
+	}
+
+	m_textureIDs.clear();
+	m_textureSlots.Clear();
 }
 
 /***********************************************************
@@ -159,21 +427,14 @@ void SceneManager::DestroyGLTextures()
  *  This method is used for getting an ID for the previously
  *  loaded texture bitmap associated with the passed in tag.
  ***********************************************************/
-int SceneManager::FindTextureID(std::string tag)
+int SceneManager::FindTextureID(TagId tag)
 {
 	int textureID = -1;
-	int index = 0;
-	bool bFound = false;
+	int textureSlot = FindTextureSlot(tag);
 
-	while ((index < m_loadedTextures) && (bFound == false))
+	if (textureSlot >= 0)
 	{
-		if (m_textureIDs[index].tag.compare(tag) == 0)
-		{
-			textureID = m_textureIDs[index].ID;
-			bFound = true;
-		}
-		else
-			index++;
+		textureID = m_textureIDs[textureSlot].ID;
 	}
 
 	return(textureID);
@@ -185,24 +446,49 @@ int SceneManager::FindTextureID(std::string tag)
  *  This method is used for getting a slot index for the previously
  *  loaded texture bitmap associated with the passed in tag.
  ***********************************************************/
-int SceneManager::FindTextureSlot(std::string tag)
+int SceneManager::FindTextureSlot(TagId tag)
 {
-	int textureSlot = -1;
-	int index = 0;
-	bool bFound = false;
+	return(m_textureSlots.Find(tag));
+}
 
-	while ((index < m_loadedTextures) && (bFound == false))
+/***********************************************************
+ *  GetTextureUnit()
+ *
+ *  This method is used for getting the texture unit a slot
+ *  is sampled from, which is the texture state that draws
+ *  are sorted and batched by.  With texture arrays an
+ *  untextured draw only needs a negative layer, so it shares
+ *  the unit of the first texture and can join its batches.
+ ***********************************************************/
+int SceneManager::GetTextureUnit(int textureSlot) const
+{
+	if ((textureSlot >= 0) && (textureSlot < (int)m_textureIDs.size()))
 	{
-		if (m_textureIDs[index].tag.compare(tag) == 0)
-		{
-			textureSlot = index;
-			bFound = true;
-		}
-		else
-			index++;
+		return(m_textureIDs[textureSlot].unit);
+	}
+
+	if (m_bUseTextureArrays && (false == m_textureIDs.empty()))
+	{
+		return(m_textureIDs[0].unit);
+	}
+
+	return(-1);
+}
+
+/***********************************************************
+ *  GetTextureLayer()
+ *
+ *  This method is used for getting the texture array layer
+ *  of a slot, or -1 when the slot is not in a texture array.
+ ***********************************************************/
+int SceneManager::GetTextureLayer(int textureSlot) const
+{
+	if ((textureSlot >= 0) && (textureSlot < (int)m_textureIDs.size()))
+	{
+		return(m_textureIDs[textureSlot].layer);
 	}
 
-	return(textureSlot);
+	return(-1);
 }
 
 /***********************************************************
@@ -211,33 +497,52 @@ int SceneManager::FindTextureSlot(std::string tag)
  *  This method is used for getting a material from the previously
  *  defined materials list that is associated with the passed in tag.
  ***********************************************************/
-bool SceneManager::FindMaterial(std::string tag, OBJECT_MATERIAL& material)
+bool SceneManager::FindMaterial(TagId tag, OBJECT_MATERIAL& material)
 {
-	if (m_objectMaterials.size() == 0)
+	int index = FindMaterialIndex(tag);
+	if (index < 0)
 	{
 		return(false);
 	}
 
-	int index = 0;
-	bool bFound = false;
-	while ((index < m_objectMaterials.size()) && (bFound == false))
-	{
-		if (m_objectMaterials[index].tag.compare(tag) == 0)
-		{
-			bFound = true;
-			material.diffuseColor = m_objectMaterials[index].diffuseColor;
-			material.specularColor = m_objectMaterials[index].specularColor;
-			material.shininess = m_objectMaterials[index].shininess;
-		}
-		else
-		{
-			index++;
-		}
-	}
+	material.diffuseColor = m_objectMaterials[index].diffuseColor;
+	material.specularColor = m_objectMaterials[index].specularColor;
+	material.shininess = m_objectMaterials[index].shininess;
 
 	return(true);
 }
 
+/***********************************************************
+ *  FindMaterialIndex()
+ *
+ *  This method is used for getting the index of the previously
+ *  defined material associated with the passed in tag.  The
+ *  index is also the entry of the material in the GPU table.
+ ***********************************************************/
+int SceneManager::FindMaterialIndex(TagId tag)
+{
+	return(m_materialIndices.Find(tag));
+}
+
+/***********************************************************
+ *  BuildModelMatrix()
+ *
+ *  This method is used for calculating the model matrix
+ *  from the passed in transformation values.
+ ***********************************************************/
+glm::mat4 SceneManager::BuildModelMatrix(
+	glm::vec3 scaleXYZ,
+	float XrotationDegrees,
+	float YrotationDegrees,
+	float ZrotationDegrees,
+	glm::vec3 positionXYZ)
+{
+	return(Transform::ComposeMatrix(
+		scaleXYZ,
+		glm::vec3(XrotationDegrees, YrotationDegrees, ZrotationDegrees),
+		positionXYZ));
+}
+
 /***********************************************************
  *  SetTransformations()
  *
@@ -253,26 +558,17 @@ void SceneManager::SetTransformations(
 {
 	// variables for this method
 	glm::mat4 modelView;
-	glm::mat4 scale;
-	glm::mat4 rotationX;
-	glm::mat4 rotationY;
-	glm::mat4 rotationZ;
-	glm::mat4 translation;
-
-	// set the scale value in the transform buffer
-	scale = glm::scale(scaleXYZ);
-	// set the rotation values in the transform buffer
-	rotationX = glm::rotate(glm::radians(XrotationDegrees), glm::vec3(1.0f, 0.0f, 0.0f));
-	rotationY = glm::rotate(glm::radians(YrotationDegrees), glm::vec3(0.0f, 1.0f, 0.0f));
-	rotationZ = glm::rotate(glm::radians(ZrotationDegrees), glm::vec3(0.0f, 0.0f, 1.0f));
-	// set the translation value in the transform buffer
-	translation = glm::translate(positionXYZ);
 
-	modelView = translation * rotationZ * rotationY * rotationX * scale;
+	modelView = BuildModelMatrix(
+		scaleXYZ,
+		XrotationDegrees,
+		YrotationDegrees,
+		ZrotationDegrees,
+		positionXYZ);
 
-	if (NULL != m_pShaderManager)
+	if (NULL != m_pShaderUniforms)
 	{
-		m_pShaderManager->setMat4Value(g_ModelName, modelView);
+		m_pShaderUniforms->setMat4Value(m_uniforms.model, modelView);
 	}
 }
 
@@ -296,10 +592,10 @@ void SceneManager::SetShaderColor(
 	currentColor.b = blueColorValue;
 	currentColor.a = alphaValue;
 
-	if (NULL != m_pShaderManager)
+	if (NULL != m_pShaderUniforms)
 	{
-		m_pShaderManager->setIntValue(g_UseTextureName, false);
-		m_pShaderManager->setVec4Value(g_ColorValueName, currentColor);
+		m_pShaderUniforms->setIntValue(m_uniforms.useTexture, false);
+		m_pShaderUniforms->setVec4Value(m_uniforms.objectColor, currentColor);
 	}
 }
 
@@ -310,15 +606,50 @@ void SceneManager::SetShaderColor(
  *  associated with the passed in ID into the shader.
  ***********************************************************/
 void SceneManager::SetShaderTexture(
-	std::string textureTag)
+	TagId textureTag)
+{
+	ApplyTextureSlot(FindTextureSlot(textureTag));
+}
+
+/***********************************************************
+ *  ApplyTextureSlot()
+ *
+ *  This method is used for setting an already resolved
+ *  texture slot into the shader.
+ ***********************************************************/
+void SceneManager::ApplyTextureSlot(int textureSlot)
 {
-	if (NULL != m_pShaderManager)
+	if ((textureSlot < 0) || (textureSlot >= (int)m_textureIDs.size()))
+	{
+		return;
+	}
+
+	ApplyTextureUnit(m_textureIDs[textureSlot].unit);
+	if (m_bUseTextureArrays && (NULL != m_pShaderUniforms))
 	{
-		m_pShaderManager->setIntValue(g_UseTextureName, true);
+		m_pShaderUniforms->setIntValue(m_uniforms.textureLayer, m_textureIDs[textureSlot].layer);
+	}
+}
 
-		int textureID = -1;
-		textureID = FindTextureSlot(textureTag);
-		m_pShaderManager->setSampler2DValue(g_TextureValueName, textureID);
+/***********************************************************
+ *  ApplyTextureUnit()
+ *
+ *  This method is used for pointing the texture sampler of
+ *  the shader at a texture unit.
+ ***********************************************************/
+void SceneManager::ApplyTextureUnit(int textureUnit)
+{
+	if (NULL != m_pShaderUniforms)
+	{
+		m_pShaderUniforms->setIntValue(m_uniforms.useTexture, true);
+		if (m_bUseTextureArrays)
+		{
+			m_pShaderUniforms->setIntValue(m_uniforms.textureArray, textureUnit);
+		}
+		else
+		{
+			m_pShaderUniforms->setSampler2DValue(m_uniforms.objectTexture, textureUnit);
+		}
 	}
 }
 
@@ -330,9 +661,9 @@ void SceneManager::SetShaderTexture(
  ***********************************************************/
 void SceneManager::SetTextureUVScale(float u, float v)
 {
-	if (NULL != m_pShaderManager)
+	if (NULL != m_pShaderUniforms)
 	{
-		m_pShaderManager->setVec2Value("UVscale", glm::vec2(u, v));
+		m_pShaderUniforms->setVec2Value(m_uniforms.UVscale, glm::vec2(u, v));
 	}
 }
 
@@ -343,20 +674,66 @@ void SceneManager::SetTextureUVScale(float u, float v)
  *  into the shader.
  ***********************************************************/
 void SceneManager::SetShaderMaterial(
-	std::string materialTag)
+	TagId materialTag)
 {
-	if (m_objectMaterials.size() > 0)
+	ApplyMaterialIndex(FindMaterialIndex(materialTag));
+}
+
+/***********************************************************
+ *  ApplyMaterialIndex()
+ *
+ *  This method is used for setting an already resolved
+ *  material into the shader.
+ ***********************************************************/
+void SceneManager::ApplyMaterialIndex(int materialIndex)
+{
+	if ((materialIndex < 0) || (materialIndex >= (int)m_objectMaterials.size()))
 	{
-		OBJECT_MATERIAL material;
-		bool bReturn = false;
+		return;
+	}
 
-		bReturn = FindMaterial(materialTag, material);
-		if (bReturn == true)
+	if (NULL != m_pShaderUniforms)
+	{
+		// with the GPU material table only the index of the
+		// material needs to be passed to the shader
+		if (m_bUseMaterialTable)
 		{
-			m_pShaderManager->setVec3Value("material.diffuseColor", material.diffuseColor);
-			m_pShaderManager->setVec3Value("material.specularColor", material.specularColor);
-			m_pShaderManager->setFloatValue("material.shininess", material.shininess);
+			m_pShaderUniforms->setIntValue(m_uniforms.materialIndex, materialIndex);
+			return;
 		}
+
+		const OBJECT_MATERIAL& material = m_objectMaterials[materialIndex];
+		m_pShaderUniforms->setVec3Value(m_uniforms.materialDiffuse, material.diffuseColor);
+		m_pShaderUniforms->setVec3Value(m_uniforms.materialSpecular, material.specularColor);
+		m_pShaderUniforms->setFloatValue(m_uniforms.materialShininess, material.shininess);
+	}
+}
+
+/***********************************************************
+ *  ResolveUniformHandles()
+ *
+ *  This method is used for resolving the locations of the
+ *  uniforms that are set for every draw command, so that
+ *  rendering never has to look them up by name.
+ ***********************************************************/
+void SceneManager::ResolveUniformHandles()
+{
+	if (NULL != m_pShaderUniforms)
+	{
+		m_uniforms.model = m_pShaderUniforms->Resolve(g_ModelName);
+		m_uniforms.objectColor = m_pShaderUniforms->Resolve(g_ColorValueName);
+		m_uniforms.objectTexture = m_pShaderUniforms->Resolve(g_TextureValueName);
+		m_uniforms.useTexture = m_pShaderUniforms->Resolve(g_UseTextureName);
+		m_uniforms.UVscale = m_pShaderUniforms->Resolve(g_UVScaleName);
+		m_uniforms.materialDiffuse = m_pShaderUniforms->Resolve("material.diffuseColor");
+		m_uniforms.materialSpecular = m_pShaderUniforms->Resolve("material.specularColor");
+		m_uniforms.materialShininess = m_pShaderUniforms->Resolve("material.shininess");
+		m_uniforms.materialIndex = m_pShaderUniforms->Resolve(g_MaterialIndexName);
+		m_uniforms.useInstanceData = m_pShaderUniforms->Resolve(g_UseInstanceDataName);
+		m_uniforms.textureArray = m_pShaderUniforms->Resolve(g_TextureArrayName);
+		m_uniforms.textureLayer = m_pShaderUniforms->Resolve(g_TextureLayerName);
+		m_uniforms.transparencyPass = m_pShaderUniforms->Resolve(g_TransparencyPassName);
+		m_uniforms.objectIndex = m_pShaderUniforms->Resolve(g_ObjectIndexName);
 	}
 }
 
@@ -377,6 +754,9 @@ void SceneManager::SetShaderMaterial(
  ***********************************************************/
 void SceneManager::PrepareScene()
 {
+	// look up the uniforms used while rendering one time
+	ResolveUniformHandles();
+
 	// only one instance of a particular mesh needs to be
 	// loaded in memory no matter how many times it is drawn
 	// in the rendered 3D scene
@@ -388,382 +768,1623 @@ void SceneManager::PrepareScene()
 	m_basicMeshes->LoadTaperedCylinderMesh();
 	m_basicMeshes->LoadSphereMesh(); //use for desk lamp bulb
 	m_basicMeshes->LoadTorusMesh(); //use for coffee mug handle
+	CountBasicMeshTriangles();
+	LoadInstancedMeshes();
+
+	// pack the textures into texture arrays when they are
+	// enabled and the fragment shader samples from them
+	m_bUseTextureArrays = RenderSettings::Get().bTextureArrays &&
+		(NULL != m_pShaderUniforms) && (m_uniforms.textureArray.location >= 0);
+	if (false == m_bUseTextureArrays)
+	{
+		std::cout << "INFO: texture arrays are not used, binding one texture per unit" << std::endl;
+	}
 
-	//Load Textures
-	CreateGLTexture("textures/monitor.jpg", "monitor");
-	CreateGLTexture("textures/screen.jpg", "screen");
-	CreateGLTexture("textures/dark-metal-texture.jpg", "metal");
-	CreateGLTexture("textures/texture-wooden-boards.jpg", "desk");
+	// start loading the textures in the background - the scene
+	// is drawn with placeholders until they are uploaded
+	m_textureLoader.Create(m_pJobSystem);
+	CreateGLTexture("textures/monitor.jpg", g_MonitorTexture);
+	CreateGLTexture("textures/screen.jpg", g_ScreenTexture);
+	CreateGLTexture("textures/dark-metal-texture.jpg", g_MetalTexture);
+	CreateGLTexture("textures/texture-wooden-boards.jpg", g_DeskTexture);
 	BindGLTextures();
 
-	// define materials for objects in the scene
+	// define materials for objects in the scene and upload
+	// them into the GPU material table
 	DefineObjectMaterials();
+	CreateMaterialTable();
 	// set up the lighting for the scene
 	SetupSceneLights();
+
+	// draw the translucent objects order independent when the
+	// fragment shader writes the transparency targets
+	m_bUseTransparencyBuffer = (NULL != m_pShaderUniforms) &&
+		(m_uniforms.transparencyPass.location >= 0) && m_transparencyBuffer.Create();
+	if (false == m_bUseTransparencyBuffer)
+	{
+		std::cout << "INFO: shader has no transparency pass, sorting translucent objects back to front" << std::endl;
+	}
+
+	// resolve the scene objects into retained draw commands
+	BuildDrawList();
 }
 
 /***********************************************************
- *  DefineObjectMaterials()
+ *  CountBasicMeshTriangles()
  *
- *  This method is used for defining the materials that will
- *  be used for the objects in the 3D scene.
+ *  This method is used for counting the triangles each of
+ *  the basic shape meshes draws, so the frame statistics
+ *  count the meshes that are actually drawn one at a time.
+ *  The meshes only expose their draw calls, so each one is
+ *  drawn once with rasterization turned off while a query
+ *  counts the primitives it generates.  The results are not
+ *  waited for - ReadBasicMeshTriangles() picks them up in
+ *  the following frames, and a mesh counts no triangles
+ *  until then.
  ***********************************************************/
-void SceneManager::DefineObjectMaterials()
+void SceneManager::CountBasicMeshTriangles()
 {
-	// Glossy material for screen - high shine
-	OBJECT_MATERIAL glossyMaterial;
-	glossyMaterial.diffuseColor = glm::vec3(1.0f, 1.0f, 1.0f);
-	glossyMaterial.specularColor = glm::vec3(1.0f, 1.0f, 1.0f);
-	glossyMaterial.shininess = 128.0;
-	glossyMaterial.tag = "glossy";
-	m_objectMaterials.push_back(glossyMaterial);
+	glGenQueries(MESH_COUNT, m_basicMeshQueries);
+	RenderState::Enable(GL_RASTERIZER_DISCARD);
+	for (int i = 0; i < MESH_COUNT; i++)
+	{
+		glBeginQuery(GL_PRIMITIVES_GENERATED, m_basicMeshQueries[i]);
+		DrawMesh((MESH_TYPE)i);
+		glEndQuery(GL_PRIMITIVES_GENERATED);
+	}
+	RenderState::Disable(GL_RASTERIZER_DISCARD);
+}
 
-	// Shiny metal material for stand - medium-high shine
-	OBJECT_MATERIAL metalMaterial;
-	metalMaterial.diffuseColor = glm::vec3(0.7f, 0.7f, 0.7f);
-	metalMaterial.specularColor = glm::vec3(0.9f, 0.9f, 0.9f);
-	metalMaterial.shininess = 64.0;
-	metalMaterial.tag = "metal";
-	m_objectMaterials.push_back(metalMaterial);
+/***********************************************************
+ *  ReadBasicMeshTriangles()
+ *
+ *  This method is used for reading the triangle counts of
+ *  the basic shape meshes whose queries have finished, and
+ *  deleting those queries.  Queries still in flight are left
+ *  for a later frame, so this never stalls on the GPU.
+ ***********************************************************/
+void SceneManager::ReadBasicMeshTriangles()
+{
+	for (int i = 0; i < MESH_COUNT; i++)
+	{
+		GLuint bAvailable = GL_FALSE;
+		GLuint primitives = 0;
 
-	// Wood material for desk - medium shine
-	OBJECT_MATERIAL woodMaterial;
-	woodMaterial.diffuseColor = glm::vec3(0.6f, 0.4f, 0.3f);
-	woodMaterial.specularColor = glm::vec3(0.3f, 0.3f, 0.3f);
-	woodMaterial.shininess = 32.0;
-	woodMaterial.tag = "wood";
-	m_objectMaterials.push_back(woodMaterial);
+		if (0 == m_basicMeshQueries[i])
+		{
+			continue;
+		}
 
-	// Matte plastic for keyboard and monitor - low shine
-	OBJECT_MATERIAL mattePlasticMaterial;
-	mattePlasticMaterial.diffuseColor = glm::vec3(0.5f, 0.5f, 0.5f);
-	mattePlasticMaterial.specularColor = glm::vec3(0.2f, 0.2f, 0.2f);
-	mattePlasticMaterial.shininess = 16.0;
-	mattePlasticMaterial.tag = "matte";
-	m_objectMaterials.push_back(mattePlasticMaterial);
+		glGetQueryObjectuiv(m_basicMeshQueries[i], GL_QUERY_RESULT_AVAILABLE, &bAvailable);
+		if (GL_FALSE == bAvailable)
+		{
+			continue;
+		}
 
-	// Ceramic material for mug - smooth with moderate shine
-	OBJECT_MATERIAL ceramicMaterial;
-	ceramicMaterial.diffuseColor = glm::vec3(0.9f, 0.9f, 0.9f);
-	ceramicMaterial.specularColor = glm::vec3(0.5f, 0.5f, 0.5f);
-	ceramicMaterial.shininess = 48.0;
-	ceramicMaterial.tag = "ceramic";
-	m_objectMaterials.push_back(ceramicMaterial);
+		glGetQueryObjectuiv(m_basicMeshQueries[i], GL_QUERY_RESULT, &primitives);
+		m_basicMeshTriangles[i] = primitives;
+		glDeleteQueries(1, &m_basicMeshQueries[i]);
+		m_basicMeshQueries[i] = 0;
+	}
+}
 
-	// Default fallback material
-	OBJECT_MATERIAL defaultMaterial;
-	defaultMaterial.diffuseColor = glm::vec3(1.0f, 1.0f, 1.0f);
-	defaultMaterial.specularColor = glm::vec3(0.5f, 0.5f, 0.5f);
-	defaultMaterial.shininess = 32.0;
-	defaultMaterial.tag = "default";
-	m_objectMaterials.push_back(defaultMaterial);
+/***********************************************************
+ *  LoadInstancedMeshes()
+ *
+ *  This method is used for loading the basic shapes a second
+ *  time for instanced drawing.  They are only needed when the
+ *  vertex shader declares the instance attributes.
+ ***********************************************************/
+void SceneManager::LoadInstancedMeshes()
+{
+	GLuint programID = 0;
+
+	if (NULL != m_pShaderUniforms)
+	{
+		programID = m_pShaderUniforms->GetProgramID();
+	}
+
+	m_bUseInstancing = (0 != programID) &&
+		(glGetAttribLocation(programID, g_InstanceModelName) == (GLint)VertexAttribute::INSTANCE_MODEL);
+	if (false == m_bUseInstancing)
+	{
+		std::cout << "INFO: shader has no instance attributes, drawing one object per call" << std::endl;
+		return;
+	}
+
+	m_pInstancedMeshes->LoadPlaneMesh();
+	m_pInstancedMeshes->LoadBoxMesh();
+	m_pInstancedMeshes->LoadCylinderMesh();
+	m_pInstancedMeshes->LoadConeMesh();
+	m_pInstancedMeshes->LoadTaperedCylinderMesh();
+	m_pInstancedMeshes->LoadSphereMesh();
+	m_pInstancedMeshes->LoadTorusMesh();
+	m_instanceBufferID = InstancedMeshes::CreateBuffer();
+	m_drawCommandBufferID = InstancedMeshes::CreateBuffer();
 }
 
 /***********************************************************
- *  SetupSceneLights()
+ *  AddSceneObject()
  *
- *  This method is called to add and configure the light
- *  sources for the 3D scene.
+ *  This method is used for resolving a scene object into a
+ *  retained draw command.  The index of the new draw command
+ *  is returned.
  ***********************************************************/
-void SceneManager::SetupSceneLights()
+int SceneManager::AddSceneObject(const SCENE_OBJECT& object)
 {
-	// Enable lighting in the shader
-	m_pShaderManager->setBoolValue(g_UseLightingName, true);
+	DRAW_ITEM item;
+
+	item.transform.SetScale(object.scaleXYZ);
+	item.transform.SetRotation(
+		object.XrotationDegrees,
+		object.YrotationDegrees,
+		object.ZrotationDegrees);
+	item.transform.SetPosition(object.positionXYZ);
+	item.transform.UpdateWorldMatrix();
+	item.color = object.color;
+	item.UVscale = object.UVscale;
+	item.mesh = object.mesh;
+	item.textureSlot = FindTextureSlot(object.textureTag);
+	item.materialIndex = FindMaterialIndex(object.materialTag);
+
+	m_drawList.push_back(item);
+
+	return((int)m_drawList.size() - 1);
+}
 
-	// PRIMARY LIGHT SOURCE: Directional light from above-front
-	// Reduced ambient for more dramatic shadows and contrast
-	m_pShaderManager->setVec3Value("directionalLight.direction", 0.2f, -1.0f, -0.3f);
-	m_pShaderManager->setVec3Value("directionalLight.ambient", 0.25f, 0.25f, 0.25f);
-	m_pShaderManager->setVec3Value("directionalLight.diffuse", 0.6f, 0.6f, 0.6f);
-	m_pShaderManager->setVec3Value("directionalLight.specular", 0.4f, 0.4f, 0.4f);
-	m_pShaderManager->setBoolValue("directionalLight.bActive", true);
+/***********************************************************
+ *  BuildDrawList()
+ *
+ *  This method is used for building the retained draw list
+ *  from the scene objects one time, so rendering a frame
+ *  only has to walk the list.
+ ***********************************************************/
+void SceneManager::BuildDrawList()
+{
+	int objectCount = sizeof(g_SceneObjects) / sizeof(g_SceneObjects[0]);
+	// place the desk copies in a square grid going away from
+	// the camera, with the first desk at the origin
+	int columns = (int)std::ceil(std::sqrt((double)m_deskCount));
+
+	m_drawList.clear();
+	m_drawList.reserve((size_t)objectCount * m_deskCount);
+	for (int desk = 0; desk < m_deskCount; desk++)
+	{
+		glm::vec3 deskOffset(
+			(float)(desk % columns) * DESK_SPACING_X,
+			0.0f,
+			-(float)(desk / columns) * DESK_SPACING_Z);
 
-	// SECONDARY LIGHT SOURCE: Point light from the right side (cool fill light)
-	// Slightly blue-tinted to contrast with warm lamp
-	m_pShaderManager->setVec3Value("pointLights[0].position", 6.0f, 6.0f, 3.0f);
-	m_pShaderManager->setVec3Value("pointLights[0].ambient", 0.1f, 0.1f, 0.15f);
-	m_pShaderManager->setVec3Value("pointLights[0].diffuse", 0.4f, 0.4f, 0.5f);  // Slightly cool/blue
-	m_pShaderManager->setVec3Value("pointLights[0].specular", 0.5f, 0.5f, 0.6f);
-	m_pShaderManager->setBoolValue("pointLights[0].bActive", true);
+		for (int i = 0; i < objectCount; i++)
+		{
+			SCENE_OBJECT object = g_SceneObjects[i];
+			object.positionXYZ += deskOffset;
+			AddSceneObject(object);
+		}
+	}
+	AddTranslucentObjects();
 
-	// THIRD LIGHT SOURCE (COLORED): Point light from desk lamp - soft red glow
-	m_pShaderManager->setVec3Value("pointLights[1].position", -5.2f, 2.6f, 0.8f);
-	// Softer red light values 
-	m_pShaderManager->setVec3Value("pointLights[1].ambient", 0.25f, 0.05f, 0.05f);   // gentle red ambient tint
-	m_pShaderManager->setVec3Value("pointLights[1].diffuse", 0.8f, 0.1f, 0.1f);     // main red light cone
-	m_pShaderManager->setVec3Value("pointLights[1].specular", 0.6f, 0.2f, 0.2f);    // soft red highlights
-	m_pShaderManager->setBoolValue("pointLights[1].bActive", true);
+	m_frustumCuller.Resize((int)m_drawList.size());
+	m_visibleItems.assign(m_drawList.size(), 1);
+	m_occluderItems.assign(m_drawList.size(), 0);
+	m_itemLods.assign(m_drawList.size(), 0);
+	for (size_t i = 0; i < m_drawList.size(); i++)
+	{
+		UpdateObjectBounds((int)i);
+	}
+	BuildHierarchy();
+	BuildStaticBatches();
+}
 
-	// Disable remaining point lights
-	m_pShaderManager->setBoolValue("pointLights[2].bActive", false);
-	m_pShaderManager->setBoolValue("pointLights[3].bActive", false);
-	m_pShaderManager->setBoolValue("pointLights[4].bActive", false);
+/***********************************************************
+ *  BuildStaticBatches()
+ *
+ *  This method is used for baking every opaque draw into the
+ *  static batch of its texture unit and material.  Every draw
+ *  starts out static and leaves its batch the first time it
+ *  moves.  Translucent draws are kept out, since they are
+ *  drawn back to front one at a time.  The batches are read
+ *  through the instance attributes, so they are only built
+ *  when the shader declares them.
+ ***********************************************************/
+void SceneManager::BuildStaticBatches()
+{
+	m_staticBatches.Destroy();
+	if (false == m_bUseInstancing)
+	{
+		return;
+	}
 
-	// Disable spotlight
-	m_pShaderManager->setBoolValue("spotLight.bActive", false);
+	for (size_t i = 0; i < m_drawList.size(); i++)
+	{
+		const DRAW_ITEM& item = m_drawList[i];
+		if (item.color.a < 1.0f)
+		{
+			continue;
+		}
+
+		StaticBatches::STATIC_OBJECT object;
+		object.objectIndex = (int)i;
+		object.shape = GetInstancedShape(item.mesh);
+		object.world = item.transform.GetWorldMatrix();
+		object.color = item.color;
+		object.UVscale = item.UVscale;
+		object.materialIndex = item.materialIndex;
+		object.textureLayer = GetTextureLayer(item.textureSlot);
+
+		// with the material table each object selects its own
+		// material, the same as in the instance batches
+		m_staticBatches.AddObject(object, GetTextureUnit(item.textureSlot),
+			m_bUseMaterialTable ? -1 : item.materialIndex);
+	}
+	m_staticBatches.Build();
 }
 
 /***********************************************************
- *  RenderScene()
+ *  UseStaticBatches()
  *
- *  This method is used for rendering the 3D scene by
- *  transforming and drawing the basic 3D shapes
+ *  This method is used for checking whether the batched
+ *  draws are drawn by their static batches this frame.
  ***********************************************************/
-void SceneManager::RenderScene()
+bool SceneManager::UseStaticBatches() const
 {
-	// declare the variables for the transformations
-	glm::vec3 scaleXYZ;
-	float XrotationDegrees = 0.0f;
-	float YrotationDegrees = 0.0f;
-	float ZrotationDegrees = 0.0f;
-	glm::vec3 positionXYZ;
-
-	/*** Set needed transformations before drawing the basic mesh.  ***/
-	/*** This same ordering of code should be used for transforming ***/
-	/*** and drawing all the basic 3D shapes.						***/
-	/******************************************************************/
-	// DESK - Draw as a box instead of a plane
-	// set the XYZ scale for the mesh - WIDER desk
-	scaleXYZ = glm::vec3(15.0f, 0.5f, 10.0f);  // Increased width from 10 to 15
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the mesh - raised slightly so top is at y=0
-	positionXYZ = glm::vec3(0.0f, -0.25f, 0.0f);
-
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	return(RenderSettings::Get().bStaticBatching && (m_staticBatches.GetBatchCount() > 0));
+}
 
-	SetShaderColor(.91, .85, .85, 1);
-	SetShaderTexture("desk");           // Apply desk texture
-	SetShaderMaterial("wood");          // Wood material with medium shine
-	SetTextureUVScale(1.5f, 1.0f);      // Adjust UV scale for wider desk
-	// draw the mesh with transformation values
-
-	m_basicMeshes->DrawBoxMesh();  // Changed from DrawPlaneMesh() to DrawBoxMesh()
-	/****************************************************************/
-	//prepare the montior box
-	scaleXYZ = glm::vec3(10.0f, 0.15f, 4.5f);
-	XrotationDegrees = 90.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-	//set position for montitor box - centered on desk
-	positionXYZ = glm::vec3(0.0f, 5.0f, 0.0f);
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ
-	);
-	//set color for monitor
-	SetShaderColor(0.2f, 0.2f, 0.2f, 1.f);
-	//DRAW monitor base
-	// When drawing an object
-	SetShaderTexture("monitor");  // Use the tag you defined
-	SetShaderMaterial("matte");   // Matte plastic for monitor casing
-	SetTextureUVScale(1.0f, 1.0f);  // Controls tiling
-	m_basicMeshes->DrawBoxMesh();
-
-
-	//draw the cylinder stand
-	scaleXYZ = glm::vec3(.5f, .5f, 2.5f);
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 90.0f; //level with plane
-	ZrotationDegrees = 0.0f;
-	positionXYZ = glm::vec3(0.0f, 0.0f, 0.0f);  // Centered on desk
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ
-	);
-	SetShaderColor(0.1f, 0.1f, 0.1f, 1.0f);
-	SetShaderMaterial("metal");  // Shiny metal material
-	//DRAW cylinder plate under monitor box
-	m_basicMeshes->DrawCylinderMesh();
-
-
-	//draw tapered cyclinder for monitor stand 
-	scaleXYZ = glm::vec3(0.2f, 5.0f, 1.0f);
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 90.0f;
-	ZrotationDegrees = 0.0f;
-	positionXYZ = glm::vec3(0.0f, 0.0f, 0.0f);  // Centered on desk
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ
-	);
-	//set color of tapered cylinder stand
-	SetShaderColor(0.1f, 0.1f, 0.1f, 1.0f);
-	SetShaderTexture("metal");
-	SetShaderMaterial("metal");  // Shiny metal material
-	SetTextureUVScale(1.0f, 2.0f);
-	//DRAW cone shape for the montior stand 
-	m_basicMeshes->DrawTaperedCylinderMesh();
-
-
-	// draw plane mesh for the monitor screen
-	scaleXYZ = glm::vec3(4.0f, 1.0f, 2.0f);
-	XrotationDegrees = 90.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-	positionXYZ = glm::vec3(-0.25f, 5.0f, 0.5f);  // Centered with monitor body
-	//set to memory
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ
-	);
-	SetShaderColor(1.0f, 1.0f, 1.0f, 1.0f);
-	//DRAW screen plane
-	SetShaderTexture("screen");
-	SetShaderMaterial("glossy");  // Glossy material for shiny screen
-	SetTextureUVScale(1.0f, 1.0f);
-	m_basicMeshes->DrawPlaneMesh();
-
-	/****************************************************************/
-	// KEYBOARD - positioned in front of monitor
-	scaleXYZ = glm::vec3(5.0f, 0.15f, 1.0f);
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-	positionXYZ = glm::vec3(0.0f, 0.075f, 3.0f);  // In front of monitor on desk
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ
-	);
-	SetShaderColor(0.1f, 0.1f, 0.1f, 1.0f);  // Dark gray/black keyboard
-	SetShaderMaterial("matte");  // Matte plastic material
-	//DRAW keyboard base
-	m_basicMeshes->DrawBoxMesh();
-
-	/****************************************************************/
-	// DESK LAMP - positioned to the left of monitor
-	// Lamp base (cylinder)
-	scaleXYZ = glm::vec3(0.5f, 0.3f, 0.3f);  // Slightly larger base
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-	positionXYZ = glm::vec3(-5.5f, 0.10f, 2.0f);  // Adjusted for wider desk
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ
-	);
-	SetShaderColor(0.2f, 0.2f, 0.2f, 1.0f);  // Dark base
-	SetShaderMaterial("metal");  // Metal base
-	//DRAW lamp base
-	m_basicMeshes->DrawCylinderMesh();
-
-	// Lamp pole (cylinder - not tapered for cleaner look)
-	scaleXYZ = glm::vec3(0.12f, 0.12f, 2.8f);
-	XrotationDegrees = 90.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-	positionXYZ = glm::vec3(-5.5f, 0.3f, 2.0f);  // Rising from base
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ
-	);
-	SetShaderColor(0.15f, 0.15f, 0.15f, 1.0f);  // Dark pole
-	SetShaderMaterial("metal");  // Metal pole
-	//DRAW lamp pole
-	m_basicMeshes->DrawCylinderMesh();
-
-	// Lamp shade (cone)
-	scaleXYZ = glm::vec3(0.7f, 0.9f, 0.7f);  // Larger shade
-	XrotationDegrees = 180.0f;  // Flip cone upside down for lamp shade
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-	positionXYZ = glm::vec3(-5.5f, 3.1f, 2.0f);  // Top of pole
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ
-	);
-	SetShaderColor(0.9f, 0.85f, 0.7f, 1.0f);  // Warm cream shade
-	SetShaderMaterial("matte");  // Matte shade
-	//DRAW lamp shade
-	m_basicMeshes->DrawConeMesh();
-
-	// Lamp bulb (sphere) - light source
-	scaleXYZ = glm::vec3(0.3f, 0.3f, 0.3f);  // Slightly larger bulb
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-	positionXYZ = glm::vec3(-5.5f, 2.7f, 2.0f);  // Inside shade
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ
-	);
-	SetShaderColor(1.0f, 0.95f, 0.8f, 1.0f);  // Warm yellow-white bulb
-	SetShaderMaterial("glossy");  // Glossy bulb
-	//DRAW lamp bulb
-	m_basicMeshes->DrawSphereMesh();
-
-	/****************************************************************/
-	// COFFEE MUG - positioned on right side of desk near keyboard
-	// Mug body (cylinder)
-	scaleXYZ = glm::vec3(0.45f, 0.45f, 0.65f);  // Slightly larger mug
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-	positionXYZ = glm::vec3(5.0f, 0.325f, 2.5f);  // Adjusted for wider desk - right side
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ
-	);
-	SetShaderColor(0.85f, 0.25f, 0.15f, 1.0f);  // Brighter red mug
-	SetShaderMaterial("ceramic");  // Ceramic material with moderate shine
-	//DRAW mug body
-	m_basicMeshes->DrawCylinderMesh();
-
-	// Mug handle (torus)
-	scaleXYZ = glm::vec3(0.28f, 0.38f, 0.1f);  // Proportional handle
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 90.0f;  // Rotate to face outward
-	ZrotationDegrees = 0.0f;
-	positionXYZ = glm::vec3(5.5f, 0.325f, 2.5f);  // Attached to side of mug
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ
-	);
-	SetShaderColor(0.85f, 0.25f, 0.15f, 1.0f);  // Same red as mug
-	SetShaderMaterial("ceramic");  // Ceramic material
-	//DRAW mug handle
-	m_basicMeshes->DrawTorusMesh();
-}
\ No newline at end of file
+/***********************************************************
+ *  DrawStaticBatches()
+ *
+ *  This method is used for drawing every static batch with
+ *  one call, including only the batched draws that passed
+ *  culling, at their current level of detail.
+ ***********************************************************/
+void SceneManager::DrawStaticBatches()
+{
+	if (NULL != m_pShaderUniforms)
+	{
+		m_pShaderUniforms->setBoolValue(m_uniforms.useInstanceData, true);
+	}
+
+	for (int i = 0; i < m_staticBatches.GetBatchCount(); i++)
+	{
+		ApplyBatchState(m_staticBatches.GetTextureUnit(i), m_staticBatches.GetMaterialIndex(i));
+		m_staticBatches.Draw(i, m_visibleItems.data(), m_itemLods.data());
+	}
+}
+
+/***********************************************************
+ *  SetDeskCount()
+ *
+ *  This method is used for setting how many copies of the
+ *  desk setup are placed in the scene, for measuring the
+ *  cost of drawing many objects.
+ ***********************************************************/
+void SceneManager::SetDeskCount(int deskCount)
+{
+	m_deskCount = (deskCount > 0) ? deskCount : 1;
+}
+
+/***********************************************************
+ *  SetTranslucentCount()
+ *
+ *  This method is used for setting how many extra
+ *  translucent objects are placed in the scene, for
+ *  measuring the cost of drawing many of them.
+ ***********************************************************/
+void SceneManager::SetTranslucentCount(int translucentCount)
+{
+	m_translucentCount = (translucentCount > 0) ? translucentCount : 0;
+}
+
+/***********************************************************
+ *  AddTranslucentObjects()
+ *
+ *  This method is used for filling a cube above the first
+ *  desk with translucent spheres of changing colors, so many
+ *  translucent surfaces overlap on screen.
+ ***********************************************************/
+void SceneManager::AddTranslucentObjects()
+{
+	int side = (int)std::ceil(std::cbrt((double)m_translucentCount));
+	float offset = (float)(side - 1) * TRANSLUCENT_SPACING * 0.5f;
+
+	for (int i = 0; i < m_translucentCount; i++)
+	{
+		int x = i % side;
+		int y = (i / side) % side;
+		int z = i / (side * side);
+
+		SCENE_OBJECT object;
+		object.mesh = MESH_SPHERE;
+		object.scaleXYZ = glm::vec3(TRANSLUCENT_SCALE);
+		object.XrotationDegrees = 0.0f;
+		object.YrotationDegrees = 0.0f;
+		object.ZrotationDegrees = 0.0f;
+		object.positionXYZ = glm::vec3(
+			(float)x * TRANSLUCENT_SPACING - offset,
+			(float)y * TRANSLUCENT_SPACING + TRANSLUCENT_BASE_HEIGHT,
+			(float)z * TRANSLUCENT_SPACING - offset);
+		object.color = glm::vec4(
+			(float)x / (float)side,
+			(float)y / (float)side,
+			(float)z / (float)side,
+			TRANSLUCENT_ALPHA);
+		object.textureTag = TagId();
+		object.materialTag = g_GlossyMaterial;
+		object.UVscale = glm::vec2(1.0f, 1.0f);
+		AddSceneObject(object);
+	}
+}
+
+/***********************************************************
+ *  GetObjectTransform()
+ *
+ *  This method is used for getting the transform of a scene
+ *  object, so the object can be moved, rotated or scaled.
+ ***********************************************************/
+Transform* SceneManager::GetObjectTransform(int objectIndex)
+{
+	if ((objectIndex < 0) || (objectIndex >= (int)m_drawList.size()))
+	{
+		return(NULL);
+	}
+
+	return(&m_drawList[objectIndex].transform);
+}
+
+/***********************************************************
+ *  PickObject()
+ *
+ *  This method is used for finding the scene object under a
+ *  ray, such as one cast from the camera through the mouse
+ *  cursor.  The objects are tested by their bounding boxes.
+ ***********************************************************/
+int SceneManager::PickObject(const glm::vec3& origin, const glm::vec3& direction, float& distance) const
+{
+	return(m_bvh.Raycast(origin, direction, distance));
+}
+
+/***********************************************************
+ *  UpdateTransforms()
+ *
+ *  This method is used for rebuilding the model matrices of
+ *  the objects whose transformation values changed since the
+ *  last frame.  Objects that did not move keep their cached
+ *  matrix.
+ ***********************************************************/
+void SceneManager::UpdateTransforms()
+{
+	m_transformBatch.Clear();
+	m_batchedItems.clear();
+
+	for (size_t i = 0; i < m_drawList.size(); i++)
+	{
+		const Transform& transform = m_drawList[i].transform;
+		if (transform.IsDirty())
+		{
+			m_transformBatch.Add(transform.GetScale(), transform.GetRotation(), transform.GetPosition());
+			m_batchedItems.push_back((int)i);
+			// a moved object leaves its static batch for good
+			m_staticBatches.RemoveObject((int)i);
+		}
+	}
+
+	// a few moved objects are cheaper to rebuild one at a time
+	if (m_transformBatch.GetCount() < MIN_TRANSFORM_BATCH)
+	{
+		for (size_t i = 0; i < m_batchedItems.size(); i++)
+		{
+			m_drawList[m_batchedItems[i]].transform.UpdateWorldMatrix();
+			UpdateObjectBounds(m_batchedItems[i]);
+		}
+	}
+	else
+	{
+		m_batchedMatrices.resize(m_transformBatch.GetCount());
+
+		// every job writes the matrices and bounds of its own
+		// objects only, so the jobs need no locking
+		JobSystem::RANGE_JOB buildMatrices = [this](int first, int count)
+		{
+			m_transformBatch.BuildModelMatrices(first, count, m_batchedMatrices.data());
+			for (int i = first; i < (first + count); i++)
+			{
+				m_drawList[m_batchedItems[i]].transform.SetWorldMatrix(m_batchedMatrices[i]);
+				UpdateObjectBounds(m_batchedItems[i]);
+			}
+		};
+
+		RunRange(m_transformBatch.GetCount(), TRANSFORM_JOB_SIZE, buildMatrices);
+		FrameStats::Current().matricesRebuilt += m_transformBatch.GetCount();
+	}
+
+	UpdateHierarchy();
+}
+
+/***********************************************************
+ *  BuildHierarchy()
+ *
+ *  This method is used for building the bounding volume
+ *  hierarchy from the world-space bounds of all draws.
+ ***********************************************************/
+void SceneManager::BuildHierarchy()
+{
+	int count = m_frustumCuller.GetCount();
+	std::vector<glm::vec3> boundsMin(count);
+	std::vector<glm::vec3> boundsMax(count);
+
+	for (int i = 0; i < count; i++)
+	{
+		glm::vec3 center;
+		glm::vec3 extent;
+		m_frustumCuller.GetBounds(i, center, extent);
+		boundsMin[i] = center - extent;
+		boundsMax[i] = center + extent;
+	}
+
+	m_bvh.Build(boundsMin.data(), boundsMax.data(), count);
+}
+
+/***********************************************************
+ *  UpdateHierarchy()
+ *
+ *  This method is used for moving the hierarchy boxes of the
+ *  draws rebuilt this frame.  Mostly static scenes only walk
+ *  up from the few objects that moved, a frame in which many
+ *  objects moved refits every node in one pass, and the tree
+ *  is built again once it has drifted too far from the
+ *  layout it was built for.
+ ***********************************************************/
+void SceneManager::UpdateHierarchy()
+{
+	int movedCount = (int)m_batchedItems.size();
+	bool bRefitAll = (movedCount > (m_bvh.GetObjectCount() / HIERARCHY_REFIT_DIVISOR));
+
+	if (0 == movedCount)
+	{
+		return;
+	}
+
+	for (int i = 0; i < movedCount; i++)
+	{
+		int itemIndex = m_batchedItems[i];
+		glm::vec3 center;
+		glm::vec3 extent;
+
+		m_frustumCuller.GetBounds(itemIndex, center, extent);
+		if (bRefitAll)
+		{
+			m_bvh.SetObjectBounds(itemIndex, center - extent, center + extent);
+		}
+		else
+		{
+			m_bvh.UpdateObject(itemIndex, center - extent, center + extent);
+		}
+	}
+
+	if (bRefitAll)
+	{
+		m_bvh.Refit();
+	}
+	if (m_bvh.NeedsRebuild())
+	{
+		BuildHierarchy();
+	}
+}
+
+/***********************************************************
+ *  UpdateObjectBounds()
+ *
+ *  This method is used for moving the world-space bounding
+ *  box of a draw to the current world matrix of its object,
+ *  starting from the local box of its mesh.
+ ***********************************************************/
+void SceneManager::UpdateObjectBounds(int itemIndex)
+{
+	const DRAW_ITEM& item = m_drawList[itemIndex];
+
+	m_frustumCuller.SetBounds(itemIndex, item.transform.GetWorldMatrix(),
+		g_MeshBounds[item.mesh][0], g_MeshBounds[item.mesh][1]);
+}
+
+/***********************************************************
+ *  CullObjects()
+ *
+ *  This method is used for marking which draws are inside
+ *  the view frustum of the current frame, so only those are
+ *  added to the render queue.
+ ***********************************************************/
+void SceneManager::CullObjects()
+{
+	int visibleCount = (int)m_drawList.size();
+
+	if (RenderSettings::Get().bFrustumCulling && RenderSettings::Get().bHierarchicalCulling)
+	{
+		glm::vec4 planes[6];
+		FrustumCuller::ExtractPlanes(m_projectionMatrix * m_viewMatrix, planes);
+		visibleCount = m_bvh.QueryFrustum(planes, m_visibleItems.data());
+	}
+	else if (RenderSettings::Get().bFrustumCulling && (NULL != m_pJobSystem))
+	{
+		glm::mat4 viewProjection = m_projectionMatrix * m_viewMatrix;
+		std::atomic<int> jobVisibleCount(0);
+
+		m_pJobSystem->ParallelFor(m_frustumCuller.GetCount(), CULLING_JOB_SIZE,
+			[this, &viewProjection, &jobVisibleCount](int first, int count)
+			{
+				jobVisibleCount += m_frustumCuller.Cull(viewProjection, first, count, m_visibleItems.data());
+			});
+		visibleCount = jobVisibleCount;
+	}
+	else if (RenderSettings::Get().bFrustumCulling)
+	{
+		visibleCount = m_frustumCuller.Cull(m_projectionMatrix * m_viewMatrix, m_visibleItems.data());
+	}
+	else
+	{
+		std::fill(m_visibleItems.begin(), m_visibleItems.end(), (uint8_t)1);
+	}
+
+	FrameStats::Current().objectsSubmitted += visibleCount;
+	FrameStats::Current().objectsCulled += (unsigned int)m_drawList.size() - visibleCount;
+}
+
+/***********************************************************
+ *  OccludeObjects()
+ *
+ *  This method is used for hiding the draws that passed
+ *  the frustum test but are behind the chosen occluders.
+ *  The occluders are drawn into the depth pyramid and every
+ *  other visible draw is tested against it by its bounds.
+ *  The occluders themselves are not tested, since they can
+ *  be hidden by their own depth when seen face on.
+ ***********************************************************/
+void SceneManager::OccludeObjects()
+{
+	if (false == RenderSettings::Get().bOcclusionCulling)
+	{
+		return;
+	}
+
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	int occludedCount = 0;
+
+	m_occlusionCuller.BeginFrame(m_projectionMatrix * m_viewMatrix);
+	SelectOccluders();
+	for (size_t i = 0; i < m_occluderCandidates.size(); i++)
+	{
+		const DRAW_ITEM& item = m_drawList[m_occluderCandidates[i].second];
+		m_occlusionCuller.DrawOccluder(item.transform.GetWorldMatrix(),
+			g_MeshBounds[item.mesh][0], g_MeshBounds[item.mesh][1]);
+		m_occluderItems[m_occluderCandidates[i].second] = 1;
+	}
+
+	if (m_occlusionCuller.GetOccluderCount() > 0)
+	{
+		std::atomic<int> jobOccludedCount(0);
+
+		m_occlusionCuller.BuildPyramid();
+		RunRange((int)m_drawList.size(), RECORD_JOB_SIZE, [this, &jobOccludedCount](int first, int count)
+		{
+			int rangeOccludedCount = 0;
+			for (int i = first; i < (first + count); i++)
+			{
+				if ((0 == m_visibleItems[i]) || (0 != m_occluderItems[i]))
+				{
+					continue;
+				}
+
+				glm::vec3 center;
+				glm::vec3 extent;
+				m_frustumCuller.GetBounds(i, center, extent);
+				if (false == m_occlusionCuller.IsVisible(center, extent))
+				{
+					m_visibleItems[i] = 0;
+					rangeOccludedCount++;
+				}
+			}
+			jobOccludedCount += rangeOccludedCount;
+		});
+		occludedCount = jobOccludedCount;
+	}
+
+	for (size_t i = 0; i < m_occluderCandidates.size(); i++)
+	{
+		m_occluderItems[m_occluderCandidates[i].second] = 0;
+	}
+
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+	FrameStats::FRAME_STATS& stats = FrameStats::Current();
+	stats.occludersDrawn += m_occlusionCuller.GetOccluderCount();
+	stats.objectsOccluded += occludedCount;
+	stats.objectsSubmitted -= occludedCount;
+	stats.occlusionPasses++;
+	stats.occlusionMilliseconds += elapsed.count();
+}
+
+/***********************************************************
+ *  SelectOccluders()
+ *
+ *  This method is used for choosing the occluders of the
+ *  frame.  Only opaque boxes and planes are considered,
+ *  because their meshes fill their bounds, and of those the
+ *  ones that look largest from the camera are kept.
+ ***********************************************************/
+void SceneManager::SelectOccluders()
+{
+	m_occluderCandidates.clear();
+	for (size_t i = 0; i < m_drawList.size(); i++)
+	{
+		const DRAW_ITEM& item = m_drawList[i];
+		if ((0 == m_visibleItems[i]) || (item.color.a < 1.0f) ||
+			((MESH_BOX != item.mesh) && (MESH_PLANE != item.mesh)))
+		{
+			continue;
+		}
+
+		glm::vec3 center;
+		glm::vec3 extent;
+		m_frustumCuller.GetBounds((int)i, center, extent);
+
+		// ratio of the bounding radius to the distance, which
+		// grows with the size of the object on screen
+		float distance = std::max(glm::length(center - m_cameraPosition), 1.0e-3f);
+		float size = glm::length(extent) / distance;
+		if (size >= MIN_OCCLUDER_SIZE)
+		{
+			m_occluderCandidates.push_back(std::make_pair(size, (int)i));
+		}
+	}
+
+	if ((int)m_occluderCandidates.size() > MAX_OCCLUDERS)
+	{
+		std::partial_sort(m_occluderCandidates.begin(), m_occluderCandidates.begin() + MAX_OCCLUDERS,
+			m_occluderCandidates.end(), std::greater<std::pair<float, int> >());
+		m_occluderCandidates.resize(MAX_OCCLUDERS);
+	}
+}
+
+/***********************************************************
+ *  SelectLevelsOfDetail()
+ *
+ *  This method is used for picking the level of detail each
+ *  visible draw is drawn at from the size of its bounding
+ *  sphere on screen.  A draw only moves to a coarser level
+ *  once it is clearly smaller than the switch size and back
+ *  once it is clearly larger, and can skip several levels in
+ *  one frame when the camera jumps.
+ ***********************************************************/
+void SceneManager::SelectLevelsOfDetail()
+{
+	bool bLevelOfDetail = RenderSettings::Get().bLevelOfDetail;
+
+	RunRange((int)m_drawList.size(), RECORD_JOB_SIZE, [this, bLevelOfDetail](int first, int count)
+	{
+		for (int i = first; i < (first + count); i++)
+		{
+			uint8_t& lod = m_itemLods[i];
+			if (0 == m_visibleItems[i])
+			{
+				continue;
+			}
+			if (false == bLevelOfDetail)
+			{
+				lod = 0;
+				continue;
+			}
+
+			glm::vec3 center;
+			glm::vec3 extent;
+			m_frustumCuller.GetBounds(i, center, extent);
+			float size = GetScreenSize(center, glm::length(extent));
+
+			while ((lod > 0) && (size > LOD_SCREEN_SIZES[lod - 1] * (1.0f + LOD_HYSTERESIS)))
+			{
+				lod--;
+			}
+			while ((lod < InstancedMeshes::LOD_COUNT - 1) && (size < LOD_SCREEN_SIZES[lod] * (1.0f - LOD_HYSTERESIS)))
+			{
+				lod++;
+			}
+		}
+	});
+}
+
+/***********************************************************
+ *  GetScreenSize()
+ *
+ *  This method is used for getting the projected radius of
+ *  a sphere as a fraction of half the viewport height.  The
+ *  distance to the camera is used instead of the depth, so
+ *  turning the camera does not change the size.
+ ***********************************************************/
+float SceneManager::GetScreenSize(const glm::vec3& center, float radius) const
+{
+	// an orthographic projection keeps the size at any distance
+	if (1.0f == m_projectionMatrix[3][3])
+	{
+		return(radius * m_projectionMatrix[1][1]);
+	}
+
+	float distance = std::max(glm::length(center - m_cameraPosition), 1.0e-3f);
+	return(radius * m_projectionMatrix[1][1] / distance);
+}
+
+/***********************************************************
+ *  DefineObjectMaterials()
+ *
+ *  This method is used for defining the materials that will
+ *  be used for the objects in the 3D scene.
+ ***********************************************************/
+void SceneManager::DefineObjectMaterials()
+{
+	// Glossy material for screen - high shine
+	OBJECT_MATERIAL glossyMaterial;
+	glossyMaterial.diffuseColor = glm::vec3(1.0f, 1.0f, 1.0f);
+	glossyMaterial.specularColor = glm::vec3(1.0f, 1.0f, 1.0f);
+	glossyMaterial.shininess = 128.0;
+	glossyMaterial.tag = g_GlossyMaterial;
+	AddObjectMaterial(glossyMaterial);
+
+	// Shiny metal material for stand - medium-high shine
+	OBJECT_MATERIAL metalMaterial;
+	metalMaterial.diffuseColor = glm::vec3(0.7f, 0.7f, 0.7f);
+	metalMaterial.specularColor = glm::vec3(0.9f, 0.9f, 0.9f);
+	metalMaterial.shininess = 64.0;
+	metalMaterial.tag = g_MetalMaterial;
+	AddObjectMaterial(metalMaterial);
+
+	// Wood material for desk - medium shine
+	OBJECT_MATERIAL woodMaterial;
+	woodMaterial.diffuseColor = glm::vec3(0.6f, 0.4f, 0.3f);
+	woodMaterial.specularColor = glm::vec3(0.3f, 0.3f, 0.3f);
+	woodMaterial.shininess = 32.0;
+	woodMaterial.tag = g_WoodMaterial;
+	AddObjectMaterial(woodMaterial);
+
+	// Matte plastic for keyboard and monitor - low shine
+	OBJECT_MATERIAL mattePlasticMaterial;
+	mattePlasticMaterial.diffuseColor = glm::vec3(0.5f, 0.5f, 0.5f);
+	mattePlasticMaterial.specularColor = glm::vec3(0.2f, 0.2f, 0.2f);
+	mattePlasticMaterial.shininess = 16.0;
+	mattePlasticMaterial.tag = g_MatteMaterial;
+	AddObjectMaterial(mattePlasticMaterial);
+
+	// Ceramic material for mug - smooth with moderate shine
+	OBJECT_MATERIAL ceramicMaterial;
+	ceramicMaterial.diffuseColor = glm::vec3(0.9f, 0.9f, 0.9f);
+	ceramicMaterial.specularColor = glm::vec3(0.5f, 0.5f, 0.5f);
+	ceramicMaterial.shininess = 48.0;
+	ceramicMaterial.tag = g_CeramicMaterial;
+	AddObjectMaterial(ceramicMaterial);
+
+	// Default fallback material
+	OBJECT_MATERIAL defaultMaterial;
+	defaultMaterial.diffuseColor = glm::vec3(1.0f, 1.0f, 1.0f);
+	defaultMaterial.specularColor = glm::vec3(0.5f, 0.5f, 0.5f);
+	defaultMaterial.shininess = 32.0;
+	defaultMaterial.tag = g_DefaultMaterial;
+	AddObjectMaterial(defaultMaterial);
+}
+
+/***********************************************************
+ *  AddObjectMaterial()
+ *
+ *  This method is used for adding a material to the scene
+ *  and registering its tag for constant time lookups.
+ ***********************************************************/
+void SceneManager::AddObjectMaterial(const OBJECT_MATERIAL& material)
+{
+	m_materialIndices.Add(material.tag, (int)m_objectMaterials.size());
+	m_objectMaterials.push_back(material);
+}
+
+/***********************************************************
+ *  CreateMaterialTable()
+ *
+ *  This method is used for uploading the defined materials
+ *  into a storage buffer one time.  Draw commands then only
+ *  pass the index of their material to the shader.  Shaders
+ *  that do not declare the MaterialData block keep receiving
+ *  the material values as separate uniforms.
+ *
+ *  The matching GLSL declaration is:
+ *
+ *    struct Material
+ *    {
+ *        vec4 diffuseShininess;    // w is the shininess
+ *        vec4 specularColor;
+ *    };
+ *    layout(std430, binding = 1) buffer MaterialData
+ *    {
+ *        Material materials[];
+ *    };
+ *    uniform int materialIndex;
+ ***********************************************************/
+void SceneManager::CreateMaterialTable()
+{
+	m_bUseMaterialTable = false;
+	if ((m_objectMaterials.size() == 0) || (NULL == m_pShaderUniforms) || (!GLEW_VERSION_4_3))
+	{
+		return;
+	}
+
+	GLuint programID = m_pShaderUniforms->GetProgramID();
+	GLuint blockIndex = glGetProgramResourceIndex(programID, GL_SHADER_STORAGE_BLOCK, g_MaterialDataBlockName);
+	if (blockIndex == GL_INVALID_INDEX)
+	{
+		return;
+	}
+
+	std::vector<GPU_MATERIAL> gpuMaterials(m_objectMaterials.size());
+	for (size_t i = 0; i < m_objectMaterials.size(); i++)
+	{
+		gpuMaterials[i].diffuseShininess = glm::vec4(m_objectMaterials[i].diffuseColor, m_objectMaterials[i].shininess);
+		gpuMaterials[i].specularColor = glm::vec4(m_objectMaterials[i].specularColor, 0.0f);
+	}
+
+	if (m_materialBufferID == 0)
+	{
+		glGenBuffers(1, &m_materialBufferID);
+	}
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_materialBufferID);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, gpuMaterials.size() * sizeof(GPU_MATERIAL), gpuMaterials.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, StorageBinding::MATERIAL_DATA, m_materialBufferID);
+	glShaderStorageBlockBinding(programID, blockIndex, StorageBinding::MATERIAL_DATA);
+	m_bUseMaterialTable = true;
+}
+
+/***********************************************************
+ *  DestroyMaterialTable()
+ *
+ *  This method is used for freeing the GPU material table.
+ ***********************************************************/
+void SceneManager::DestroyMaterialTable()
+{
+	if (m_materialBufferID != 0)
+	{
+		glDeleteBuffers(1, &m_materialBufferID);
+		m_materialBufferID = 0;
+	}
+	m_bUseMaterialTable = false;
+}
+
+/***********************************************************
+ *  SetupSceneLights()
+ *
+ *  This method is called to add and configure the light
+ *  sources for the 3D scene.
+ ***********************************************************/
+void SceneManager::SetupSceneLights()
+{
+	// Enable lighting in the shader
+	m_pShaderManager->setBoolValue(g_UseLightingName, true);
+
+	// PRIMARY LIGHT SOURCE: Directional light from above-front
+	// Reduced ambient for more dramatic shadows and contrast
+	m_pShaderManager->setVec3Value("directionalLight.direction", 0.2f, -1.0f, -0.3f);
+	m_pShaderManager->setVec3Value("directionalLight.ambient", 0.25f, 0.25f, 0.25f);
+	m_pShaderManager->setVec3Value("directionalLight.diffuse", 0.6f, 0.6f, 0.6f);
+	m_pShaderManager->setVec3Value("directionalLight.specular", 0.4f, 0.4f, 0.4f);
+	m_pShaderManager->setBoolValue("directionalLight.bActive", true);
+
+	// the point lights are kept in a storage buffer so the
+	// scene is not limited to the fixed uniform array
+	m_pLightManager->CreateBuffer();
+	if (NULL != m_pShaderUniforms)
+	{
+		m_pLightManager->AttachProgram(m_pShaderUniforms->GetProgramID());
+	}
+
+	LightManager::POINT_LIGHT pointLight;
+
+	// SECONDARY LIGHT SOURCE: Point light from the right side (cool fill light)
+	// Slightly blue-tinted to contrast with warm lamp
+	pointLight.position = glm::vec3(6.0f, 6.0f, 3.0f);
+	pointLight.ambient = glm::vec3(0.1f, 0.1f, 0.15f);
+	pointLight.diffuse = glm::vec3(0.4f, 0.4f, 0.5f);  // Slightly cool/blue
+	pointLight.specular = glm::vec3(0.5f, 0.5f, 0.6f);
+	pointLight.bActive = true;
+	// the fill light reaches the whole scene
+	pointLight.range = 0.0f;
+	m_pLightManager->AddPointLight(pointLight);
+
+	// THIRD LIGHT SOURCE (COLORED): Point light from desk lamp - soft red glow
+	pointLight.position = glm::vec3(-5.2f, 2.6f, 0.8f);
+	// Softer red light values 
+	pointLight.ambient = glm::vec3(0.25f, 0.05f, 0.05f);   // gentle red ambient tint
+	pointLight.diffuse = glm::vec3(0.8f, 0.1f, 0.1f);     // main red light cone
+	pointLight.specular = glm::vec3(0.6f, 0.2f, 0.2f);    // soft red highlights
+	pointLight.bActive = true;
+	// the lamp only lights the desk it stands on, so the other
+	// desk copies leave it out of their light lists
+	pointLight.range = 12.0f;
+	m_pLightManager->AddPointLight(pointLight);
+
+	// send all the point lights in one upload - any point
+	// lights not added stay disabled
+	m_pLightManager->UploadLights();
+
+	// Disable spotlight
+	m_pShaderManager->setBoolValue("spotLight.bActive", false);
+}
+
+/***********************************************************
+ *  RenderScene()
+ *
+ *  This method is used for rendering the 3D scene by
+ *  replaying the retained draw commands.  The frame is
+ *  recorded first, with the per-draw work spread across the
+ *  job system, and then submitted by this thread alone,
+ *  which is the only one that makes GL calls.
+ ***********************************************************/
+void SceneManager::RenderScene()
+{
+	// send any point lights that changed since the last frame
+	m_pLightManager->UploadLights();
+	// and the next part of the textures still being loaded
+	m_textureLoader.Update();
+
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	RecordScene();
+	std::chrono::high_resolution_clock::time_point recorded = std::chrono::high_resolution_clock::now();
+	SubmitScene();
+	std::chrono::high_resolution_clock::time_point submitted = std::chrono::high_resolution_clock::now();
+
+	FrameStats::Current().recordThreads = (NULL != m_pJobSystem) ? m_pJobSystem->GetThreadCount() : 1;
+	FrameStats::Current().recordMilliseconds += std::chrono::duration<double, std::milli>(recorded - start).count();
+	FrameStats::Current().submitMilliseconds += std::chrono::duration<double, std::milli>(submitted - recorded).count();
+}
+
+/***********************************************************
+ *  RecordScene()
+ *
+ *  This method is used for deciding what is drawn this frame
+ *  and in which order.  Every pass over the draws is split
+ *  into jobs that write only their own draws, and the jobs
+ *  make no GL calls, so the GL state is left untouched until
+ *  SubmitScene().
+ ***********************************************************/
+void SceneManager::RecordScene()
+{
+	int packetCount = ((int)m_drawList.size() + RECORD_JOB_SIZE - 1) / RECORD_JOB_SIZE;
+	m_recordPackets.resize((packetCount > 0) ? packetCount : 1);
+
+	// rebuild only the model matrices of objects that moved
+	UpdateTransforms();
+	// and the light lists of the objects that moved
+	m_pLightManager->BuildLightLists(m_bvh, m_batchedItems);
+	// skip the objects outside of the camera view
+	CullObjects();
+	// and the ones hidden behind large objects in front of them
+	OccludeObjects();
+	// draw the small curved objects with fewer triangles
+	SelectLevelsOfDetail();
+
+	// order the draws so objects sharing state are drawn together
+	BuildRenderQueue();
+	FrameStats::Current().drawStateChangesUnsorted += m_renderQueue.CountStateChanges();
+	if (RenderSettings::Get().bSortDraws)
+	{
+		m_renderQueue.Sort();
+	}
+	FrameStats::Current().drawStateChangesSubmitted += m_renderQueue.CountStateChanges();
+
+	if (m_bUseInstancing && RenderSettings::Get().bInstancedDraws)
+	{
+		RecordInstances();
+	}
+}
+
+/***********************************************************
+ *  SubmitScene()
+ *
+ *  This method is used for making the GL calls for the draw
+ *  commands recorded this frame, in their recorded order.
+ ***********************************************************/
+void SceneManager::SubmitScene()
+{
+	// send the light lists gathered while recording
+	m_pLightManager->UploadLightLists();
+	// pick up the mesh triangle counts that have finished
+	ReadBasicMeshTriangles();
+
+	// draw the objects that never moved from their batches
+	if (UseStaticBatches())
+	{
+		DrawStaticBatches();
+	}
+
+	if (m_bUseInstancing && RenderSettings::Get().bInstancedDraws)
+	{
+		DrawQueueInstanced();
+	}
+	else
+	{
+		// without instancing the translucent draws of the
+		// transparency pass are held back until the opaque ones
+		// are drawn
+		bool bTransparencyPass = UseTransparencyPass();
+
+		m_transparentDraws.clear();
+		m_translucentBatches.clear();
+		for (int i = 0; i < m_renderQueue.GetCount(); i++)
+		{
+			uint32_t itemIndex = m_renderQueue.GetItemIndex(i);
+			if (bTransparencyPass && (m_drawList[itemIndex].color.a < 1.0f))
+			{
+				m_transparentDraws.push_back(itemIndex);
+				continue;
+			}
+			DrawItem(itemIndex);
+		}
+
+		if (false == m_transparentDraws.empty())
+		{
+			DrawTransparencyPass();
+		}
+	}
+}
+
+/***********************************************************
+ *  RunRange()
+ *
+ *  This method is used for running a job over the draws
+ *  [0, count), split into jobs of grainSize draws on the job
+ *  system, or over the whole range at once without one.
+ *  Every split starts at a multiple of the grain size.
+ ***********************************************************/
+void SceneManager::RunRange(int count, int grainSize, const JobSystem::RANGE_JOB& job)
+{
+	if (NULL != m_pJobSystem)
+	{
+		m_pJobSystem->ParallelFor(count, grainSize, job);
+	}
+	else if (count > 0)
+	{
+		job(0, count);
+	}
+}
+
+/***********************************************************
+ *  SetRingBuffer()
+ *
+ *  This method is used for writing the per-draw instance
+ *  data and draw commands into the mapped ring buffer, so
+ *  they need no buffer updates.
+ ***********************************************************/
+void SceneManager::SetRingBuffer(PersistentRingBuffer* pRingBuffer)
+{
+	m_pRingBuffer = pRingBuffer;
+}
+
+/***********************************************************
+ *  SetJobSystem()
+ *
+ *  This method is used for spreading the transform updates,
+ *  frustum tests and light queries of large scenes across
+ *  the threads of a job system.
+ ***********************************************************/
+void SceneManager::SetJobSystem(JobSystem* pJobSystem)
+{
+	m_pJobSystem = pJobSystem;
+	m_pLightManager->SetJobSystem(pJobSystem);
+}
+
+/***********************************************************
+ *  SetViewMatrix()
+ *
+ *  This method is used for setting the view matrix of the
+ *  current frame, which orders the opaque draws front to
+ *  back and the translucent draws back to front, and the
+ *  camera position that sizes the draws on screen.
+ ***********************************************************/
+void SceneManager::SetViewMatrix(const glm::mat4& view)
+{
+	m_viewMatrix = view;
+	m_cameraPosition = glm::vec3(glm::inverse(view)[3]);
+}
+
+/***********************************************************
+ *  SetProjectionMatrix()
+ *
+ *  This method is used for setting the projection matrix of
+ *  the current frame, which together with the view matrix
+ *  gives the frustum the draws are culled against.
+ ***********************************************************/
+void SceneManager::SetProjectionMatrix(const glm::mat4& projection)
+{
+	m_projectionMatrix = projection;
+}
+
+/***********************************************************
+ *  BuildRenderQueue()
+ *
+ *  This method is used for adding every draw command that
+ *  passed culling to the render queue in authoring order
+ *  with its sort key.
+ ***********************************************************/
+void SceneManager::BuildRenderQueue()
+{
+	uint32_t programID = 0;
+
+	if (NULL != m_pShaderUniforms)
+	{
+		programID = m_pShaderUniforms->GetProgramID();
+	}
+
+	bool bStaticBatches = UseStaticBatches();
+	bool bTransparencyPass = UseTransparencyPass();
+
+	for (size_t i = 0; i < m_recordPackets.size(); i++)
+	{
+		m_recordPackets[i].entries.clear();
+	}
+
+	// every job keys its own slice of the draw list into its
+	// packet, and the packets are joined in draw list order
+	RunRange((int)m_drawList.size(), RECORD_JOB_SIZE, [this, programID, bStaticBatches, bTransparencyPass](int first, int count)
+	{
+		RECORD_PACKET& packet = m_recordPackets[first / RECORD_JOB_SIZE];
+		for (int i = first; i < (first + count); i++)
+		{
+			if ((0 == m_visibleItems[i]) || (bStaticBatches && m_staticBatches.IsBatched(i)))
+			{
+				continue;
+			}
+
+			const DRAW_ITEM& item = m_drawList[i];
+			const glm::mat4& world = item.transform.GetWorldMatrix();
+
+			// distance of the object origin in front of the camera,
+			// which translucent draws in the transparency pass do
+			// not need, so they are ordered by state alone
+			glm::vec4 viewPosition = m_viewMatrix * world[3];
+			float depth = -viewPosition.z;
+			if (bTransparencyPass && (item.color.a < 1.0f))
+			{
+				depth = 0.0f;
+			}
+
+			// untextured draws and draws without a material use key
+			// value 0, so the indices are stored one higher, and
+			// every level of detail counts as its own mesh
+			RenderQueue::RENDER_ENTRY entry;
+			entry.key = RenderQueue::MakeSortKey(
+				item.color.a < 1.0f,
+				programID,
+				(uint32_t)(item.mesh * InstancedMeshes::LOD_COUNT + m_itemLods[i]),
+				(uint32_t)(GetTextureUnit(item.textureSlot) + 1),
+				(uint32_t)(item.materialIndex + 1),
+				depth);
+			entry.itemIndex = (uint32_t)i;
+			packet.entries.push_back(entry);
+		}
+	});
+
+	m_renderQueue.Clear();
+	for (size_t i = 0; i < m_recordPackets.size(); i++)
+	{
+		m_renderQueue.Append(m_recordPackets[i].entries.data(), (int)m_recordPackets[i].entries.size());
+	}
+}
+
+/***********************************************************
+ *  RecordInstances()
+ *
+ *  This method is used for turning the render queue into as
+ *  few draw calls as possible.  Neighbouring opaque draws
+ *  that use the same mesh and texture are merged into one
+ *  instance batch, which with sorting enabled is one batch
+ *  per mesh and texture pair.  Translucent draws are batched
+ *  the same way when they go into the transparency pass, and
+ *  otherwise keep their own draw calls after the opaque ones,
+ *  so their back to front order is kept.
+ *
+ *  Every queued draw owns the instance slot at its queue
+ *  position, so jobs fill the slots and batches of their
+ *  slice of the queue independently, and the batches that
+ *  continue across the end of a slice are joined after.
+ ***********************************************************/
+void SceneManager::RecordInstances()
+{
+	int queueCount = m_renderQueue.GetCount();
+	InstancedMeshes::INSTANCE_DATA* pInstances = NULL;
+	int instanceBase = 0;
+
+	bool bTransparencyPass = UseTransparencyPass();
+
+	m_instanceBatches.clear();
+	m_translucentBatches.clear();
+	m_transparentDraws.clear();
+	m_singleDraws.clear();
+	m_instanceCount = queueCount;
+
+	// write the instances straight into the mapped ring buffer
+	// when there is one, otherwise stage them for an upload
+	m_frameInstanceBuffer = m_instanceBufferID;
+	if ((NULL != m_pRingBuffer) && (queueCount > 0))
+	{
+		GLintptr offset = 0;
+		pInstances = (InstancedMeshes::INSTANCE_DATA*)m_pRingBuffer->Allocate(
+			queueCount * sizeof(InstancedMeshes::INSTANCE_DATA), sizeof(InstancedMeshes::INSTANCE_DATA), offset);
+		if (NULL != pInstances)
+		{
+			// the instance attributes read from the start of the
+			// ring, so the base instance selects this frame's range
+			m_frameInstanceBuffer = m_pRingBuffer->GetBufferID();
+			instanceBase = (int)(offset / sizeof(InstancedMeshes::INSTANCE_DATA));
+		}
+	}
+	if (NULL == pInstances)
+	{
+		m_instances.resize(queueCount);
+		pInstances = m_instances.data();
+	}
+
+	for (size_t i = 0; i < m_recordPackets.size(); i++)
+	{
+		RECORD_PACKET& packet = m_recordPackets[i];
+		packet.batches.clear();
+		packet.singleDraws.clear();
+		packet.trianglesDrawn = 0;
+		packet.trianglesFullDetail = 0;
+	}
+
+	RunRange(queueCount, RECORD_JOB_SIZE, [this, pInstances, instanceBase, bTransparencyPass](int first, int count)
+	{
+		RECORD_PACKET& packet = m_recordPackets[first / RECORD_JOB_SIZE];
+		for (int i = first; i < (first + count); i++)
+		{
+			uint32_t itemIndex = m_renderQueue.GetItemIndex(i);
+			const DRAW_ITEM& item = m_drawList[itemIndex];
+			bool bTranslucent = (item.color.a < 1.0f);
+
+			if (bTranslucent && (false == bTransparencyPass))
+			{
+				packet.singleDraws.push_back(itemIndex);
+				continue;
+			}
+
+			// with the material table each instance selects its own
+			// material, otherwise the material is set per batch, and
+			// with texture arrays each instance selects its own layer
+			INSTANCE_BATCH batch;
+			batch.mesh = item.mesh;
+			batch.lod = m_itemLods[itemIndex];
+			batch.textureUnit = GetTextureUnit(item.textureSlot);
+			batch.materialIndex = m_bUseMaterialTable ? -1 : item.materialIndex;
+			batch.firstInstance = instanceBase + i;
+			batch.instanceCount = 0;
+			batch.bTranslucent = bTranslucent;
+			if (packet.batches.empty() || (false == CanJoinBatch(packet.batches.back(), batch)))
+			{
+				packet.batches.push_back(batch);
+			}
+
+			InstancedMeshes::INSTANCE_DATA& instance = pInstances[i];
+			instance.model = item.transform.GetWorldMatrix();
+			instance.color = item.color;
+			instance.UVscale = item.UVscale;
+			instance.materialIndex = item.materialIndex;
+			instance.textureLayer = GetTextureLayer(item.textureSlot);
+			instance.objectIndex = (int32_t)itemIndex;
+			packet.batches.back().instanceCount++;
+
+			InstancedMeshes::SHAPE shape = GetInstancedShape(item.mesh);
+			packet.trianglesDrawn += m_pInstancedMeshes->GetTriangleCount(shape, batch.lod);
+			packet.trianglesFullDetail += m_pInstancedMeshes->GetTriangleCount(shape, 0);
+		}
+	});
+
+	for (size_t i = 0; i < m_recordPackets.size(); i++)
+	{
+		const RECORD_PACKET& packet = m_recordPackets[i];
+		for (size_t b = 0; b < packet.batches.size(); b++)
+		{
+			const INSTANCE_BATCH& batch = packet.batches[b];
+			std::vector<INSTANCE_BATCH>& batches = batch.bTranslucent ? m_translucentBatches : m_instanceBatches;
+			if ((false == batches.empty()) && CanJoinBatch(batches.back(), batch))
+			{
+				batches.back().instanceCount += batch.instanceCount;
+			}
+			else
+			{
+				batches.push_back(batch);
+			}
+		}
+		m_singleDraws.insert(m_singleDraws.end(), packet.singleDraws.begin(), packet.singleDraws.end());
+		FrameStats::Current().trianglesDrawn += packet.trianglesDrawn;
+		FrameStats::Current().trianglesFullDetail += packet.trianglesFullDetail;
+	}
+}
+
+/***********************************************************
+ *  DrawQueueInstanced()
+ *
+ *  This method is used for drawing the instance batches and
+ *  single draws recorded this frame, with indirect draws
+ *  when available, followed by the translucent batches.
+ ***********************************************************/
+void SceneManager::DrawQueueInstanced()
+{
+	if (m_frameInstanceBuffer == m_instanceBufferID)
+	{
+		InstancedMeshes::UploadInstances(m_instanceBufferID, m_instanceCapacity, m_instances.data(), m_instanceCount);
+	}
+
+	if (NULL != m_pShaderUniforms)
+	{
+		m_pShaderUniforms->setBoolValue(m_uniforms.useInstanceData, true);
+	}
+
+	if (InstancedMeshes::IsIndirectSupported() && RenderSettings::Get().bMultiDrawIndirect)
+	{
+		DrawBatchesIndirect();
+	}
+	else
+	{
+		for (size_t i = 0; i < m_instanceBatches.size(); i++)
+		{
+			const INSTANCE_BATCH& batch = m_instanceBatches[i];
+
+			ApplyBatchState(batch.textureUnit, batch.materialIndex);
+			m_pInstancedMeshes->DrawMeshInstanced(GetInstancedShape(batch.mesh), batch.lod, m_frameInstanceBuffer,
+				batch.instanceCount, batch.firstInstance);
+		}
+	}
+
+	for (size_t i = 0; i < m_singleDraws.size(); i++)
+	{
+		DrawItem(m_singleDraws[i]);
+	}
+
+	if (false == m_translucentBatches.empty())
+	{
+		DrawTransparencyPass();
+	}
+}
+
+/***********************************************************
+ *  UseTransparencyPass()
+ *
+ *  This method is used for checking whether translucent
+ *  draws are drawn order independent this frame, which needs
+ *  the shader to write the transparency targets.
+ ***********************************************************/
+bool SceneManager::UseTransparencyPass() const
+{
+	return(RenderSettings::Get().bOrderIndependentTransparency && m_bUseTransparencyBuffer);
+}
+
+/***********************************************************
+ *  DrawTransparencyPass()
+ *
+ *  This method is used for drawing the translucent batches
+ *  and draws recorded this frame into the transparency
+ *  targets, in any order, and compositing them over the
+ *  frame.  When the targets cannot be created they are drawn
+ *  blended straight into the frame instead, and the pass is
+ *  turned off from the next frame on, so the draws are
+ *  sorted back to front again.
+ ***********************************************************/
+void SceneManager::DrawTransparencyPass()
+{
+	bool bStarted = m_transparencyBuffer.Begin();
+	if (bStarted)
+	{
+		m_pShaderUniforms->setBoolValue(m_uniforms.transparencyPass, true);
+	}
+	else
+	{
+		std::cout << "ERROR: could not create the transparency targets, sorting translucent objects back to front" << std::endl;
+		m_bUseTransparencyBuffer = false;
+	}
+
+	if (false == m_translucentBatches.empty())
+	{
+		m_pShaderUniforms->setBoolValue(m_uniforms.useInstanceData, true);
+		for (size_t i = 0; i < m_translucentBatches.size(); i++)
+		{
+			const INSTANCE_BATCH& batch = m_translucentBatches[i];
+
+			ApplyBatchState(batch.textureUnit, batch.materialIndex);
+			m_pInstancedMeshes->DrawMeshInstanced(GetInstancedShape(batch.mesh), batch.lod, m_frameInstanceBuffer,
+				batch.instanceCount, batch.firstInstance);
+		}
+	}
+	for (size_t i = 0; i < m_transparentDraws.size(); i++)
+	{
+		DrawItem(m_transparentDraws[i]);
+	}
+
+	if (bStarted)
+	{
+		m_pShaderUniforms->setBoolValue(m_uniforms.transparencyPass, false);
+		m_transparencyBuffer.End();
+	}
+}
+
+/***********************************************************
+ *  ApplyBatchState()
+ *
+ *  This method is used for setting the texture and material
+ *  uniforms shared by every object of an instance batch or
+ *  static batch.
+ ***********************************************************/
+void SceneManager::ApplyBatchState(int textureUnit, int materialIndex)
+{
+	if (textureUnit >= 0)
+	{
+		ApplyTextureUnit(textureUnit);
+	}
+	else if (NULL != m_pShaderUniforms)
+	{
+		m_pShaderUniforms->setIntValue(m_uniforms.useTexture, false);
+	}
+
+	if (materialIndex >= 0)
+	{
+		ApplyMaterialIndex(materialIndex);
+	}
+}
+
+/***********************************************************
+ *  DrawBatchesIndirect()
+ *
+ *  This method is used for drawing all instance batches with
+ *  as few glMultiDrawElementsIndirect calls as the texture
+ *  and material uniforms allow.  The batches are grouped by
+ *  those uniforms and each group is one call, so the number
+ *  of calls depends on the number of texture units in use
+ *  and not on the number of objects.  With texture arrays
+ *  and the material table that is one call per size bucket.
+ ***********************************************************/
+void SceneManager::DrawBatchesIndirect()
+{
+	int batchCount = (int)m_instanceBatches.size();
+
+	m_batchOrder.resize(batchCount);
+	for (int i = 0; i < batchCount; i++)
+	{
+		m_batchOrder[i] = i;
+	}
+	std::stable_sort(m_batchOrder.begin(), m_batchOrder.end(),
+		[this](int left, int right)
+		{
+			const INSTANCE_BATCH& leftBatch = m_instanceBatches[left];
+			const INSTANCE_BATCH& rightBatch = m_instanceBatches[right];
+			if (leftBatch.textureUnit != rightBatch.textureUnit)
+			{
+				return(leftBatch.textureUnit < rightBatch.textureUnit);
+			}
+			return(leftBatch.materialIndex < rightBatch.materialIndex);
+		});
+
+	m_drawCommands.resize(batchCount);
+	for (int i = 0; i < batchCount; i++)
+	{
+		const INSTANCE_BATCH& batch = m_instanceBatches[m_batchOrder[i]];
+		InstancedMeshes::DRAW_COMMAND& command = m_drawCommands[i];
+
+		// a shape that was not loaded draws nothing
+		memset(&command, 0, sizeof(command));
+		m_pInstancedMeshes->MakeDrawCommand(GetInstancedShape(batch.mesh), batch.lod, batch.instanceCount, batch.firstInstance, command);
+	}
+
+	// the commands go into the ring buffer next to the instances
+	// when there is room, otherwise into their own buffer
+	GLuint commandBuffer = m_drawCommandBufferID;
+	int commandBase = 0;
+	void* pCommands = NULL;
+	if (NULL != m_pRingBuffer)
+	{
+		GLintptr offset = 0;
+		pCommands = m_pRingBuffer->Allocate(batchCount * sizeof(InstancedMeshes::DRAW_COMMAND),
+			sizeof(InstancedMeshes::DRAW_COMMAND), offset);
+		if (NULL != pCommands)
+		{
+			memcpy(pCommands, m_drawCommands.data(), batchCount * sizeof(InstancedMeshes::DRAW_COMMAND));
+			commandBuffer = m_pRingBuffer->GetBufferID();
+			commandBase = (int)(offset / sizeof(InstancedMeshes::DRAW_COMMAND));
+		}
+	}
+	if (NULL == pCommands)
+	{
+		InstancedMeshes::UploadDrawCommands(m_drawCommandBufferID, m_drawCommandCapacity, m_drawCommands.data(), batchCount);
+	}
+
+	int firstCommand = 0;
+	for (int i = 0; i < batchCount; i++)
+	{
+		const INSTANCE_BATCH& batch = m_instanceBatches[m_batchOrder[i]];
+		bool bLastInGroup = (i == (batchCount - 1)) ||
+			(m_instanceBatches[m_batchOrder[i + 1]].textureUnit != batch.textureUnit) ||
+			(m_instanceBatches[m_batchOrder[i + 1]].materialIndex != batch.materialIndex);
+
+		if (bLastInGroup)
+		{
+			ApplyBatchState(batch.textureUnit, batch.materialIndex);
+			m_pInstancedMeshes->DrawIndirect(m_frameInstanceBuffer, commandBuffer, commandBase + firstCommand,
+				i - firstCommand + 1);
+			firstCommand = i + 1;
+		}
+	}
+}
+
+/***********************************************************
+ *  DrawItem()
+ *
+ *  This method is used for sending the transformation,
+ *  color, texture, material and object index of a retained
+ *  draw command into the shader and drawing its mesh.
+ ***********************************************************/
+void SceneManager::DrawItem(uint32_t itemIndex)
+{
+	const DRAW_ITEM& item = m_drawList[itemIndex];
+
+	if (NULL != m_pShaderUniforms)
+	{
+		m_pShaderUniforms->setBoolValue(m_uniforms.useInstanceData, false);
+		m_pShaderUniforms->setMat4Value(m_uniforms.model, item.transform.GetWorldMatrix());
+		m_pShaderUniforms->setVec4Value(m_uniforms.objectColor, item.color);
+		m_pShaderUniforms->setIntValue(m_uniforms.objectIndex, (int)itemIndex);
+	}
+
+	if (item.textureSlot >= 0)
+	{
+		ApplyTextureSlot(item.textureSlot);
+		SetTextureUVScale(item.UVscale.x, item.UVscale.y);
+	}
+	else if (NULL != m_pShaderUniforms)
+	{
+		m_pShaderUniforms->setIntValue(m_uniforms.useTexture, false);
+	}
+
+	ApplyMaterialIndex(item.materialIndex);
+	DrawMesh(item.mesh);
+	FrameStats::Current().drawCalls++;
+
+	// the basic shape meshes only have the full detail
+	unsigned int triangleCount = m_basicMeshTriangles[item.mesh];
+	FrameStats::Current().trianglesDrawn += triangleCount;
+	FrameStats::Current().trianglesFullDetail += triangleCount;
+}
+
+/***********************************************************
+ *  DrawMesh()
+ *
+ *  This method is used for drawing one of the loaded basic
+ *  shape meshes.
+ ***********************************************************/
+void SceneManager::DrawMesh(MESH_TYPE mesh)
+{
+	switch (mesh)
+	{
+	case MESH_BOX:
+		m_basicMeshes->DrawBoxMesh();
+		break;
+	case MESH_PLANE:
+		m_basicMeshes->DrawPlaneMesh();
+		break;
+	case MESH_CYLINDER:
+		m_basicMeshes->DrawCylinderMesh();
+		break;
+	case MESH_CONE:
+		m_basicMeshes->DrawConeMesh();
+		break;
+	case MESH_TAPERED_CYLINDER:
+		m_basicMeshes->DrawTaperedCylinderMesh();
+		break;
+	case MESH_SPHERE:
+		m_basicMeshes->DrawSphereMesh();
+		break;
+	case MESH_TORUS:
+		m_basicMeshes->DrawTorusMesh();
+		break;
+	default:
+		break;
+	}
+}
@@ -10,9 +10,26 @@
 #pragma once
 
 #include "ShaderManager.h"
+#include "ShaderUniforms.h"
 #include "ShapeMeshes.h"
+#include "LightManager.h"
+#include "TagId.h"
+#include "Transform.h"
+#include "TransformBatch.h"
+#include "RenderQueue.h"
+#include "InstancedMeshes.h"
+#include "PersistentRingBuffer.h"
+#include "TextureArrays.h"
+#include "TextureLoader.h"
+#include "FrustumCuller.h"
+#include "BoundingVolumeHierarchy.h"
+#include "OcclusionCuller.h"
+#include "StaticBatches.h"
+#include "JobSystem.h"
+#include "TransparencyBuffer.h"
 
 #include <string>
+#include <utility>
 #include <vector>
 
 /***********************************************************
@@ -25,14 +42,18 @@ class SceneManager
 {
 public:
 	// constructor
-	SceneManager(ShaderManager* pShaderManager);
+	SceneManager(ShaderManager* pShaderManager, ShaderUniforms* pShaderUniforms);
 	// destructor
 	~SceneManager();
 
 	struct TEXTURE_INFO
 	{
-		std::string tag;
+		TagId tag;
 		uint32_t ID;
+		// texture unit the texture is sampled from and its
+		// layer when packed into a texture array, otherwise -1
+		int unit;
+		int layer;
 	};
 
 	struct OBJECT_MATERIAL
@@ -40,32 +61,236 @@ public:
 		glm::vec3 diffuseColor;
 		glm::vec3 specularColor;
 		float shininess;
-		std::string tag;
+		TagId tag;
+	};
+
+	// std430 image of one entry in the GPU material table
+	struct GPU_MATERIAL
+	{
+		// rgb is the diffuse color, w is the shininess
+		glm::vec4 diffuseShininess;
+		glm::vec4 specularColor;
+	};
+
+	// basic shape meshes that objects in the scene are drawn with
+	enum MESH_TYPE
+	{
+		MESH_BOX,
+		MESH_PLANE,
+		MESH_CYLINDER,
+		MESH_CONE,
+		MESH_TAPERED_CYLINDER,
+		MESH_SPHERE,
+		MESH_TORUS,
+		MESH_COUNT
+	};
+
+	// authoring description of one object in the scene
+	struct SCENE_OBJECT
+	{
+		MESH_TYPE mesh;
+		glm::vec3 scaleXYZ;
+		float XrotationDegrees;
+		float YrotationDegrees;
+		float ZrotationDegrees;
+		glm::vec3 positionXYZ;
+		glm::vec4 color;
+		// the empty tag draws the object without a texture
+		TagId textureTag;
+		TagId materialTag;
+		glm::vec2 UVscale;
+	};
+
+	// retained draw command built from a scene object, with
+	// all tags already resolved to slots and indices
+	struct DRAW_ITEM
+	{
+		// transformation values and cached model matrix
+		Transform transform;
+		glm::vec4 color;
+		glm::vec2 UVscale;
+		MESH_TYPE mesh;
+		// -1 when the object is drawn without a texture
+		int textureSlot;
+		int materialIndex;
+	};
+
+	// uniform handles that are used for every draw command
+	struct UNIFORM_HANDLES
+	{
+		ShaderUniforms::UNIFORM_HANDLE model;
+		ShaderUniforms::UNIFORM_HANDLE objectColor;
+		ShaderUniforms::UNIFORM_HANDLE objectTexture;
+		ShaderUniforms::UNIFORM_HANDLE useTexture;
+		ShaderUniforms::UNIFORM_HANDLE UVscale;
+		ShaderUniforms::UNIFORM_HANDLE materialDiffuse;
+		ShaderUniforms::UNIFORM_HANDLE materialSpecular;
+		ShaderUniforms::UNIFORM_HANDLE materialShininess;
+		ShaderUniforms::UNIFORM_HANDLE materialIndex;
+		ShaderUniforms::UNIFORM_HANDLE useInstanceData;
+		ShaderUniforms::UNIFORM_HANDLE textureArray;
+		ShaderUniforms::UNIFORM_HANDLE textureLayer;
+		ShaderUniforms::UNIFORM_HANDLE transparencyPass;
+		ShaderUniforms::UNIFORM_HANDLE objectIndex;
+	};
+
+	// range of the instance buffer drawn with one call
+	struct INSTANCE_BATCH
+	{
+		MESH_TYPE mesh;
+		int lod;
+		// -1 when the batch is drawn without a texture
+		int textureUnit;
+		int materialIndex;
+		int firstInstance;
+		int instanceCount;
+		// true for a batch drawn in the transparency pass
+		bool bTranslucent;
+	};
+
+	// draw commands recorded by one job - the render queue
+	// entries of a slice of the draw list and, once the queue
+	// is sorted, the instance batches and single draws of a
+	// slice of the queue
+	struct RECORD_PACKET
+	{
+		std::vector<RenderQueue::RENDER_ENTRY> entries;
+		std::vector<INSTANCE_BATCH> batches;
+		std::vector<uint32_t> singleDraws;
+		unsigned int trianglesDrawn;
+		unsigned int trianglesFullDetail;
 	};
 
 private:
 	// pointer to shader manager object
 	ShaderManager* m_pShaderManager;
+	// pointer to resolved shader uniforms object
+	ShaderUniforms* m_pShaderUniforms;
+	// handles of the uniforms set for each draw command
+	UNIFORM_HANDLES m_uniforms;
+	// pointer to scene lights object
+	LightManager* m_pLightManager;
 	// pointer to basic shapes object
 	ShapeMeshes* m_basicMeshes;
-	// total number of loaded textures
-	int m_loadedTextures;
+	// triangles drawn for each basic shape mesh and the
+	// queries counting them until their results are read
+	unsigned int m_basicMeshTriangles[MESH_COUNT];
+	GLuint m_basicMeshQueries[MESH_COUNT];
+	// basic shapes drawn with per-instance data
+	InstancedMeshes* m_pInstancedMeshes;
+	// per-instance data of the opaque draws and its buffer
+	std::vector<InstancedMeshes::INSTANCE_DATA> m_instances;
+	std::vector<INSTANCE_BATCH> m_instanceBatches;
+	// draws that are not part of an instance batch
+	std::vector<uint32_t> m_singleDraws;
+	GLuint m_instanceBufferID;
+	int m_instanceCapacity;
+	// number of instance slots written this frame, one per
+	// queued draw
+	int m_instanceCount;
+	// per-job draw commands of the record phase, one packet
+	// per RECORD_JOB_SIZE draws
+	std::vector<RECORD_PACKET> m_recordPackets;
+	// indirect draw commands of the instance batches, in the
+	// order of m_batchOrder
+	std::vector<InstancedMeshes::DRAW_COMMAND> m_drawCommands;
+	std::vector<int> m_batchOrder;
+	GLuint m_drawCommandBufferID;
+	int m_drawCommandCapacity;
+	// optional mapped ring buffer the instance data and draw
+	// commands are written into, and the buffer the instance
+	// data of the current frame is in
+	PersistentRingBuffer* m_pRingBuffer;
+	// optional job system the per-object work of a frame is
+	// split across
+	JobSystem* m_pJobSystem;
+	GLuint m_frameInstanceBuffer;
+	// true when the shader reads the instance attributes
+	bool m_bUseInstancing;
+	// number of copies of the desk setup in the scene
+	int m_deskCount;
 	// loaded textures info
-	TEXTURE_INFO m_textureIDs[16];
+	std::vector<TEXTURE_INFO> m_textureIDs;
+	// size buckets the textures are packed into, and whether
+	// textures are selected by layer instead of by unit
+	TextureArrays m_textureArrays;
+	// decodes the texture images in the background and
+	// streams them into the textures
+	TextureLoader m_textureLoader;
+	bool m_bUseTextureArrays;
 	// defined object materials
 	std::vector<OBJECT_MATERIAL> m_objectMaterials;
+	// retained draw commands replayed every frame
+	std::vector<DRAW_ITEM> m_drawList;
+	// transform values and results of moved objects whose
+	// matrices are rebuilt together
+	TransformBatch m_transformBatch;
+	std::vector<int> m_batchedItems;
+	std::vector<glm::mat4> m_batchedMatrices;
+	// draw commands ordered by state for submission
+	RenderQueue m_renderQueue;
+	// view matrix of the current frame for depth ordering
+	// and the camera position it places
+	glm::mat4 m_viewMatrix;
+	glm::vec3 m_cameraPosition;
+	// projection matrix of the current frame for culling
+	glm::mat4 m_projectionMatrix;
+	// world-space bounds of the draws and which of them are
+	// inside the view frustum this frame
+	FrustumCuller m_frustumCuller;
+	std::vector<uint8_t> m_visibleItems;
+	// tree over the same bounds for culling and queries
+	BoundingVolumeHierarchy m_bvh;
+	// depth pyramid of the occluders of the current frame,
+	// the candidate occluders ranked by their size on screen
+	// and which draws were chosen as occluders
+	OcclusionCuller m_occlusionCuller;
+	std::vector<std::pair<float, int> > m_occluderCandidates;
+	std::vector<uint8_t> m_occluderItems;
+	// level of detail each draw was last drawn at
+	std::vector<uint8_t> m_itemLods;
+	// world-space geometry of the draws that have not moved
+	StaticBatches m_staticBatches;
+	// targets of the order-independent transparency pass, true
+	// when the shader writes them, and the translucent batches
+	// and single draws that go into the pass this frame
+	TransparencyBuffer m_transparencyBuffer;
+	bool m_bUseTransparencyBuffer;
+	std::vector<INSTANCE_BATCH> m_translucentBatches;
+	std::vector<uint32_t> m_transparentDraws;
+	// number of extra translucent objects in the scene
+	int m_translucentCount;
+	// texture slots and material indices looked up by tag
+	TagTable m_textureSlots;
+	TagTable m_materialIndices;
+	// storage buffer holding the defined object materials
+	GLuint m_materialBufferID;
+	// true when the shader reads materials from the table
+	bool m_bUseMaterialTable;
 
 	// load texture images and convert to OpenGL texture data
-	bool CreateGLTexture(const char* filename, std::string tag);
+	bool CreateGLTexture(const char* filename, TagId tag);
 	// bind loaded OpenGL textures to slots in memory
 	void BindGLTextures();
 	// free the loaded OpenGL textures
 	void DestroyGLTextures();
 	// find a loaded texture by tag
-	int FindTextureID(std::string tag);
-	int FindTextureSlot(std::string tag);
+	int FindTextureID(TagId tag);
+	int FindTextureSlot(TagId tag);
+	// get the texture unit or array layer of a texture slot
+	int GetTextureUnit(int textureSlot) const;
+	int GetTextureLayer(int textureSlot) const;
 	// find a defined material by tag
-	bool FindMaterial(std::string tag, OBJECT_MATERIAL& material);
+	bool FindMaterial(TagId tag, OBJECT_MATERIAL& material);
+	int FindMaterialIndex(TagId tag);
+
+	// calculate the model matrix from transformation values
+	static glm::mat4 BuildModelMatrix(
+		glm::vec3 scaleXYZ,
+		float XrotationDegrees,
+		float YrotationDegrees,
+		float ZrotationDegrees,
+		glm::vec3 positionXYZ);
 
 	// set the transformation values 
 	// into the transform buffer
@@ -85,7 +310,7 @@ private:
 
 	// set the texture data into the shader
 	void SetShaderTexture(
-		std::string textureTag);
+		TagId textureTag);
 
 	// set the UV scale for the texture mapping
 	void SetTextureUVScale(
@@ -93,10 +318,91 @@ private:
 
 	// set the object material into the shader
 	void SetShaderMaterial(
-		std::string materialTag);
+		TagId materialTag);
+
+	// resolve the uniform handles used while rendering
+	void ResolveUniformHandles();
+
+	// set a resolved texture slot or material into the shader
+	void ApplyTextureSlot(int textureSlot);
+	void ApplyTextureUnit(int textureUnit);
+	void ApplyMaterialIndex(int materialIndex);
+
+	// load the basic shapes used for instanced drawing
+	void LoadInstancedMeshes();
+	// count the triangles each basic shape mesh draws
+	void CountBasicMeshTriangles();
+	// read the triangle counts whose queries have finished
+	void ReadBasicMeshTriangles();
+	// add an object to the retained draw list
+	int AddSceneObject(const SCENE_OBJECT& object);
+	// build the retained draw list for the scene objects
+	void BuildDrawList();
+	// rebuild the model matrices of objects that were moved
+	void UpdateTransforms();
+	// move the bounds of a draw to its current world matrix
+	void UpdateObjectBounds(int itemIndex);
+	// find the draws that are inside the view frustum
+	void CullObjects();
+	// hide the visible draws that are behind the occluders
+	void OccludeObjects();
+	// pick the draws that are drawn into the depth pyramid
+	void SelectOccluders();
+	// pick the level of detail of every visible draw
+	void SelectLevelsOfDetail();
+	// get the height of a sphere on screen, as a fraction of
+	// half the viewport height
+	float GetScreenSize(const glm::vec3& center, float radius) const;
+	// bake the opaque draws into static batches
+	void BuildStaticBatches();
+	// check whether static batches draw the batched draws
+	bool UseStaticBatches() const;
+	// draw the static batches
+	void DrawStaticBatches();
+	// check whether translucent draws go into the
+	// order-independent transparency pass this frame
+	bool UseTransparencyPass() const;
+	// draw the translucent batches and draws into the
+	// transparency targets and composite them
+	void DrawTransparencyPass();
+	// add the grid of extra translucent objects to the scene
+	void AddTranslucentObjects();
+	// run a job over a range of draws, split across the job
+	// system when there is one
+	void RunRange(int count, int grainSize, const JobSystem::RANGE_JOB& job);
+	// cull the draws and record their draw commands into the
+	// render queue and instance batches, without GL calls
+	void RecordScene();
+	// make the GL calls for the draw commands recorded this
+	// frame
+	void SubmitScene();
+	// build the instance data and batches of the sorted queue
+	void RecordInstances();
+	// build the bounding volume hierarchy over the draws
+	void BuildHierarchy();
+	// move the hierarchy boxes of the draws that moved
+	void UpdateHierarchy();
+	// fill the render queue with the sort keys of the draws
+	void BuildRenderQueue();
+	// send the state of a retained draw command and draw it
+	void DrawItem(uint32_t itemIndex);
+	// draw one of the basic shape meshes
+	void DrawMesh(MESH_TYPE mesh);
+	// draw the recorded instance batches and single draws
+	void DrawQueueInstanced();
+	// draw every instance batch with indirect draw calls
+	void DrawBatchesIndirect();
+	// set the texture and material uniforms shared by a batch
+	void ApplyBatchState(int textureUnit, int materialIndex);
 
 	// define object materials for the scene
 	void DefineObjectMaterials();
+	// add a material to the scene and register its tag
+	void AddObjectMaterial(const OBJECT_MATERIAL& material);
+	// upload the defined materials into the GPU material table
+	void CreateMaterialTable();
+	// free the GPU material table
+	void DestroyMaterialTable();
 	// set up the lighting for the scene
 	void SetupSceneLights();
 
@@ -107,4 +413,30 @@ public:
 	void PrepareScene();
 	void RenderScene();
 
-};
\ No newline at end of file
+	// set how many copies of the desk setup are placed in
+	// the scene - must be called before PrepareScene
+	void SetDeskCount(int deskCount);
+	// set how many extra translucent objects are placed above
+	// the first desk - must be called before PrepareScene
+	void SetTranslucentCount(int translucentCount);
+
+	// write the per-draw data into a ring buffer
+	void SetRingBuffer(PersistentRingBuffer* pRingBuffer);
+	// split the per-object work of a frame across the
+	// threads of a job system
+	void SetJobSystem(JobSystem* pJobSystem);
+
+	// set the camera view used for ordering the draws
+	void SetViewMatrix(const glm::mat4& view);
+	// set the camera projection used for culling the draws
+	void SetProjectionMatrix(const glm::mat4& projection);
+
+	// get the transform of a scene object for moving it
+	Transform* GetObjectTransform(int objectIndex);
+
+	// find the scene object whose bounds a ray hits first -
+	// returns -1 when nothing is hit before the distance,
+	// which is replaced with the distance to the hit
+	int PickObject(const glm::vec3& origin, const glm::vec3& direction, float& distance) const;
+
+};
\ No newline at end of file
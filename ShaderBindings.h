@@ -0,0 +1,62 @@
+///////////////////////////////////////////////////////////////////////////////
+// shaderbindings.h
+// ============
+// fixed binding points shared between the application and the GLSL shaders
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// uniform buffer binding points - these must match the
+// layout(binding = N) qualifiers declared in the shaders
+namespace UniformBinding
+{
+	// per-frame camera and timing data - see FrameDataBuffer
+	const unsigned int FRAME_DATA = 0;
+}
+
+// shader storage buffer binding points - these must match the
+// layout(binding = N) qualifiers declared in the shaders
+namespace StorageBinding
+{
+	// runtime sized list of point lights - see LightManager
+	const unsigned int LIGHT_DATA = 0;
+	// table of object materials - see SceneManager
+	const unsigned int MATERIAL_DATA = 1;
+	// lists of the point lights reaching each object - see
+	// LightManager
+	const unsigned int LIGHT_LIST_DATA = 2;
+}
+
+// vertex attribute locations - these must match the
+// layout(location = N) qualifiers declared in the shaders
+namespace VertexAttribute
+{
+	// per-vertex mesh data - see ShapeGeometry
+	const unsigned int POSITION = 0;
+	const unsigned int NORMAL = 1;
+	const unsigned int TEXTURE_COORDINATE = 2;
+	// per-instance draw data - see InstancedMeshes, the model
+	// matrix takes the four locations 3 to 6
+	const unsigned int INSTANCE_MODEL = 3;
+	const unsigned int INSTANCE_COLOR = 7;
+	const unsigned int INSTANCE_UV_SCALE = 8;
+	const unsigned int INSTANCE_MATERIAL_INDEX = 9;
+	const unsigned int INSTANCE_TEXTURE_LAYER = 10;
+	const unsigned int INSTANCE_OBJECT_INDEX = 11;
+}
+
+// texture units kept for the textures of the application
+// itself - the scene textures only take the units below
+// FIRST_RESERVED, so nothing binds over these
+namespace TextureUnit
+{
+	// targets read by the transparency composite - see
+	// TransparencyBuffer
+	const int TRANSPARENCY_ACCUMULATION = 30;
+	const int TRANSPARENCY_REVEALAGE = 31;
+	// textures are bound here while their levels stream in -
+	// see TextureLoader
+	const int TEXTURE_UPLOAD = 29;
+	// lowest of the units above
+	const int FIRST_RESERVED = 29;
+}
@@ -0,0 +1,256 @@
+///////////////////////////////////////////////////////////////////////////////
+// shaderuniforms.cpp
+// ============
+// resolve shader uniform locations once and set values through cached handles
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ShaderUniforms.h"
+#include "FrameStats.h"
+#include "RenderSettings.h"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <iostream>
+#include <cstring>
+
+/***********************************************************
+ *  ShaderUniforms()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ShaderUniforms::ShaderUniforms()
+{
+	m_programID = 0;
+}
+
+/***********************************************************
+ *  ~ShaderUniforms()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ShaderUniforms::~ShaderUniforms()
+{
+	m_programID = 0;
+}
+
+/***********************************************************
+ *  AttachProgram()
+ *
+ *  This method is used for attaching to the shader program
+ *  that is currently in use.  It must be called after the
+ *  shaders have been loaded and activated.
+ ***********************************************************/
+bool ShaderUniforms::AttachProgram()
+{
+	GLint currentProgram = 0;
+
+	glGetIntegerv(GL_CURRENT_PROGRAM, &currentProgram);
+	if (currentProgram == 0)
+	{
+		std::cout << "No active shader program to resolve uniforms from" << std::endl;
+		return(false);
+	}
+
+	m_programID = (GLuint)currentProgram;
+	m_shadowValues.clear();
+	return(true);
+}
+
+/***********************************************************
+ *  GetProgramID()
+ *
+ *  This method is used for getting the ID of the attached
+ *  shader program.
+ ***********************************************************/
+GLuint ShaderUniforms::GetProgramID() const
+{
+	return(m_programID);
+}
+
+/***********************************************************
+ *  Resolve()
+ *
+ *  This method is used for looking up the location of the
+ *  named uniform in the attached shader program.  Uniforms
+ *  that are not active in the shader resolve to -1 and any
+ *  values set through them are ignored.
+ ***********************************************************/
+ShaderUniforms::UNIFORM_HANDLE ShaderUniforms::Resolve(const char* uniformName)
+{
+	UNIFORM_HANDLE handle;
+
+	handle.location = glGetUniformLocation(m_programID, uniformName);
+	handle.slot = -1;
+	FrameStats::Current().uniformNameLookups++;
+
+	if (handle.location >= 0)
+	{
+		// handles resolved for the same uniform share one
+		// remembered value
+		for (size_t i = 0; i < m_shadowValues.size(); i++)
+		{
+			if (m_shadowValues[i].location == handle.location)
+			{
+				handle.slot = (int)i;
+				return(handle);
+			}
+		}
+
+		SHADOW_VALUE shadowValue;
+		shadowValue.location = handle.location;
+		shadowValue.bValid = false;
+		m_shadowValues.push_back(shadowValue);
+		handle.slot = (int)m_shadowValues.size() - 1;
+	}
+
+	return(handle);
+}
+
+/***********************************************************
+ *  UpdateShadowValue()
+ *
+ *  This method is used for comparing a uniform value with
+ *  the last value sent through the same handle.  Repeated
+ *  values are counted and dropped while filtering is on.
+ *  The remembered value is kept up to date either way, so
+ *  filtering can be switched on again at any time.
+ ***********************************************************/
+bool ShaderUniforms::UpdateShadowValue(UNIFORM_HANDLE handle, const void* pValue, size_t valueSize)
+{
+	if (handle.location < 0)
+	{
+		return(false);
+	}
+
+	if ((handle.slot < 0) || (handle.slot >= (int)m_shadowValues.size()))
+	{
+		FrameStats::Current().uniformUploads++;
+		return(true);
+	}
+
+	SHADOW_VALUE& shadowValue = m_shadowValues[handle.slot];
+	if (shadowValue.bValid && RenderSettings::Get().bFilterRedundantState &&
+		(memcmp(shadowValue.data, pValue, valueSize) == 0))
+	{
+		FrameStats::Current().uniformsSuppressed++;
+		return(false);
+	}
+
+	memcpy(shadowValue.data, pValue, valueSize);
+	shadowValue.bValid = true;
+	FrameStats::Current().uniformUploads++;
+
+	return(true);
+}
+
+/***********************************************************
+ *  InvalidateShadowValues()
+ *
+ *  This method is used for forgetting the remembered values
+ *  so the next write through every handle is sent.
+ ***********************************************************/
+void ShaderUniforms::InvalidateShadowValues()
+{
+	for (size_t i = 0; i < m_shadowValues.size(); i++)
+	{
+		m_shadowValues[i].bValid = false;
+	}
+}
+
+/***********************************************************
+ *  setBoolValue()
+ *
+ *  This method is used for setting a bool uniform value.
+ ***********************************************************/
+void ShaderUniforms::setBoolValue(UNIFORM_HANDLE handle, bool value)
+{
+	setIntValue(handle, (int)value);
+}
+
+/***********************************************************
+ *  setIntValue()
+ *
+ *  This method is used for setting an int uniform value.
+ ***********************************************************/
+void ShaderUniforms::setIntValue(UNIFORM_HANDLE handle, int value)
+{
+	if (UpdateShadowValue(handle, &value, sizeof(value)))
+	{
+		glUniform1i(handle.location, value);
+	}
+}
+
+/***********************************************************
+ *  setFloatValue()
+ *
+ *  This method is used for setting a float uniform value.
+ ***********************************************************/
+void ShaderUniforms::setFloatValue(UNIFORM_HANDLE handle, float value)
+{
+	if (UpdateShadowValue(handle, &value, sizeof(value)))
+	{
+		glUniform1f(handle.location, value);
+	}
+}
+
+/***********************************************************
+ *  setSampler2DValue()
+ *
+ *  This method is used for setting a texture sampler slot.
+ ***********************************************************/
+void ShaderUniforms::setSampler2DValue(UNIFORM_HANDLE handle, int value)
+{
+	setIntValue(handle, value);
+}
+
+/***********************************************************
+ *  setVec2Value()
+ *
+ *  This method is used for setting a vec2 uniform value.
+ ***********************************************************/
+void ShaderUniforms::setVec2Value(UNIFORM_HANDLE handle, const glm::vec2& value)
+{
+	if (UpdateShadowValue(handle, &value, sizeof(value)))
+	{
+		glUniform2fv(handle.location, 1, glm::value_ptr(value));
+	}
+}
+
+/***********************************************************
+ *  setVec3Value()
+ *
+ *  This method is used for setting a vec3 uniform value.
+ ***********************************************************/
+void ShaderUniforms::setVec3Value(UNIFORM_HANDLE handle, const glm::vec3& value)
+{
+	if (UpdateShadowValue(handle, &value, sizeof(value)))
+	{
+		glUniform3fv(handle.location, 1, glm::value_ptr(value));
+	}
+}
+
+/***********************************************************
+ *  setVec4Value()
+ *
+ *  This method is used for setting a vec4 uniform value.
+ ***********************************************************/
+void ShaderUniforms::setVec4Value(UNIFORM_HANDLE handle, const glm::vec4& value)
+{
+	if (UpdateShadowValue(handle, &value, sizeof(value)))
+	{
+		glUniform4fv(handle.location, 1, glm::value_ptr(value));
+	}
+}
+
+/***********************************************************
+ *  setMat4Value()
+ *
+ *  This method is used for setting a mat4 uniform value.
+ ***********************************************************/
+void ShaderUniforms::setMat4Value(UNIFORM_HANDLE handle, const glm::mat4& value)
+{
+	if (UpdateShadowValue(handle, &value, sizeof(value)))
+	{
+		glUniformMatrix4fv(handle.location, 1, GL_FALSE, glm::value_ptr(value));
+	}
+}
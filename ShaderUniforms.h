@@ -0,0 +1,81 @@
+///////////////////////////////////////////////////////////////////////////////
+// shaderuniforms.h
+// ============
+// resolve shader uniform locations once and set values through cached handles
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  ShaderUniforms
+ *
+ *  This class resolves the uniform locations of the active
+ *  shader program one time, after the shaders are loaded,
+ *  and hands out typed handles.  Setting a value through a
+ *  handle is a plain glUniform* call with no name lookup.
+ *
+ *  The last value sent through each handle is remembered,
+ *  and writes that repeat it are dropped when redundant
+ *  state filtering is switched on in RenderSettings.
+ ***********************************************************/
+class ShaderUniforms
+{
+public:
+	// constructor
+	ShaderUniforms();
+	// destructor
+	~ShaderUniforms();
+
+	struct UNIFORM_HANDLE
+	{
+		GLint location;
+		// index of the remembered value for this uniform
+		int slot;
+	};
+
+	// attach to the shader program that is currently in use
+	bool AttachProgram();
+	// get the ID of the attached shader program
+	GLuint GetProgramID() const;
+
+	// resolve the location of a named uniform - this performs
+	// a name lookup and should only be called at setup time
+	UNIFORM_HANDLE Resolve(const char* uniformName);
+
+	// set uniform values through previously resolved handles
+	void setBoolValue(UNIFORM_HANDLE handle, bool value);
+	void setIntValue(UNIFORM_HANDLE handle, int value);
+	void setFloatValue(UNIFORM_HANDLE handle, float value);
+	void setSampler2DValue(UNIFORM_HANDLE handle, int value);
+	void setVec2Value(UNIFORM_HANDLE handle, const glm::vec2& value);
+	void setVec3Value(UNIFORM_HANDLE handle, const glm::vec3& value);
+	void setVec4Value(UNIFORM_HANDLE handle, const glm::vec4& value);
+	void setMat4Value(UNIFORM_HANDLE handle, const glm::mat4& value);
+
+	// forget the remembered uniform values, for example after
+	// the values were changed outside of this class
+	void InvalidateShadowValues();
+
+private:
+	// last value sent to the shader for one uniform
+	struct SHADOW_VALUE
+	{
+		GLint location;
+		bool bValid;
+		unsigned char data[sizeof(glm::mat4)];
+	};
+
+	// ID of the attached shader program
+	GLuint m_programID;
+	// remembered values of the resolved uniforms
+	std::vector<SHADOW_VALUE> m_shadowValues;
+
+	// check a value against the remembered one - returns true
+	// when the value needs to be sent to the shader
+	bool UpdateShadowValue(UNIFORM_HANDLE handle, const void* pValue, size_t valueSize);
+};
@@ -0,0 +1,328 @@
+///////////////////////////////////////////////////////////////////////////////
+// shapegeometry.cpp
+// ============
+// generate the vertex and index data of the basic shape meshes
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ShapeGeometry.h"
+
+#include <cmath>
+
+// declaration of global variables
+namespace
+{
+	const float PI = 3.14159265358979f;
+	// radius of the tube of the torus
+	const float TORUS_TUBE_RADIUS = 0.2f;
+	// top radius of the tapered cylinder
+	const float TAPERED_TOP_RADIUS = 0.5f;
+
+	/***********************************************************
+	 *  MakeVertex()
+	 *
+	 *  This function is used for filling in one vertex.
+	 ***********************************************************/
+	ShapeGeometry::VERTEX MakeVertex(const glm::vec3& position, const glm::vec3& normal, float u, float v)
+	{
+		ShapeGeometry::VERTEX vertex;
+		vertex.position = position;
+		vertex.normal = normal;
+		vertex.textureCoordinate = glm::vec2(u, v);
+		return(vertex);
+	}
+}
+
+/***********************************************************
+ *  AddQuad()
+ *
+ *  This method is used for adding a quad made of two
+ *  triangles.  The corners are center -u -v, +u -v, +u +v
+ *  and -u +v, so u cross v must point along the normal.
+ ***********************************************************/
+void ShapeGeometry::AddQuad(MESH_DATA& mesh, const glm::vec3& center, const glm::vec3& uAxis, const glm::vec3& vAxis, const glm::vec3& normal)
+{
+	uint32_t first = (uint32_t)mesh.vertices.size();
+
+	mesh.vertices.push_back(MakeVertex(center - uAxis - vAxis, normal, 0.0f, 0.0f));
+	mesh.vertices.push_back(MakeVertex(center + uAxis - vAxis, normal, 1.0f, 0.0f));
+	mesh.vertices.push_back(MakeVertex(center + uAxis + vAxis, normal, 1.0f, 1.0f));
+	mesh.vertices.push_back(MakeVertex(center - uAxis + vAxis, normal, 0.0f, 1.0f));
+
+	mesh.indices.push_back(first);
+	mesh.indices.push_back(first + 1);
+	mesh.indices.push_back(first + 2);
+	mesh.indices.push_back(first);
+	mesh.indices.push_back(first + 2);
+	mesh.indices.push_back(first + 3);
+}
+
+/***********************************************************
+ *  BuildBox()
+ *
+ *  This method is used for building a unit cube with its
+ *  own vertices and texture coordinates on each face.
+ ***********************************************************/
+void ShapeGeometry::BuildBox(MESH_DATA& mesh)
+{
+	mesh.vertices.clear();
+	mesh.indices.clear();
+
+	const glm::vec3 right(0.5f, 0.0f, 0.0f);
+	const glm::vec3 up(0.0f, 0.5f, 0.0f);
+	const glm::vec3 front(0.0f, 0.0f, 0.5f);
+
+	AddQuad(mesh, right, -front, up, glm::vec3(1.0f, 0.0f, 0.0f));
+	AddQuad(mesh, -right, front, up, glm::vec3(-1.0f, 0.0f, 0.0f));
+	AddQuad(mesh, up, right, -front, glm::vec3(0.0f, 1.0f, 0.0f));
+	AddQuad(mesh, -up, right, front, glm::vec3(0.0f, -1.0f, 0.0f));
+	AddQuad(mesh, front, right, up, glm::vec3(0.0f, 0.0f, 1.0f));
+	AddQuad(mesh, -front, -right, up, glm::vec3(0.0f, 0.0f, -1.0f));
+}
+
+/***********************************************************
+ *  BuildPlane()
+ *
+ *  This method is used for building a flat square in the
+ *  XZ plane that faces up.
+ ***********************************************************/
+void ShapeGeometry::BuildPlane(MESH_DATA& mesh)
+{
+	mesh.vertices.clear();
+	mesh.indices.clear();
+
+	AddQuad(mesh, glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f),
+		glm::vec3(0.0f, 1.0f, 0.0f));
+}
+
+/***********************************************************
+ *  AddCap()
+ *
+ *  This method is used for adding a flat disc at a height,
+ *  as a fan of triangles around a center vertex.
+ ***********************************************************/
+void ShapeGeometry::AddCap(MESH_DATA& mesh, float radius, float height, int slices, bool bFacingUp)
+{
+	uint32_t center = (uint32_t)mesh.vertices.size();
+	glm::vec3 normal(0.0f, bFacingUp ? 1.0f : -1.0f, 0.0f);
+
+	mesh.vertices.push_back(MakeVertex(glm::vec3(0.0f, height, 0.0f), normal, 0.5f, 0.5f));
+	for (int slice = 0; slice <= slices; slice++)
+	{
+		float angle = 2.0f * PI * (float)slice / (float)slices;
+		float cosine = std::cos(angle);
+		float sine = std::sin(angle);
+		mesh.vertices.push_back(MakeVertex(glm::vec3(radius * cosine, height, radius * sine), normal,
+			0.5f + 0.5f * cosine, 0.5f + 0.5f * sine));
+	}
+
+	for (int slice = 0; slice < slices; slice++)
+	{
+		uint32_t ring = center + 1 + (uint32_t)slice;
+		mesh.indices.push_back(center);
+		mesh.indices.push_back(bFacingUp ? ring + 1 : ring);
+		mesh.indices.push_back(bFacingUp ? ring : ring + 1);
+	}
+}
+
+/***********************************************************
+ *  BuildFrustum()
+ *
+ *  This method is used for building a cylinder from Y 0 to
+ *  Y 1 whose radius goes from the bottom to the top radius.
+ *  A top radius of zero makes a cone without a top cap.
+ ***********************************************************/
+void ShapeGeometry::BuildFrustum(MESH_DATA& mesh, float bottomRadius, float topRadius, int slices)
+{
+	mesh.vertices.clear();
+	mesh.indices.clear();
+
+	if (slices < 3)
+	{
+		slices = 3;
+	}
+
+	// the side normals lean up by the slope of the side
+	float slope = bottomRadius - topRadius;
+
+	for (int slice = 0; slice <= slices; slice++)
+	{
+		float angle = 2.0f * PI * (float)slice / (float)slices;
+		float cosine = std::cos(angle);
+		float sine = std::sin(angle);
+		float u = (float)slice / (float)slices;
+		glm::vec3 normal = glm::normalize(glm::vec3(cosine, slope, sine));
+
+		mesh.vertices.push_back(MakeVertex(glm::vec3(bottomRadius * cosine, 0.0f, bottomRadius * sine), normal, u, 0.0f));
+		mesh.vertices.push_back(MakeVertex(glm::vec3(topRadius * cosine, 1.0f, topRadius * sine), normal, u, 1.0f));
+	}
+
+	for (int slice = 0; slice < slices; slice++)
+	{
+		uint32_t bottom = (uint32_t)slice * 2;
+		uint32_t top = bottom + 1;
+
+		mesh.indices.push_back(bottom);
+		mesh.indices.push_back(top);
+		mesh.indices.push_back(bottom + 2);
+
+		// the second triangle has no area when the top is a point
+		if (topRadius > 0.0f)
+		{
+			mesh.indices.push_back(bottom + 2);
+			mesh.indices.push_back(top);
+			mesh.indices.push_back(top + 2);
+		}
+	}
+
+	AddCap(mesh, bottomRadius, 0.0f, slices, false);
+	if (topRadius > 0.0f)
+	{
+		AddCap(mesh, topRadius, 1.0f, slices, true);
+	}
+}
+
+/***********************************************************
+ *  BuildCylinder()
+ *
+ *  This method is used for building a closed cylinder.
+ ***********************************************************/
+void ShapeGeometry::BuildCylinder(MESH_DATA& mesh, int slices)
+{
+	BuildFrustum(mesh, 1.0f, 1.0f, slices);
+}
+
+/***********************************************************
+ *  BuildCone()
+ *
+ *  This method is used for building a cone with a closed
+ *  base.
+ ***********************************************************/
+void ShapeGeometry::BuildCone(MESH_DATA& mesh, int slices)
+{
+	BuildFrustum(mesh, 1.0f, 0.0f, slices);
+}
+
+/***********************************************************
+ *  BuildTaperedCylinder()
+ *
+ *  This method is used for building a closed cylinder that
+ *  narrows toward the top.
+ ***********************************************************/
+void ShapeGeometry::BuildTaperedCylinder(MESH_DATA& mesh, int slices)
+{
+	BuildFrustum(mesh, 1.0f, TAPERED_TOP_RADIUS, slices);
+}
+
+/***********************************************************
+ *  BuildSphere()
+ *
+ *  This method is used for building a sphere from rings of
+ *  latitude, from the top pole down to the bottom pole.
+ ***********************************************************/
+void ShapeGeometry::BuildSphere(MESH_DATA& mesh, int slices, int stacks)
+{
+	mesh.vertices.clear();
+	mesh.indices.clear();
+
+	if (slices < 3)
+	{
+		slices = 3;
+	}
+	if (stacks < 2)
+	{
+		stacks = 2;
+	}
+
+	for (int stack = 0; stack <= stacks; stack++)
+	{
+		float latitude = PI * (float)stack / (float)stacks;
+		for (int slice = 0; slice <= slices; slice++)
+		{
+			float longitude = 2.0f * PI * (float)slice / (float)slices;
+			glm::vec3 normal(
+				std::sin(latitude) * std::cos(longitude),
+				std::cos(latitude),
+				std::sin(latitude) * std::sin(longitude));
+			mesh.vertices.push_back(MakeVertex(normal, normal,
+				(float)slice / (float)slices, 1.0f - (float)stack / (float)stacks));
+		}
+	}
+
+	uint32_t ringSize = (uint32_t)slices + 1;
+	for (int stack = 0; stack < stacks; stack++)
+	{
+		for (int slice = 0; slice < slices; slice++)
+		{
+			uint32_t upper = (uint32_t)stack * ringSize + (uint32_t)slice;
+			uint32_t lower = upper + ringSize;
+
+			// skip the triangles that collapse into the poles
+			if (stack > 0)
+			{
+				mesh.indices.push_back(upper);
+				mesh.indices.push_back(upper + 1);
+				mesh.indices.push_back(lower);
+			}
+			if (stack < (stacks - 1))
+			{
+				mesh.indices.push_back(upper + 1);
+				mesh.indices.push_back(lower + 1);
+				mesh.indices.push_back(lower);
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  BuildTorus()
+ *
+ *  This method is used for building a torus whose ring lies
+ *  in the XY plane around the Z axis.
+ ***********************************************************/
+void ShapeGeometry::BuildTorus(MESH_DATA& mesh, int slices, int tubeSlices)
+{
+	mesh.vertices.clear();
+	mesh.indices.clear();
+
+	if (slices < 3)
+	{
+		slices = 3;
+	}
+	if (tubeSlices < 3)
+	{
+		tubeSlices = 3;
+	}
+
+	for (int slice = 0; slice <= slices; slice++)
+	{
+		float ringAngle = 2.0f * PI * (float)slice / (float)slices;
+		for (int tubeSlice = 0; tubeSlice <= tubeSlices; tubeSlice++)
+		{
+			float tubeAngle = 2.0f * PI * (float)tubeSlice / (float)tubeSlices;
+			glm::vec3 normal(
+				std::cos(tubeAngle) * std::cos(ringAngle),
+				std::cos(tubeAngle) * std::sin(ringAngle),
+				std::sin(tubeAngle));
+			glm::vec3 center(std::cos(ringAngle), std::sin(ringAngle), 0.0f);
+			mesh.vertices.push_back(MakeVertex(center + normal * TORUS_TUBE_RADIUS, normal,
+				(float)slice / (float)slices, (float)tubeSlice / (float)tubeSlices));
+		}
+	}
+
+	uint32_t ringSize = (uint32_t)tubeSlices + 1;
+	for (int slice = 0; slice < slices; slice++)
+	{
+		for (int tubeSlice = 0; tubeSlice < tubeSlices; tubeSlice++)
+		{
+			uint32_t current = (uint32_t)slice * ringSize + (uint32_t)tubeSlice;
+			uint32_t next = current + ringSize;
+
+			mesh.indices.push_back(current);
+			mesh.indices.push_back(next);
+			mesh.indices.push_back(current + 1);
+			mesh.indices.push_back(current + 1);
+			mesh.indices.push_back(next);
+			mesh.indices.push_back(next + 1);
+		}
+	}
+}
@@ -0,0 +1,71 @@
+///////////////////////////////////////////////////////////////////////////////
+// shapegeometry.h
+// ============
+// generate the vertex and index data of the basic shape meshes
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <stdint.h>
+#include <vector>
+
+/***********************************************************
+ *  ShapeGeometry
+ *
+ *  This class builds the same basic shapes as ShapeMeshes
+ *  on the CPU, so the application owns the vertex data and
+ *  can store it in its own buffers.  The shapes follow the
+ *  ShapeMeshes conventions:
+ *
+ *    box               unit cube centered on the origin
+ *    plane             -1 to 1 in X and Z, facing +Y
+ *    cylinder          radius 1, from Y 0 to Y 1
+ *    cone              radius 1 at Y 0, tip at Y 1
+ *    tapered cylinder  radius 1 at Y 0, radius 0.5 at Y 1
+ *    sphere            radius 1 centered on the origin
+ *    torus             ring of radius 1 around the Z axis
+ *
+ *  Front faces are counter-clockwise and every vertex has a
+ *  position, normal and texture coordinate.
+ ***********************************************************/
+class ShapeGeometry
+{
+public:
+	// interleaved vertex format - attribute locations 0, 1 and 2
+	struct VERTEX
+	{
+		glm::vec3 position;
+		glm::vec3 normal;
+		glm::vec2 textureCoordinate;
+	};
+
+	struct MESH_DATA
+	{
+		std::vector<VERTEX> vertices;
+		std::vector<uint32_t> indices;
+	};
+
+	// default number of segments around curved shapes
+	static const int DEFAULT_SLICES = 36;
+	static const int DEFAULT_STACKS = 18;
+
+	// build the shapes - any existing data in the mesh is replaced
+	static void BuildBox(MESH_DATA& mesh);
+	static void BuildPlane(MESH_DATA& mesh);
+	static void BuildCylinder(MESH_DATA& mesh, int slices = DEFAULT_SLICES);
+	static void BuildCone(MESH_DATA& mesh, int slices = DEFAULT_SLICES);
+	static void BuildTaperedCylinder(MESH_DATA& mesh, int slices = DEFAULT_SLICES);
+	static void BuildSphere(MESH_DATA& mesh, int slices = DEFAULT_SLICES, int stacks = DEFAULT_STACKS);
+	static void BuildTorus(MESH_DATA& mesh, int slices = DEFAULT_SLICES, int tubeSlices = DEFAULT_STACKS);
+
+private:
+	// build the side and caps of a cylinder with possibly
+	// different bottom and top radii
+	static void BuildFrustum(MESH_DATA& mesh, float bottomRadius, float topRadius, int slices);
+	// add a flat disc facing up or down
+	static void AddCap(MESH_DATA& mesh, float radius, float height, int slices, bool bFacingUp);
+	// add a quad with its corners in counter-clockwise order
+	static void AddQuad(MESH_DATA& mesh, const glm::vec3& center, const glm::vec3& uAxis, const glm::vec3& vAxis, const glm::vec3& normal);
+};
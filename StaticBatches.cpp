@@ -0,0 +1,390 @@
+///////////////////////////////////////////////////////////////////////////////
+// staticbatches.cpp
+// ============
+// merge the geometry of objects that do not move into world-space batches
+///////////////////////////////////////////////////////////////////////////////
+
+#include "StaticBatches.h"
+#include "ShaderBindings.h"
+#include "FrameStats.h"
+
+#include <cstddef>
+#include <iostream>
+
+// the attribute offsets below rely on this exact layout
+static_assert(sizeof(StaticBatches::VERTEX) == 68, "VERTEX must match the static batch attribute layout");
+
+/***********************************************************
+ *  StaticBatches()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+StaticBatches::StaticBatches()
+{
+}
+
+/***********************************************************
+ *  ~StaticBatches()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+StaticBatches::~StaticBatches()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  AddObject()
+ *
+ *  This method is used for adding an object to the batch
+ *  that shares its texture unit and material, starting a new
+ *  batch when there is none yet.  The object is baked when
+ *  Build() is called.
+ ***********************************************************/
+int StaticBatches::AddObject(const STATIC_OBJECT& object, int textureUnit, int materialIndex)
+{
+	int batchIndex = -1;
+
+	for (size_t i = 0; i < m_batches.size(); i++)
+	{
+		if ((m_batches[i].textureUnit == textureUnit) &&
+			(m_batches[i].materialIndex == materialIndex) &&
+			(0 == m_batches[i].vao))
+		{
+			batchIndex = (int)i;
+			break;
+		}
+	}
+
+	if (batchIndex < 0)
+	{
+		BATCH batch;
+		batch.textureUnit = textureUnit;
+		batch.materialIndex = materialIndex;
+		batch.vao = 0;
+		batch.vbo = 0;
+		batch.ibo = 0;
+		m_batches.push_back(batch);
+		batchIndex = (int)m_batches.size() - 1;
+	}
+
+	MEMBER member;
+	member.object = object;
+	member.bRemoved = false;
+	m_batches[batchIndex].members.push_back(member);
+
+	if (object.objectIndex >= (int)m_objectBatch.size())
+	{
+		m_objectBatch.resize(object.objectIndex + 1, -1);
+		m_objectMember.resize(object.objectIndex + 1, -1);
+	}
+	m_objectBatch[object.objectIndex] = batchIndex;
+	m_objectMember[object.objectIndex] = (int)m_batches[batchIndex].members.size() - 1;
+
+	return(batchIndex);
+}
+
+/***********************************************************
+ *  Build()
+ *
+ *  This method is used for baking and uploading every batch
+ *  that objects were added to since the last build.
+ ***********************************************************/
+void StaticBatches::Build()
+{
+	int objectCount = 0;
+
+	for (size_t i = 0; i < m_batches.size(); i++)
+	{
+		if (0 == m_batches[i].vao)
+		{
+			BuildBatch(m_batches[i]);
+		}
+		objectCount += (int)m_batches[i].members.size();
+	}
+
+	std::cout << "INFO: baked " << objectCount << " static objects into " << m_batches.size() << " batches" << std::endl;
+}
+
+/***********************************************************
+ *  BuildBatch()
+ *
+ *  This method is used for moving the mesh of every member
+ *  of a batch into world space at every level of detail and
+ *  uploading the result.  All members of one level are
+ *  stored before the next level, so members that are drawn
+ *  at the same level are next to each other in the index
+ *  buffer and merge into one range.
+ ***********************************************************/
+void StaticBatches::BuildBatch(BATCH& batch)
+{
+	std::vector<VERTEX> vertices;
+	std::vector<uint32_t> indices;
+	ShapeGeometry::MESH_DATA mesh;
+
+	for (int lod = 0; lod < InstancedMeshes::LOD_COUNT; lod++)
+	{
+		for (size_t i = 0; i < batch.members.size(); i++)
+		{
+			MEMBER& member = batch.members[i];
+			const STATIC_OBJECT& object = member.object;
+
+			if (false == InstancedMeshes::BuildShapeGeometry(object.shape, lod, mesh))
+			{
+				// the level draws the mesh of the level before
+				if (lod > 0)
+				{
+					member.ranges[lod] = member.ranges[lod - 1];
+				}
+				else
+				{
+					member.ranges[lod].firstIndex = 0;
+					member.ranges[lod].indexCount = 0;
+				}
+				continue;
+			}
+
+			// normals move with the inverse transpose, so they
+			// stay perpendicular under non-uniform scaling
+			glm::mat4 normalMatrix = glm::transpose(glm::inverse(object.world));
+			uint32_t baseVertex = (uint32_t)vertices.size();
+
+			for (size_t v = 0; v < mesh.vertices.size(); v++)
+			{
+				const ShapeGeometry::VERTEX& source = mesh.vertices[v];
+				VERTEX vertex;
+
+				vertex.position = glm::vec3(object.world * glm::vec4(source.position, 1.0f));
+				vertex.normal = glm::normalize(glm::vec3(normalMatrix * glm::vec4(source.normal, 0.0f)));
+				vertex.textureCoordinate = source.textureCoordinate;
+				vertex.color = object.color;
+				vertex.UVscale = object.UVscale;
+				vertex.materialIndex = object.materialIndex;
+				vertex.textureLayer = object.textureLayer;
+				vertex.objectIndex = object.objectIndex;
+				vertices.push_back(vertex);
+			}
+
+			member.ranges[lod].firstIndex = (uint32_t)indices.size();
+			member.ranges[lod].indexCount = (uint32_t)mesh.indices.size();
+			for (size_t n = 0; n < mesh.indices.size(); n++)
+			{
+				indices.push_back(baseVertex + mesh.indices[n]);
+			}
+		}
+	}
+
+	if (indices.empty())
+	{
+		return;
+	}
+
+	GLsizei stride = sizeof(VERTEX);
+
+	glGenVertexArrays(1, &batch.vao);
+	glGenBuffers(1, &batch.vbo);
+	glGenBuffers(1, &batch.ibo);
+
+	glBindVertexArray(batch.vao);
+
+	glBindBuffer(GL_ARRAY_BUFFER, batch.vbo);
+	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(VERTEX), vertices.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, batch.ibo);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint32_t), indices.data(), GL_STATIC_DRAW);
+
+	glEnableVertexAttribArray(VertexAttribute::POSITION);
+	glVertexAttribPointer(VertexAttribute::POSITION, 3, GL_FLOAT, GL_FALSE, stride,
+		(const void*)offsetof(VERTEX, position));
+	glEnableVertexAttribArray(VertexAttribute::NORMAL);
+	glVertexAttribPointer(VertexAttribute::NORMAL, 3, GL_FLOAT, GL_FALSE, stride,
+		(const void*)offsetof(VERTEX, normal));
+	glEnableVertexAttribArray(VertexAttribute::TEXTURE_COORDINATE);
+	glVertexAttribPointer(VertexAttribute::TEXTURE_COORDINATE, 2, GL_FLOAT, GL_FALSE, stride,
+		(const void*)offsetof(VERTEX, textureCoordinate));
+
+	// the per-object values are read per vertex, so the
+	// instance attributes keep a divisor of 0
+	glEnableVertexAttribArray(VertexAttribute::INSTANCE_COLOR);
+	glVertexAttribPointer(VertexAttribute::INSTANCE_COLOR, 4, GL_FLOAT, GL_FALSE, stride,
+		(const void*)offsetof(VERTEX, color));
+	glEnableVertexAttribArray(VertexAttribute::INSTANCE_UV_SCALE);
+	glVertexAttribPointer(VertexAttribute::INSTANCE_UV_SCALE, 2, GL_FLOAT, GL_FALSE, stride,
+		(const void*)offsetof(VERTEX, UVscale));
+	glEnableVertexAttribArray(VertexAttribute::INSTANCE_MATERIAL_INDEX);
+	glVertexAttribIPointer(VertexAttribute::INSTANCE_MATERIAL_INDEX, 1, GL_INT, stride,
+		(const void*)offsetof(VERTEX, materialIndex));
+	glEnableVertexAttribArray(VertexAttribute::INSTANCE_TEXTURE_LAYER);
+	glVertexAttribIPointer(VertexAttribute::INSTANCE_TEXTURE_LAYER, 1, GL_INT, stride,
+		(const void*)offsetof(VERTEX, textureLayer));
+	glEnableVertexAttribArray(VertexAttribute::INSTANCE_OBJECT_INDEX);
+	glVertexAttribIPointer(VertexAttribute::INSTANCE_OBJECT_INDEX, 1, GL_INT, stride,
+		(const void*)offsetof(VERTEX, objectIndex));
+
+	// the model matrix columns are left disabled, so they
+	// read the constant values set before each draw
+	for (unsigned int column = 0; column < 4; column++)
+	{
+		glDisableVertexAttribArray(VertexAttribute::INSTANCE_MODEL + column);
+	}
+
+	glBindVertexArray(0);
+
+	FrameStats::Current().bufferUploads += 2;
+}
+
+/***********************************************************
+ *  RemoveObject()
+ *
+ *  This method is used for taking an object out of its
+ *  batch, for example once it starts to move.  The baked
+ *  geometry stays in the buffers and is skipped from now on,
+ *  so the caller has to draw the object itself.
+ ***********************************************************/
+void StaticBatches::RemoveObject(int objectIndex)
+{
+	if (false == IsBatched(objectIndex))
+	{
+		return;
+	}
+
+	m_batches[m_objectBatch[objectIndex]].members[m_objectMember[objectIndex]].bRemoved = true;
+	m_objectBatch[objectIndex] = -1;
+	m_objectMember[objectIndex] = -1;
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the buffers of every
+ *  batch and forgetting the batched objects.
+ ***********************************************************/
+void StaticBatches::Destroy()
+{
+	for (size_t i = 0; i < m_batches.size(); i++)
+	{
+		if (0 != m_batches[i].vao)
+		{
+			glDeleteVertexArrays(1, &m_batches[i].vao);
+			glDeleteBuffers(1, &m_batches[i].vbo);
+			glDeleteBuffers(1, &m_batches[i].ibo);
+		}
+	}
+
+	m_batches.clear();
+	m_objectBatch.clear();
+	m_objectMember.clear();
+}
+
+/***********************************************************
+ *  IsBatched()
+ *
+ *  This method is used for checking whether an object is
+ *  drawn as part of a batch.
+ ***********************************************************/
+bool StaticBatches::IsBatched(int objectIndex) const
+{
+	return((objectIndex >= 0) && (objectIndex < (int)m_objectBatch.size()) &&
+		(m_objectBatch[objectIndex] >= 0));
+}
+
+/***********************************************************
+ *  GetBatchCount()
+ *
+ *  This method is used for getting the number of batches.
+ ***********************************************************/
+int StaticBatches::GetBatchCount() const
+{
+	return((int)m_batches.size());
+}
+
+/***********************************************************
+ *  GetTextureUnit()
+ *
+ *  This method is used for getting the texture unit every
+ *  object of a batch is sampled from, -1 for none.
+ ***********************************************************/
+int StaticBatches::GetTextureUnit(int batchIndex) const
+{
+	return(m_batches[batchIndex].textureUnit);
+}
+
+/***********************************************************
+ *  GetMaterialIndex()
+ *
+ *  This method is used for getting the material shared by
+ *  every object of a batch, -1 when each object passes its
+ *  own material index.
+ ***********************************************************/
+int StaticBatches::GetMaterialIndex(int batchIndex) const
+{
+	return(m_batches[batchIndex].materialIndex);
+}
+
+/***********************************************************
+ *  Draw()
+ *
+ *  This method is used for drawing the visible members of a
+ *  batch with one glMultiDrawElements call, each at its
+ *  level of detail.  Ranges that follow each other in the
+ *  index buffer are merged before the call.
+ ***********************************************************/
+void StaticBatches::Draw(int batchIndex, const uint8_t* pVisible, const uint8_t* pLods)
+{
+	const BATCH& batch = m_batches[batchIndex];
+	unsigned int triangleCount = 0;
+	unsigned int fullDetailCount = 0;
+	size_t rangeEnd = 0;
+
+	if (0 == batch.vao)
+	{
+		return;
+	}
+
+	m_drawCounts.clear();
+	m_drawOffsets.clear();
+	for (size_t i = 0; i < batch.members.size(); i++)
+	{
+		const MEMBER& member = batch.members[i];
+		int objectIndex = member.object.objectIndex;
+
+		if (member.bRemoved || (0 == pVisible[objectIndex]))
+		{
+			continue;
+		}
+
+		const INDEX_RANGE& range = member.ranges[pLods[objectIndex]];
+		size_t rangeStart = (size_t)range.firstIndex * sizeof(uint32_t);
+		if ((false == m_drawCounts.empty()) && (rangeEnd == rangeStart))
+		{
+			m_drawCounts.back() += (GLsizei)range.indexCount;
+		}
+		else
+		{
+			m_drawCounts.push_back((GLsizei)range.indexCount);
+			m_drawOffsets.push_back((const void*)rangeStart);
+		}
+		rangeEnd = rangeStart + (size_t)range.indexCount * sizeof(uint32_t);
+
+		triangleCount += range.indexCount / 3;
+		fullDetailCount += member.ranges[0].indexCount / 3;
+	}
+
+	if (m_drawCounts.empty())
+	{
+		return;
+	}
+
+	glBindVertexArray(batch.vao);
+	// the vertices are already in world space
+	glVertexAttrib4f(VertexAttribute::INSTANCE_MODEL + 0, 1.0f, 0.0f, 0.0f, 0.0f);
+	glVertexAttrib4f(VertexAttribute::INSTANCE_MODEL + 1, 0.0f, 1.0f, 0.0f, 0.0f);
+	glVertexAttrib4f(VertexAttribute::INSTANCE_MODEL + 2, 0.0f, 0.0f, 1.0f, 0.0f);
+	glVertexAttrib4f(VertexAttribute::INSTANCE_MODEL + 3, 0.0f, 0.0f, 0.0f, 1.0f);
+	glMultiDrawElements(GL_TRIANGLES, m_drawCounts.data(), GL_UNSIGNED_INT, m_drawOffsets.data(),
+		(GLsizei)m_drawCounts.size());
+	glBindVertexArray(0);
+
+	FrameStats::Current().drawCalls++;
+	FrameStats::Current().trianglesDrawn += triangleCount;
+	FrameStats::Current().trianglesFullDetail += fullDetailCount;
+}
@@ -0,0 +1,133 @@
+///////////////////////////////////////////////////////////////////////////////
+// staticbatches.h
+// ============
+// merge the geometry of objects that do not move into world-space batches
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "InstancedMeshes.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <stdint.h>
+#include <vector>
+
+/***********************************************************
+ *  StaticBatches
+ *
+ *  This class bakes the meshes of objects that do not move
+ *  into world space and merges the objects that share a
+ *  texture unit and material into one vertex and index
+ *  buffer per batch, so a batch is drawn with one call no
+ *  matter how many objects it holds.  Every level of detail
+ *  of every object is baked, with the objects of a level
+ *  stored next to each other, and a draw only includes the
+ *  objects that are visible this frame at their current
+ *  level through glMultiDrawElements.  An object that starts
+ *  to move leaves its batch by being skipped from then on.
+ *
+ *  The color, UV scale, material index, texture layer and
+ *  object index of each object are stored in every one of
+ *  its vertices at the instance attribute locations, and the
+ *  instance model matrix attribute is held at the identity,
+ *  so the vertex shader reads a batch the same way as
+ *  instanced draws while bUseInstanceData is true - see
+ *  InstancedMeshes.
+ ***********************************************************/
+class StaticBatches
+{
+public:
+	// constructor
+	StaticBatches();
+	// destructor
+	~StaticBatches();
+
+	// object to bake into a batch
+	struct STATIC_OBJECT
+	{
+		// index of the object in the caller's list
+		int objectIndex;
+		InstancedMeshes::SHAPE shape;
+		glm::mat4 world;
+		glm::vec4 color;
+		glm::vec2 UVscale;
+		int32_t materialIndex;
+		// layer in the bound texture array, -1 for none
+		int32_t textureLayer;
+	};
+
+	// interleaved vertex of the baked geometry
+	struct VERTEX
+	{
+		glm::vec3 position;
+		glm::vec3 normal;
+		glm::vec2 textureCoordinate;
+		glm::vec4 color;
+		glm::vec2 UVscale;
+		int32_t materialIndex;
+		int32_t textureLayer;
+		int32_t objectIndex;
+	};
+
+	// add an object to the batch of a texture unit and batch
+	// material, which are -1 for none - returns the batch
+	int AddObject(const STATIC_OBJECT& object, int textureUnit, int materialIndex);
+	// bake the added objects and upload the batches
+	void Build();
+	// take an object out of its batch for good
+	void RemoveObject(int objectIndex);
+	// free the batches
+	void Destroy();
+
+	// check whether an object is drawn by a batch
+	bool IsBatched(int objectIndex) const;
+	// get the number of batches
+	int GetBatchCount() const;
+	// get the texture unit and material shared by a batch
+	int GetTextureUnit(int batchIndex) const;
+	int GetMaterialIndex(int batchIndex) const;
+
+	// draw the objects of a batch that are visible, each at
+	// its level of detail - both arrays are indexed by object
+	void Draw(int batchIndex, const uint8_t* pVisible, const uint8_t* pLods);
+
+private:
+	// place of one level of detail of an object in the
+	// index buffer of its batch
+	struct INDEX_RANGE
+	{
+		uint32_t firstIndex;
+		uint32_t indexCount;
+	};
+
+	// an object in a batch
+	struct MEMBER
+	{
+		STATIC_OBJECT object;
+		INDEX_RANGE ranges[InstancedMeshes::LOD_COUNT];
+		bool bRemoved;
+	};
+
+	struct BATCH
+	{
+		int textureUnit;
+		int materialIndex;
+		std::vector<MEMBER> members;
+		GLuint vao;
+		GLuint vbo;
+		GLuint ibo;
+	};
+
+	std::vector<BATCH> m_batches;
+	// batch and member of every object, -1 when not batched
+	std::vector<int> m_objectBatch;
+	std::vector<int> m_objectMember;
+	// index ranges gathered for a multi-draw call
+	std::vector<GLsizei> m_drawCounts;
+	std::vector<const void*> m_drawOffsets;
+
+	// bake the members of a batch and upload its buffers
+	void BuildBatch(BATCH& batch);
+};
@@ -0,0 +1,132 @@
+///////////////////////////////////////////////////////////////////////////////
+// tagid.cpp
+// ============
+// compile-time interned tags and a flat tag lookup table
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TagId.h"
+
+#include <cassert>
+#include <cstring>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// number of entries the table starts with
+	const size_t INITIAL_TABLE_SIZE = 16;
+}
+
+/***********************************************************
+ *  TagTable()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TagTable::TagTable()
+{
+	m_count = 0;
+	m_entries.resize(INITIAL_TABLE_SIZE);
+}
+
+/***********************************************************
+ *  Add()
+ *
+ *  This method is used for registering a tag with its value.
+ *  Registering a tag a second time replaces its value.
+ ***********************************************************/
+void TagTable::Add(TagId tag, int value)
+{
+	if (tag == TagId())
+	{
+		return;
+	}
+
+	// keep the table at most half full so probe runs stay short
+	if ((size_t)(m_count + 1) * 2 > m_entries.size())
+	{
+		Grow();
+	}
+
+	size_t mask = m_entries.size() - 1;
+	size_t index = tag.GetHash() & mask;
+	while (m_entries[index].tag != TagId())
+	{
+		if (m_entries[index].tag == tag)
+		{
+#ifndef NDEBUG
+			// equal hashes from different strings would make the
+			// two tags indistinguishable
+			if (strcmp(m_entries[index].tag.GetName(), tag.GetName()) != 0)
+			{
+				std::cout << "ERROR: tag hash collision between \"" << m_entries[index].tag.GetName()
+					<< "\" and \"" << tag.GetName() << "\"" << std::endl;
+				assert(false);
+			}
+#endif
+			m_entries[index].value = value;
+			return;
+		}
+		index = (index + 1) & mask;
+	}
+
+	m_entries[index].tag = tag;
+	m_entries[index].value = value;
+	m_count++;
+}
+
+/***********************************************************
+ *  Find()
+ *
+ *  This method is used for getting the value registered for
+ *  a tag.  -1 is returned for tags that were not registered.
+ ***********************************************************/
+int TagTable::Find(TagId tag) const
+{
+	size_t mask = m_entries.size() - 1;
+	size_t index = tag.GetHash() & mask;
+
+	while (m_entries[index].tag != TagId())
+	{
+		if (m_entries[index].tag == tag)
+		{
+			return(m_entries[index].value);
+		}
+		index = (index + 1) & mask;
+	}
+
+	return(-1);
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for removing all registered tags.
+ ***********************************************************/
+void TagTable::Clear()
+{
+	m_entries.assign(INITIAL_TABLE_SIZE, TAG_ENTRY());
+	m_count = 0;
+}
+
+/***********************************************************
+ *  Grow()
+ *
+ *  This method is used for doubling the size of the table
+ *  and inserting the registered tags into it again.
+ ***********************************************************/
+void TagTable::Grow()
+{
+	std::vector<TAG_ENTRY> oldEntries;
+	oldEntries.swap(m_entries);
+
+	m_entries.resize(oldEntries.size() * 2);
+	m_count = 0;
+
+	for (size_t i = 0; i < oldEntries.size(); i++)
+	{
+		if (oldEntries[i].tag != TagId())
+		{
+			Add(oldEntries[i].tag, oldEntries[i].value);
+		}
+	}
+}
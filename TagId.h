@@ -0,0 +1,94 @@
+///////////////////////////////////////////////////////////////////////////////
+// tagid.h
+// ============
+// compile-time interned tags and a flat tag lookup table
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+/***********************************************************
+ *  TagId
+ *
+ *  This class identifies a texture, material or other named
+ *  scene resource by the FNV-1a hash of its tag string.  The
+ *  hash is computed at compile time for tags declared as
+ *  constexpr values, so comparing and looking up tags never
+ *  copies or compares strings.
+ ***********************************************************/
+class TagId
+{
+public:
+	// the empty tag, which never matches a registered tag
+	constexpr TagId() : m_hash(0), m_name("") {}
+	// intern a tag from a string literal
+	constexpr explicit TagId(const char* name) : m_hash(Hash(name)), m_name(name) {}
+
+	// get the hash value of the tag
+	constexpr uint32_t GetHash() const { return(m_hash); }
+	// get the tag string the tag was created from
+	constexpr const char* GetName() const { return(m_name); }
+
+	constexpr bool operator==(const TagId& other) const { return(m_hash == other.m_hash); }
+	constexpr bool operator!=(const TagId& other) const { return(m_hash != other.m_hash); }
+
+private:
+	// 32-bit FNV-1a hash of a null terminated string
+	static constexpr uint32_t Hash(const char* name)
+	{
+		uint32_t hash = 2166136261u;
+		while (*name != '\0')
+		{
+			hash ^= (uint32_t)(unsigned char)(*name);
+			hash *= 16777619u;
+			name++;
+		}
+		return(hash);
+	}
+
+	uint32_t m_hash;
+	// the tag string is kept for diagnostics - it always points
+	// at the string literal the tag was created from
+	const char* m_name;
+};
+
+/***********************************************************
+ *  TagTable
+ *
+ *  This class maps tags to small integer values, such as a
+ *  texture slot or material index, with an open addressed
+ *  hash table.  Lookups take constant time and do not
+ *  allocate.  Debug builds report two different tag strings
+ *  with the same hash when the tags are registered.
+ ***********************************************************/
+class TagTable
+{
+public:
+	// constructor
+	TagTable();
+
+	// register a tag with its value
+	void Add(TagId tag, int value);
+	// get the value of a tag, or -1 when it is not registered
+	int Find(TagId tag) const;
+	// remove all registered tags
+	void Clear();
+
+private:
+	struct TAG_ENTRY
+	{
+		TagId tag;
+		int value;
+	};
+
+	// power of two sized table of entries - unused entries
+	// hold the empty tag
+	std::vector<TAG_ENTRY> m_entries;
+	// number of registered tags
+	int m_count;
+
+	// double the size of the table and re-insert the tags
+	void Grow();
+};
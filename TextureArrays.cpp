@@ -0,0 +1,354 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturearrays.cpp
+// ============
+// pack loaded textures into 2D texture arrays grouped by size bucket
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TextureArrays.h"
+
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// bytes per pixel of the packed RGBA layers
+	const int PIXEL_SIZE = 4;
+	// color of a reserved layer before its image arrives
+	const unsigned char PLACEHOLDER_PIXEL[PIXEL_SIZE] = { 128, 128, 128, 255 };
+
+	/***********************************************************
+	 *  ResampleRows()
+	 *
+	 *  This function is used for resampling every row of an
+	 *  RGBA float image to a new width with a tent filter.  The
+	 *  filter is widened by the reduction factor when shrinking
+	 *  so every source pixel is counted, and reads past the edges
+	 *  wrap around like a repeating texture.  The output is
+	 *  transposed, so running it twice resamples both axes.
+	 ***********************************************************/
+	void ResampleRows(
+		const float* pSource, int sourceWidth, int rows,
+		float* pTarget, int targetWidth)
+	{
+		float ratio = (float)sourceWidth / (float)targetWidth;
+		float radius = (ratio > 1.0f) ? ratio : 1.0f;
+
+		for (int x = 0; x < targetWidth; x++)
+		{
+			float center = ((float)x + 0.5f) * ratio - 0.5f;
+			int first = (int)std::ceil(center - radius);
+			int last = (int)std::floor(center + radius);
+
+			for (int y = 0; y < rows; y++)
+			{
+				const float* pRow = pSource + (size_t)y * sourceWidth * PIXEL_SIZE;
+				float sum[PIXEL_SIZE] = { 0.0f, 0.0f, 0.0f, 0.0f };
+				float weightSum = 0.0f;
+
+				for (int i = first; i <= last; i++)
+				{
+					float weight = 1.0f - std::fabs((float)i - center) / radius;
+					if (weight <= 0.0f)
+					{
+						continue;
+					}
+
+					int wrapped = i % sourceWidth;
+					wrapped = (wrapped < 0) ? (wrapped + sourceWidth) : wrapped;
+					for (int c = 0; c < PIXEL_SIZE; c++)
+					{
+						sum[c] += pRow[wrapped * PIXEL_SIZE + c] * weight;
+					}
+					weightSum += weight;
+				}
+
+				float* pOut = pTarget + ((size_t)x * rows + y) * PIXEL_SIZE;
+				for (int c = 0; c < PIXEL_SIZE; c++)
+				{
+					pOut[c] = (weightSum > 0.0f) ? (sum[c] / weightSum) : 0.0f;
+				}
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  TextureArrays()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TextureArrays::TextureArrays()
+{
+	for (int i = 0; i < BUCKET_COUNT; i++)
+	{
+		m_buckets[i].textureID = 0;
+		m_buckets[i].layerCount = 0;
+	}
+	m_maxSize = 0;
+	m_maxLayers = 0;
+}
+
+/***********************************************************
+ *  ~TextureArrays()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+TextureArrays::~TextureArrays()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  AddImage()
+ *
+ *  This method is used for converting an image to RGBA,
+ *  resampling it to the size of its bucket and adding it as
+ *  the next layer of that bucket.  All images have to be
+ *  added before Build() is called.
+ ***********************************************************/
+bool TextureArrays::AddImage(const unsigned char* pPixels, int width, int height, int channels, TEXTURE_LOCATION& location)
+{
+	if ((NULL == pPixels) || (channels < 1) || (channels > 4) ||
+		(false == ReserveLayer(width, height, location)))
+	{
+		return(false);
+	}
+
+	// expand the image to RGBA - gray images fill all three
+	// color channels and images without alpha are opaque
+	std::vector<unsigned char> rgba((size_t)width * height * PIXEL_SIZE);
+	for (size_t i = 0; i < (size_t)width * height; i++)
+	{
+		const unsigned char* pIn = pPixels + i * channels;
+		unsigned char* pOut = &rgba[i * PIXEL_SIZE];
+
+		pOut[0] = pIn[0];
+		pOut[1] = (channels >= 3) ? pIn[1] : pIn[0];
+		pOut[2] = (channels >= 3) ? pIn[2] : pIn[0];
+		pOut[3] = (channels == 4) ? pIn[3] : ((channels == 2) ? pIn[1] : 255);
+	}
+
+	int size = GetBucketSize(location.bucket);
+	size_t layerBytes = (size_t)size * size * PIXEL_SIZE;
+	Resample(rgba.data(), width, height, &m_buckets[location.bucket].pixels[location.layer * layerBytes], size, size);
+
+	return(true);
+}
+
+/***********************************************************
+ *  ReserveLayer()
+ *
+ *  This method is used for adding a gray layer to the bucket
+ *  an image of the passed size goes into.  All layers have
+ *  to be added before Build() is called.
+ ***********************************************************/
+bool TextureArrays::ReserveLayer(int width, int height, TEXTURE_LOCATION& location)
+{
+	if ((width <= 0) || (height <= 0))
+	{
+		return(false);
+	}
+
+	if (0 == m_maxSize)
+	{
+		glGetIntegerv(GL_MAX_TEXTURE_SIZE, &m_maxSize);
+		glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &m_maxLayers);
+	}
+
+	// step down to a bucket the context can hold
+	int bucket = FindBucket(width, height);
+	while ((bucket > 0) && (GetBucketSize(bucket) > m_maxSize))
+	{
+		bucket--;
+	}
+
+	BUCKET& target = m_buckets[bucket];
+	if ((0 != target.textureID) || (target.layerCount >= m_maxLayers))
+	{
+		std::cout << "ERROR: no room for another " << GetBucketSize(bucket) << " pixel texture layer" << std::endl;
+		return(false);
+	}
+
+	int size = GetBucketSize(bucket);
+	size_t layerBytes = (size_t)size * size * PIXEL_SIZE;
+	size_t layerStart = target.pixels.size();
+	target.pixels.resize(layerStart + layerBytes);
+	for (size_t i = layerStart; i < target.pixels.size(); i += PIXEL_SIZE)
+	{
+		memcpy(&target.pixels[i], PLACEHOLDER_PIXEL, PIXEL_SIZE);
+	}
+
+	location.bucket = bucket;
+	location.layer = target.layerCount;
+	target.layerCount++;
+
+	return(true);
+}
+
+/***********************************************************
+ *  Build()
+ *
+ *  This method is used for creating one texture array for
+ *  every bucket that received images, uploading the layers,
+ *  generating the mipmaps and freeing the images.
+ ***********************************************************/
+void TextureArrays::Build()
+{
+	for (int bucket = 0; bucket < BUCKET_COUNT; bucket++)
+	{
+		BUCKET& target = m_buckets[bucket];
+		if ((0 != target.textureID) || (0 == target.layerCount))
+		{
+			continue;
+		}
+
+		int size = GetBucketSize(bucket);
+
+		glGenTextures(1, &target.textureID);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, target.textureID);
+
+		// set the texture wrapping parameters
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		// set texture filtering parameters
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+		// the layers are stored back to back in the same order
+		// as the array, so all of them go up in one call
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, size, size, target.layerCount, 0,
+			GL_RGBA, GL_UNSIGNED_BYTE, target.pixels.data());
+		glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+		std::cout << "INFO: packed " << target.layerCount << " textures into a " << size << "x" << size << " texture array" << std::endl;
+
+		// release the memory instead of only clearing it
+		std::vector<unsigned char>().swap(target.pixels);
+	}
+}
+
+/***********************************************************
+ *  Bind()
+ *
+ *  This method is used for binding the texture arrays to the
+ *  texture units with the same numbers as their buckets.
+ ***********************************************************/
+void TextureArrays::Bind() const
+{
+	for (int bucket = 0; bucket < BUCKET_COUNT; bucket++)
+	{
+		if (0 != m_buckets[bucket].textureID)
+		{
+			glActiveTexture(GL_TEXTURE0 + bucket);
+			glBindTexture(GL_TEXTURE_2D_ARRAY, m_buckets[bucket].textureID);
+		}
+	}
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the texture arrays and
+ *  the images that were not uploaded yet.
+ ***********************************************************/
+void TextureArrays::Destroy()
+{
+	for (int bucket = 0; bucket < BUCKET_COUNT; bucket++)
+	{
+		BUCKET& target = m_buckets[bucket];
+		if (0 != target.textureID)
+		{
+			glDeleteTextures(1, &target.textureID);
+			target.textureID = 0;
+		}
+		target.layerCount = 0;
+		std::vector<unsigned char>().swap(target.pixels);
+	}
+}
+
+/***********************************************************
+ *  GetTextureID()
+ *
+ *  This method is used for getting the texture object that
+ *  holds the layers of a bucket.
+ ***********************************************************/
+GLuint TextureArrays::GetTextureID(int bucket) const
+{
+	if ((bucket < 0) || (bucket >= BUCKET_COUNT))
+	{
+		return(0);
+	}
+
+	return(m_buckets[bucket].textureID);
+}
+
+/***********************************************************
+ *  GetBucketSize()
+ *
+ *  This method is used for getting the width and height of
+ *  the layers of a bucket.
+ ***********************************************************/
+int TextureArrays::GetBucketSize(int bucket)
+{
+	return(MIN_BUCKET_SIZE << bucket);
+}
+
+/***********************************************************
+ *  FindBucket()
+ *
+ *  This method is used for getting the bucket whose size is
+ *  the power of two nearest to the longer side of an image,
+ *  so no image is scaled by more than a factor of about 1.4
+ *  unless it is outside the range of the buckets.
+ ***********************************************************/
+int TextureArrays::FindBucket(int width, int height)
+{
+	int longest = (width > height) ? width : height;
+	float steps = std::log2((float)longest / (float)MIN_BUCKET_SIZE);
+	int bucket = (int)std::floor(steps + 0.5f);
+
+	return((bucket < 0) ? 0 : ((bucket >= BUCKET_COUNT) ? (BUCKET_COUNT - 1) : bucket));
+}
+
+/***********************************************************
+ *  Resample()
+ *
+ *  This method is used for resampling an RGBA image to a new
+ *  width and height, one axis at a time.
+ ***********************************************************/
+void TextureArrays::Resample(
+	const unsigned char* pSource, int sourceWidth, int sourceHeight,
+	unsigned char* pTarget, int targetWidth, int targetHeight)
+{
+	size_t sourcePixels = (size_t)sourceWidth * sourceHeight;
+
+	if ((sourceWidth == targetWidth) && (sourceHeight == targetHeight))
+	{
+		memcpy(pTarget, pSource, sourcePixels * PIXEL_SIZE);
+		return;
+	}
+
+	std::vector<float> source(sourcePixels * PIXEL_SIZE);
+	std::vector<float> columns((size_t)targetWidth * sourceHeight * PIXEL_SIZE);
+	std::vector<float> target((size_t)targetWidth * targetHeight * PIXEL_SIZE);
+
+	for (size_t i = 0; i < source.size(); i++)
+	{
+		source[i] = (float)pSource[i];
+	}
+
+	// each pass writes its result transposed, so the second
+	// pass filters the columns and turns the image back
+	ResampleRows(source.data(), sourceWidth, sourceHeight, columns.data(), targetWidth);
+	ResampleRows(columns.data(), sourceHeight, targetWidth, target.data(), targetHeight);
+
+	for (size_t i = 0; i < target.size(); i++)
+	{
+		float value = std::floor(target[i] + 0.5f);
+		pTarget[i] = (unsigned char)((value < 0.0f) ? 0.0f : ((value > 255.0f) ? 255.0f : value));
+	}
+}
@@ -0,0 +1,92 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturearrays.h
+// ============
+// pack loaded textures into 2D texture arrays grouped by size bucket
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <vector>
+
+/***********************************************************
+ *  TextureArrays
+ *
+ *  This class collects texture images of any size, resamples
+ *  each one to the nearest power of two square size bucket
+ *  and stores every bucket as one GL_TEXTURE_2D_ARRAY with a
+ *  layer per image.  A texture is then selected with a layer
+ *  index instead of a texture unit, so the number of textures
+ *  is no longer limited by the texture units and objects with
+ *  different textures in the same bucket can be drawn with
+ *  one call.  Each bucket is bound to the texture unit with
+ *  the same number as the bucket.  The fragment shader reads
+ *
+ *    uniform sampler2DArray objectTextureArray;
+ *    texture(objectTextureArray, vec3(uv, float(layer)));
+ *
+ *  Images are kept in memory until Build() uploads them.  A
+ *  layer can also be reserved from the image size alone and
+ *  filled later, which leaves it gray until then.
+ ***********************************************************/
+class TextureArrays
+{
+public:
+	// constructor
+	TextureArrays();
+	// destructor
+	~TextureArrays();
+
+	// bucket and layer a texture was packed into
+	struct TEXTURE_LOCATION
+	{
+		int bucket;
+		int layer;
+	};
+
+	// resample an 8-bit image with 1 to 4 channels into its
+	// size bucket - returns false when the bucket is full
+	bool AddImage(const unsigned char* pPixels, int width, int height, int channels, TEXTURE_LOCATION& location);
+	// add a gray layer to the bucket of an image of the passed
+	// size, for the image to be uploaded into after Build()
+	bool ReserveLayer(int width, int height, TEXTURE_LOCATION& location);
+	// create the texture arrays from the added images and
+	// free the images
+	void Build();
+	// bind every texture array to the texture unit that
+	// matches its bucket
+	void Bind() const;
+	// free the texture arrays and any images not yet built
+	void Destroy();
+
+	// get the texture object of a bucket, 0 when it is unused
+	GLuint GetTextureID(int bucket) const;
+	// get the width and height of the layers of a bucket
+	static int GetBucketSize(int bucket);
+	// get the bucket an image of the passed size goes into
+	static int FindBucket(int width, int height);
+	// resample an RGBA image to a new size, wrapping at the
+	// edges like GL_REPEAT
+	static void Resample(
+		const unsigned char* pSource, int sourceWidth, int sourceHeight,
+		unsigned char* pTarget, int targetWidth, int targetHeight);
+
+	// number of size buckets, from MIN_BUCKET_SIZE doubling
+	static const int BUCKET_COUNT = 7;
+	static const int MIN_BUCKET_SIZE = 64;
+
+private:
+	// RGBA pixels of the layers of one bucket before upload
+	struct BUCKET
+	{
+		GLuint textureID;
+		int layerCount;
+		std::vector<unsigned char> pixels;
+	};
+
+	BUCKET m_buckets[BUCKET_COUNT];
+	// largest size and layer count the context supports
+	int m_maxSize;
+	int m_maxLayers;
+};
@@ -0,0 +1,349 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturecache.cpp
+// ============
+// keep decoded and mipmapped textures on disk between runs
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TextureCache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <thread>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// declaration of global variables
+namespace
+{
+	// "TXCH" in the first bytes of every entry, and the version
+	// of the layout, raised whenever the layout changes
+	const uint32_t CACHE_MAGIC = 0x48435854;
+	const uint32_t CACHE_VERSION = 1;
+	// FNV-1a 64 bit hash constants
+	const uint64_t HASH_OFFSET_BASIS = 14695981039346656037ULL;
+	const uint64_t HASH_PRIME = 1099511628211ULL;
+
+	// the header as it is stored at the start of an entry,
+	// followed by the levels
+	struct CACHE_HEADER
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint64_t sourceHash;
+		int32_t sourceWidth;
+		int32_t sourceHeight;
+		int32_t width;
+		int32_t height;
+		int32_t channels;
+		int32_t levelCount;
+		uint64_t dataSize;
+	};
+
+	/***********************************************************
+	 *  GetLevelsSize()
+	 *
+	 *  This function is used for getting the bytes of every
+	 *  level from the full size one down to 1x1, and the number
+	 *  of levels, so a damaged header can be told apart.
+	 ***********************************************************/
+	uint64_t GetLevelsSize(int width, int height, int channels, int* pLevelCount)
+	{
+		uint64_t size = 0;
+		int levelCount = 0;
+		while (true)
+		{
+			size += (uint64_t)width * height * channels;
+			levelCount++;
+			if ((1 == width) && (1 == height))
+			{
+				break;
+			}
+			width = (width > 1) ? (width / 2) : 1;
+			height = (height > 1) ? (height / 2) : 1;
+		}
+
+		*pLevelCount = levelCount;
+		return(size);
+	}
+}
+
+/***********************************************************
+ *  TextureCache()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TextureCache::TextureCache()
+{
+	memset(&m_info, 0, sizeof(m_info));
+	m_pMapping = NULL;
+	m_mappingSize = 0;
+	m_fileHandle = NULL;
+	m_mappingHandle = NULL;
+}
+
+/***********************************************************
+ *  ~TextureCache()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+TextureCache::~TextureCache()
+{
+	Close();
+}
+
+/***********************************************************
+ *  Open()
+ *
+ *  This method is used for mapping the entry of an image
+ *  into memory.  The entry is only kept when its header
+ *  matches the version, the passed hash of the image file
+ *  and the size of the file.
+ ***********************************************************/
+TextureCache::LOOKUP TextureCache::Open(const char* filename, uint64_t sourceHash)
+{
+	Close();
+
+#if defined(_WIN32)
+	HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (INVALID_HANDLE_VALUE == file)
+	{
+		return(LOOKUP_MISSING);
+	}
+
+	LARGE_INTEGER fileSize;
+	HANDLE mapping = NULL;
+	if ((FALSE != GetFileSizeEx(file, &fileSize)) && (fileSize.QuadPart >= (LONGLONG)sizeof(CACHE_HEADER)))
+	{
+		mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	}
+	if (NULL == mapping)
+	{
+		CloseHandle(file);
+		return(LOOKUP_STALE);
+	}
+
+	m_fileHandle = file;
+	m_mappingHandle = mapping;
+	m_mappingSize = (size_t)fileSize.QuadPart;
+	m_pMapping = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+#else
+	int file = open(filename, O_RDONLY);
+	if (file < 0)
+	{
+		return(LOOKUP_MISSING);
+	}
+
+	struct stat status;
+	void* pMapping = MAP_FAILED;
+	if ((0 == fstat(file, &status)) && (status.st_size >= (off_t)sizeof(CACHE_HEADER)))
+	{
+		pMapping = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+	}
+	// the mapping stays valid once the file is closed
+	close(file);
+
+	if (MAP_FAILED != pMapping)
+	{
+		m_pMapping = (const unsigned char*)pMapping;
+		m_mappingSize = (size_t)status.st_size;
+	}
+#endif
+
+	if (NULL == m_pMapping)
+	{
+		Close();
+		return(LOOKUP_STALE);
+	}
+
+	CACHE_HEADER header;
+	memcpy(&header, m_pMapping, sizeof(header));
+
+	int levelCount = 0;
+	bool bValid = (CACHE_MAGIC == header.magic) && (CACHE_VERSION == header.version) &&
+		(sourceHash == header.sourceHash) && (header.width > 0) && (header.height > 0) &&
+		((3 == header.channels) || (4 == header.channels)) &&
+		(header.dataSize == GetLevelsSize(header.width, header.height, header.channels, &levelCount)) &&
+		(header.levelCount == levelCount) && ((sizeof(header) + header.dataSize) == m_mappingSize);
+	if (false == bValid)
+	{
+		Close();
+		return(LOOKUP_STALE);
+	}
+
+	m_info.sourceHash = header.sourceHash;
+	m_info.sourceWidth = header.sourceWidth;
+	m_info.sourceHeight = header.sourceHeight;
+	m_info.width = header.width;
+	m_info.height = header.height;
+	m_info.channels = header.channels;
+	m_info.levelCount = header.levelCount;
+	m_info.dataSize = header.dataSize;
+
+	return(LOOKUP_HIT);
+}
+
+/***********************************************************
+ *  Close()
+ *
+ *  This method is used for unmapping the entry.
+ ***********************************************************/
+void TextureCache::Close()
+{
+#if defined(_WIN32)
+	if (NULL != m_pMapping)
+	{
+		UnmapViewOfFile(m_pMapping);
+	}
+	if (NULL != m_mappingHandle)
+	{
+		CloseHandle((HANDLE)m_mappingHandle);
+	}
+	if (NULL != m_fileHandle)
+	{
+		CloseHandle((HANDLE)m_fileHandle);
+	}
+#else
+	if (NULL != m_pMapping)
+	{
+		munmap((void*)m_pMapping, m_mappingSize);
+	}
+#endif
+
+	memset(&m_info, 0, sizeof(m_info));
+	m_pMapping = NULL;
+	m_mappingSize = 0;
+	m_fileHandle = NULL;
+	m_mappingHandle = NULL;
+}
+
+/***********************************************************
+ *  GetInfo()
+ *
+ *  This method is used for getting the header of the mapped
+ *  entry.
+ ***********************************************************/
+const TextureCache::ENTRY_INFO& TextureCache::GetInfo() const
+{
+	return(m_info);
+}
+
+/***********************************************************
+ *  GetData()
+ *
+ *  This method is used for getting the levels of the mapped
+ *  entry, back to back from the full size one down.
+ ***********************************************************/
+const unsigned char* TextureCache::GetData() const
+{
+	if (NULL == m_pMapping)
+	{
+		return(NULL);
+	}
+	return(m_pMapping + sizeof(CACHE_HEADER));
+}
+
+/***********************************************************
+ *  IsOpen()
+ *
+ *  This method is used for checking whether an entry is
+ *  mapped.
+ ***********************************************************/
+bool TextureCache::IsOpen() const
+{
+	return(NULL != m_pMapping);
+}
+
+/***********************************************************
+ *  Write()
+ *
+ *  This method is used for writing an entry.  It is written
+ *  to a file of its own first and then renamed, so another
+ *  run never maps a partly written entry.
+ ***********************************************************/
+bool TextureCache::Write(const char* filename, const ENTRY_INFO& info, const unsigned char* pData)
+{
+	CACHE_HEADER header;
+	memset(&header, 0, sizeof(header));
+	header.magic = CACHE_MAGIC;
+	header.version = CACHE_VERSION;
+	header.sourceHash = info.sourceHash;
+	header.sourceWidth = info.sourceWidth;
+	header.sourceHeight = info.sourceHeight;
+	header.width = info.width;
+	header.height = info.height;
+	header.channels = info.channels;
+	header.levelCount = info.levelCount;
+	header.dataSize = info.dataSize;
+
+	// each thread writes its own temporary file
+	std::string temporaryFilename = std::string(filename) + "." +
+		std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+	{
+		std::ofstream file(temporaryFilename.c_str(), std::ios::binary | std::ios::trunc);
+		file.write((const char*)&header, sizeof(header));
+		file.write((const char*)pData, (std::streamsize)info.dataSize);
+		if (false == file.good())
+		{
+			file.close();
+			std::remove(temporaryFilename.c_str());
+			return(false);
+		}
+	}
+
+#if defined(_WIN32)
+	// rename does not replace an existing file on Windows
+	std::remove(filename);
+#endif
+	if (0 != std::rename(temporaryFilename.c_str(), filename))
+	{
+		std::remove(temporaryFilename.c_str());
+		return(false);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  HashBytes()
+ *
+ *  This method is used for hashing the bytes of an image
+ *  file with 64 bit FNV-1a.
+ ***********************************************************/
+uint64_t TextureCache::HashBytes(const unsigned char* pBytes, size_t size)
+{
+	uint64_t hash = HASH_OFFSET_BASIS;
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= pBytes[i];
+		hash *= HASH_PRIME;
+	}
+	return(hash);
+}
+
+/***********************************************************
+ *  GetCacheFilename()
+ *
+ *  This method is used for getting the name of the entry of
+ *  an image, which is the image name with the layer size, if
+ *  any, and a .texcache extension added.
+ ***********************************************************/
+std::string TextureCache::GetCacheFilename(const std::string& filename, int layerSize)
+{
+	if (layerSize > 0)
+	{
+		return(filename + "." + std::to_string(layerSize) + ".texcache");
+	}
+	return(filename + ".texcache");
+}
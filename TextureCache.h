@@ -0,0 +1,86 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturecache.h
+// ============
+// keep decoded and mipmapped textures on disk between runs
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/***********************************************************
+ *  TextureCache
+ *
+ *  This class maps one entry of the texture cache into
+ *  memory.  An entry sits next to its image and holds the
+ *  texture exactly as it is uploaded - decoded, resampled
+ *  for a texture array layer, and with every mipmap level -
+ *  behind a small header with the hash of the image file it
+ *  was made from.  The texture loader hashes the image file,
+ *  and only when the hash matches does it upload straight
+ *  from the mapped entry, so a changed image is decoded again
+ *  and its entry rewritten.
+ ***********************************************************/
+class TextureCache
+{
+public:
+	// what looking up the entry of an image found
+	enum LOOKUP
+	{
+		LOOKUP_MISSING,
+		LOOKUP_STALE,
+		LOOKUP_HIT
+	};
+
+	// the header of an entry
+	struct ENTRY_INFO
+	{
+		uint64_t sourceHash;
+		int sourceWidth;
+		int sourceHeight;
+		// size and channels of the full size level
+		int width;
+		int height;
+		int channels;
+		int levelCount;
+		uint64_t dataSize;
+	};
+
+	// constructor
+	TextureCache();
+	// destructor
+	~TextureCache();
+
+	// map an entry when it was made from an image with the
+	// passed hash
+	LOOKUP Open(const char* filename, uint64_t sourceHash);
+	// unmap the entry
+	void Close();
+
+	// get the header and the level data of the mapped entry
+	const ENTRY_INFO& GetInfo() const;
+	const unsigned char* GetData() const;
+	bool IsOpen() const;
+
+	// write an entry - the levels are stored back to back
+	static bool Write(const char* filename, const ENTRY_INFO& info, const unsigned char* pData);
+	// hash the bytes of an image file
+	static uint64_t HashBytes(const unsigned char* pBytes, size_t size);
+	// get the name of the entry of an image, which depends
+	// on the layer size it is resampled to, or 0 for none
+	static std::string GetCacheFilename(const std::string& filename, int layerSize);
+
+private:
+	ENTRY_INFO m_info;
+	const unsigned char* m_pMapping;
+	size_t m_mappingSize;
+	// file and mapping handles, only used on Windows
+	void* m_fileHandle;
+	void* m_mappingHandle;
+
+	// an entry is mapped once, so it is never copied
+	TextureCache(const TextureCache&);
+	TextureCache& operator=(const TextureCache&);
+};
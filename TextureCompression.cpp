@@ -0,0 +1,659 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturecompression.cpp
+// ============
+// encode, decode, read and write block compressed textures
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TextureCompression.h"
+#include "TextureArrays.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+// declaration of global variables
+namespace
+{
+	// pixels along each side of a block, and the bytes of a
+	// color or alpha block
+	const int BLOCK_SIDE = 4;
+	const size_t HALF_BLOCK_BYTES = 8;
+
+	// values of the DDS file header - the header is 31 words
+	// after the magic number, and the words used are named
+	const uint32_t DDS_MAGIC = 0x20534444;
+	const int DDS_HEADER_WORDS = 31;
+	const uint32_t DDS_HEADER_SIZE = 124;
+	const uint32_t DDS_PIXEL_FORMAT_SIZE = 32;
+	const uint32_t DDS_FLAGS = 0x1 | 0x2 | 0x4 | 0x1000 | 0x20000 | 0x80000;
+	const uint32_t DDS_FLAG_MIPMAP_COUNT = 0x20000;
+	const uint32_t DDS_PIXEL_FORMAT_FOURCC = 0x4;
+	const uint32_t DDS_CAPS = 0x1000 | 0x400000 | 0x8;
+	const uint32_t FOURCC_DXT1 = 0x31545844;
+	const uint32_t FOURCC_DXT5 = 0x35545844;
+	// largest width or height read from a cooked file, which
+	// is the size of the largest texture array layer
+	const int MAX_COOKED_SIZE = TextureArrays::MIN_BUCKET_SIZE << (TextureArrays::BUCKET_COUNT - 1);
+	enum DDS_HEADER_WORD
+	{
+		WORD_SIZE = 0,
+		WORD_FLAGS = 1,
+		WORD_HEIGHT = 2,
+		WORD_WIDTH = 3,
+		WORD_LINEAR_SIZE = 4,
+		WORD_MIPMAP_COUNT = 6,
+		WORD_PIXEL_FORMAT_SIZE = 18,
+		WORD_PIXEL_FORMAT_FLAGS = 19,
+		WORD_FOURCC = 20,
+		WORD_CAPS = 26
+	};
+
+	/***********************************************************
+	 *  PackColor()
+	 *
+	 *  This function is used for rounding an 8-bit RGB color to
+	 *  the 5:6:5 bits of a block endpoint.
+	 ***********************************************************/
+	uint16_t PackColor(const unsigned char* pColor)
+	{
+		int red = (pColor[0] * 31 + 127) / 255;
+		int green = (pColor[1] * 63 + 127) / 255;
+		int blue = (pColor[2] * 31 + 127) / 255;
+
+		return((uint16_t)((red << 11) | (green << 5) | blue));
+	}
+
+	/***********************************************************
+	 *  UnpackColor()
+	 *
+	 *  This function is used for expanding a 5:6:5 block
+	 *  endpoint back to 8 bits per channel.
+	 ***********************************************************/
+	void UnpackColor(uint16_t packed, int* pColor)
+	{
+		int red = (packed >> 11) & 31;
+		int green = (packed >> 5) & 63;
+		int blue = packed & 31;
+
+		pColor[0] = (red << 3) | (red >> 2);
+		pColor[1] = (green << 2) | (green >> 4);
+		pColor[2] = (blue << 3) | (blue >> 2);
+	}
+
+	/***********************************************************
+	 *  GetColorPalette()
+	 *
+	 *  This function is used for getting the four colors a
+	 *  color block selects from.  With the endpoints in
+	 *  increasing order a BC1 block has only three colors and
+	 *  transparent black instead.
+	 ***********************************************************/
+	void GetColorPalette(uint16_t color0, uint16_t color1, bool bFourColors, int palette[4][4])
+	{
+		UnpackColor(color0, palette[0]);
+		UnpackColor(color1, palette[1]);
+		palette[0][3] = 255;
+		palette[1][3] = 255;
+
+		for (int c = 0; c < 3; c++)
+		{
+			if (bFourColors)
+			{
+				palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+			}
+			else
+			{
+				palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+				palette[3][c] = 0;
+			}
+		}
+		palette[2][3] = 255;
+		palette[3][3] = bFourColors ? 255 : 0;
+	}
+
+	/***********************************************************
+	 *  EncodeColorBlock()
+	 *
+	 *  This function is used for compressing the colors of a
+	 *  block of 16 RGBA pixels.  The endpoints are the two
+	 *  pixels furthest apart along the main axis of the colors,
+	 *  found from their covariance, and every pixel takes the
+	 *  nearest of the four palette colors.
+	 ***********************************************************/
+	void EncodeColorBlock(const unsigned char* pBlock, unsigned char* pOut)
+	{
+		float mean[3] = { 0.0f, 0.0f, 0.0f };
+		for (int i = 0; i < 16; i++)
+		{
+			for (int c = 0; c < 3; c++)
+			{
+				mean[c] += pBlock[i * 4 + c] / 16.0f;
+			}
+		}
+
+		float covariance[3][3] = { { 0.0f } };
+		for (int i = 0; i < 16; i++)
+		{
+			float offset[3];
+			for (int c = 0; c < 3; c++)
+			{
+				offset[c] = pBlock[i * 4 + c] - mean[c];
+			}
+			for (int row = 0; row < 3; row++)
+			{
+				for (int column = 0; column < 3; column++)
+				{
+					covariance[row][column] += offset[row] * offset[column];
+				}
+			}
+		}
+
+		// a few power iterations turn any start toward the axis
+		// along which the colors spread the most
+		float axis[3] = { 1.0f, 1.0f, 1.0f };
+		for (int iteration = 0; iteration < 8; iteration++)
+		{
+			float next[3];
+			float largest = 0.0f;
+			for (int row = 0; row < 3; row++)
+			{
+				next[row] = covariance[row][0] * axis[0] + covariance[row][1] * axis[1] + covariance[row][2] * axis[2];
+				largest = (std::fabs(next[row]) > largest) ? std::fabs(next[row]) : largest;
+			}
+			if (largest < 1.0e-6f)
+			{
+				break;
+			}
+			for (int row = 0; row < 3; row++)
+			{
+				axis[row] = next[row] / largest;
+			}
+		}
+
+		int minIndex = 0;
+		int maxIndex = 0;
+		float minDot = 0.0f;
+		float maxDot = 0.0f;
+		for (int i = 0; i < 16; i++)
+		{
+			float dot = pBlock[i * 4] * axis[0] + pBlock[i * 4 + 1] * axis[1] + pBlock[i * 4 + 2] * axis[2];
+			if ((0 == i) || (dot < minDot))
+			{
+				minDot = dot;
+				minIndex = i;
+			}
+			if ((0 == i) || (dot > maxDot))
+			{
+				maxDot = dot;
+				maxIndex = i;
+			}
+		}
+
+		// the first endpoint is kept the larger one, which
+		// selects the four color mode
+		uint16_t color0 = PackColor(&pBlock[maxIndex * 4]);
+		uint16_t color1 = PackColor(&pBlock[minIndex * 4]);
+		if (color0 < color1)
+		{
+			uint16_t swap = color0;
+			color0 = color1;
+			color1 = swap;
+		}
+
+		uint32_t indices = 0;
+		if (color0 != color1)
+		{
+			int palette[4][4];
+			GetColorPalette(color0, color1, true, palette);
+			for (int i = 0; i < 16; i++)
+			{
+				int bestIndex = 0;
+				int bestDistance = 0;
+				for (int p = 0; p < 4; p++)
+				{
+					int distance = 0;
+					for (int c = 0; c < 3; c++)
+					{
+						int difference = pBlock[i * 4 + c] - palette[p][c];
+						distance += difference * difference;
+					}
+					if ((0 == p) || (distance < bestDistance))
+					{
+						bestDistance = distance;
+						bestIndex = p;
+					}
+				}
+				indices |= (uint32_t)bestIndex << (i * 2);
+			}
+		}
+
+		pOut[0] = (unsigned char)(color0 & 0xFF);
+		pOut[1] = (unsigned char)(color0 >> 8);
+		pOut[2] = (unsigned char)(color1 & 0xFF);
+		pOut[3] = (unsigned char)(color1 >> 8);
+		for (int i = 0; i < 4; i++)
+		{
+			pOut[4 + i] = (unsigned char)((indices >> (i * 8)) & 0xFF);
+		}
+	}
+
+	/***********************************************************
+	 *  DecodeColorBlock()
+	 *
+	 *  This function is used for expanding a color block into
+	 *  16 RGBA pixels.
+	 ***********************************************************/
+	void DecodeColorBlock(const unsigned char* pIn, bool bAlwaysFourColors, unsigned char* pBlock)
+	{
+		uint16_t color0 = (uint16_t)(pIn[0] | (pIn[1] << 8));
+		uint16_t color1 = (uint16_t)(pIn[2] | (pIn[3] << 8));
+		uint32_t indices = (uint32_t)pIn[4] | ((uint32_t)pIn[5] << 8) | ((uint32_t)pIn[6] << 16) | ((uint32_t)pIn[7] << 24);
+
+		int palette[4][4];
+		GetColorPalette(color0, color1, bAlwaysFourColors || (color0 > color1), palette);
+		for (int i = 0; i < 16; i++)
+		{
+			const int* pColor = palette[(indices >> (i * 2)) & 3];
+			for (int c = 0; c < 4; c++)
+			{
+				pBlock[i * 4 + c] = (unsigned char)pColor[c];
+			}
+		}
+	}
+
+	/***********************************************************
+	 *  GetAlphaPalette()
+	 *
+	 *  This function is used for getting the eight alpha values
+	 *  an alpha block selects from.  With the endpoints in
+	 *  increasing order there are six steps plus 0 and 255.
+	 ***********************************************************/
+	void GetAlphaPalette(int alpha0, int alpha1, int palette[8])
+	{
+		palette[0] = alpha0;
+		palette[1] = alpha1;
+		if (alpha0 > alpha1)
+		{
+			for (int i = 1; i < 7; i++)
+			{
+				palette[i + 1] = ((7 - i) * alpha0 + i * alpha1) / 7;
+			}
+		}
+		else
+		{
+			for (int i = 1; i < 5; i++)
+			{
+				palette[i + 1] = ((5 - i) * alpha0 + i * alpha1) / 5;
+			}
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+	}
+
+	/***********************************************************
+	 *  EncodeAlphaBlock()
+	 *
+	 *  This function is used for compressing the alpha of a
+	 *  block of 16 RGBA pixels between its largest and smallest
+	 *  value.
+	 ***********************************************************/
+	void EncodeAlphaBlock(const unsigned char* pBlock, unsigned char* pOut)
+	{
+		int alpha0 = 0;
+		int alpha1 = 255;
+		for (int i = 0; i < 16; i++)
+		{
+			int alpha = pBlock[i * 4 + 3];
+			alpha0 = (alpha > alpha0) ? alpha : alpha0;
+			alpha1 = (alpha < alpha1) ? alpha : alpha1;
+		}
+
+		uint64_t indices = 0;
+		if (alpha0 != alpha1)
+		{
+			int palette[8];
+			GetAlphaPalette(alpha0, alpha1, palette);
+			for (int i = 0; i < 16; i++)
+			{
+				int bestIndex = 0;
+				int bestDistance = 256;
+				for (int p = 0; p < 8; p++)
+				{
+					int distance = std::abs(pBlock[i * 4 + 3] - palette[p]);
+					if (distance < bestDistance)
+					{
+						bestDistance = distance;
+						bestIndex = p;
+					}
+				}
+				indices |= (uint64_t)bestIndex << (i * 3);
+			}
+		}
+
+		pOut[0] = (unsigned char)alpha0;
+		pOut[1] = (unsigned char)alpha1;
+		for (int i = 0; i < 6; i++)
+		{
+			pOut[2 + i] = (unsigned char)((indices >> (i * 8)) & 0xFF);
+		}
+	}
+
+	/***********************************************************
+	 *  DecodeAlphaBlock()
+	 *
+	 *  This function is used for expanding an alpha block into
+	 *  the alpha of 16 RGBA pixels.
+	 ***********************************************************/
+	void DecodeAlphaBlock(const unsigned char* pIn, unsigned char* pBlock)
+	{
+		uint64_t indices = 0;
+		for (int i = 0; i < 6; i++)
+		{
+			indices |= (uint64_t)pIn[2 + i] << (i * 8);
+		}
+
+		int palette[8];
+		GetAlphaPalette(pIn[0], pIn[1], palette);
+		for (int i = 0; i < 16; i++)
+		{
+			pBlock[i * 4 + 3] = (unsigned char)palette[(indices >> (i * 3)) & 7];
+		}
+	}
+
+	/***********************************************************
+	 *  GetBlockBytes()
+	 *
+	 *  This function is used for getting the bytes of one block
+	 *  of a format.
+	 ***********************************************************/
+	size_t GetBlockBytes(TextureCompression::FORMAT format)
+	{
+		return((TextureCompression::FORMAT_BC3 == format) ? (2 * HALF_BLOCK_BYTES) : HALF_BLOCK_BYTES);
+	}
+}
+
+/***********************************************************
+ *  Compress()
+ *
+ *  This method is used for compressing an RGBA image one 4x4
+ *  block at a time.  Blocks past the right or bottom edge of
+ *  a small or odd sized image repeat the last pixels.
+ ***********************************************************/
+void TextureCompression::Compress(const unsigned char* pPixels, int width, int height, FORMAT format,
+	unsigned char* pBlocks)
+{
+	unsigned char block[16 * 4];
+	size_t blockBytes = GetBlockBytes(format);
+
+	for (int blockY = 0; blockY < height; blockY += BLOCK_SIDE)
+	{
+		for (int blockX = 0; blockX < width; blockX += BLOCK_SIDE)
+		{
+			for (int i = 0; i < 16; i++)
+			{
+				int x = blockX + (i % BLOCK_SIDE);
+				int y = blockY + (i / BLOCK_SIDE);
+				x = (x < width) ? x : (width - 1);
+				y = (y < height) ? y : (height - 1);
+				memcpy(&block[i * 4], &pPixels[((size_t)y * width + x) * 4], 4);
+			}
+
+			if (FORMAT_BC3 == format)
+			{
+				EncodeAlphaBlock(block, pBlocks);
+				EncodeColorBlock(block, pBlocks + HALF_BLOCK_BYTES);
+			}
+			else
+			{
+				EncodeColorBlock(block, pBlocks);
+			}
+			pBlocks += blockBytes;
+		}
+	}
+}
+
+/***********************************************************
+ *  Decompress()
+ *
+ *  This method is used for expanding the blocks of an image
+ *  into RGBA pixels, for contexts that cannot sample the
+ *  compressed format.
+ ***********************************************************/
+void TextureCompression::Decompress(const unsigned char* pBlocks, int width, int height, FORMAT format,
+	unsigned char* pPixels)
+{
+	unsigned char block[16 * 4];
+	size_t blockBytes = GetBlockBytes(format);
+
+	for (int blockY = 0; blockY < height; blockY += BLOCK_SIDE)
+	{
+		for (int blockX = 0; blockX < width; blockX += BLOCK_SIDE)
+		{
+			if (FORMAT_BC3 == format)
+			{
+				DecodeColorBlock(pBlocks + HALF_BLOCK_BYTES, true, block);
+				DecodeAlphaBlock(pBlocks, block);
+			}
+			else
+			{
+				DecodeColorBlock(pBlocks, false, block);
+			}
+			pBlocks += blockBytes;
+
+			for (int i = 0; i < 16; i++)
+			{
+				int x = blockX + (i % BLOCK_SIDE);
+				int y = blockY + (i / BLOCK_SIDE);
+				if ((x < width) && (y < height))
+				{
+					memcpy(&pPixels[((size_t)y * width + x) * 4], &block[i * 4], 4);
+				}
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  GetImageSize()
+ *
+ *  This method is used for getting the bytes of the blocks
+ *  that cover an image of the passed size.
+ ***********************************************************/
+size_t TextureCompression::GetImageSize(FORMAT format, int width, int height)
+{
+	size_t blocksWide = (size_t)(width + BLOCK_SIDE - 1) / BLOCK_SIDE;
+	size_t blocksHigh = (size_t)(height + BLOCK_SIDE - 1) / BLOCK_SIDE;
+
+	return(blocksWide * blocksHigh * GetBlockBytes(format));
+}
+
+/***********************************************************
+ *  WriteFile()
+ *
+ *  This method is used for writing an image and its levels
+ *  into a DDS file with a DXT1 or DXT5 pixel format.
+ ***********************************************************/
+bool TextureCompression::WriteFile(const char* filename, const COMPRESSED_IMAGE& image)
+{
+	uint32_t header[DDS_HEADER_WORDS];
+	memset(header, 0, sizeof(header));
+	header[WORD_SIZE] = DDS_HEADER_SIZE;
+	header[WORD_FLAGS] = DDS_FLAGS;
+	header[WORD_HEIGHT] = (uint32_t)image.height;
+	header[WORD_WIDTH] = (uint32_t)image.width;
+	header[WORD_LINEAR_SIZE] = image.levels.empty() ? 0 : (uint32_t)image.levels[0].size;
+	header[WORD_MIPMAP_COUNT] = (uint32_t)image.levels.size();
+	header[WORD_PIXEL_FORMAT_SIZE] = DDS_PIXEL_FORMAT_SIZE;
+	header[WORD_PIXEL_FORMAT_FLAGS] = DDS_PIXEL_FORMAT_FOURCC;
+	header[WORD_FOURCC] = (FORMAT_BC3 == image.format) ? FOURCC_DXT5 : FOURCC_DXT1;
+	header[WORD_CAPS] = DDS_CAPS;
+
+	std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+	file.write((const char*)&DDS_MAGIC, sizeof(DDS_MAGIC));
+	file.write((const char*)header, sizeof(header));
+	file.write((const char*)image.data.data(), (std::streamsize)image.data.size());
+
+	return(file.good());
+}
+
+/***********************************************************
+ *  ReadFile()
+ *
+ *  This method is used for reading a DDS file with a DXT1
+ *  or DXT5 pixel format and laying out its levels.  The file
+ *  can be anything that sits next to an image, so the size,
+ *  the number of levels and the bytes they take are checked
+ *  against the file before anything is allocated.
+ ***********************************************************/
+bool TextureCompression::ReadFile(const char* filename, COMPRESSED_IMAGE& image)
+{
+	std::ifstream file(filename, std::ios::binary | std::ios::ate);
+	uint32_t magic = 0;
+	uint32_t header[DDS_HEADER_WORDS];
+
+	if (false == file.is_open())
+	{
+		return(false);
+	}
+	std::streamoff fileSize = file.tellg();
+	file.seekg(0, std::ios::beg);
+
+	if ((false == file.read((char*)&magic, sizeof(magic)).good()) || (DDS_MAGIC != magic) ||
+		(false == file.read((char*)header, sizeof(header)).good()) || (DDS_HEADER_SIZE != header[WORD_SIZE]))
+	{
+		return(false);
+	}
+
+	if (FOURCC_DXT1 == header[WORD_FOURCC])
+	{
+		image.format = FORMAT_BC1;
+	}
+	else if (FOURCC_DXT5 == header[WORD_FOURCC])
+	{
+		image.format = FORMAT_BC3;
+	}
+	else
+	{
+		return(false);
+	}
+
+	uint32_t levelCount = (0 != (header[WORD_FLAGS] & DDS_FLAG_MIPMAP_COUNT)) ? header[WORD_MIPMAP_COUNT] : 1;
+	if ((0 == header[WORD_WIDTH]) || (0 == header[WORD_HEIGHT]) ||
+		(header[WORD_WIDTH] > (uint32_t)MAX_COOKED_SIZE) || (header[WORD_HEIGHT] > (uint32_t)MAX_COOKED_SIZE))
+	{
+		return(false);
+	}
+	image.width = (int)header[WORD_WIDTH];
+	image.height = (int)header[WORD_HEIGHT];
+
+	// a full chain halves the larger side down to 1
+	uint32_t maxLevelCount = 1;
+	for (int size = (image.width > image.height) ? image.width : image.height; size > 1; size /= 2)
+	{
+		maxLevelCount++;
+	}
+	if ((0 == levelCount) || (levelCount > maxLevelCount))
+	{
+		return(false);
+	}
+
+	int width = image.width;
+	int height = image.height;
+	size_t offset = 0;
+	image.levels.clear();
+	for (uint32_t i = 0; i < levelCount; i++)
+	{
+		LEVEL level;
+		level.width = width;
+		level.height = height;
+		level.offset = offset;
+		level.size = GetImageSize(image.format, width, height);
+		image.levels.push_back(level);
+
+		offset += level.size;
+		width = (width > 1) ? (width / 2) : 1;
+		height = (height > 1) ? (height / 2) : 1;
+	}
+
+	if ((std::streamoff)offset > (fileSize - (std::streamoff)(sizeof(magic) + sizeof(header))))
+	{
+		return(false);
+	}
+
+	image.data.resize(offset);
+	return(file.read((char*)image.data.data(), (std::streamsize)offset).good());
+}
+
+/***********************************************************
+ *  ReadCookedFile()
+ *
+ *  This method is used for reading the cooked file of a
+ *  source image.  A cooked file older than its image was
+ *  made from an earlier version of it, so it is skipped and
+ *  the image is decoded instead until it is cooked again.
+ ***********************************************************/
+bool TextureCompression::ReadCookedFile(const std::string& filename, COMPRESSED_IMAGE& image)
+{
+	std::string cookedFilename = GetCookedFilename(filename);
+	struct stat sourceStatus;
+	struct stat cookedStatus;
+
+	if (0 != stat(cookedFilename.c_str(), &cookedStatus))
+	{
+		return(false);
+	}
+	if ((0 == stat(filename.c_str(), &sourceStatus)) && (sourceStatus.st_mtime > cookedStatus.st_mtime))
+	{
+		return(false);
+	}
+
+	return(ReadFile(cookedFilename.c_str(), image));
+}
+
+/***********************************************************
+ *  GetCookedFilename()
+ *
+ *  This method is used for getting the name of the cooked
+ *  file of an image, which is the image name with a .dds
+ *  extension.
+ ***********************************************************/
+std::string TextureCompression::GetCookedFilename(const std::string& filename)
+{
+	size_t extension = filename.find_last_of('.');
+	size_t directory = filename.find_last_of("/\\");
+
+	if ((std::string::npos == extension) || ((std::string::npos != directory) && (extension < directory)))
+	{
+		return(filename + ".dds");
+	}
+
+	return(filename.substr(0, extension) + ".dds");
+}
+
+/***********************************************************
+ *  GetGLFormat()
+ *
+ *  This method is used for getting the OpenGL internal
+ *  format the blocks of a format are uploaded as.
+ ***********************************************************/
+GLenum TextureCompression::GetGLFormat(FORMAT format)
+{
+	return((FORMAT_BC3 == format) ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT);
+}
+
+/***********************************************************
+ *  IsSupported()
+ *
+ *  This method is used for checking whether the context
+ *  can sample textures in the S3TC formats.
+ ***********************************************************/
+bool TextureCompression::IsSupported()
+{
+	return(GLEW_EXT_texture_compression_s3tc ? true : false);
+}
@@ -0,0 +1,83 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturecompression.h
+// ============
+// encode, decode, read and write block compressed textures
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  TextureCompression
+ *
+ *  This class converts RGBA images to and from the BC1 and
+ *  BC3 block compressed formats, known to OpenGL as S3TC
+ *  DXT1 and DXT5, and stores them with their mipmaps in DDS
+ *  files.  Each 4x4 block of pixels takes 8 bytes in BC1,
+ *  which has no alpha, and 16 bytes in BC3, so a texture
+ *  takes a sixth or a quarter of the memory of RGB8 or RGBA8
+ *  and is sampled by the GPU without being expanded.
+ *
+ *  The rows of a cooked file are stored bottom row first,
+ *  the way the textures are uploaded, so a cooked file only
+ *  matches the images it was made from in this application.
+ ***********************************************************/
+class TextureCompression
+{
+public:
+	// block compressed formats
+	enum FORMAT
+	{
+		FORMAT_BC1,
+		FORMAT_BC3
+	};
+
+	// size and start of one mipmap level in the block data
+	struct LEVEL
+	{
+		int width;
+		int height;
+		size_t offset;
+		size_t size;
+	};
+
+	// a compressed image with all of its levels
+	struct COMPRESSED_IMAGE
+	{
+		FORMAT format;
+		int width;
+		int height;
+		std::vector<LEVEL> levels;
+		std::vector<unsigned char> data;
+	};
+
+	// compress an RGBA image into blocks of the format
+	static void Compress(const unsigned char* pPixels, int width, int height, FORMAT format,
+		unsigned char* pBlocks);
+	// expand the blocks of an image back into RGBA
+	static void Decompress(const unsigned char* pBlocks, int width, int height, FORMAT format,
+		unsigned char* pPixels);
+	// get the bytes of an image of the passed size
+	static size_t GetImageSize(FORMAT format, int width, int height);
+
+	// write an image with its levels into a DDS file
+	static bool WriteFile(const char* filename, const COMPRESSED_IMAGE& image);
+	// read a DDS file written by WriteFile() - returns false
+	// when it is missing, holds another format, or its header
+	// does not fit the size of the file
+	static bool ReadFile(const char* filename, COMPRESSED_IMAGE& image);
+	// read the cooked file of a source image - returns false
+	// when there is none or it is older than the image
+	static bool ReadCookedFile(const std::string& filename, COMPRESSED_IMAGE& image);
+	// get the name of the cooked file of a source image
+	static std::string GetCookedFilename(const std::string& filename);
+
+	// get the OpenGL internal format of a format
+	static GLenum GetGLFormat(FORMAT format);
+	// check whether the context can sample the formats
+	static bool IsSupported();
+};
@@ -0,0 +1,168 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturecooker.cpp
+// ============
+// convert texture images into block compressed files ahead of time
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TextureCooker.h"
+#include "TextureCompression.h"
+#include "TextureLoader.h"
+
+#include "stb_image.h"
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// declaration of global variables
+namespace
+{
+	/***********************************************************
+	 *  GetPeakSignalToNoise()
+	 *
+	 *  This function is used for measuring how close two RGBA
+	 *  images are, in decibels - higher is closer.
+	 ***********************************************************/
+	double GetPeakSignalToNoise(const std::vector<unsigned char>& expected, const std::vector<unsigned char>& actual)
+	{
+		double squaredError = 0.0;
+		for (size_t i = 0; i < expected.size(); i++)
+		{
+			double difference = (double)expected[i] - (double)actual[i];
+			squaredError += difference * difference;
+		}
+
+		double meanSquaredError = squaredError / (double)expected.size();
+		if (meanSquaredError <= 0.0)
+		{
+			return(INFINITY);
+		}
+		return(10.0 * std::log10(255.0 * 255.0 / meanSquaredError));
+	}
+}
+
+/***********************************************************
+ *  Run()
+ *
+ *  This method is used for cooking every passed image file.
+ ***********************************************************/
+bool TextureCooker::Run(int fileCount, char* filenames[])
+{
+	bool bSucceeded = true;
+
+	if (fileCount <= 0)
+	{
+		std::cout << "ERROR: no image files to cook - usage: --cook <image>..." << std::endl;
+		return(false);
+	}
+
+	// cooked rows are stored bottom row first, like the
+	// texture loader uploads them
+	stbi_set_flip_vertically_on_load(true);
+
+	for (int i = 0; i < fileCount; i++)
+	{
+		bSucceeded = CookImage(filenames[i]) && bSucceeded;
+	}
+
+	return(bSucceeded);
+}
+
+/***********************************************************
+ *  CookImage()
+ *
+ *  This method is used for decoding an image, building its
+ *  mipmap levels, compressing each of them and writing them
+ *  into the cooked file of the image.  The full size level
+ *  is decompressed again to report the quality that was kept.
+ ***********************************************************/
+bool TextureCooker::CookImage(const char* filename)
+{
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	int width = 0;
+	int height = 0;
+	int colorChannels = 0;
+
+	unsigned char* image = stbi_load(filename, &width, &height, &colorChannels, 4);
+	if (NULL == image)
+	{
+		std::cout << "Could not load image:" << filename << std::endl;
+		return(false);
+	}
+
+	std::vector<unsigned char> pixels(image, image + (size_t)width * height * 4);
+	stbi_image_free(image);
+
+	// only images with any alpha below 255 need the alpha blocks
+	TextureCompression::COMPRESSED_IMAGE cooked;
+	cooked.format = TextureCompression::FORMAT_BC1;
+	for (size_t i = 3; i < pixels.size(); i += 4)
+	{
+		if (pixels[i] < 255)
+		{
+			cooked.format = TextureCompression::FORMAT_BC3;
+			break;
+		}
+	}
+	cooked.width = width;
+	cooked.height = height;
+
+	std::vector<unsigned char> level = pixels;
+	std::vector<unsigned char> nextLevel;
+	size_t offset = 0;
+	while (true)
+	{
+		TextureCompression::LEVEL cookedLevel;
+		cookedLevel.width = width;
+		cookedLevel.height = height;
+		cookedLevel.offset = offset;
+		cookedLevel.size = TextureCompression::GetImageSize(cooked.format, width, height);
+		cooked.levels.push_back(cookedLevel);
+
+		cooked.data.resize(offset + cookedLevel.size);
+		TextureCompression::Compress(level.data(), width, height, cooked.format, &cooked.data[offset]);
+		offset += cookedLevel.size;
+
+		if ((1 == width) && (1 == height))
+		{
+			break;
+		}
+
+		int nextWidth = (width > 1) ? (width / 2) : 1;
+		int nextHeight = (height > 1) ? (height / 2) : 1;
+		nextLevel.resize((size_t)nextWidth * nextHeight * 4);
+		TextureLoader::DownsampleLevel(level.data(), width, height, 4, nextLevel.data(), nextWidth, nextHeight);
+		level.swap(nextLevel);
+		width = nextWidth;
+		height = nextHeight;
+	}
+
+	std::string cookedFilename = TextureCompression::GetCookedFilename(filename);
+	if (false == TextureCompression::WriteFile(cookedFilename.c_str(), cooked))
+	{
+		std::cout << "ERROR: could not write " << cookedFilename << std::endl;
+		return(false);
+	}
+
+	std::vector<unsigned char> decoded(pixels.size());
+	TextureCompression::Decompress(cooked.data.data(), cooked.width, cooked.height, cooked.format, decoded.data());
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+	// the uncompressed size counts RGB8 or RGBA8 with mipmaps
+	size_t uncompressedBytes = 0;
+	for (size_t i = 0; i < cooked.levels.size(); i++)
+	{
+		uncompressedBytes += (size_t)cooked.levels[i].width * cooked.levels[i].height *
+			((TextureCompression::FORMAT_BC3 == cooked.format) ? 4 : 3);
+	}
+
+	std::cout << "INFO: cooked " << filename << " (" << cooked.width << "x" << cooked.height << ", "
+		<< cooked.levels.size() << " levels) into " << cookedFilename << " as "
+		<< ((TextureCompression::FORMAT_BC3 == cooked.format) ? "BC3" : "BC1") << " - "
+		<< (cooked.data.size() / 1024) << " KB instead of " << (uncompressedBytes / 1024) << " KB, "
+		<< GetPeakSignalToNoise(pixels, decoded) << " dB PSNR, " << elapsed.count() << " ms" << std::endl;
+
+	return(true);
+}
@@ -0,0 +1,32 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturecooker.h
+// ============
+// convert texture images into block compressed files ahead of time
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+/***********************************************************
+ *  TextureCooker
+ *
+ *  This class cooks the image files passed on the command
+ *  line with "--cook <image>..." into block compressed DDS
+ *  files next to them, with every mipmap level built with
+ *  the same filter the texture loader uses.  Images that are
+ *  fully opaque are stored as BC1 and the others as BC3.
+ *  The texture loader reads a cooked file instead of its
+ *  image when one exists, so cooking runs once instead of
+ *  decoding at every start.  Like the benchmarks it runs
+ *  before any window or OpenGL context is created.
+ ***********************************************************/
+class TextureCooker
+{
+public:
+	// cook the passed image files - returns false when any
+	// of them could not be cooked
+	static bool Run(int fileCount, char* filenames[]);
+
+private:
+	// cook one image file into its DDS file
+	static bool CookImage(const char* filename);
+};
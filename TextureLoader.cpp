@@ -0,0 +1,876 @@
+///////////////////////////////////////////////////////////////////////////////
+// textureloader.cpp
+// ============
+// decode texture images on worker threads and stream them to the GPU
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TextureLoader.h"
+#include "RenderSettings.h"
+#include "ShaderBindings.h"
+
+#include "stb_image.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// most bytes of texture rows uploaded in one frame, the
+	// number of pixel buffers they are copied through, and the
+	// texture unit textures are bound to while uploading, which
+	// no draw samples from
+	const size_t UPLOAD_BYTES_PER_FRAME = 4 * 1024 * 1024;
+	const int PIXEL_BUFFER_COUNT = 3;
+	const GLint UPLOAD_TEXTURE_UNIT = TextureUnit::TEXTURE_UPLOAD;
+	// color of the texture drawn until a texture is loaded
+	const unsigned char PLACEHOLDER_PIXEL[4] = { 128, 128, 128, 255 };
+
+	/***********************************************************
+	 *  ElapsedMilliseconds()
+	 *
+	 *  This function is used for getting the milliseconds that
+	 *  passed since the passed in start time.
+	 ***********************************************************/
+	double ElapsedMilliseconds(std::chrono::high_resolution_clock::time_point start)
+	{
+		std::chrono::duration<double, std::milli> elapsed =
+			std::chrono::high_resolution_clock::now() - start;
+		return(elapsed.count());
+	}
+
+	/***********************************************************
+	 *  ReadImageFile()
+	 *
+	 *  This function is used for reading the whole of an image
+	 *  file into memory.
+	 ***********************************************************/
+	bool ReadImageFile(const std::string& filename, std::vector<unsigned char>& bytes)
+	{
+		std::ifstream file(filename.c_str(), std::ios::binary | std::ios::ate);
+		if (false == file.is_open())
+		{
+			return(false);
+		}
+
+		std::streamoff size = file.tellg();
+		if (size <= 0)
+		{
+			return(false);
+		}
+
+		bytes.resize((size_t)size);
+		file.seekg(0, std::ios::beg);
+		return(file.read((char*)bytes.data(), size).good());
+	}
+}
+
+/***********************************************************
+ *  TextureLoader()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TextureLoader::TextureLoader()
+{
+	m_pJobSystem = NULL;
+	m_placeholderID = 0;
+	m_nextPixelBuffer = 0;
+	m_pendingCount = 0;
+	m_loadedCount = 0;
+	m_cachedCount = 0;
+	m_frameIndex = 0;
+	m_bDestroying = false;
+	m_bCompressedUpload = false;
+	m_bUseCache = false;
+}
+
+/***********************************************************
+ *  ~TextureLoader()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+TextureLoader::~TextureLoader()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for creating the placeholder texture
+ *  and the pool of pixel buffers the textures are uploaded
+ *  through.  Cooked textures go up compressed only when the
+ *  context can sample their format.  The texture cache is
+ *  used when the render settings ask for it.
+ ***********************************************************/
+void TextureLoader::Create(JobSystem* pJobSystem)
+{
+	m_pJobSystem = pJobSystem;
+	m_bDestroying = false;
+	m_bCompressedUpload = RenderSettings::Get().bCompressedTextures && TextureCompression::IsSupported();
+	m_bUseCache = RenderSettings::Get().bTextureCache;
+
+	// indicate to always flip images vertically when loaded -
+	// set once here, before any worker decodes an image
+	stbi_set_flip_vertically_on_load(true);
+
+	if (0 == m_placeholderID)
+	{
+		glGenTextures(1, &m_placeholderID);
+		glActiveTexture(GL_TEXTURE0 + UPLOAD_TEXTURE_UNIT);
+		glBindTexture(GL_TEXTURE_2D, m_placeholderID);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, PLACEHOLDER_PIXEL);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		glActiveTexture(GL_TEXTURE0);
+	}
+
+	while ((int)m_pixelBuffers.size() < PIXEL_BUFFER_COUNT)
+	{
+		PIXEL_BUFFER buffer;
+		glGenBuffers(1, &buffer.bufferID);
+		buffer.fence = 0;
+		buffer.capacity = 0;
+		m_pixelBuffers.push_back(buffer);
+	}
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for waiting for the images still
+ *  being decoded and freeing everything that was not handed
+ *  out.  Images decoded while waiting are dropped.
+ ***********************************************************/
+void TextureLoader::Destroy()
+{
+	m_bDestroying = true;
+	if (NULL != m_pJobSystem)
+	{
+		m_pJobSystem->Wait(&m_decodeCounter);
+		m_pJobSystem = NULL;
+	}
+
+	for (size_t i = 0; i < m_uploadQueue.size(); i++)
+	{
+		if (0 != m_uploadQueue[i]->textureID)
+		{
+			glDeleteTextures(1, &m_uploadQueue[i]->textureID);
+		}
+		delete m_uploadQueue[i];
+	}
+	m_uploadQueue.clear();
+	m_pendingCount = 0;
+
+	for (size_t i = 0; i < m_pixelBuffers.size(); i++)
+	{
+		if (0 != m_pixelBuffers[i].fence)
+		{
+			glDeleteSync(m_pixelBuffers[i].fence);
+		}
+		glDeleteBuffers(1, &m_pixelBuffers[i].bufferID);
+	}
+	m_pixelBuffers.clear();
+	m_nextPixelBuffer = 0;
+
+	if (0 != m_placeholderID)
+	{
+		glDeleteTextures(1, &m_placeholderID);
+		m_placeholderID = 0;
+	}
+}
+
+/***********************************************************
+ *  LoadTexture()
+ *
+ *  This method is used for starting to load an image into a
+ *  new 2D texture with a full mipmap chain.  The callback
+ *  gets the texture once it is uploaded and owns it from
+ *  then on.
+ ***********************************************************/
+void TextureLoader::LoadTexture(const char* filename, const LOADED_CALLBACK& onLoaded)
+{
+	TEXTURE_REQUEST* pRequest = new TEXTURE_REQUEST();
+	pRequest->filename = filename;
+	pRequest->pTextureArrays = NULL;
+	pRequest->location.bucket = -1;
+	pRequest->location.layer = -1;
+	pRequest->onLoaded = onLoaded;
+
+	StartRequest(pRequest);
+}
+
+/***********************************************************
+ *  LoadTextureLayer()
+ *
+ *  This method is used for starting to load an image into a
+ *  layer reserved in the texture arrays.  The upload starts
+ *  once the texture arrays are built.
+ ***********************************************************/
+void TextureLoader::LoadTextureLayer(const char* filename, const TextureArrays* pTextureArrays,
+	const TextureArrays::TEXTURE_LOCATION& location)
+{
+	TEXTURE_REQUEST* pRequest = new TEXTURE_REQUEST();
+	pRequest->filename = filename;
+	pRequest->pTextureArrays = pTextureArrays;
+	pRequest->location = location;
+
+	StartRequest(pRequest);
+}
+
+/***********************************************************
+ *  StartRequest()
+ *
+ *  This method is used for adding a request and decoding it
+ *  in the background.  The decoded request goes back to the
+ *  main thread as a main thread job, which both report to
+ *  the decode counter, so Destroy() can wait for them.
+ ***********************************************************/
+void TextureLoader::StartRequest(TEXTURE_REQUEST* pRequest)
+{
+	pRequest->width = 0;
+	pRequest->height = 0;
+	pRequest->channels = 0;
+	pRequest->bCompressedUpload = m_bCompressedUpload;
+	pRequest->compressedFormat = 0;
+	pRequest->bUseCache = m_bUseCache;
+	pRequest->cacheLookup = TextureCache::LOOKUP_MISSING;
+	pRequest->textureID = 0;
+	pRequest->nextLevel = 0;
+	pRequest->nextRow = 0;
+	pRequest->requestTime = std::chrono::high_resolution_clock::now();
+	pRequest->decodeMilliseconds = 0.0;
+	pRequest->mipmapMilliseconds = 0.0;
+	pRequest->cacheWriteMilliseconds = 0.0;
+	pRequest->uploadMilliseconds = 0.0;
+	pRequest->uploadFrames = 0;
+	pRequest->lastUploadFrame = -1;
+
+	if ((0 == m_pendingCount) && (0 == m_loadedCount))
+	{
+		m_firstRequestTime = pRequest->requestTime;
+	}
+	m_pendingCount++;
+
+	if (NULL == m_pJobSystem)
+	{
+		DecodeRequest(pRequest);
+		QueueUpload(pRequest);
+		return;
+	}
+
+	m_pJobSystem->RunInBackground([this, pRequest]()
+	{
+		DecodeRequest(pRequest);
+		m_pJobSystem->RunOnMainThread([this, pRequest]() { QueueUpload(pRequest); }, &m_decodeCounter);
+	}, &m_decodeCounter);
+}
+
+/***********************************************************
+ *  DecodeRequest()
+ *
+ *  This method is used for decoding the image of a request
+ *  and building all of its mipmap levels.  Images for a
+ *  texture array are expanded to RGBA and resampled to the
+ *  size of their bucket first.  A cooked file is read in
+ *  place of its image - its levels are used as they are for
+ *  a 2D texture, while a texture array layer only takes its
+ *  decompressed full size level, since the layers are RGBA.
+ *  Any other image file is hashed, and its levels are mapped
+ *  from its cache entry when the hash matches, or decoded
+ *  and written to the entry when it does not.  It only
+ *  touches the request, so it can run on any thread.
+ ***********************************************************/
+void TextureLoader::DecodeRequest(TEXTURE_REQUEST* pRequest)
+{
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	bool bLayer = (NULL != pRequest->pTextureArrays);
+	TextureCompression::COMPRESSED_IMAGE cooked;
+	std::vector<unsigned char> cookedPixels;
+	std::vector<unsigned char> fileBytes;
+	std::string cacheFilename;
+	uint64_t sourceHash = 0;
+	unsigned char* image = NULL;
+
+	// cooked textures skip the decode already, so they are
+	// never kept in the texture cache
+	bool bCooked = TextureCompression::ReadCookedFile(pRequest->filename, cooked);
+	pRequest->bUseCache = pRequest->bUseCache && (false == bCooked);
+	if (bCooked && (false == bLayer))
+	{
+		UseCookedLevels(pRequest, cooked);
+		pRequest->decodeMilliseconds = ElapsedMilliseconds(start);
+		return;
+	}
+
+	if (bCooked)
+	{
+		pRequest->width = cooked.width;
+		pRequest->height = cooked.height;
+		pRequest->channels = 4;
+		cookedPixels.resize((size_t)cooked.width * cooked.height * 4);
+		TextureCompression::Decompress(cooked.data.data(), cooked.width, cooked.height, cooked.format,
+			cookedPixels.data());
+		image = cookedPixels.data();
+	}
+	else
+	{
+		// the image file is read once, both to hash and decode it
+		if (false == ReadImageFile(pRequest->filename, fileBytes))
+		{
+			return;
+		}
+
+		if (pRequest->bUseCache)
+		{
+			sourceHash = TextureCache::HashBytes(fileBytes.data(), fileBytes.size());
+			cacheFilename = TextureCache::GetCacheFilename(pRequest->filename,
+				bLayer ? TextureArrays::GetBucketSize(pRequest->location.bucket) : 0);
+			pRequest->cacheLookup = pRequest->cacheEntry.Open(cacheFilename.c_str(), sourceHash);
+			if (TextureCache::LOOKUP_HIT == pRequest->cacheLookup)
+			{
+				const TextureCache::ENTRY_INFO& info = pRequest->cacheEntry.GetInfo();
+				pRequest->width = info.sourceWidth;
+				pRequest->height = info.sourceHeight;
+				pRequest->channels = info.channels;
+				LayoutLevels(pRequest, info.width, info.height);
+				pRequest->decodeMilliseconds = ElapsedMilliseconds(start);
+				return;
+			}
+		}
+
+		// try to parse the image data from the specified image file
+		image = stbi_load_from_memory(
+			fileBytes.data(),
+			(int)fileBytes.size(),
+			&pRequest->width,
+			&pRequest->height,
+			&pRequest->channels,
+			bLayer ? 4 : 0);
+		if (NULL == image)
+		{
+			return;
+		}
+	}
+
+	int width = pRequest->width;
+	int height = pRequest->height;
+	if (bLayer)
+	{
+		width = TextureArrays::GetBucketSize(pRequest->location.bucket);
+		height = width;
+		pRequest->channels = 4;
+		pRequest->pixels.resize((size_t)width * height * 4);
+		TextureArrays::Resample(image, pRequest->width, pRequest->height, pRequest->pixels.data(), width, height);
+	}
+	else if ((3 == pRequest->channels) || (4 == pRequest->channels))
+	{
+		pRequest->pixels.assign(image, image + (size_t)width * height * pRequest->channels);
+	}
+	if (false == bCooked)
+	{
+		stbi_image_free(image);
+	}
+	pRequest->decodeMilliseconds = ElapsedMilliseconds(start);
+
+	// the other channel counts are not supported
+	if (pRequest->pixels.empty())
+	{
+		return;
+	}
+
+	// lay out every level down to 1x1 after the full size one
+	start = std::chrono::high_resolution_clock::now();
+	pRequest->pixels.resize(LayoutLevels(pRequest, width, height));
+	for (size_t i = 1; i < pRequest->levels.size(); i++)
+	{
+		const MIP_LEVEL& source = pRequest->levels[i - 1];
+		const MIP_LEVEL& target = pRequest->levels[i];
+		DownsampleLevel(&pRequest->pixels[source.offset], source.width, source.height, pRequest->channels,
+			&pRequest->pixels[target.offset], target.width, target.height);
+	}
+	pRequest->mipmapMilliseconds = ElapsedMilliseconds(start);
+
+	if (false == cacheFilename.empty())
+	{
+		WriteCacheEntry(pRequest, cacheFilename, sourceHash);
+	}
+}
+
+/***********************************************************
+ *  LayoutLevels()
+ *
+ *  This method is used for laying out every level of a
+ *  request after the full size one, each half the size of
+ *  the one before, down to 1x1.
+ ***********************************************************/
+size_t TextureLoader::LayoutLevels(TEXTURE_REQUEST* pRequest, int width, int height)
+{
+	size_t offset = 0;
+
+	pRequest->levels.clear();
+	while (true)
+	{
+		MIP_LEVEL level;
+		level.width = width;
+		level.height = height;
+		level.offset = offset;
+		level.size = (size_t)width * height * pRequest->channels;
+		pRequest->levels.push_back(level);
+		offset += level.size;
+
+		if ((1 == width) && (1 == height))
+		{
+			break;
+		}
+		width = (width > 1) ? (width / 2) : 1;
+		height = (height > 1) ? (height / 2) : 1;
+	}
+
+	return(offset);
+}
+
+/***********************************************************
+ *  WriteCacheEntry()
+ *
+ *  This method is used for writing the decoded levels of a
+ *  request to its cache entry, so the next run maps them
+ *  instead of decoding the image.
+ ***********************************************************/
+void TextureLoader::WriteCacheEntry(TEXTURE_REQUEST* pRequest, const std::string& cacheFilename, uint64_t sourceHash)
+{
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	TextureCache::ENTRY_INFO info;
+
+	info.sourceHash = sourceHash;
+	info.sourceWidth = pRequest->width;
+	info.sourceHeight = pRequest->height;
+	info.width = pRequest->levels[0].width;
+	info.height = pRequest->levels[0].height;
+	info.channels = pRequest->channels;
+	info.levelCount = (int)pRequest->levels.size();
+	info.dataSize = pRequest->pixels.size();
+
+	if (false == TextureCache::Write(cacheFilename.c_str(), info, pRequest->pixels.data()))
+	{
+		// the texture still loads, only without its entry
+		pRequest->cacheLookup = TextureCache::LOOKUP_MISSING;
+		pRequest->bUseCache = false;
+	}
+	pRequest->cacheWriteMilliseconds = ElapsedMilliseconds(start);
+}
+
+/***********************************************************
+ *  UseCookedLevels()
+ *
+ *  This method is used for taking the levels of a cooked
+ *  file for a 2D texture.  They are kept compressed when they
+ *  can be uploaded that way, and otherwise each level is
+ *  decompressed to RGBA, which is how the cooked texture is
+ *  drawn when the driver lacks the format.
+ ***********************************************************/
+void TextureLoader::UseCookedLevels(TEXTURE_REQUEST* pRequest, TextureCompression::COMPRESSED_IMAGE& cooked)
+{
+	pRequest->width = cooked.width;
+	pRequest->height = cooked.height;
+	pRequest->levels.resize(cooked.levels.size());
+
+	if (pRequest->bCompressedUpload)
+	{
+		pRequest->channels = (TextureCompression::FORMAT_BC3 == cooked.format) ? 4 : 3;
+		pRequest->compressedFormat = TextureCompression::GetGLFormat(cooked.format);
+		for (size_t i = 0; i < cooked.levels.size(); i++)
+		{
+			pRequest->levels[i].width = cooked.levels[i].width;
+			pRequest->levels[i].height = cooked.levels[i].height;
+			pRequest->levels[i].offset = cooked.levels[i].offset;
+			pRequest->levels[i].size = cooked.levels[i].size;
+		}
+		pRequest->pixels.swap(cooked.data);
+		return;
+	}
+
+	size_t offset = 0;
+	pRequest->channels = 4;
+	for (size_t i = 0; i < cooked.levels.size(); i++)
+	{
+		pRequest->levels[i].width = cooked.levels[i].width;
+		pRequest->levels[i].height = cooked.levels[i].height;
+		pRequest->levels[i].offset = offset;
+		pRequest->levels[i].size = (size_t)cooked.levels[i].width * cooked.levels[i].height * 4;
+		offset += pRequest->levels[i].size;
+	}
+
+	pRequest->pixels.resize(offset);
+	for (size_t i = 0; i < cooked.levels.size(); i++)
+	{
+		TextureCompression::Decompress(&cooked.data[cooked.levels[i].offset], cooked.levels[i].width,
+			cooked.levels[i].height, cooked.format, &pRequest->pixels[pRequest->levels[i].offset]);
+	}
+}
+
+/***********************************************************
+ *  QueueUpload()
+ *
+ *  This method is used for queuing a decoded request for its
+ *  upload, or dropping it when it could not be decoded.
+ ***********************************************************/
+void TextureLoader::QueueUpload(TEXTURE_REQUEST* pRequest)
+{
+	if (m_bDestroying)
+	{
+		delete pRequest;
+		return;
+	}
+
+	if (pRequest->levels.empty())
+	{
+		if (pRequest->channels > 0)
+		{
+			std::cout << "Not implemented to handle image with " << pRequest->channels << " channels" << std::endl;
+		}
+		std::cout << "Could not load image:" << pRequest->filename << std::endl;
+		CompleteRequest(pRequest);
+		return;
+	}
+
+	m_uploadQueue.push_back(pRequest);
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used for uploading the next rows of the
+ *  decoded images, oldest first, until the bytes of the
+ *  frame are used up or no pixel buffer is free.  At least
+ *  one row goes up every frame while images are waiting.
+ ***********************************************************/
+void TextureLoader::Update()
+{
+	size_t budget = UPLOAD_BYTES_PER_FRAME;
+
+	m_frameIndex++;
+	if (m_uploadQueue.empty())
+	{
+		return;
+	}
+
+	// the decoded rows are tightly packed
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	while ((false == m_uploadQueue.empty()) && (budget > 0))
+	{
+		PIXEL_BUFFER* pBuffer = FindFreeBuffer();
+		if (NULL == pBuffer)
+		{
+			break;
+		}
+
+		TEXTURE_REQUEST* pRequest = m_uploadQueue.front();
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		size_t uploaded = UploadRows(pRequest, pBuffer, budget);
+		if (0 == uploaded)
+		{
+			break;
+		}
+
+		budget = (uploaded < budget) ? (budget - uploaded) : 0;
+		pRequest->uploadMilliseconds += ElapsedMilliseconds(start);
+		if (pRequest->lastUploadFrame != m_frameIndex)
+		{
+			pRequest->lastUploadFrame = m_frameIndex;
+			pRequest->uploadFrames++;
+		}
+
+		if (pRequest->nextLevel == (int)pRequest->levels.size())
+		{
+			m_uploadQueue.pop_front();
+			FinishRequest(pRequest);
+		}
+	}
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glActiveTexture(GL_TEXTURE0);
+}
+
+/***********************************************************
+ *  DownsampleLevel()
+ *
+ *  This method is used for building a mipmap level from the
+ *  level above it by averaging each 2x2 block of pixels.
+ *  The last row or column of an odd sized level is repeated.
+ ***********************************************************/
+void TextureLoader::DownsampleLevel(
+	const unsigned char* pSource, int sourceWidth, int sourceHeight, int channels,
+	unsigned char* pTarget, int targetWidth, int targetHeight)
+{
+	for (int y = 0; y < targetHeight; y++)
+	{
+		int y0 = y * 2;
+		int y1 = ((y0 + 1) < sourceHeight) ? (y0 + 1) : y0;
+		for (int x = 0; x < targetWidth; x++)
+		{
+			int x0 = x * 2;
+			int x1 = ((x0 + 1) < sourceWidth) ? (x0 + 1) : x0;
+			for (int c = 0; c < channels; c++)
+			{
+				int sum = pSource[((size_t)y0 * sourceWidth + x0) * channels + c] +
+					pSource[((size_t)y0 * sourceWidth + x1) * channels + c] +
+					pSource[((size_t)y1 * sourceWidth + x0) * channels + c] +
+					pSource[((size_t)y1 * sourceWidth + x1) * channels + c];
+				pTarget[((size_t)y * targetWidth + x) * channels + c] = (unsigned char)((sum + 2) / 4);
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  GetPlaceholderID()
+ *
+ *  This method is used for getting the texture that is drawn
+ *  until a texture is loaded.
+ ***********************************************************/
+GLuint TextureLoader::GetPlaceholderID() const
+{
+	return(m_placeholderID);
+}
+
+/***********************************************************
+ *  FindFreeBuffer()
+ *
+ *  This method is used for getting the next pixel buffer of
+ *  the pool once the GPU has finished the upload that reads
+ *  it.  The buffers are used in turn, so when the next one
+ *  is still being read the others are too.
+ ***********************************************************/
+TextureLoader::PIXEL_BUFFER* TextureLoader::FindFreeBuffer()
+{
+	if (m_pixelBuffers.empty())
+	{
+		return(NULL);
+	}
+
+	PIXEL_BUFFER& buffer = m_pixelBuffers[m_nextPixelBuffer];
+	if (0 != buffer.fence)
+	{
+		GLenum result = glClientWaitSync(buffer.fence, 0, 0);
+		if ((GL_ALREADY_SIGNALED != result) && (GL_CONDITION_SATISFIED != result))
+		{
+			return(NULL);
+		}
+		glDeleteSync(buffer.fence);
+		buffer.fence = 0;
+	}
+
+	m_nextPixelBuffer = (m_nextPixelBuffer + 1) % (int)m_pixelBuffers.size();
+	return(&buffer);
+}
+
+/***********************************************************
+ *  UploadRows()
+ *
+ *  This method is used for copying as many rows of the next
+ *  level of a request as fit the budget into a pixel buffer
+ *  and uploading them from there.  Compressed levels go up
+ *  in whole rows of 4x4 blocks.  Nothing is uploaded into a
+ *  texture array layer before the arrays are built.
+ ***********************************************************/
+size_t TextureLoader::UploadRows(TEXTURE_REQUEST* pRequest, PIXEL_BUFFER* pBuffer, size_t budget)
+{
+	const MIP_LEVEL& level = pRequest->levels[pRequest->nextLevel];
+	GLenum target = GL_TEXTURE_2D;
+	GLuint textureID = pRequest->textureID;
+
+	if (NULL != pRequest->pTextureArrays)
+	{
+		target = GL_TEXTURE_2D_ARRAY;
+		textureID = pRequest->pTextureArrays->GetTextureID(pRequest->location.bucket);
+		if (0 == textureID)
+		{
+			return(0);
+		}
+	}
+	else if (0 == textureID)
+	{
+		CreateTexture(pRequest);
+		textureID = pRequest->textureID;
+	}
+
+	// a group is a row of pixels, or a row of blocks when the
+	// level is compressed
+	int groupRows = (0 != pRequest->compressedFormat) ? 4 : 1;
+	int groupCount = (level.height + groupRows - 1) / groupRows;
+	int firstGroup = pRequest->nextRow / groupRows;
+	size_t groupBytes = level.size / groupCount;
+	int groups = (int)(budget / groupBytes);
+	groups = (groups < 1) ? 1 : groups;
+	groups = (groups > (groupCount - firstGroup)) ? (groupCount - firstGroup) : groups;
+	int rows = groups * groupRows;
+	rows = (rows > (level.height - pRequest->nextRow)) ? (level.height - pRequest->nextRow) : rows;
+	size_t bytes = (size_t)groups * groupBytes;
+	const unsigned char* pData = pRequest->cacheEntry.IsOpen() ? pRequest->cacheEntry.GetData() : pRequest->pixels.data();
+	const unsigned char* pSource = pData + level.offset + (size_t)firstGroup * groupBytes;
+
+	glActiveTexture(GL_TEXTURE0 + UPLOAD_TEXTURE_UNIT);
+	glBindTexture(target, textureID);
+
+	// the GPU is done with the buffer, so its old contents can
+	// be thrown away and it only grows to the largest copy
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pBuffer->bufferID);
+	if (bytes > pBuffer->capacity)
+	{
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, bytes, NULL, GL_STREAM_DRAW);
+		pBuffer->capacity = bytes;
+	}
+
+	const void* pPixels = NULL;
+	void* pMapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+	if (NULL != pMapped)
+	{
+		memcpy(pMapped, pSource, bytes);
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+	}
+	else
+	{
+		// upload straight from memory when the buffer cannot be mapped
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		pPixels = pSource;
+	}
+
+	if (GL_TEXTURE_2D_ARRAY == target)
+	{
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, pRequest->nextLevel, 0, pRequest->nextRow, pRequest->location.layer,
+			level.width, rows, 1, GL_RGBA, GL_UNSIGNED_BYTE, pPixels);
+	}
+	else if (0 != pRequest->compressedFormat)
+	{
+		glCompressedTexSubImage2D(GL_TEXTURE_2D, pRequest->nextLevel, 0, pRequest->nextRow,
+			level.width, rows, pRequest->compressedFormat, (GLsizei)bytes, pPixels);
+	}
+	else
+	{
+		glTexSubImage2D(GL_TEXTURE_2D, pRequest->nextLevel, 0, pRequest->nextRow,
+			level.width, rows, (4 == pRequest->channels) ? GL_RGBA : GL_RGB, GL_UNSIGNED_BYTE, pPixels);
+	}
+
+	if (NULL != pMapped)
+	{
+		pBuffer->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+	glBindTexture(target, 0);
+
+	pRequest->nextRow += rows;
+	if (pRequest->nextRow == level.height)
+	{
+		pRequest->nextLevel++;
+		pRequest->nextRow = 0;
+	}
+
+	return(bytes);
+}
+
+/***********************************************************
+ *  CreateTexture()
+ *
+ *  This method is used for creating the 2D texture a request
+ *  is uploaded into, with storage for all of its levels in
+ *  the compressed format of a cooked file when it has one.
+ ***********************************************************/
+void TextureLoader::CreateTexture(TEXTURE_REQUEST* pRequest)
+{
+	bool bAlpha = (4 == pRequest->channels);
+
+	glGenTextures(1, &pRequest->textureID);
+	glActiveTexture(GL_TEXTURE0 + UPLOAD_TEXTURE_UNIT);
+	glBindTexture(GL_TEXTURE_2D, pRequest->textureID);
+
+	// set the texture wrapping parameters
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	// set texture filtering parameters
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)pRequest->levels.size() - 1);
+
+	// a NULL pointer only allocates while no pixel buffer is bound
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	for (size_t i = 0; i < pRequest->levels.size(); i++)
+	{
+		if (0 != pRequest->compressedFormat)
+		{
+			glCompressedTexImage2D(GL_TEXTURE_2D, (GLint)i, pRequest->compressedFormat,
+				pRequest->levels[i].width, pRequest->levels[i].height, 0,
+				(GLsizei)pRequest->levels[i].size, NULL);
+		}
+		else
+		{
+			glTexImage2D(GL_TEXTURE_2D, (GLint)i, bAlpha ? GL_RGBA8 : GL_RGB8,
+				pRequest->levels[i].width, pRequest->levels[i].height, 0,
+				bAlpha ? GL_RGBA : GL_RGB, GL_UNSIGNED_BYTE, NULL);
+		}
+	}
+}
+
+/***********************************************************
+ *  FinishRequest()
+ *
+ *  This method is used for handing a loaded 2D texture to
+ *  its callback and reporting how long each stage took, and
+ *  whether it came from the texture cache.
+ ***********************************************************/
+void TextureLoader::FinishRequest(TEXTURE_REQUEST* pRequest)
+{
+	const MIP_LEVEL& lastLevel = pRequest->levels.back();
+	bool bCacheHit = (TextureCache::LOOKUP_HIT == pRequest->cacheLookup);
+
+	if (NULL == pRequest->pTextureArrays)
+	{
+		pRequest->onLoaded(pRequest->textureID);
+	}
+
+	std::cout << "INFO: loaded " << pRequest->filename << " (" << pRequest->width << "x" << pRequest->height
+		<< ", " << ((lastLevel.offset + lastLevel.size) / 1024) << " KB"
+		<< ((0 != pRequest->compressedFormat) ? " compressed" : "")
+		<< ") " << ElapsedMilliseconds(pRequest->requestTime) << " ms after the request - "
+		<< (bCacheHit ? "mapped from the texture cache: " : "decode: ") << pRequest->decodeMilliseconds
+		<< " ms, mipmaps: " << pRequest->mipmapMilliseconds
+		<< " ms, upload: " << pRequest->uploadMilliseconds << " ms over " << pRequest->uploadFrames
+		<< " frames";
+	if (pRequest->bUseCache && (false == bCacheHit))
+	{
+		std::cout << ", " << ((TextureCache::LOOKUP_STALE == pRequest->cacheLookup) ? "stale " : "")
+			<< "cache entry written in " << pRequest->cacheWriteMilliseconds << " ms";
+	}
+	std::cout << std::endl;
+
+	m_loadedCount++;
+	m_cachedCount += bCacheHit ? 1 : 0;
+	CompleteRequest(pRequest);
+}
+
+/***********************************************************
+ *  CompleteRequest()
+ *
+ *  This method is used for freeing a finished request and
+ *  reporting when the last requested texture is done.  The
+ *  start is warm when every texture came from the texture
+ *  cache, and cold when none did.
+ ***********************************************************/
+void TextureLoader::CompleteRequest(TEXTURE_REQUEST* pRequest)
+{
+	delete pRequest;
+
+	m_pendingCount--;
+	if ((0 == m_pendingCount) && (m_loadedCount > 0))
+	{
+		const char* pStart = (m_cachedCount == m_loadedCount) ? "warm" : ((0 == m_cachedCount) ? "cold" : "partly warm");
+		std::cout << "INFO: all " << m_loadedCount << " textures loaded "
+			<< ElapsedMilliseconds(m_firstRequestTime) << " ms after the first request - " << pStart
+			<< " start, " << m_cachedCount << " from the texture cache" << std::endl;
+	}
+}
@@ -0,0 +1,199 @@
+///////////////////////////////////////////////////////////////////////////////
+// textureloader.h
+// ============
+// decode texture images on worker threads and stream them to the GPU
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "JobSystem.h"
+#include "TextureArrays.h"
+#include "TextureCache.h"
+#include "TextureCompression.h"
+
+#include <GL/glew.h>
+
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  TextureLoader
+ *
+ *  This class loads texture images without holding up the
+ *  frames.  Each image is decoded and its mipmaps are built
+ *  by a background job on the job system, and the decoded
+ *  levels are handed to the main thread, which copies them
+ *  into a small pool of pixel buffer objects a few rows at a
+ *  time, so each frame uploads at most a fixed number of
+ *  bytes.  A pixel buffer is only written again once the GPU
+ *  has read it, so the upload never waits on the GPU.
+ *
+ *  A texture is uploaded into a new texture object that is
+ *  handed to the caller once every level is in place, so
+ *  draws sample a gray placeholder texture until then.  A
+ *  texture array layer is uploaded in place, over the gray
+ *  of its reserved layer.  Every texture reports how long
+ *  its decode and upload took and when it was ready.
+ *
+ *  When an image has a cooked DDS file next to it, the file
+ *  is read instead of decoding the image, and its levels go
+ *  up still compressed when the context supports the format.
+ *  Otherwise they are decompressed on the worker first.
+ *  Any other image keeps its decoded levels in the texture
+ *  cache, and the next run maps them from there instead of
+ *  decoding the image again, as long as the image file has
+ *  the same hash.
+ ***********************************************************/
+class TextureLoader
+{
+public:
+	// called on the main thread with the new texture object
+	// once every level of a texture is uploaded
+	typedef std::function<void(GLuint textureID)> LOADED_CALLBACK;
+
+	// constructor
+	TextureLoader();
+	// destructor
+	~TextureLoader();
+
+	// create the placeholder texture and the pixel buffers -
+	// without a job system images are decoded right away on
+	// the calling thread
+	void Create(JobSystem* pJobSystem);
+	// wait for the decodes still running and free the pixel
+	// buffers and the textures not handed out yet
+	void Destroy();
+
+	// start loading an image into a new 2D texture
+	void LoadTexture(const char* filename, const LOADED_CALLBACK& onLoaded);
+	// start loading an image into a reserved texture array
+	// layer, resampled to the size of its bucket
+	void LoadTextureLayer(const char* filename, const TextureArrays* pTextureArrays,
+		const TextureArrays::TEXTURE_LOCATION& location);
+	// upload the next part of the decoded images - called
+	// once per frame on the main thread
+	void Update();
+
+	// get the texture drawn until a texture is loaded
+	GLuint GetPlaceholderID() const;
+
+	// build a mipmap level of an 8-bit image from the level
+	// above it
+	static void DownsampleLevel(
+		const unsigned char* pSource, int sourceWidth, int sourceHeight, int channels,
+		unsigned char* pTarget, int targetWidth, int targetHeight);
+
+private:
+	// size and start of one mipmap level in the pixel data
+	struct MIP_LEVEL
+	{
+		int width;
+		int height;
+		size_t offset;
+		size_t size;
+	};
+
+	// an image on its way from the file to the GPU
+	struct TEXTURE_REQUEST
+	{
+		std::string filename;
+		// texture arrays and layer the image goes into, NULL
+		// for an image loaded into a new 2D texture
+		const TextureArrays* pTextureArrays;
+		TextureArrays::TEXTURE_LOCATION location;
+		LOADED_CALLBACK onLoaded;
+
+		// decoded pixels of all levels back to back - empty
+		// when the image could not be decoded, or when the
+		// levels are read from the mapped cache entry
+		int width;
+		int height;
+		int channels;
+		std::vector<unsigned char> pixels;
+		std::vector<MIP_LEVEL> levels;
+		// whether cooked levels may be uploaded compressed, and
+		// the internal format of the levels when they are, or 0
+		bool bCompressedUpload;
+		GLenum compressedFormat;
+		// whether the texture cache is used, the cache entry of
+		// the image, and what looking it up found
+		bool bUseCache;
+		TextureCache cacheEntry;
+		TextureCache::LOOKUP cacheLookup;
+
+		// texture the levels go into, and the next rows to upload
+		GLuint textureID;
+		int nextLevel;
+		int nextRow;
+
+		// timing of the stages, and the frames the upload took
+		std::chrono::high_resolution_clock::time_point requestTime;
+		double decodeMilliseconds;
+		double mipmapMilliseconds;
+		double cacheWriteMilliseconds;
+		double uploadMilliseconds;
+		int uploadFrames;
+		int lastUploadFrame;
+	};
+
+	// pixel buffer the rows of a texture are copied into, its
+	// size, and the fence of the upload that reads it
+	struct PIXEL_BUFFER
+	{
+		GLuint bufferID;
+		size_t capacity;
+		GLsync fence;
+	};
+
+	JobSystem* m_pJobSystem;
+	JobSystem::JOB_COUNTER m_decodeCounter;
+	GLuint m_placeholderID;
+	std::vector<PIXEL_BUFFER> m_pixelBuffers;
+	int m_nextPixelBuffer;
+	// decoded images waiting for their upload, in the order
+	// they were decoded
+	std::deque<TEXTURE_REQUEST*> m_uploadQueue;
+	// textures requested and not ready yet, textures loaded,
+	// and the time of the first request
+	int m_pendingCount;
+	int m_loadedCount;
+	// textures loaded from the texture cache
+	int m_cachedCount;
+	std::chrono::high_resolution_clock::time_point m_firstRequestTime;
+	int m_frameIndex;
+	bool m_bDestroying;
+	// whether cooked textures are uploaded compressed
+	bool m_bCompressedUpload;
+	// whether decoded textures are kept in the texture cache
+	bool m_bUseCache;
+
+	// add a request and start decoding it
+	void StartRequest(TEXTURE_REQUEST* pRequest);
+	// decode the image of a request and build its mipmaps -
+	// runs on a worker thread
+	static void DecodeRequest(TEXTURE_REQUEST* pRequest);
+	// take the levels of a cooked file for a 2D texture,
+	// decompressing them unless they go up compressed
+	static void UseCookedLevels(TEXTURE_REQUEST* pRequest, TextureCompression::COMPRESSED_IMAGE& cooked);
+	// lay out every level of a request down to 1x1 - returns
+	// the bytes of all levels
+	static size_t LayoutLevels(TEXTURE_REQUEST* pRequest, int width, int height);
+	// write the decoded levels of a request to its cache entry
+	static void WriteCacheEntry(TEXTURE_REQUEST* pRequest, const std::string& cacheFilename, uint64_t sourceHash);
+	// queue a decoded request for its upload
+	void QueueUpload(TEXTURE_REQUEST* pRequest);
+	// get a pixel buffer the GPU is done reading, or NULL
+	PIXEL_BUFFER* FindFreeBuffer();
+	// upload the next rows of a request that fit the budget -
+	// returns the number of bytes uploaded
+	size_t UploadRows(TEXTURE_REQUEST* pRequest, PIXEL_BUFFER* pBuffer, size_t budget);
+	// create the 2D texture a request is uploaded into
+	void CreateTexture(TEXTURE_REQUEST* pRequest);
+	// hand out a loaded texture and report its timing
+	void FinishRequest(TEXTURE_REQUEST* pRequest);
+	// count a request as done, loaded or not
+	void CompleteRequest(TEXTURE_REQUEST* pRequest);
+};
@@ -0,0 +1,186 @@
+///////////////////////////////////////////////////////////////////////////////
+// transform.cpp
+// ============
+// scale, rotation and position of a scene object with a cached world matrix
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Transform.h"
+#include "FrameStats.h"
+
+#include <glm/gtx/transform.hpp>
+
+/***********************************************************
+ *  Transform()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+Transform::Transform()
+{
+	m_scale = glm::vec3(1.0f, 1.0f, 1.0f);
+	m_rotation = glm::vec3(0.0f, 0.0f, 0.0f);
+	m_position = glm::vec3(0.0f, 0.0f, 0.0f);
+	m_worldMatrix = glm::mat4(1.0f);
+	m_bDirty = false;
+}
+
+/***********************************************************
+ *  SetScale()
+ *
+ *  This method is used for setting the XYZ scale.
+ ***********************************************************/
+void Transform::SetScale(const glm::vec3& scaleXYZ)
+{
+	if (m_scale != scaleXYZ)
+	{
+		m_scale = scaleXYZ;
+		m_bDirty = true;
+	}
+}
+
+/***********************************************************
+ *  SetRotation()
+ *
+ *  This method is used for setting the XYZ rotation angles.
+ ***********************************************************/
+void Transform::SetRotation(float XrotationDegrees, float YrotationDegrees, float ZrotationDegrees)
+{
+	glm::vec3 rotation(XrotationDegrees, YrotationDegrees, ZrotationDegrees);
+
+	if (m_rotation != rotation)
+	{
+		m_rotation = rotation;
+		m_bDirty = true;
+	}
+}
+
+/***********************************************************
+ *  SetPosition()
+ *
+ *  This method is used for setting the XYZ position.
+ ***********************************************************/
+void Transform::SetPosition(const glm::vec3& positionXYZ)
+{
+	if (m_position != positionXYZ)
+	{
+		m_position = positionXYZ;
+		m_bDirty = true;
+	}
+}
+
+/***********************************************************
+ *  GetScale()
+ *
+ *  This method is used for getting the XYZ scale.
+ ***********************************************************/
+const glm::vec3& Transform::GetScale() const
+{
+	return(m_scale);
+}
+
+/***********************************************************
+ *  GetRotation()
+ *
+ *  This method is used for getting the XYZ rotation angles.
+ ***********************************************************/
+const glm::vec3& Transform::GetRotation() const
+{
+	return(m_rotation);
+}
+
+/***********************************************************
+ *  GetPosition()
+ *
+ *  This method is used for getting the XYZ position.
+ ***********************************************************/
+const glm::vec3& Transform::GetPosition() const
+{
+	return(m_position);
+}
+
+/***********************************************************
+ *  IsDirty()
+ *
+ *  This method is used for checking whether the world
+ *  matrix is out of date.
+ ***********************************************************/
+bool Transform::IsDirty() const
+{
+	return(m_bDirty);
+}
+
+/***********************************************************
+ *  UpdateWorldMatrix()
+ *
+ *  This method is used for rebuilding the world matrix when
+ *  a transformation value has changed since the last build.
+ ***********************************************************/
+bool Transform::UpdateWorldMatrix()
+{
+	if (false == m_bDirty)
+	{
+		return(false);
+	}
+
+	m_worldMatrix = ComposeMatrix(m_scale, m_rotation, m_position);
+	m_bDirty = false;
+	FrameStats::Current().matricesRebuilt++;
+
+	return(true);
+}
+
+/***********************************************************
+ *  SetWorldMatrix()
+ *
+ *  This method is used for storing a world matrix that was
+ *  built outside of this class from the current values, so
+ *  many objects can be rebuilt together in one batch.  It
+ *  can be called from worker threads, so the caller counts
+ *  the rebuilt matrices in the frame stats.
+ ***********************************************************/
+void Transform::SetWorldMatrix(const glm::mat4& worldMatrix)
+{
+	m_worldMatrix = worldMatrix;
+	m_bDirty = false;
+}
+
+/***********************************************************
+ *  GetWorldMatrix()
+ *
+ *  This method is used for getting the cached world matrix.
+ *  UpdateWorldMatrix() must be called after a change for the
+ *  matrix to include it.
+ ***********************************************************/
+const glm::mat4& Transform::GetWorldMatrix() const
+{
+	return(m_worldMatrix);
+}
+
+/***********************************************************
+ *  ComposeMatrix()
+ *
+ *  This method is used for calculating the model matrix
+ *  from the passed in transformation values.
+ ***********************************************************/
+glm::mat4 Transform::ComposeMatrix(
+	const glm::vec3& scaleXYZ,
+	const glm::vec3& rotationDegrees,
+	const glm::vec3& positionXYZ)
+{
+	// variables for this method
+	glm::mat4 scale;
+	glm::mat4 rotationX;
+	glm::mat4 rotationY;
+	glm::mat4 rotationZ;
+	glm::mat4 translation;
+
+	// set the scale value in the transform buffer
+	scale = glm::scale(scaleXYZ);
+	// set the rotation values in the transform buffer
+	rotationX = glm::rotate(glm::radians(rotationDegrees.x), glm::vec3(1.0f, 0.0f, 0.0f));
+	rotationY = glm::rotate(glm::radians(rotationDegrees.y), glm::vec3(0.0f, 1.0f, 0.0f));
+	rotationZ = glm::rotate(glm::radians(rotationDegrees.z), glm::vec3(0.0f, 0.0f, 1.0f));
+	// set the translation value in the transform buffer
+	translation = glm::translate(positionXYZ);
+
+	return(translation * rotationZ * rotationY * rotationX * scale);
+}
@@ -0,0 +1,62 @@
+///////////////////////////////////////////////////////////////////////////////
+// transform.h
+// ============
+// scale, rotation and position of a scene object with a cached world matrix
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+/***********************************************************
+ *  Transform
+ *
+ *  This class holds the transformation values of one scene
+ *  object together with the world matrix built from them.
+ *  The matrix is only rebuilt after the scale, rotation or
+ *  position has actually changed, so objects that never
+ *  move cost nothing per frame.
+ ***********************************************************/
+class Transform
+{
+public:
+	// constructor
+	Transform();
+
+	// change the transformation values - the world matrix is
+	// marked dirty only when a value is different
+	void SetScale(const glm::vec3& scaleXYZ);
+	void SetRotation(float XrotationDegrees, float YrotationDegrees, float ZrotationDegrees);
+	void SetPosition(const glm::vec3& positionXYZ);
+
+	// get the transformation values
+	const glm::vec3& GetScale() const;
+	const glm::vec3& GetRotation() const;
+	const glm::vec3& GetPosition() const;
+
+	// check whether the world matrix needs to be rebuilt
+	bool IsDirty() const;
+	// rebuild the world matrix if it is dirty - returns true
+	// when the matrix was rebuilt
+	bool UpdateWorldMatrix();
+	// store a world matrix that was built elsewhere from the
+	// current transformation values, such as by a TransformBatch
+	void SetWorldMatrix(const glm::mat4& worldMatrix);
+	// get the cached world matrix as of the last update
+	const glm::mat4& GetWorldMatrix() const;
+
+	// calculate a model matrix from transformation values
+	static glm::mat4 ComposeMatrix(
+		const glm::vec3& scaleXYZ,
+		const glm::vec3& rotationDegrees,
+		const glm::vec3& positionXYZ);
+
+private:
+	glm::vec3 m_scale;
+	// X, Y and Z rotation angles in degrees
+	glm::vec3 m_rotation;
+	glm::vec3 m_position;
+	// cached world matrix and whether it is out of date
+	glm::mat4 m_worldMatrix;
+	bool m_bDirty;
+};
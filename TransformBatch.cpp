@@ -0,0 +1,450 @@
+///////////////////////////////////////////////////////////////////////////////
+// transformbatch.cpp
+// ============
+// build many model matrices at once from structure-of-arrays transform data
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TransformBatch.h"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <cmath>
+
+// select the widest instruction set the code is compiled for
+#if defined(__AVX2__)
+#define TRANSFORM_BATCH_AVX2
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define TRANSFORM_BATCH_SSE2
+#endif
+
+#if defined(TRANSFORM_BATCH_AVX2) || defined(TRANSFORM_BATCH_SSE2)
+#include <immintrin.h>
+#endif
+
+// declaration of global variables
+namespace
+{
+	const float DEGREES_TO_RADIANS = 0.01745329251994329577f;
+
+	// constants of the sine and cosine approximation - the
+	// argument is reduced to [-pi/4, pi/4] in three steps of
+	// pi/4 split into parts that are exact in single precision
+	const float FOUR_OVER_PI = 1.27323954473516f;
+	const float REDUCE_PART_1 = -0.78515625f;
+	const float REDUCE_PART_2 = -2.4187564849853515625e-4f;
+	const float REDUCE_PART_3 = -3.77489497744594108e-8f;
+	const float COS_COEFFICIENT_0 = 2.443315711809948e-005f;
+	const float COS_COEFFICIENT_1 = -1.388731625493765e-003f;
+	const float COS_COEFFICIENT_2 = 4.166664568298827e-002f;
+	const float SIN_COEFFICIENT_0 = -1.9515295891e-4f;
+	const float SIN_COEFFICIENT_1 = 8.3321608736e-3f;
+	const float SIN_COEFFICIENT_2 = -1.6666654611e-1f;
+
+	/***********************************************************
+	 *  WriteMatrix()
+	 *
+	 *  This function is used for writing one model matrix from
+	 *  the scaled rotation columns and the position.
+	 ***********************************************************/
+	inline void WriteMatrix(const float columns[12], glm::mat4& matrix)
+	{
+		float* pValues = glm::value_ptr(matrix);
+
+		pValues[0] = columns[0];
+		pValues[1] = columns[1];
+		pValues[2] = columns[2];
+		pValues[3] = 0.0f;
+		pValues[4] = columns[3];
+		pValues[5] = columns[4];
+		pValues[6] = columns[5];
+		pValues[7] = 0.0f;
+		pValues[8] = columns[6];
+		pValues[9] = columns[7];
+		pValues[10] = columns[8];
+		pValues[11] = 0.0f;
+		pValues[12] = columns[9];
+		pValues[13] = columns[10];
+		pValues[14] = columns[11];
+		pValues[15] = 1.0f;
+	}
+
+#if defined(TRANSFORM_BATCH_AVX2)
+	// AVX2 operations on 8 floats at a time
+	struct SIMD_AVX2
+	{
+		typedef __m256 Float;
+		typedef __m256i Int;
+		static const int WIDTH = 8;
+
+		static inline Float Set1(float value) { return _mm256_set1_ps(value); }
+		static inline Float Load(const float* pValues) { return _mm256_loadu_ps(pValues); }
+		static inline void Store(float* pValues, Float value) { _mm256_storeu_ps(pValues, value); }
+		static inline Float Add(Float a, Float b) { return _mm256_add_ps(a, b); }
+		static inline Float Sub(Float a, Float b) { return _mm256_sub_ps(a, b); }
+		static inline Float Mul(Float a, Float b) { return _mm256_mul_ps(a, b); }
+		static inline Float And(Float a, Float b) { return _mm256_and_ps(a, b); }
+		static inline Float AndNot(Float a, Float b) { return _mm256_andnot_ps(a, b); }
+		static inline Float Or(Float a, Float b) { return _mm256_or_ps(a, b); }
+		static inline Float Xor(Float a, Float b) { return _mm256_xor_ps(a, b); }
+		static inline Int Set1i(int value) { return _mm256_set1_epi32(value); }
+		static inline Int ToInt(Float value) { return _mm256_cvttps_epi32(value); }
+		static inline Float ToFloat(Int value) { return _mm256_cvtepi32_ps(value); }
+		static inline Int Addi(Int a, Int b) { return _mm256_add_epi32(a, b); }
+		static inline Int Subi(Int a, Int b) { return _mm256_sub_epi32(a, b); }
+		static inline Int Andi(Int a, Int b) { return _mm256_and_si256(a, b); }
+		static inline Int CmpEqi(Int a, Int b) { return _mm256_cmpeq_epi32(a, b); }
+		static inline Float AsFloat(Int value) { return _mm256_castsi256_ps(value); }
+	};
+#endif
+
+#if defined(TRANSFORM_BATCH_SSE2)
+	// SSE2 operations on 4 floats at a time
+	struct SIMD_SSE2
+	{
+		typedef __m128 Float;
+		typedef __m128i Int;
+		static const int WIDTH = 4;
+
+		static inline Float Set1(float value) { return _mm_set1_ps(value); }
+		static inline Float Load(const float* pValues) { return _mm_loadu_ps(pValues); }
+		static inline void Store(float* pValues, Float value) { _mm_storeu_ps(pValues, value); }
+		static inline Float Add(Float a, Float b) { return _mm_add_ps(a, b); }
+		static inline Float Sub(Float a, Float b) { return _mm_sub_ps(a, b); }
+		static inline Float Mul(Float a, Float b) { return _mm_mul_ps(a, b); }
+		static inline Float And(Float a, Float b) { return _mm_and_ps(a, b); }
+		static inline Float AndNot(Float a, Float b) { return _mm_andnot_ps(a, b); }
+		static inline Float Or(Float a, Float b) { return _mm_or_ps(a, b); }
+		static inline Float Xor(Float a, Float b) { return _mm_xor_ps(a, b); }
+		static inline Int Set1i(int value) { return _mm_set1_epi32(value); }
+		static inline Int ToInt(Float value) { return _mm_cvttps_epi32(value); }
+		static inline Float ToFloat(Int value) { return _mm_cvtepi32_ps(value); }
+		static inline Int Addi(Int a, Int b) { return _mm_add_epi32(a, b); }
+		static inline Int Subi(Int a, Int b) { return _mm_sub_epi32(a, b); }
+		static inline Int Andi(Int a, Int b) { return _mm_and_si128(a, b); }
+		static inline Int CmpEqi(Int a, Int b) { return _mm_cmpeq_epi32(a, b); }
+		static inline Float AsFloat(Int value) { return _mm_castsi128_ps(value); }
+	};
+#endif
+
+#if defined(TRANSFORM_BATCH_AVX2) || defined(TRANSFORM_BATCH_SSE2)
+	/***********************************************************
+	 *  SinCos()
+	 *
+	 *  This function is used for calculating the sine and
+	 *  cosine of every lane at once.  The angle is reduced to
+	 *  an octant and evaluated with minimax polynomials, which
+	 *  is accurate to about one unit in the last place for the
+	 *  angle range of scene rotations.
+	 ***********************************************************/
+	template <class V>
+	inline void SinCos(typename V::Float angle, typename V::Float& sine, typename V::Float& cosine)
+	{
+		typedef typename V::Float Float;
+		typedef typename V::Int Int;
+
+		const Float signMask = V::AsFloat(V::Set1i((int)0x80000000));
+		const Int zero = V::Set1i(0);
+
+		// work on the absolute value and remember the sign
+		Float sineSign = V::And(angle, signMask);
+		Float x = V::AndNot(signMask, angle);
+
+		// find the octant of the angle, rounded up to even
+		Int octant = V::ToInt(V::Mul(x, V::Set1(FOUR_OVER_PI)));
+		octant = V::Andi(V::Addi(octant, V::Set1i(1)), V::Set1i(~1));
+		Float y = V::ToFloat(octant);
+
+		// select the polynomial and the signs for each octant
+		Float swapSineSign = V::And(V::AsFloat(V::CmpEqi(V::Andi(octant, V::Set1i(4)), V::Set1i(4))), signMask);
+		Float cosineSign = V::And(V::AsFloat(V::CmpEqi(V::Andi(V::Subi(octant, V::Set1i(2)), V::Set1i(4)), zero)), signMask);
+		Float polynomialMask = V::AsFloat(V::CmpEqi(V::Andi(octant, V::Set1i(2)), zero));
+		sineSign = V::Xor(sineSign, swapSineSign);
+
+		// reduce the angle to [-pi/4, pi/4]
+		x = V::Add(x, V::Mul(y, V::Set1(REDUCE_PART_1)));
+		x = V::Add(x, V::Mul(y, V::Set1(REDUCE_PART_2)));
+		x = V::Add(x, V::Mul(y, V::Set1(REDUCE_PART_3)));
+		Float z = V::Mul(x, x);
+
+		// cosine polynomial
+		Float cosineValue = V::Set1(COS_COEFFICIENT_0);
+		cosineValue = V::Add(V::Mul(cosineValue, z), V::Set1(COS_COEFFICIENT_1));
+		cosineValue = V::Add(V::Mul(cosineValue, z), V::Set1(COS_COEFFICIENT_2));
+		cosineValue = V::Mul(V::Mul(cosineValue, z), z);
+		cosineValue = V::Sub(cosineValue, V::Mul(z, V::Set1(0.5f)));
+		cosineValue = V::Add(cosineValue, V::Set1(1.0f));
+
+		// sine polynomial
+		Float sineValue = V::Set1(SIN_COEFFICIENT_0);
+		sineValue = V::Add(V::Mul(sineValue, z), V::Set1(SIN_COEFFICIENT_1));
+		sineValue = V::Add(V::Mul(sineValue, z), V::Set1(SIN_COEFFICIENT_2));
+		sineValue = V::Add(V::Mul(V::Mul(sineValue, z), x), x);
+
+		sine = V::Or(V::And(polynomialMask, sineValue), V::AndNot(polynomialMask, cosineValue));
+		cosine = V::Or(V::And(polynomialMask, cosineValue), V::AndNot(polynomialMask, sineValue));
+		sine = V::Xor(sine, sineSign);
+		cosine = V::Xor(cosine, cosineSign);
+	}
+
+	/***********************************************************
+	 *  BuildMatricesSimd()
+	 *
+	 *  This function is used for building the model matrices
+	 *  of V::WIDTH objects per iteration.  A partial block at
+	 *  the end is padded with identity transforms.
+	 ***********************************************************/
+	template <class V>
+	void BuildMatricesSimd(const TransformBatch::TRANSFORM_SOA& transforms, int count, glm::mat4* pMatrices)
+	{
+		typedef typename V::Float Float;
+		const int WIDTH = V::WIDTH;
+
+		// padded copy of the inputs for a partial last block
+		float padded[9][WIDTH];
+		// the 12 non-constant matrix values of each lane
+		float columns[12][WIDTH];
+
+		for (int first = 0; first < count; first += WIDTH)
+		{
+			int laneCount = ((count - first) < WIDTH) ? (count - first) : WIDTH;
+			const float* pInputs[9] =
+			{
+				transforms.scaleX + first, transforms.scaleY + first, transforms.scaleZ + first,
+				transforms.rotationX + first, transforms.rotationY + first, transforms.rotationZ + first,
+				transforms.positionX + first, transforms.positionY + first, transforms.positionZ + first
+			};
+
+			if (laneCount < WIDTH)
+			{
+				for (int component = 0; component < 9; component++)
+				{
+					float fill = (component < 3) ? 1.0f : 0.0f;
+					for (int lane = 0; lane < WIDTH; lane++)
+					{
+						padded[component][lane] = (lane < laneCount) ? pInputs[component][lane] : fill;
+					}
+					pInputs[component] = padded[component];
+				}
+			}
+
+			Float scaleX = V::Load(pInputs[0]);
+			Float scaleY = V::Load(pInputs[1]);
+			Float scaleZ = V::Load(pInputs[2]);
+			Float toRadians = V::Set1(DEGREES_TO_RADIANS);
+
+			Float sinX, cosX, sinY, cosY, sinZ, cosZ;
+			SinCos<V>(V::Mul(V::Load(pInputs[3]), toRadians), sinX, cosX);
+			SinCos<V>(V::Mul(V::Load(pInputs[4]), toRadians), sinY, cosY);
+			SinCos<V>(V::Mul(V::Load(pInputs[5]), toRadians), sinZ, cosZ);
+
+			// closed form of rotationZ * rotationY * rotationX
+			Float sinYcosZ = V::Mul(sinY, cosZ);
+			Float sinYsinZ = V::Mul(sinY, sinZ);
+			Float r00 = V::Mul(cosY, cosZ);
+			Float r10 = V::Mul(cosY, sinZ);
+			Float r20 = V::Sub(V::Set1(0.0f), sinY);
+			Float r01 = V::Sub(V::Mul(sinX, sinYcosZ), V::Mul(cosX, sinZ));
+			Float r11 = V::Add(V::Mul(sinX, sinYsinZ), V::Mul(cosX, cosZ));
+			Float r21 = V::Mul(sinX, cosY);
+			Float r02 = V::Add(V::Mul(cosX, sinYcosZ), V::Mul(sinX, sinZ));
+			Float r12 = V::Sub(V::Mul(cosX, sinYsinZ), V::Mul(sinX, cosZ));
+			Float r22 = V::Mul(cosX, cosY);
+
+			// scale the rotation columns and add the translation
+			V::Store(columns[0], V::Mul(r00, scaleX));
+			V::Store(columns[1], V::Mul(r10, scaleX));
+			V::Store(columns[2], V::Mul(r20, scaleX));
+			V::Store(columns[3], V::Mul(r01, scaleY));
+			V::Store(columns[4], V::Mul(r11, scaleY));
+			V::Store(columns[5], V::Mul(r21, scaleY));
+			V::Store(columns[6], V::Mul(r02, scaleZ));
+			V::Store(columns[7], V::Mul(r12, scaleZ));
+			V::Store(columns[8], V::Mul(r22, scaleZ));
+			V::Store(columns[9], V::Load(pInputs[6]));
+			V::Store(columns[10], V::Load(pInputs[7]));
+			V::Store(columns[11], V::Load(pInputs[8]));
+
+			for (int lane = 0; lane < laneCount; lane++)
+			{
+				float laneColumns[12];
+				for (int value = 0; value < 12; value++)
+				{
+					laneColumns[value] = columns[value][lane];
+				}
+				WriteMatrix(laneColumns, pMatrices[first + lane]);
+			}
+		}
+	}
+#endif
+}
+
+/***********************************************************
+ *  TransformBatch()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TransformBatch::TransformBatch()
+{
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for removing all objects from the
+ *  batch.  The array memory is kept for the next batch.
+ ***********************************************************/
+void TransformBatch::Clear()
+{
+	m_scaleX.clear();
+	m_scaleY.clear();
+	m_scaleZ.clear();
+	m_rotationX.clear();
+	m_rotationY.clear();
+	m_rotationZ.clear();
+	m_positionX.clear();
+	m_positionY.clear();
+	m_positionZ.clear();
+}
+
+/***********************************************************
+ *  Add()
+ *
+ *  This method is used for adding the transform values of
+ *  one object to the batch.
+ ***********************************************************/
+void TransformBatch::Add(const glm::vec3& scaleXYZ, const glm::vec3& rotationDegrees, const glm::vec3& positionXYZ)
+{
+	m_scaleX.push_back(scaleXYZ.x);
+	m_scaleY.push_back(scaleXYZ.y);
+	m_scaleZ.push_back(scaleXYZ.z);
+	m_rotationX.push_back(rotationDegrees.x);
+	m_rotationY.push_back(rotationDegrees.y);
+	m_rotationZ.push_back(rotationDegrees.z);
+	m_positionX.push_back(positionXYZ.x);
+	m_positionY.push_back(positionXYZ.y);
+	m_positionZ.push_back(positionXYZ.z);
+}
+
+/***********************************************************
+ *  GetCount()
+ *
+ *  This method is used for getting the number of objects
+ *  in the batch.
+ ***********************************************************/
+int TransformBatch::GetCount() const
+{
+	return((int)m_scaleX.size());
+}
+
+/***********************************************************
+ *  BuildModelMatrices()
+ *
+ *  This method is used for building the model matrices of
+ *  all objects in the batch, in the order they were added.
+ ***********************************************************/
+void TransformBatch::BuildModelMatrices(glm::mat4* pMatrices) const
+{
+	BuildModelMatrices(0, GetCount(), pMatrices);
+}
+
+/***********************************************************
+ *  BuildModelMatrices()
+ *
+ *  This method is used for building the model matrices of
+ *  part of the batch, so the batch can be split between
+ *  threads that each write their own part of the array.
+ ***********************************************************/
+void TransformBatch::BuildModelMatrices(int first, int count, glm::mat4* pMatrices) const
+{
+	if (count <= 0)
+	{
+		return;
+	}
+
+	TRANSFORM_SOA transforms;
+	transforms.scaleX = m_scaleX.data() + first;
+	transforms.scaleY = m_scaleY.data() + first;
+	transforms.scaleZ = m_scaleZ.data() + first;
+	transforms.rotationX = m_rotationX.data() + first;
+	transforms.rotationY = m_rotationY.data() + first;
+	transforms.rotationZ = m_rotationZ.data() + first;
+	transforms.positionX = m_positionX.data() + first;
+	transforms.positionY = m_positionY.data() + first;
+	transforms.positionZ = m_positionZ.data() + first;
+
+	BuildModelMatrices(transforms, count, pMatrices + first);
+}
+
+/***********************************************************
+ *  BuildModelMatrices()
+ *
+ *  This method is used for building model matrices from
+ *  structure-of-arrays input with the widest SIMD kernel
+ *  the code was compiled for.
+ ***********************************************************/
+void TransformBatch::BuildModelMatrices(const TRANSFORM_SOA& transforms, int count, glm::mat4* pMatrices)
+{
+#if defined(TRANSFORM_BATCH_AVX2)
+	BuildMatricesSimd<SIMD_AVX2>(transforms, count, pMatrices);
+#elif defined(TRANSFORM_BATCH_SSE2)
+	BuildMatricesSimd<SIMD_SSE2>(transforms, count, pMatrices);
+#else
+	BuildModelMatricesScalar(transforms, count, pMatrices);
+#endif
+}
+
+/***********************************************************
+ *  BuildModelMatricesScalar()
+ *
+ *  This method is used for building model matrices from
+ *  the same closed form one object at a time.
+ ***********************************************************/
+void TransformBatch::BuildModelMatricesScalar(const TRANSFORM_SOA& transforms, int count, glm::mat4* pMatrices)
+{
+	for (int i = 0; i < count; i++)
+	{
+		float sinX = std::sin(transforms.rotationX[i] * DEGREES_TO_RADIANS);
+		float cosX = std::cos(transforms.rotationX[i] * DEGREES_TO_RADIANS);
+		float sinY = std::sin(transforms.rotationY[i] * DEGREES_TO_RADIANS);
+		float cosY = std::cos(transforms.rotationY[i] * DEGREES_TO_RADIANS);
+		float sinZ = std::sin(transforms.rotationZ[i] * DEGREES_TO_RADIANS);
+		float cosZ = std::cos(transforms.rotationZ[i] * DEGREES_TO_RADIANS);
+		float scaleX = transforms.scaleX[i];
+		float scaleY = transforms.scaleY[i];
+		float scaleZ = transforms.scaleZ[i];
+
+		float columns[12];
+		columns[0] = cosY * cosZ * scaleX;
+		columns[1] = cosY * sinZ * scaleX;
+		columns[2] = -sinY * scaleX;
+		columns[3] = (sinX * sinY * cosZ - cosX * sinZ) * scaleY;
+		columns[4] = (sinX * sinY * sinZ + cosX * cosZ) * scaleY;
+		columns[5] = sinX * cosY * scaleY;
+		columns[6] = (cosX * sinY * cosZ + sinX * sinZ) * scaleZ;
+		columns[7] = (cosX * sinY * sinZ - sinX * cosZ) * scaleZ;
+		columns[8] = cosX * cosY * scaleZ;
+		columns[9] = transforms.positionX[i];
+		columns[10] = transforms.positionY[i];
+		columns[11] = transforms.positionZ[i];
+
+		WriteMatrix(columns, pMatrices[i]);
+	}
+}
+
+/***********************************************************
+ *  GetKernelName()
+ *
+ *  This method is used for getting the name of the kernel
+ *  that BuildModelMatrices uses, for benchmark reports.
+ ***********************************************************/
+const char* TransformBatch::GetKernelName()
+{
+#if defined(TRANSFORM_BATCH_AVX2)
+	return("AVX2 x8");
+#elif defined(TRANSFORM_BATCH_SSE2)
+	return("SSE2 x4");
+#else
+	return("scalar");
+#endif
+}
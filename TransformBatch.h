@@ -0,0 +1,80 @@
+///////////////////////////////////////////////////////////////////////////////
+// transformbatch.h
+// ============
+// build many model matrices at once from structure-of-arrays transform data
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  TransformBatch
+ *
+ *  This class collects the scale, Euler XYZ rotation and
+ *  position of many objects in separate arrays and builds
+ *  their model matrices in one pass.  Instead of multiplying
+ *  the scale, three rotation and translation matrices, each
+ *  matrix is written directly from the closed form of
+ *
+ *    translation * rotationZ * rotationY * rotationX * scale
+ *
+ *  using SSE2 or AVX2 kernels that handle 4 or 8 objects per
+ *  instruction, depending on the instruction set the code is
+ *  compiled for.  The results match Transform::ComposeMatrix
+ *  to within floating point rounding.
+ ***********************************************************/
+class TransformBatch
+{
+public:
+	// constructor
+	TransformBatch();
+
+	// pointers to the transform values of a batch of objects,
+	// one array per component - rotations are in degrees
+	struct TRANSFORM_SOA
+	{
+		const float* scaleX;
+		const float* scaleY;
+		const float* scaleZ;
+		const float* rotationX;
+		const float* rotationY;
+		const float* rotationZ;
+		const float* positionX;
+		const float* positionY;
+		const float* positionZ;
+	};
+
+	// remove all objects from the batch
+	void Clear();
+	// add the transform values of one object to the batch
+	void Add(const glm::vec3& scaleXYZ, const glm::vec3& rotationDegrees, const glm::vec3& positionXYZ);
+	// get the number of objects in the batch
+	int GetCount() const;
+	// build the model matrices of all objects in the batch
+	void BuildModelMatrices(glm::mat4* pMatrices) const;
+	// build the model matrices of the objects [first, first +
+	// count) into the same places of the full matrix array
+	void BuildModelMatrices(int first, int count, glm::mat4* pMatrices) const;
+
+	// build model matrices from structure-of-arrays input with
+	// the fastest kernel available
+	static void BuildModelMatrices(const TRANSFORM_SOA& transforms, int count, glm::mat4* pMatrices);
+	// build model matrices one object at a time without SIMD
+	static void BuildModelMatricesScalar(const TRANSFORM_SOA& transforms, int count, glm::mat4* pMatrices);
+	// get the name of the kernel used by BuildModelMatrices
+	static const char* GetKernelName();
+
+private:
+	std::vector<float> m_scaleX;
+	std::vector<float> m_scaleY;
+	std::vector<float> m_scaleZ;
+	std::vector<float> m_rotationX;
+	std::vector<float> m_rotationY;
+	std::vector<float> m_rotationZ;
+	std::vector<float> m_positionX;
+	std::vector<float> m_positionY;
+	std::vector<float> m_positionZ;
+};
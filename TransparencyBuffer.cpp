@@ -0,0 +1,342 @@
+///////////////////////////////////////////////////////////////////////////////
+// transparencybuffer.cpp
+// ============
+// render targets of the weighted blended order-independent transparency pass
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TransparencyBuffer.h"
+#include "RenderState.h"
+#include "FrameStats.h"
+#include "ShaderBindings.h"
+
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// texture units the composite shader reads the targets
+	// from, kept above the units used by the scene textures
+	const GLint ACCUMULATION_UNIT = TextureUnit::TRANSPARENCY_ACCUMULATION;
+	const GLint REVEALAGE_UNIT = TextureUnit::TRANSPARENCY_REVEALAGE;
+
+	// full screen triangle made from the vertex index alone
+	const char* const COMPOSITE_VERTEX_SHADER =
+		"#version 330 core\n"
+		"void main()\n"
+		"{\n"
+		"	vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);\n"
+		"	gl_Position = vec4(position * 2.0 - 1.0, 0.0, 1.0);\n"
+		"}\n";
+
+	// average translucent color, blended over the frame by
+	// the coverage of all the translucent layers together
+	const char* const COMPOSITE_FRAGMENT_SHADER =
+		"#version 330 core\n"
+		"uniform sampler2D accumulationTexture;\n"
+		"uniform sampler2D revealageTexture;\n"
+		"out vec4 fragmentColor;\n"
+		"void main()\n"
+		"{\n"
+		"	ivec2 texel = ivec2(gl_FragCoord.xy);\n"
+		"	float revealage = texelFetch(revealageTexture, texel, 0).r;\n"
+		"	if (revealage >= 1.0)\n"
+		"	{\n"
+		"		discard;\n"
+		"	}\n"
+		"	vec4 accumulation = texelFetch(accumulationTexture, texel, 0);\n"
+		"	vec3 average = accumulation.rgb / max(accumulation.a, 1.0e-5);\n"
+		"	fragmentColor = vec4(average, 1.0 - revealage);\n"
+		"}\n";
+
+	/***********************************************************
+	 *  CompileShader()
+	 *
+	 *  This function is used for compiling one stage of the
+	 *  composite shader - returns 0 on failure.
+	 ***********************************************************/
+	GLuint CompileShader(GLenum type, const char* pSource)
+	{
+		GLuint shader = glCreateShader(type);
+		GLint bCompiled = GL_FALSE;
+
+		glShaderSource(shader, 1, &pSource, NULL);
+		glCompileShader(shader);
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &bCompiled);
+		if (GL_FALSE == bCompiled)
+		{
+			char log[512];
+			glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+			std::cout << "ERROR: transparency composite shader failed to compile: " << log << std::endl;
+			glDeleteShader(shader);
+			return(0);
+		}
+
+		return(shader);
+	}
+}
+
+/***********************************************************
+ *  TransparencyBuffer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TransparencyBuffer::TransparencyBuffer()
+{
+	m_framebuffer = 0;
+	m_accumulationTexture = 0;
+	m_revealageTexture = 0;
+	m_depthBuffer = 0;
+	m_compositeProgram = 0;
+	m_compositeVertexArray = 0;
+	m_width = 0;
+	m_height = 0;
+	m_bTargetsComplete = false;
+}
+
+/***********************************************************
+ *  ~TransparencyBuffer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+TransparencyBuffer::~TransparencyBuffer()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for compiling the composite shader.
+ *  The targets are created by the first Begin(), once the
+ *  size of the viewport is known.  The two targets need
+ *  different blend functions, which takes OpenGL 4.0.
+ ***********************************************************/
+bool TransparencyBuffer::Create()
+{
+	Destroy();
+	if (!GLEW_VERSION_4_0)
+	{
+		return(false);
+	}
+
+	GLuint vertexShader = CompileShader(GL_VERTEX_SHADER, COMPOSITE_VERTEX_SHADER);
+	GLuint fragmentShader = CompileShader(GL_FRAGMENT_SHADER, COMPOSITE_FRAGMENT_SHADER);
+	GLint bLinked = GL_FALSE;
+
+	if ((0 != vertexShader) && (0 != fragmentShader))
+	{
+		m_compositeProgram = glCreateProgram();
+		glAttachShader(m_compositeProgram, vertexShader);
+		glAttachShader(m_compositeProgram, fragmentShader);
+		glLinkProgram(m_compositeProgram);
+		glGetProgramiv(m_compositeProgram, GL_LINK_STATUS, &bLinked);
+	}
+	glDeleteShader(vertexShader);
+	glDeleteShader(fragmentShader);
+
+	if (GL_FALSE == bLinked)
+	{
+		std::cout << "ERROR: transparency composite shader failed to link" << std::endl;
+		Destroy();
+		return(false);
+	}
+
+	// the sampler units never change, so they are set once
+	GLint previousProgram = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &previousProgram);
+	glUseProgram(m_compositeProgram);
+	glUniform1i(glGetUniformLocation(m_compositeProgram, "accumulationTexture"), ACCUMULATION_UNIT);
+	glUniform1i(glGetUniformLocation(m_compositeProgram, "revealageTexture"), REVEALAGE_UNIT);
+	glUseProgram(previousProgram);
+
+	// the full screen triangle has no vertex attributes, but
+	// a core profile still needs a vertex array to draw
+	glGenVertexArrays(1, &m_compositeVertexArray);
+
+	return(true);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the targets and the
+ *  composite shader.
+ ***********************************************************/
+void TransparencyBuffer::Destroy()
+{
+	DestroyTargets();
+	if (0 != m_compositeProgram)
+	{
+		glDeleteProgram(m_compositeProgram);
+		m_compositeProgram = 0;
+	}
+	if (0 != m_compositeVertexArray)
+	{
+		glDeleteVertexArrays(1, &m_compositeVertexArray);
+		m_compositeVertexArray = 0;
+	}
+}
+
+/***********************************************************
+ *  Begin()
+ *
+ *  This method is used for starting the translucent draws.
+ *  The accumulation target is cleared to zero and the
+ *  revealage target to one, then every draw adds into the
+ *  first and multiplies the second by one minus its alpha.
+ ***********************************************************/
+bool TransparencyBuffer::Begin()
+{
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	if ((viewport[2] != m_width) || (viewport[3] != m_height))
+	{
+		m_bTargetsComplete = CreateTargets(viewport[2], viewport[3]);
+	}
+	if ((false == m_bTargetsComplete) || (0 == m_compositeProgram))
+	{
+		return(false);
+	}
+
+	// the translucent draws are hidden by opaque surfaces in
+	// front of them, so the pass starts with the frame depth
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_framebuffer);
+	glBlitFramebuffer(0, 0, m_width, m_height, 0, 0, m_width, m_height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+
+	const GLfloat clearAccumulation[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	const GLfloat clearRevealage[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+	glClearBufferfv(GL_COLOR, 0, clearAccumulation);
+	glClearBufferfv(GL_COLOR, 1, clearRevealage);
+
+	RenderState::Enable(GL_DEPTH_TEST);
+	RenderState::DepthMask(GL_FALSE);
+	RenderState::Enable(GL_BLEND);
+	RenderState::BlendFunci(0, GL_ONE, GL_ONE);
+	RenderState::BlendFunci(1, GL_ZERO, GL_ONE_MINUS_SRC_COLOR);
+
+	return(true);
+}
+
+/***********************************************************
+ *  End()
+ *
+ *  This method is used for compositing the translucent
+ *  layers over the frame with one full screen triangle and
+ *  putting back the depth and blend state of the frame.
+ ***********************************************************/
+void TransparencyBuffer::End()
+{
+	GLint previousProgram = 0;
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	RenderState::DepthMask(GL_TRUE);
+	RenderState::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	RenderState::Disable(GL_DEPTH_TEST);
+
+	glGetIntegerv(GL_CURRENT_PROGRAM, &previousProgram);
+	glUseProgram(m_compositeProgram);
+	glActiveTexture(GL_TEXTURE0 + ACCUMULATION_UNIT);
+	glBindTexture(GL_TEXTURE_2D, m_accumulationTexture);
+	glActiveTexture(GL_TEXTURE0 + REVEALAGE_UNIT);
+	glBindTexture(GL_TEXTURE_2D, m_revealageTexture);
+	glActiveTexture(GL_TEXTURE0);
+
+	glBindVertexArray(m_compositeVertexArray);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	glBindVertexArray(0);
+	FrameStats::Current().drawCalls++;
+
+	glUseProgram(previousProgram);
+	RenderState::Enable(GL_DEPTH_TEST);
+}
+
+/***********************************************************
+ *  CreateTargets()
+ *
+ *  This method is used for creating the accumulation and
+ *  revealage textures and the depth buffer at the size of
+ *  the viewport.
+ ***********************************************************/
+bool TransparencyBuffer::CreateTargets(int width, int height)
+{
+	DestroyTargets();
+	m_width = width;
+	m_height = height;
+	if ((width <= 0) || (height <= 0))
+	{
+		return(false);
+	}
+
+	glGenTextures(1, &m_accumulationTexture);
+	glBindTexture(GL_TEXTURE_2D, m_accumulationTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_HALF_FLOAT, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+	glGenTextures(1, &m_revealageTexture);
+	glBindTexture(GL_TEXTURE_2D, m_revealageTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, width, height, 0, GL_RED, GL_UNSIGNED_BYTE, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	// the depth format has to match the default framebuffer
+	// for the opaque depth to be copied in
+	glGenRenderbuffers(1, &m_depthBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_depthBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	const GLenum drawBuffers[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+	glGenFramebuffers(1, &m_framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_accumulationTexture, 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, m_revealageTexture, 0);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_depthBuffer);
+	glDrawBuffers(2, drawBuffers);
+
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	if (GL_FRAMEBUFFER_COMPLETE != status)
+	{
+		std::cout << "ERROR: transparency framebuffer is incomplete, status 0x" << std::hex << status << std::dec << std::endl;
+		return(false);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  DestroyTargets()
+ *
+ *  This method is used for freeing the targets.
+ ***********************************************************/
+void TransparencyBuffer::DestroyTargets()
+{
+	if (0 != m_framebuffer)
+	{
+		glDeleteFramebuffers(1, &m_framebuffer);
+		m_framebuffer = 0;
+	}
+	if (0 != m_accumulationTexture)
+	{
+		glDeleteTextures(1, &m_accumulationTexture);
+		m_accumulationTexture = 0;
+	}
+	if (0 != m_revealageTexture)
+	{
+		glDeleteTextures(1, &m_revealageTexture);
+		m_revealageTexture = 0;
+	}
+	if (0 != m_depthBuffer)
+	{
+		glDeleteRenderbuffers(1, &m_depthBuffer);
+		m_depthBuffer = 0;
+	}
+	m_width = 0;
+	m_height = 0;
+	m_bTargetsComplete = false;
+}
@@ -0,0 +1,80 @@
+///////////////////////////////////////////////////////////////////////////////
+// transparencybuffer.h
+// ============
+// render targets of the weighted blended order-independent transparency pass
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+/***********************************************************
+ *  TransparencyBuffer
+ *
+ *  This class holds the two render targets of weighted
+ *  blended order-independent transparency and composites
+ *  them over the opaque frame.  Translucent draws add their
+ *  premultiplied color times a depth weight into an RGBA16F
+ *  accumulation target and multiply their coverage into an
+ *  R8 revealage target, both with order-independent blend
+ *  functions, so the draws need no sorting.  The composite
+ *  divides the accumulated color by the accumulated weight
+ *  and blends it over the frame by the revealage.
+ *
+ *  The depth of the opaque frame is copied into the pass
+ *  before the translucent draws, which are depth tested
+ *  against it without writing depth.  The fragment shader
+ *  writes both targets while the pass is active:
+ *
+ *    uniform bool bTransparencyPass;
+ *    layout(location = 0) out vec4 fragmentColor;
+ *    layout(location = 1) out float revealage;
+ *    ...
+ *    if (bTransparencyPass)
+ *    {
+ *        float a = color.a;
+ *        float weight = clamp(pow(min(1.0, a * 10.0) + 0.01, 3.0) *
+ *            1e8 * pow(1.0 - gl_FragCoord.z * 0.9, 3.0), 1e-2, 3e3);
+ *        fragmentColor = vec4(color.rgb * a, a) * weight;
+ *        revealage = a;
+ *    }
+ ***********************************************************/
+class TransparencyBuffer
+{
+public:
+	// constructor
+	TransparencyBuffer();
+	// destructor
+	~TransparencyBuffer();
+
+	// compile the composite shader - returns false when the
+	// context cannot blend the two targets separately
+	bool Create();
+	// free the targets and the composite shader
+	void Destroy();
+
+	// copy the depth of the opaque frame and start drawing
+	// into the transparency targets, sized to the viewport -
+	// returns false when the targets could not be created
+	bool Begin();
+	// stop drawing into the targets and composite them over
+	// the frame in the default framebuffer
+	void End();
+
+private:
+	GLuint m_framebuffer;
+	GLuint m_accumulationTexture;
+	GLuint m_revealageTexture;
+	GLuint m_depthBuffer;
+	GLuint m_compositeProgram;
+	GLuint m_compositeVertexArray;
+	int m_width;
+	int m_height;
+	// true when the targets at the current size are complete
+	bool m_bTargetsComplete;
+
+	// create the targets at a new size
+	bool CreateTargets(int width, int height);
+	// free the targets
+	void DestroyTargets();
+};
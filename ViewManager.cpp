@@ -8,6 +8,8 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "ViewManager.h"
+#include "RenderState.h"
+#include "RenderSettings.h"
 
 // GLM Math Header inclusions
 #include <glm/glm.hpp>
@@ -22,6 +24,7 @@ namespace
 	const int WINDOW_HEIGHT = 800;
 	const char* g_ViewName = "view";
 	const char* g_ProjectionName = "projection";
+	const char* g_ViewPositionName = "viewPosition";
 
 	// camera object used for viewing and interacting with
 	// the 3D scene
@@ -40,6 +43,12 @@ namespace
 	// is off and true when it is on
 	bool bOrthographicProjection = false;
 	float gCameraSpeed = 2.5f;
+
+	// key states from the previous keyboard check, used for
+	// keys that toggle an option once per press
+	bool gKeyWasDown[GLFW_KEY_LAST + 1] = { false };
+	// left mouse button state from the previous check
+	bool gMouseWasDown = false;
 }
 
 /***********************************************************
@@ -52,7 +61,15 @@ ViewManager::ViewManager(
 {
 	// initialize the member variables
 	m_pShaderManager = pShaderManager;
+	m_pShaderUniforms = NULL;
+	m_pFrameData = NULL;
+	m_bUseFrameData = false;
 	m_pWindow = NULL;
+	m_viewMatrix = glm::mat4(1.0f);
+	m_projectionMatrix = glm::mat4(1.0f);
+	m_bPickRequested = false;
+	m_pickOrigin = glm::vec3(0.0f);
+	m_pickDirection = glm::vec3(0.0f, 0.0f, -1.0f);
 	g_pCamera = new Camera();
 	// default camera view parameters
 	g_pCamera->Position = glm::vec3(0.0f, 5.0f, 12.0f);
@@ -71,7 +88,13 @@ ViewManager::~ViewManager()
 {
 	// free up allocated memory
 	m_pShaderManager = NULL;
+	m_pShaderUniforms = NULL;
 	m_pWindow = NULL;
+	if (NULL != m_pFrameData)
+	{
+		delete m_pFrameData;
+		m_pFrameData = NULL;
+	}
 	if (NULL != g_pCamera)
 	{
 		delete g_pCamera;
@@ -112,14 +135,61 @@ GLFWwindow* ViewManager::CreateDisplayWindow(const char* windowTitle)
 	// allows adjusting the camera movement speed dynamically 
 	glfwSetScrollCallback(window, &ViewManager::Mouse_Scroll_Callback);
 	// enable blending for supporting tranparent rendering
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	RenderState::Enable(GL_BLEND);
+	RenderState::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
 	m_pWindow = window;
 
 	return(window);
 }
 
+/***********************************************************
+ *  ResolveUniformHandles()
+ *
+ *  This method is used for resolving the locations of the
+ *  uniforms that are set for every frame and for creating
+ *  the FrameData uniform buffer.  It must be called after
+ *  the shaders have been loaded.
+ ***********************************************************/
+void ViewManager::ResolveUniformHandles(ShaderUniforms* pShaderUniforms)
+{
+	m_pShaderUniforms = pShaderUniforms;
+
+	if (NULL == m_pFrameData)
+	{
+		m_pFrameData = new FrameDataBuffer();
+		m_pFrameData->CreateBuffer();
+	}
+
+	if (NULL != m_pShaderUniforms)
+	{
+		m_viewHandle = m_pShaderUniforms->Resolve(g_ViewName);
+		m_projectionHandle = m_pShaderUniforms->Resolve(g_ProjectionName);
+		m_viewPositionHandle = m_pShaderUniforms->Resolve(g_ViewPositionName);
+
+		// shaders that declare the FrameData block get the camera
+		// values from the buffer instead of separate uniforms
+		m_bUseFrameData = AttachFrameData(m_pShaderUniforms->GetProgramID());
+	}
+}
+
+/***********************************************************
+ *  AttachFrameData()
+ *
+ *  This method is used for connecting the FrameData block
+ *  of a shader program, such as a shadow or post-processing
+ *  pass, to the per-frame uniform buffer.
+ ***********************************************************/
+bool ViewManager::AttachFrameData(GLuint programID)
+{
+	if (NULL == m_pFrameData)
+	{
+		return(false);
+	}
+
+	return(m_pFrameData->AttachProgram(programID));
+}
+
 /***********************************************************
  *  Mouse_Position_Callback()
  *
@@ -226,6 +296,155 @@ void ViewManager::ProcessKeyboardEvents()
 	//useful for technical drawings and top-down views
 	if (glfwGetKey(m_pWindow, GLFW_KEY_O) == GLFW_PRESS)
 		bOrthographicProjection = true;
+
+	//F1:Key switch the redundant state filter on and off
+	//used for measuring the driver overhead with and without it
+	if (WasKeyPressed(GLFW_KEY_F1))
+	{
+		RenderSettings::RENDER_SETTINGS& settings = RenderSettings::Get();
+		settings.bFilterRedundantState = !settings.bFilterRedundantState;
+		std::cout << "INFO: Redundant state filter " << (settings.bFilterRedundantState ? "on" : "off") << std::endl;
+	}
+
+	//F2:Key switch sorting the draws by state on and off
+	//used for comparing the state changes with authoring order
+	if (WasKeyPressed(GLFW_KEY_F2))
+	{
+		RenderSettings::RENDER_SETTINGS& settings = RenderSettings::Get();
+		settings.bSortDraws = !settings.bSortDraws;
+		std::cout << "INFO: Draw sorting " << (settings.bSortDraws ? "on" : "off") << std::endl;
+	}
+
+	//F3:Key switch instanced drawing on and off
+	//used for comparing one draw per object with one per batch
+	if (WasKeyPressed(GLFW_KEY_F3))
+	{
+		RenderSettings::RENDER_SETTINGS& settings = RenderSettings::Get();
+		settings.bInstancedDraws = !settings.bInstancedDraws;
+		std::cout << "INFO: Instanced drawing " << (settings.bInstancedDraws ? "on" : "off") << std::endl;
+	}
+
+	//F4:Key switch multi-draw-indirect submission on and off
+	//used for comparing one draw call per batch with one per texture
+	if (WasKeyPressed(GLFW_KEY_F4))
+	{
+		RenderSettings::RENDER_SETTINGS& settings = RenderSettings::Get();
+		settings.bMultiDrawIndirect = !settings.bMultiDrawIndirect;
+		std::cout << "INFO: Multi-draw-indirect " << (settings.bMultiDrawIndirect ? "on" : "off") << std::endl;
+	}
+
+	//F5:Key switch frustum culling on and off
+	//used for comparing the draw cost with and without culling
+	if (WasKeyPressed(GLFW_KEY_F5))
+	{
+		RenderSettings::RENDER_SETTINGS& settings = RenderSettings::Get();
+		settings.bFrustumCulling = !settings.bFrustumCulling;
+		std::cout << "INFO: Frustum culling " << (settings.bFrustumCulling ? "on" : "off") << std::endl;
+	}
+
+	//F6:Key switch culling through the bounding volume hierarchy
+	//used for comparing it with testing every object box
+	if (WasKeyPressed(GLFW_KEY_F6))
+	{
+		RenderSettings::RENDER_SETTINGS& settings = RenderSettings::Get();
+		settings.bHierarchicalCulling = !settings.bHierarchicalCulling;
+		std::cout << "INFO: Hierarchical culling " << (settings.bHierarchicalCulling ? "on" : "off") << std::endl;
+	}
+
+	//F7:Key switch occlusion culling
+	//used for measuring the net frame time it saves
+	if (WasKeyPressed(GLFW_KEY_F7))
+	{
+		RenderSettings::RENDER_SETTINGS& settings = RenderSettings::Get();
+		settings.bOcclusionCulling = !settings.bOcclusionCulling;
+		std::cout << "INFO: Occlusion culling " << (settings.bOcclusionCulling ? "on" : "off") << std::endl;
+	}
+
+	//F8:Key switch the levels of detail of the curved shapes
+	//used for comparing the triangles drawn at full detail
+	if (WasKeyPressed(GLFW_KEY_F8))
+	{
+		RenderSettings::RENDER_SETTINGS& settings = RenderSettings::Get();
+		settings.bLevelOfDetail = !settings.bLevelOfDetail;
+		std::cout << "INFO: Levels of detail " << (settings.bLevelOfDetail ? "on" : "off") << std::endl;
+	}
+
+	//F9:Key switch drawing the static batches
+	//used for comparing them with drawing every object
+	if (WasKeyPressed(GLFW_KEY_F9))
+	{
+		RenderSettings::RENDER_SETTINGS& settings = RenderSettings::Get();
+		settings.bStaticBatching = !settings.bStaticBatching;
+		std::cout << "INFO: Static batching " << (settings.bStaticBatching ? "on" : "off") << std::endl;
+	}
+
+	//F10:Key switch order-independent transparency
+	//used for comparing it with sorted translucent draws
+	if (WasKeyPressed(GLFW_KEY_F10))
+	{
+		RenderSettings::RENDER_SETTINGS& settings = RenderSettings::Get();
+		settings.bOrderIndependentTransparency = !settings.bOrderIndependentTransparency;
+		std::cout << "INFO: Order-independent transparency " << (settings.bOrderIndependentTransparency ? "on" : "off") << std::endl;
+	}
+}
+
+/***********************************************************
+ *  WasKeyPressed()
+ *
+ *  This method is used for checking whether a key went down
+ *  since the last check, so holding a key only toggles an
+ *  option one time.
+ ***********************************************************/
+bool ViewManager::WasKeyPressed(int key)
+{
+	bool bKeyDown = (glfwGetKey(m_pWindow, key) == GLFW_PRESS);
+	bool bPressed = (bKeyDown && (false == gKeyWasDown[key]));
+
+	gKeyWasDown[key] = bKeyDown;
+
+	return(bPressed);
+}
+
+/***********************************************************
+ *  ProcessMouseButtons()
+ *
+ *  This method is used for turning a click of the left mouse
+ *  button into a pick ray.  The cursor is captured by the
+ *  camera, so the ray starts at the camera and goes through
+ *  the middle of the view.
+ ***********************************************************/
+void ViewManager::ProcessMouseButtons()
+{
+	bool bMouseDown = (glfwGetMouseButton(m_pWindow, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS);
+
+	if (bMouseDown && (false == gMouseWasDown))
+	{
+		m_pickOrigin = g_pCamera->Position;
+		m_pickDirection = glm::normalize(g_pCamera->Front);
+		m_bPickRequested = true;
+	}
+	gMouseWasDown = bMouseDown;
+}
+
+/***********************************************************
+ *  GetPickRay()
+ *
+ *  This method is used for getting the ray of the last click
+ *  so the scene can find the object under it.  Each click is
+ *  only returned one time.
+ ***********************************************************/
+bool ViewManager::GetPickRay(glm::vec3& origin, glm::vec3& direction)
+{
+	if (false == m_bPickRequested)
+	{
+		return(false);
+	}
+
+	origin = m_pickOrigin;
+	direction = m_pickDirection;
+	m_bPickRequested = false;
+
+	return(true);
 }
 
 /***********************************************************
@@ -248,6 +467,8 @@ void ViewManager::PrepareSceneView()
 	// process any keyboard events that may be waiting in the 
 	// event queue
 	ProcessKeyboardEvents();
+	// and any click for picking an object
+	ProcessMouseButtons();
 
 	// get the current view matrix from the camera
 	view = g_pCamera->GetViewMatrix();
@@ -285,14 +506,77 @@ void ViewManager::PrepareSceneView()
 		);
 	}
 
-	// if the shader manager object is valid
-	if (NULL != m_pShaderManager)
+	// keep the camera values for sorting and culling the scene
+	m_viewMatrix = view;
+	m_projectionMatrix = projection;
+
+	// write the camera and timing values for all shader
+	// programs with a single buffer update
+	if (NULL != m_pFrameData)
+	{
+		FrameDataBuffer::FRAME_DATA frameData;
+		int viewportWidth = WINDOW_WIDTH;
+		int viewportHeight = WINDOW_HEIGHT;
+
+		if (NULL != m_pWindow)
+		{
+			glfwGetFramebufferSize(m_pWindow, &viewportWidth, &viewportHeight);
+		}
+
+		frameData.view = view;
+		frameData.projection = projection;
+		frameData.viewPosition = glm::vec4(g_pCamera->Position, 1.0f);
+		frameData.viewportSize = glm::vec2((float)viewportWidth, (float)viewportHeight);
+		frameData.time = currentFrame;
+		frameData.deltaTime = gDeltaTime;
+		m_pFrameData->Update(frameData);
+	}
+
+	// shaders without the FrameData block still need the
+	// camera values set as separate uniforms
+	if ((NULL != m_pShaderUniforms) && (false == m_bUseFrameData))
 	{
 		// set the view matrix into the shader for proper rendering
-		m_pShaderManager->setMat4Value(g_ViewName, view);
+		m_pShaderUniforms->setMat4Value(m_viewHandle, view);
 		// set the view matrix into the shader for proper rendering
-		m_pShaderManager->setMat4Value(g_ProjectionName, projection);
+		m_pShaderUniforms->setMat4Value(m_projectionHandle, projection);
 		// set the view position of the camera into the shader for proper rendering
-		m_pShaderManager->setVec3Value("viewPosition", g_pCamera->Position);
+		m_pShaderUniforms->setVec3Value(m_viewPositionHandle, g_pCamera->Position);
 	}
-}
\ No newline at end of file
+}
+
+/***********************************************************
+ *  GetViewMatrix()
+ *
+ *  This method is used for getting the view matrix of the
+ *  current frame.
+ ***********************************************************/
+const glm::mat4& ViewManager::GetViewMatrix() const
+{
+	return(m_viewMatrix);
+}
+
+/***********************************************************
+ *  GetProjectionMatrix()
+ *
+ *  This method is used for getting the projection matrix of
+ *  the current frame.
+ ***********************************************************/
+const glm::mat4& ViewManager::GetProjectionMatrix() const
+{
+	return(m_projectionMatrix);
+}
+
+/***********************************************************
+ *  SetRingBuffer()
+ *
+ *  This method is used for writing the per-frame camera and
+ *  timing data into ranges of the passed in ring buffer.
+ ***********************************************************/
+void ViewManager::SetRingBuffer(PersistentRingBuffer* pRingBuffer)
+{
+	if (NULL != m_pFrameData)
+	{
+		m_pFrameData->SetRingBuffer(pRingBuffer);
+	}
+}
@@ -10,6 +10,8 @@
 #pragma once
 
 #include "ShaderManager.h"
+#include "ShaderUniforms.h"
+#include "FrameDataBuffer.h"
 #include "camera.h"
 
 // GLFW library
@@ -33,16 +35,53 @@ public:
 private:
 	// pointer to shader manager object
 	ShaderManager* m_pShaderManager;
+	// pointer to resolved shader uniforms object
+	ShaderUniforms* m_pShaderUniforms;
+	// handles of the uniforms set for each frame
+	ShaderUniforms::UNIFORM_HANDLE m_viewHandle;
+	ShaderUniforms::UNIFORM_HANDLE m_projectionHandle;
+	ShaderUniforms::UNIFORM_HANDLE m_viewPositionHandle;
+	// uniform buffer holding the per-frame camera and timing data
+	FrameDataBuffer* m_pFrameData;
+	// true when the shader reads the FrameData uniform block
+	bool m_bUseFrameData;
 	// active OpenGL display window
 	GLFWwindow* m_pWindow;
+	// camera values of the current frame
+	glm::mat4 m_viewMatrix;
+	glm::mat4 m_projectionMatrix;
 
 	// process keyboard events for interaction with the 3D scene
 	void ProcessKeyboardEvents();
+	// check whether a key went down since the last check
+	bool WasKeyPressed(int key);
+	// process mouse button events for picking scene objects
+	void ProcessMouseButtons();
+
+	// true when a click is waiting to be picked, and the ray
+	// from the camera through the middle of the view
+	bool m_bPickRequested;
+	glm::vec3 m_pickOrigin;
+	glm::vec3 m_pickDirection;
 
 public:
 	// create the initial OpenGL display window
 	GLFWwindow* CreateDisplayWindow(const char* windowTitle);
+
+	// resolve the uniform handles and blocks used for each frame
+	void ResolveUniformHandles(ShaderUniforms* pShaderUniforms);
+	// connect another shader program to the per-frame data
+	bool AttachFrameData(GLuint programID);
+	// write the per-frame data into a ring buffer
+	void SetRingBuffer(PersistentRingBuffer* pRingBuffer);
 	
 	// prepare the conversion from 3D object display to 2D scene display
 	void PrepareSceneView();
-};
\ No newline at end of file
+
+	// get the camera values of the current frame
+	const glm::mat4& GetViewMatrix() const;
+	const glm::mat4& GetProjectionMatrix() const;
+	// get the ray of a click waiting to be picked - returns
+	// false when there was no click since the last call
+	bool GetPickRay(glm::vec3& origin, glm::vec3& direction);
+};
\ No newline at end of file